@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include <libpayload.h>
+
+#define ID_AA64ISAR0_SHA2_SHIFT		12
+#define ID_AA64ISAR0_SHA2_MASK		0xf
+
+void sha256_ce_blocks(u32 state[8], const u8 *data, size_t blocks);
+
+static int have_sha2(void)
+{
+	static int sha2 = -1;
+	u64 isar0;
+
+	if (sha2 < 0) {
+		asm volatile ("mrs %0, id_aa64isar0_el1" : "=r"(isar0));
+		sha2 = !!((isar0 >> ID_AA64ISAR0_SHA2_SHIFT) & ID_AA64ISAR0_SHA2_MASK);
+	}
+
+	return sha2;
+}
+
+size_t arch_sha256_blocks(u32 state[8], const u8 *data, size_t blocks)
+{
+	if (!have_sha2())
+		return 0;
+
+	sha256_ce_blocks(state, data, blocks);
+	return blocks;
+}
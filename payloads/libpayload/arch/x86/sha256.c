@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include <arch/cpuid.h>
+#include <libpayload.h>
+
+#define CPUID_1_ECX_SSSE3	(1 << 9)
+#define CPUID_1_ECX_SSE4_1	(1 << 19)
+#define CPUID_7_EBX_SHA		(1 << 29)
+
+void sha256_ni_blocks(u32 state[8], const u8 *data, size_t blocks);
+
+static int have_sha_ni(void)
+{
+	static int sha_ni = -1;
+	unsigned int eax, ebx, ecx, edx;
+
+	if (sha_ni >= 0)
+		return sha_ni;
+
+	sha_ni = 0;
+	if (cpuid_max() < 7)
+		return sha_ni;
+
+	/* head.S has enabled SSE already, the SHA code also needs SSSE3 and SSE4.1. */
+	cpuid(1, eax, ebx, ecx, edx);
+	if ((ecx & (CPUID_1_ECX_SSSE3 | CPUID_1_ECX_SSE4_1)) !=
+	    (CPUID_1_ECX_SSSE3 | CPUID_1_ECX_SSE4_1))
+		return sha_ni;
+
+	cpuid_count(7, 0, eax, ebx, ecx, edx);
+	sha_ni = !!(ebx & CPUID_7_EBX_SHA);
+
+	return sha_ni;
+}
+
+size_t arch_sha256_blocks(u32 state[8], const u8 *data, size_t blocks)
+{
+	if (!have_sha_ni())
+		return 0;
+
+	sha256_ni_blocks(state, data, blocks);
+	return blocks;
+}
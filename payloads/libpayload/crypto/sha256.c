@@ -0,0 +1,168 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/* SHA-256 as in FIPS 180-4. */
+
+#include <libpayload.h>
+
+#define ROR32(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+
+#define CH(x, y, z)	(((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z)	(((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define S0(x)		(ROR32(x, 2) ^ ROR32(x, 13) ^ ROR32(x, 22))
+#define S1(x)		(ROR32(x, 6) ^ ROR32(x, 11) ^ ROR32(x, 25))
+#define s0(x)		(ROR32(x, 7) ^ ROR32(x, 18) ^ ((x) >> 3))
+#define s1(x)		(ROR32(x, 17) ^ ROR32(x, 19) ^ ((x) >> 10))
+
+static const u32 K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+void SHA256Transform(u32 state[8], const u8 block[SHA256_BLOCK_LENGTH])
+{
+	u32 a, b, c, d, e, f, g, h, t1, t2;
+	u32 w[16];
+	int i;
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+	f = state[5];
+	g = state[6];
+	h = state[7];
+
+	for (i = 0; i < 64; i++) {
+		/* The message schedule only needs the last 16 words. */
+		if (i < 16)
+			w[i] = be32dec(&block[i * 4]);
+		else
+			w[i & 15] += s1(w[(i - 2) & 15]) + w[(i - 7) & 15] +
+				     s0(w[(i - 15) & 15]);
+
+		t1 = h + S1(e) + CH(e, f, g) + K[i] + w[i & 15];
+		t2 = S0(a) + MAJ(a, b, c);
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+
+/*
+ * Architectures override this with an implementation that uses hash instructions if the CPU
+ * has them. Returns the number of blocks it hashed.
+ */
+__weak size_t arch_sha256_blocks(u32 state[8], const u8 *data, size_t blocks)
+{
+	return 0;
+}
+
+static void sha256_blocks(u32 state[8], const u8 *data, size_t blocks)
+{
+	size_t i = arch_sha256_blocks(state, data, blocks);
+
+	for (data += i * SHA256_BLOCK_LENGTH; i < blocks; i++) {
+		SHA256Transform(state, data);
+		data += SHA256_BLOCK_LENGTH;
+	}
+}
+
+void SHA256Init(SHA256_CTX *ctx)
+{
+	static const u32 iv[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+	};
+
+	memcpy(ctx->state, iv, sizeof(iv));
+	ctx->count = 0;
+}
+
+void SHA256Update(SHA256_CTX *ctx, const u8 *data, size_t len)
+{
+	size_t used = ctx->count % SHA256_BLOCK_LENGTH;
+	size_t n;
+
+	ctx->count += len;
+
+	if (used) {
+		n = MIN(len, SHA256_BLOCK_LENGTH - used);
+		memcpy(&ctx->buffer[used], data, n);
+		data += n;
+		len -= n;
+		if (used + n < SHA256_BLOCK_LENGTH)
+			return;
+		sha256_blocks(ctx->state, ctx->buffer, 1);
+	}
+
+	/* Whole blocks straight from the caller's buffer. */
+	n = len / SHA256_BLOCK_LENGTH;
+	if (n) {
+		sha256_blocks(ctx->state, data, n);
+		data += n * SHA256_BLOCK_LENGTH;
+		len -= n * SHA256_BLOCK_LENGTH;
+	}
+
+	memcpy(ctx->buffer, data, len);
+}
+
+void SHA256Final(u8 digest[SHA256_DIGEST_LENGTH], SHA256_CTX *ctx)
+{
+	const u64 bits = ctx->count * 8;
+	size_t used = ctx->count % SHA256_BLOCK_LENGTH;
+	int i;
+
+	ctx->buffer[used++] = 0x80;
+	if (used > SHA256_BLOCK_LENGTH - 8) {
+		memset(&ctx->buffer[used], 0, SHA256_BLOCK_LENGTH - used);
+		sha256_blocks(ctx->state, ctx->buffer, 1);
+		used = 0;
+	}
+	memset(&ctx->buffer[used], 0, SHA256_BLOCK_LENGTH - 8 - used);
+	be32enc(&ctx->buffer[SHA256_BLOCK_LENGTH - 8], bits >> 32);
+	be32enc(&ctx->buffer[SHA256_BLOCK_LENGTH - 4], bits);
+	sha256_blocks(ctx->state, ctx->buffer, 1);
+
+	for (i = 0; i < 8; i++)
+		be32enc(&digest[i * 4], ctx->state[i]);
+
+	memset(ctx, 0, sizeof(*ctx));
+}
+
+/**
+ * Compute the SHA-256 hash of len bytes at data into buf, which must hold
+ * SHA256_DIGEST_LENGTH bytes.
+ *
+ * @return buf
+ */
+u8 *sha256(const u8 *data, size_t len, u8 *buf)
+{
+	SHA256_CTX ctx;
+
+	SHA256Init(&ctx);
+	SHA256Update(&ctx, data, len);
+	SHA256Final(buf, &ctx);
+
+	return buf;
+}
@@ -141,7 +141,7 @@ static int ahci_dev_init(hba_ctrl_t *const ctrl,
 	const int timeout_s = 30; /* Time out after 30s. */
 	int timeout = timeout_s * 100;
 	while ((port->taskfile_data & HBA_PxTFD_BSY) && timeout--)
-		mdelay(10);
+		task_sleep(10 * USECS_PER_MSEC);
 
 	if (port->taskfile_data & HBA_PxTFD_BSY)
 		printf("ahci: Timed out after %d seconds "
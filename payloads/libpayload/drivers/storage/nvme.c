@@ -76,7 +76,7 @@ static int nvme_cmd(
 	struct nvme_c_queue_entry *c_entry = nvme->queue[cq].base +
 		(nvme->queue[cq].idx * NVME_CQ_ENTRY_SIZE);
 	while (((read32(&c_entry->dw[3]) >> 16) & 0x1) == nvme->queue[cq].round)
-		;
+		task_yield();
 	nvme->queue[cq].idx = (nvme->queue[cq].idx + 1) & (NVME_QUEUE_SIZE - 1);
 	write32(nvme->queue[cq].bell, nvme->queue[cq].idx);
 	if (nvme->queue[cq].idx == 0)
@@ -361,7 +361,7 @@ static void nvme_init(pcidev_t dev)
 			goto abort;
 		}
 		timeout -= 10;
-		mdelay(10);
+		task_sleep(10 * USECS_PER_MSEC);
 	} while (status != 0x0);
 	if (create_admin_queues(nvme))
 		goto abort;
@@ -375,7 +375,7 @@ static void nvme_init(pcidev_t dev)
 		if (timeout < 0)
 			goto abort;
 		timeout -= 10;
-		mdelay(10);
+		task_sleep(10 * USECS_PER_MSEC);
 	} while (status != 0x1);
 
 	uint16_t command = pci_read_config16(dev, PCI_COMMAND);
@@ -36,25 +36,66 @@ static storage_dev_t **devices = NULL;
 static size_t devices_length = 0;
 static size_t dev_count = 0;
 
-int storage_attach_device(storage_dev_t *const dev)
+static int append_device(storage_dev_t ***const list, size_t *const length,
+			 size_t *const count, storage_dev_t *const dev)
 {
-	if (dev_count == devices_length) {
-		const size_t new_len =
-			(0 == devices_length) ? 4 : devices_length << 1;
-		storage_dev_t **const new_devices =
-			realloc(devices, new_len * sizeof(storage_dev_t *));
-		if (!new_devices)
+	if (*count == *length) {
+		const size_t new_len = (0 == *length) ? 4 : *length << 1;
+		storage_dev_t **const new_list =
+			realloc(*list, new_len * sizeof(storage_dev_t *));
+		if (!new_list)
 			return -1;
-		devices = new_devices;
-		memset(devices + devices_length, '\0',
-			(new_len - devices_length) * sizeof(storage_dev_t *));
-		devices_length = new_len;
+		*list = new_list;
+		memset(*list + *length, '\0',
+			(new_len - *length) * sizeof(storage_dev_t *));
+		*length = new_len;
 	}
-	devices[dev_count++] = dev;
+	(*list)[(*count)++] = dev;
 
 	return 0;
 }
 
+#if CONFIG(LP_COOP_TASKS)
+/*
+ * Controllers are brought up in a task each. Their devices are collected per
+ * controller and attached in PCI order when all are done, so device numbers
+ * don't depend on which controller was quicker.
+ */
+struct init_job {
+	struct pci_dev *pci;
+	struct task *task;
+	storage_dev_t **devices;
+	size_t devices_length;
+	size_t dev_count;
+};
+
+static struct init_job *init_jobs;
+static size_t init_job_count;
+
+static struct init_job *current_init_job(void)
+{
+	struct task *const self = task_self();
+	size_t i;
+
+	for (i = 0; i < init_job_count; ++i) {
+		if (init_jobs[i].task == self)
+			return &init_jobs[i];
+	}
+	return NULL;
+}
+#endif
+
+int storage_attach_device(storage_dev_t *const dev)
+{
+#if CONFIG(LP_COOP_TASKS)
+	struct init_job *const job = current_init_job();
+	if (job)
+		return append_device(&job->devices, &job->devices_length,
+				     &job->dev_count, dev);
+#endif
+	return append_device(&devices, &devices_length, &dev_count, dev);
+}
+
 int storage_device_count(void)
 {
 	return dev_count;
@@ -100,31 +141,155 @@ ssize_t storage_read_blocks512(const size_t dev_num,
 		return -1;
 }
 
+/* Small enough to stay in the cache until it is hashed. */
+#define HASH_CHUNK_BLOCKS	64
+
 /**
- * Initializes storage controllers
+ * Read 512-byte blocks and hash them
  *
- * This function should be called once at startup to bring up supported
- * storage controllers.
+ * Like storage_read_blocks512(), but reads in chunks and passes each
+ * of them to hash() right away.
+ *
+ * @dev_num device number counted from 0
+ * @start number of first block to read from
+ * @count number of blocks to read
+ * @buf buffer where the read data should be written
+ * @hash called with ctx for every chunk read, in order
+ * @ctx passed to hash()
  */
-void storage_initialize(void)
+ssize_t storage_read_blocks512_hash(const size_t dev_num,
+				    const lba_t start, const size_t count,
+				    unsigned char *const buf,
+				    void (*const hash)(void *ctx, const u8 *data, size_t len),
+				    void *const ctx)
 {
+	size_t off = 0;
+	ssize_t ret;
+
+	while (off < count) {
+		const size_t blocks = MIN(count - off, HASH_CHUNK_BLOCKS);
+		ret = storage_read_blocks512(dev_num, start + off, blocks,
+					     buf + off * 512);
+		if (ret > 0)
+			hash(ctx, buf + off * 512, ret * 512);
+		if (ret < 0)
+			return off ? off : ret;
+		off += ret;
+		if ((size_t)ret < blocks)
+			break;
+	}
+
+	return off;
+}
+
 #if CONFIG(LP_PCI)
-	struct pci_dev *dev;
-	for (dev = lib_sysinfo.pacc.devices; dev; dev = dev->next) {
-		switch (dev->device_class) {
+static int storage_controller_supported(const struct pci_dev *const dev)
+{
+	switch (dev->device_class) {
 #if CONFIG(LP_STORAGE_AHCI)
-		case PCI_CLASS_STORAGE_AHCI:
-			ahci_initialize(dev);
-			break;
+	case PCI_CLASS_STORAGE_AHCI:
+		return 1;
 #endif
 #if CONFIG(LP_STORAGE_NVME)
-		case PCI_CLASS_STORAGE_NVME:
-			nvme_initialize(dev);
-			break;
+	case PCI_CLASS_STORAGE_NVME:
+		return 1;
 #endif
-		default:
-			break;
+	default:
+		return 0;
+	}
+}
+
+static void storage_controller_initialize(void *const arg)
+{
+	struct pci_dev *const dev = arg;
+
+	switch (dev->device_class) {
+#if CONFIG(LP_STORAGE_AHCI)
+	case PCI_CLASS_STORAGE_AHCI:
+		ahci_initialize(dev);
+		break;
+#endif
+#if CONFIG(LP_STORAGE_NVME)
+	case PCI_CLASS_STORAGE_NVME:
+		nvme_initialize(dev);
+		break;
+#endif
+	default:
+		break;
+	}
+}
+
+#if CONFIG(LP_COOP_TASKS)
+static int storage_initialize_concurrently(void)
+{
+	struct pci_dev *dev;
+	size_t i, j, count = 0;
+
+	for (dev = lib_sysinfo.pacc.devices; dev; dev = dev->next)
+		count += storage_controller_supported(dev);
+	if (count < 2)
+		return -1;
+
+	init_jobs = calloc(count, sizeof(*init_jobs));
+	if (!init_jobs)
+		return -1;
+
+	for (dev = lib_sysinfo.pacc.devices; dev; dev = dev->next) {
+		if (storage_controller_supported(dev))
+			init_jobs[init_job_count++].pci = dev;
+	}
+
+	/* Start all before any of them runs. */
+	for (i = 0; i < init_job_count; ++i)
+		init_jobs[i].task = task_create(storage_controller_initialize,
+						init_jobs[i].pci, 0);
+
+	for (i = 0; i < init_job_count; ++i) {
+		if (init_jobs[i].task) {
+			task_join(init_jobs[i].task);
+		} else {
+			/* Out of memory for a stack, bring it up ourselves. */
+			init_jobs[i].task = task_self();
+			storage_controller_initialize(init_jobs[i].pci);
 		}
+		init_jobs[i].task = NULL;
+	}
+
+	for (i = 0; i < init_job_count; ++i) {
+		for (j = 0; j < init_jobs[i].dev_count; ++j)
+			append_device(&devices, &devices_length, &dev_count,
+				      init_jobs[i].devices[j]);
+		free(init_jobs[i].devices);
+	}
+
+	free(init_jobs);
+	init_jobs = NULL;
+	init_job_count = 0;
+
+	return 0;
+}
+#endif
+#endif
+
+/**
+ * Initializes storage controllers
+ *
+ * This function should be called once at startup to bring up supported
+ * storage controllers. With CONFIG_LP_COOP_TASKS, the controllers are
+ * brought up concurrently.
+ */
+void storage_initialize(void)
+{
+#if CONFIG(LP_PCI)
+	struct pci_dev *dev;
+
+#if CONFIG(LP_COOP_TASKS)
+	if (!storage_initialize_concurrently())
+		return;
+#endif
+	for (dev = lib_sysinfo.pacc.devices; dev; dev = dev->next) {
+		if (storage_controller_supported(dev))
+			storage_controller_initialize(dev);
 	}
 #endif
 }
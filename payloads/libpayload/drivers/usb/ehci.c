@@ -134,12 +134,12 @@ static void ehci_reset (hci_t *controller)
 	short count = 0;
 	ehci_stop(controller);
 	/* wait 10 ms just to be sure */
-	mdelay(10);
+	task_sleep(10 * USECS_PER_MSEC);
 	if (EHCI_INST(controller)->operation->usbsts & HC_OP_HC_HALTED) {
 		EHCI_INST(controller)->operation->usbcmd = HC_OP_HC_RESET;
 		/* wait 100 ms */
 		for (count = 0; count < 10; count++) {
-			mdelay(10);
+			task_sleep(10 * USECS_PER_MSEC);
 			if (!(EHCI_INST(controller)->operation->usbcmd & HC_OP_HC_RESET)) {
 				return;
 			}
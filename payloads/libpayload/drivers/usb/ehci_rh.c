@@ -195,7 +195,7 @@ ehci_rh_init (usbdev_t *dev)
 		for (i=0; i < RH_INST(dev)->n_ports; i++)
 			RH_INST(dev)->ports[i] |= P_PP;
 	}
-	mdelay(20); // ehci spec 2.3.9
+	task_sleep(20 * USECS_PER_MSEC); // ehci spec 2.3.9
 
 	dev->speed = HIGH_SPEED;
 	dev->address = 0;
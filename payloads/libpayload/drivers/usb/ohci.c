@@ -126,9 +126,9 @@ ohci_reset (hci_t *controller)
 		return;
 
 	OHCI_INST(controller)->opreg->HcCommandStatus = HostControllerReset;
-	mdelay(2); /* wait 2ms */
+	task_sleep(2 * USECS_PER_MSEC); /* wait 2ms */
 	OHCI_INST(controller)->opreg->HcControl = 0;
-	mdelay(10); /* wait 10ms */
+	task_sleep(10 * USECS_PER_MSEC); /* wait 10ms */
 }
 
 static void
@@ -243,7 +243,7 @@ ohci_init (unsigned long physical_bar)
 	OHCI_INST (controller)->opreg->HcPeriodicStart = (((OHCI_INST (controller)->opreg->HcFmInterval & FrameIntervalMask) / 10) * 9);
 	OHCI_INST (controller)->opreg->HcControl = (OHCI_INST (controller)->opreg->HcControl & ~HostControllerFunctionalStateMask) | USBOperational;
 
-	mdelay(100);
+	task_sleep(100 * USECS_PER_MSEC);
 
 	controller->devices[0]->controller = controller;
 	controller->devices[0]->init = ohci_rh_init;
@@ -113,15 +113,15 @@ uhci_reset (hci_t *controller)
 {
 	/* reset */
 	uhci_reg_write16 (controller, USBCMD, 4); /* Global Reset */
-	mdelay (50); /* uhci spec 2.1.1: at least 10ms */
+	task_sleep (50 * USECS_PER_MSEC); /* uhci spec 2.1.1: at least 10ms */
 	uhci_reg_write16 (controller, USBCMD, 0);
-	mdelay (10);
+	task_sleep (10 * USECS_PER_MSEC);
 	uhci_reg_write16 (controller, USBCMD, 2); /* Host Controller Reset */
 	/* wait for controller to finish reset */
 	/* TOTEST: how long to wait? 100ms for now */
 	int timeout = 200; /* time out after 200 * 500us == 100ms */
 	while (((uhci_reg_read16 (controller, USBCMD) & 2) != 0) && timeout--)
-		udelay (500);
+		task_sleep (500);
 	if (timeout < 0)
 		usb_debug ("Warning: uhci: host controller reset timed out.\n");
 }
@@ -116,12 +116,90 @@ static int usb_controller_initialize(int bus, int dev, int func)
 	return 0;
 }
 
+#if CONFIG(LP_COOP_TASKS)
+/* PCI devices with USB controllers, initialized in a task each. */
+static struct usb_pci_job {
+	pcidev_t dev;
+	int max_func;
+	struct task *task;
+} *usb_pci_jobs;
+static int usb_pci_job_count;
+static int usb_pci_jobs_length;
+
+static int usb_is_controller(pcidev_t pci_device)
+{
+	return (pci_read_config32(pci_device, 8) >> 16) == 0xc03;
+}
+
+static void usb_pci_device_initialize(void *arg)
+{
+	const struct usb_pci_job *const job = arg;
+	int func;
+
+	/* Functions stay in order, see usb_scan_pci_bus(). */
+	for (func = job->max_func; func >= 0; func--) {
+		const pcidev_t pci_device =
+			PCI_DEV(PCI_BUS(job->dev), PCI_SLOT(job->dev), func);
+		if (usb_is_controller(pci_device))
+			usb_controller_initialize(PCI_BUS(job->dev),
+						  PCI_SLOT(job->dev), func);
+	}
+}
+
+static void usb_queue_pci_device(int bus, int dev, int max_func)
+{
+	struct usb_pci_job *new_jobs;
+
+	if (usb_pci_job_count == usb_pci_jobs_length) {
+		const int new_len = usb_pci_jobs_length ? usb_pci_jobs_length * 2 : 4;
+		new_jobs = realloc(usb_pci_jobs, new_len * sizeof(*new_jobs));
+		if (!new_jobs) {
+			/* Do it now then. */
+			struct usb_pci_job job = { PCI_DEV(bus, dev, 0), max_func };
+			usb_pci_device_initialize(&job);
+			return;
+		}
+		usb_pci_jobs = new_jobs;
+		usb_pci_jobs_length = new_len;
+	}
+	usb_pci_jobs[usb_pci_job_count].dev = PCI_DEV(bus, dev, 0);
+	usb_pci_jobs[usb_pci_job_count].max_func = max_func;
+	usb_pci_jobs[usb_pci_job_count].task = NULL;
+	usb_pci_job_count++;
+}
+
+static void usb_run_pci_jobs(void)
+{
+	int i;
+
+	if (usb_pci_job_count > 1) {
+		for (i = 0; i < usb_pci_job_count; i++)
+			usb_pci_jobs[i].task = task_create(usb_pci_device_initialize,
+							   &usb_pci_jobs[i], 0);
+	}
+
+	for (i = 0; i < usb_pci_job_count; i++) {
+		if (usb_pci_jobs[i].task)
+			task_join(usb_pci_jobs[i].task);
+		else
+			usb_pci_device_initialize(&usb_pci_jobs[i]);
+	}
+
+	free(usb_pci_jobs);
+	usb_pci_jobs = NULL;
+	usb_pci_job_count = usb_pci_jobs_length = 0;
+}
+#endif
+
 static void usb_scan_pci_bus(int bus)
 {
 	int dev, func;
 	for (dev = 0; dev < 32; dev++) {
 		u8 header_type;
 		pcidev_t pci_device = PCI_DEV(bus, dev, 0);
+#if CONFIG(LP_COOP_TASKS)
+		int max_func = -1;
+#endif
 
 		/* Check if there's a device here at all. */
 		if (pci_read_config32(pci_device, REG_VENDOR_ID) == 0xffffffff)
@@ -153,20 +231,37 @@ static void usb_scan_pci_bus(int bus)
 					usb_scan_pci_bus(pci_read_config8(
 						pci_device, REG_SECONDARY_BUS));
 			}
+#if CONFIG(LP_COOP_TASKS)
+			/* The controllers of a device are set up together, later. */
+			else if (usb_is_controller(pci_device)) {
+				if (max_func < 0)
+					max_func = func;
+			}
+#endif
 			else
 				usb_controller_initialize(bus, dev, func);
 		}
+#if CONFIG(LP_COOP_TASKS)
+		if (max_func >= 0)
+			usb_queue_pci_device(bus, dev, max_func);
+#endif
 	}
 }
 #endif
 
 /**
  * Initialize all USB controllers attached to PCI.
+ *
+ * With CONFIG_LP_COOP_TASKS, controllers on different PCI devices are
+ * initialized concurrently.
  */
 int usb_initialize(void)
 {
 #if CONFIG(LP_USB_PCI)
 	usb_scan_pci_bus(0);
+#if CONFIG(LP_COOP_TASKS)
+	usb_run_pci_jobs();
+#endif
 #endif
 	return 0;
 }
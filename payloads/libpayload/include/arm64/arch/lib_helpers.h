@@ -45,6 +45,9 @@
 #define SCTLR_RES1           ((0x3 << 4) | (0x1 << 11) | (0x1 << 16) |	\
 			      (0x1 << 18) | (0x3 << 22) | (0x3 << 28))
 
+#define CPTR_EL2_TFP	(1 << 10)	/* Trap FP/SIMD			*/
+#define CPTR_EL2_RES1	((0xff << 0) | (0x1 << 9) | (0x3 << 12))
+
 #define DAIF_DBG_BIT      (1 << 3)
 #define DAIF_ABT_BIT      (1 << 2)
 #define DAIF_IRQ_BIT      (1 << 1)
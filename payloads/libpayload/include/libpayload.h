@@ -503,6 +503,34 @@ void SHA1Update(SHA1_CTX *context, const u8 *data, size_t len);
 void SHA1Pad(SHA1_CTX *context);
 void SHA1Final(u8 digest[SHA1_DIGEST_LENGTH], SHA1_CTX *context);
 u8 *sha1(const u8 *data, size_t len, u8 *buf);
+
+#define SHA256_BLOCK_LENGTH	64
+#define SHA256_DIGEST_LENGTH	32
+typedef struct {
+	u32 state[8];
+	u64 count;
+	u8 buffer[SHA256_BLOCK_LENGTH];
+} SHA256_CTX;
+void SHA256Init(SHA256_CTX *ctx);
+void SHA256Transform(u32 state[8], const u8 block[SHA256_BLOCK_LENGTH]);
+void SHA256Update(SHA256_CTX *ctx, const u8 *data, size_t len);
+void SHA256Final(u8 digest[SHA256_DIGEST_LENGTH], SHA256_CTX *ctx);
+u8 *sha256(const u8 *data, size_t len, u8 *buf);
+/* Hash whole blocks with CPU hash instructions if there are any. */
+size_t arch_sha256_blocks(u32 state[8], const u8 *data, size_t blocks);
+
+#define SHA512_BLOCK_LENGTH	128
+#define SHA512_DIGEST_LENGTH	64
+typedef struct {
+	u64 state[8];
+	u64 count;
+	u8 buffer[SHA512_BLOCK_LENGTH];
+} SHA512_CTX;
+void SHA512Init(SHA512_CTX *ctx);
+void SHA512Transform(u64 state[8], const u8 block[SHA512_BLOCK_LENGTH]);
+void SHA512Update(SHA512_CTX *ctx, const u8 *data, size_t len);
+void SHA512Final(u8 digest[SHA512_DIGEST_LENGTH], SHA512_CTX *ctx);
+u8 *sha512(const u8 *data, size_t len, u8 *buf);
 /** @} */
 
 /**
@@ -514,6 +542,30 @@ u8 *sha1(const u8 *data, size_t len, u8 *buf);
 int sysinfo_have_multiboot(unsigned long *addr);
 /** @} */
 
+/**
+ * @defgroup task Cooperative task functions
+ * Tasks only switch in task_yield(), task_sleep(), task_sleep_until() and
+ * task_wait_for(), there is no preemption. The delay functions below always
+ * busy-wait. Without CONFIG_LP_COOP_TASKS, task_create() fails and the waits
+ * are busy loops.
+ * @{
+ */
+struct task;
+
+/* Run func(arg) on a new stack, CONFIG_LP_COOP_TASK_STACK_SIZE if 0. */
+struct task *task_create(void (*func)(void *arg), void *arg, size_t stack_size);
+/* Wait for a task to return and free it. */
+int task_join(struct task *task);
+struct task *task_self(void);
+void task_yield(void);
+/* Let other tasks run for at least us microseconds. */
+void task_sleep(uint64_t us);
+/* Let other tasks run until timer_us(0) reaches deadline_us. */
+void task_sleep_until(uint64_t deadline_us);
+/* Yield until cond(arg) is true. Returns 0, or -1 on timeout. */
+int task_wait_for(int (*cond)(void *arg), void *arg, uint64_t timeout_us);
+/** @} */
+
 /**
  * @defgroup arch Architecture specific functions
  * This module contains global architecture specific functions.
@@ -70,5 +70,10 @@ int storage_attach_device(storage_dev_t *dev);
 
 storage_poll_t storage_probe(size_t dev_num);
 ssize_t storage_read_blocks512(size_t dev_num, lba_t start, size_t count, unsigned char *buf);
+/* Pass the data to hash() piecewise as it is read, while it is still in the cache. */
+ssize_t storage_read_blocks512_hash(size_t dev_num, lba_t start, size_t count,
+				    unsigned char *buf,
+				    void (*hash)(void *ctx, const u8 *data, size_t len),
+				    void *ctx);
 
 #endif
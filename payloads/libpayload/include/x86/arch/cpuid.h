@@ -32,6 +32,10 @@
 #define cpuid(fn, eax, ebx, ecx, edx) \
 	asm("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "0"(fn))
 
+/* For leaves with subleaves, in ecx. */
+#define cpuid_count(fn, sub, eax, ebx, ecx, edx) \
+	asm("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "0"(fn), "2"(sub))
+
 #define _declare_cpuid(reg)					\
 	static inline unsigned int cpuid_##reg(unsigned int fn)	\
 	{							\
@@ -0,0 +1,211 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include <libpayload.h>
+
+#if CONFIG(LP_COOP_TASKS)
+
+/*
+ * task_switch() pushes the callee-saved registers and the return address on the current stack,
+ * stores the stack pointer in *saved_sp and pops the same from new_sp. A task that never ran
+ * gets a frame that returns into task_start().
+ */
+void task_switch(void **saved_sp, void *new_sp);
+
+#if CONFIG(LP_ARCH_X86)
+/* edi, esi, ebx, ebp, the return address, and the return address of task_start(). */
+#define FRAME_WORDS	6
+#define FRAME_RET	4
+#elif CONFIG(LP_ARCH_ARM)
+/* r4-r11 and pc. */
+#define FRAME_WORDS	9
+#define FRAME_RET	8
+#elif CONFIG(LP_ARCH_ARM64)
+/* x19-x30 and d8-d15. */
+#define FRAME_WORDS	20
+#define FRAME_RET	11
+#endif
+
+#define STACK_ALIGN	16
+
+struct task {
+	struct task *next;
+	void *sp;
+	u8 *stack;
+	void (*func)(void *arg);
+	void *arg;
+	uint64_t wake_us;
+	int done;
+};
+
+/* The payload itself is the main task. Tasks that haven't finished form a ring. */
+static struct task main_task = { .next = &main_task };
+static struct task *current = &main_task;
+
+static struct task *next_ready(struct task *first)
+{
+	const uint64_t now = timer_us(0);
+	struct task *t = first;
+
+	do {
+		if (t->wake_us <= now)
+			return t;
+		t = t->next;
+	} while (t != first);
+
+	return NULL;
+}
+
+/* Switch to the next task that can run, round-robin. Waits if all tasks sleep. */
+static void schedule(void)
+{
+	struct task *prev = current;
+	struct task *next;
+
+	/* A finished task has left the ring already, but its next pointer is still valid. */
+	while (!(next = next_ready(prev->next)))
+		;
+
+	if (next == prev)
+		return;
+
+	current = next;
+	task_switch(&prev->sp, next->sp);
+}
+
+static void task_start(void)
+{
+	struct task *t = current;
+	struct task *prev;
+
+	t->func(t->arg);
+
+	/* Leave the ring for good. task_join() frees the stack. */
+	for (prev = t; prev->next != t; prev = prev->next)
+		;
+	prev->next = t->next;
+	t->done = 1;
+
+	schedule();
+	fatal("Finished task was scheduled again\n");
+}
+
+struct task *task_create(void (*func)(void *arg), void *arg, size_t stack_size)
+{
+	struct task *t;
+	uintptr_t *frame;
+
+	if (!stack_size)
+		stack_size = CONFIG_LP_COOP_TASK_STACK_SIZE;
+	stack_size = ALIGN_UP(stack_size, STACK_ALIGN);
+
+	t = calloc(1, sizeof(*t));
+	if (!t)
+		return NULL;
+
+	t->stack = memalign(STACK_ALIGN, stack_size);
+	if (!t->stack) {
+		free(t);
+		return NULL;
+	}
+
+	t->func = func;
+	t->arg = arg;
+
+	frame = (uintptr_t *)(t->stack + stack_size) - FRAME_WORDS;
+	memset(frame, 0, FRAME_WORDS * sizeof(*frame));
+	frame[FRAME_RET] = (uintptr_t)task_start;
+	t->sp = frame;
+
+	/* Runs when the creator yields the next time. */
+	t->next = current->next;
+	current->next = t;
+
+	return t;
+}
+
+int task_join(struct task *task)
+{
+	if (task == current || task == &main_task)
+		return -1;
+
+	while (!task->done)
+		task_yield();
+
+	free(task->stack);
+	free(task);
+
+	return 0;
+}
+
+struct task *task_self(void)
+{
+	return current;
+}
+
+void task_yield(void)
+{
+	schedule();
+}
+
+void task_sleep_until(uint64_t deadline_us)
+{
+	current->wake_us = deadline_us;
+	schedule();
+	current->wake_us = 0;
+}
+
+void task_sleep(uint64_t us)
+{
+	/* Nobody to run meanwhile. */
+	if (main_task.next == &main_task)
+		arch_ndelay(us * NSECS_PER_USEC);
+	else
+		task_sleep_until(timer_us(0) + us);
+}
+
+#else
+
+struct task *task_create(void (*func)(void *arg), void *arg, size_t stack_size)
+{
+	return NULL;
+}
+
+int task_join(struct task *task)
+{
+	return -1;
+}
+
+struct task *task_self(void)
+{
+	return NULL;
+}
+
+void task_yield(void)
+{
+}
+
+void task_sleep_until(uint64_t deadline_us)
+{
+	while (timer_us(0) < deadline_us)
+		;
+}
+
+void task_sleep(uint64_t us)
+{
+	arch_ndelay(us * NSECS_PER_USEC);
+}
+
+#endif
+
+int task_wait_for(int (*cond)(void *arg), void *arg, uint64_t timeout_us)
+{
+	const uint64_t start = timer_us(0);
+
+	while (!cond(arg)) {
+		if (timer_us(start) >= timeout_us)
+			return cond(arg) ? 0 : -1;
+		task_yield();
+	}
+
+	return 0;
+}
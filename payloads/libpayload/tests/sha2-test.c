@@ -0,0 +1,182 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/*
+ * Checks SHA-256 and SHA-512 against the FIPS 180-4 examples, feeding the data in pieces of
+ * all sizes, and compares the speed of arch_sha256_blocks() and the portable code.
+ */
+
+#include <libpayload.h>
+
+#define BENCH_SIZE	(16 * MiB)
+
+struct test_vector {
+	const char *msg;
+	size_t repeat;
+	const char *sha256;
+	const char *sha512;
+};
+
+static const struct test_vector vectors[] = {
+	{
+		"", 1,
+		"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+		"cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce"
+		"47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e",
+	},
+	{
+		"abc", 1,
+		"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+		"ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+		"2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f",
+	},
+	{
+		"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+		"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+		"204a8fc6dda82f0a0ced7beb8e08a41657c16ef468b228a8279be331a703c335"
+		"96fd15c13b1b07f9aa1d3bea57789ca031ad85c7a71dd70354ec631238ca3445",
+	},
+	{
+		"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmno"
+		"ijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu", 1,
+		"cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1",
+		"8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018"
+		"501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909",
+	},
+	{
+		"a", 1000000,
+		"cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+		"e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973eb"
+		"de0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b",
+	},
+};
+
+static int failures;
+
+static void check(const char *what, const struct test_vector *v, const u8 *digest,
+		  const char *expected, size_t len)
+{
+	char hex[2 * SHA512_DIGEST_LENGTH + 1];
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		snprintf(&hex[2 * i], 3, "%02x", digest[i]);
+
+	if (strcmp(hex, expected)) {
+		printf("FAIL %s(\"%.16s\" x %zu): %s\n", what, v->msg, v->repeat, hex);
+		failures++;
+	}
+}
+
+/* The message, repeated as often as the vector says. */
+static u8 *message(const struct test_vector *v, size_t *len)
+{
+	const size_t msg_len = strlen(v->msg);
+	u8 *data;
+	size_t i;
+
+	*len = msg_len * v->repeat;
+	data = malloc(*len + 1);
+	for (i = 0; i < v->repeat; i++)
+		memcpy(&data[i * msg_len], v->msg, msg_len);
+
+	return data;
+}
+
+static void test_vectors(void)
+{
+	u8 digest[SHA512_DIGEST_LENGTH];
+	SHA256_CTX ctx256;
+	SHA512_CTX ctx512;
+	size_t len, piece, off;
+	size_t i;
+	u8 *data;
+
+	for (i = 0; i < ARRAY_SIZE(vectors); i++) {
+		data = message(&vectors[i], &len);
+
+		check("sha256", &vectors[i], sha256(data, len, digest), vectors[i].sha256,
+		      SHA256_DIGEST_LENGTH);
+		check("sha512", &vectors[i], sha512(data, len, digest), vectors[i].sha512,
+		      SHA512_DIGEST_LENGTH);
+
+		/* Pieces that start and end anywhere in a block. */
+		for (piece = 1; piece <= 2 * SHA512_BLOCK_LENGTH + 1 && len < 1000; piece++) {
+			SHA256Init(&ctx256);
+			SHA512Init(&ctx512);
+			for (off = 0; off < len; off += piece) {
+				SHA256Update(&ctx256, &data[off], MIN(piece, len - off));
+				SHA512Update(&ctx512, &data[off], MIN(piece, len - off));
+			}
+			SHA256Final(digest, &ctx256);
+			check("SHA256Update", &vectors[i], digest, vectors[i].sha256,
+			      SHA256_DIGEST_LENGTH);
+			SHA512Final(digest, &ctx512);
+			check("SHA512Update", &vectors[i], digest, vectors[i].sha512,
+			      SHA512_DIGEST_LENGTH);
+		}
+
+		free(data);
+	}
+}
+
+static u64 now_us(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (u64)tv.tv_sec * USECS_PER_SEC + tv.tv_usec;
+}
+
+static void report(const char *what, u64 start)
+{
+	const u64 us = MAX(now_us() - start, 1);
+
+	printf("%-24s %6llu MiB/s\n", what, (unsigned long long)BENCH_SIZE * USECS_PER_SEC / us / MiB);
+}
+
+static void benchmark(void)
+{
+	u8 *data = malloc(BENCH_SIZE);
+	u8 digest[SHA512_DIGEST_LENGTH];
+	u32 state[8] = { 0 };
+	u32 arch_state[8] = { 0 };
+	size_t i, blocks;
+	u64 start;
+
+	for (i = 0; i < BENCH_SIZE; i++)
+		data[i] = i * 7 + (i >> 11);
+
+	start = now_us();
+	for (i = 0; i < BENCH_SIZE / SHA256_BLOCK_LENGTH; i++)
+		SHA256Transform(state, &data[i * SHA256_BLOCK_LENGTH]);
+	report("SHA-256 portable", start);
+
+	start = now_us();
+	blocks = arch_sha256_blocks(arch_state, data, BENCH_SIZE / SHA256_BLOCK_LENGTH);
+	if (blocks) {
+		report("SHA-256 accelerated", start);
+		if (memcmp(state, arch_state, sizeof(state))) {
+			printf("FAIL arch_sha256_blocks() differs from SHA256Transform()\n");
+			failures++;
+		}
+	} else {
+		printf("%-24s not available\n", "SHA-256 accelerated");
+	}
+
+	start = now_us();
+	sha512(data, BENCH_SIZE, digest);
+	report("SHA-512 portable", start);
+
+	free(data);
+}
+
+int main(void)
+{
+	test_vectors();
+	benchmark();
+
+	if (failures)
+		printf("%d failures\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -1,6 +1,8 @@
 /* SPDX-License-Identifier: BSD-3-Clause */
 
 #include <assert.h>
+#include <commonlib/helpers.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 #include <symbols.h>
@@ -8,13 +10,21 @@
 #include <console/console.h>
 #include <arch/mmu.h>
 #include <arch/lib_helpers.h>
-#include <arch/cache.h>
+#include <arch/barrier.h>
 
-/* This just caches the next free table slot (okay to do since they fill up from
- * bottom to top and can never be freed up again). It will reset to its initial
- * value on stage transition, so we still need to check it for UNUSED_DESC. */
+/* This just caches the lowest table slot that may be free. Freed tables move it
+ * back down. It will reset to its initial value on stage transition, so we
+ * still need to check it for UNUSED_DESC. */
 static uint64_t *next_free_table = (void *)_ttb;
 
+/* Subtables that were unhooked from the tree. The table walker may still have
+ * them cached, so they only become UNUSED_DESC after the next TLB flush. */
+static uint64_t *pending_free_tables[16];
+static size_t pending_free_count;
+
+/* Nesting depth of mmu_config_begin() / mmu_config_commit(). */
+static int config_batch_depth;
+
 static void print_tag(int level, uint64_t tag)
 {
 	printk(level, tag & MA_MEM_NC ? "non-cacheable | " :
@@ -53,6 +63,35 @@ static uint64_t get_block_attr(unsigned long tag)
 	return attr;
 }
 
+/* Func : mmu_is_enabled
+ * Desc : Once the MMU is on, the table walker may have any entry cached.
+ */
+static bool mmu_is_enabled(void)
+{
+	return raw_read_sctlr_el3() & SCTLR_M;
+}
+
+/* Func : flush_tlb
+ * Desc : Invalidate all TLB entries and hand subtables that were freed since the
+ * last flush back to the table allocator.
+ */
+static void flush_tlb(void)
+{
+	/* ARMv8 MMUs snoop L1 data cache, no need to flush it. */
+	dsb();
+	tlbiall_el3();
+	dsb();
+	isb();
+
+	while (pending_free_count) {
+		uint64_t *table = pending_free_tables[--pending_free_count];
+
+		table[0] = UNUSED_DESC;
+		if (table < next_free_table)
+			next_free_table = table;
+	}
+}
+
 /* Func : setup_new_table
  * Desc : Get next free table from TTB and set it up to match old parent entry.
  */
@@ -60,8 +99,12 @@ static uint64_t *setup_new_table(uint64_t desc, size_t xlat_size)
 {
 	while (next_free_table[0] != UNUSED_DESC) {
 		next_free_table += GRANULE_SIZE/sizeof(*next_free_table);
-		if (_ettb - (u8 *)next_free_table <= 0)
-			die("Ran out of page table space!");
+		if (_ettb - (u8 *)next_free_table <= 0) {
+			if (!pending_free_count)
+				die("Ran out of page table space!");
+			/* Reclaim tables released earlier in this batch. */
+			flush_tlb();
+		}
 	}
 
 	void *frame_base = (void *)(desc & XLAT_ADDR_MASK);
@@ -75,6 +118,10 @@ static uint64_t *setup_new_table(uint64_t desc, size_t xlat_size)
 		/* Can reuse old parent entry, but may need to adjust type. */
 		if (xlat_size == L3_XLAT_SIZE)
 			desc |= PAGE_DESC;
+		/* Every aligned group of a split block is a uniform run. Hints
+		 * are only set while the MMU is off, see write_desc(). */
+		if (CONFIG(ARM64_MMU_CONTIGUOUS_HINTS) && !mmu_is_enabled())
+			desc |= BLOCK_CONTIGUOUS;
 
 		int i = 0;
 		for (; i < GRANULE_SIZE/sizeof(*next_free_table); i++) {
@@ -86,6 +133,60 @@ static uint64_t *setup_new_table(uint64_t desc, size_t xlat_size)
 	return next_free_table;
 }
 
+/* Func : free_table
+ * Desc : Queue a table that is no longer referenced, and all of its subtables,
+ * for release. xlat_size is the size addressed by each entry of the table.
+ */
+static void free_table(uint64_t *table, size_t xlat_size)
+{
+	int i;
+
+	if (xlat_size > L3_XLAT_SIZE)
+		for (i = 0; i < GRANULE_SIZE/sizeof(*table); i++)
+			if ((table[i] & DESC_MASK) == TABLE_DESC)
+				free_table((uint64_t *)(table[i] & XLAT_ADDR_MASK),
+					   xlat_size >> BITS_RESOLVED_PER_LVL);
+
+	if (pending_free_count == ARRAY_SIZE(pending_free_tables))
+		flush_tlb();
+	pending_free_tables[pending_free_count++] = table;
+}
+
+/* Func : write_desc
+ * Desc : Replace a table entry. A contiguous hint on the entry's group no
+ * longer holds once one member changes, so it is dropped first. With the MMU
+ * on, that takes break-before-make: the group is unmapped and the TLB
+ * invalidated before it comes back without the hint. Hints only exist with
+ * ARM64_MMU_CONTIGUOUS_HINTS, see its help text. A subtable the entry pointed
+ * to is released.
+ */
+static void write_desc(uint64_t *ptr, uint64_t desc, size_t xlat_size)
+{
+	uint64_t old = *ptr;
+	int i;
+
+	if (old & BLOCK_CONTIGUOUS) {
+		uint64_t *group = (uint64_t *)ALIGN_DOWN((uintptr_t)ptr,
+					CONTIG_ENTRIES * sizeof(*ptr));
+		uint64_t saved[CONTIG_ENTRIES];
+
+		memcpy(saved, group, sizeof(saved));
+		if (mmu_is_enabled()) {
+			for (i = 0; i < CONTIG_ENTRIES; i++)
+				group[i] = INVALID_DESC;
+			flush_tlb();
+		}
+		for (i = 0; i < CONTIG_ENTRIES; i++)
+			group[i] = saved[i] & ~BLOCK_CONTIGUOUS;
+	}
+
+	*ptr = desc;
+
+	if (xlat_size > L3_XLAT_SIZE && (old & DESC_MASK) == TABLE_DESC)
+		free_table((uint64_t *)(old & XLAT_ADDR_MASK),
+			   xlat_size >> BITS_RESOLVED_PER_LVL);
+}
+
 /* Func: get_next_level_table
  * Desc: Check if the table entry is a valid descriptor. If not, initialize new
  * table, update the entry and return the table addr. If valid, return the addr
@@ -95,9 +196,10 @@ static uint64_t *get_next_level_table(uint64_t *ptr, size_t xlat_size)
 	uint64_t desc = *ptr;
 
 	if ((desc & DESC_MASK) != TABLE_DESC) {
-		uint64_t *new_table = setup_new_table(desc, xlat_size);
+		uint64_t *new_table = setup_new_table(desc & ~BLOCK_CONTIGUOUS,
+						      xlat_size);
 		desc = ((uint64_t)new_table) | TABLE_DESC;
-		*ptr = desc;
+		write_desc(ptr, desc, xlat_size << BITS_RESOLVED_PER_LVL);
 	}
 	return (uint64_t *)(desc & XLAT_ADDR_MASK);
 }
@@ -131,7 +233,7 @@ static uint64_t init_xlat_table(uint64_t base_addr,
 			 * or equal to size addressed by each L1 entry, we can
 			 * directly store a block desc */
 			desc = base_addr | BLOCK_DESC | attr;
-			table[l1_index] = desc;
+			write_desc(&table[l1_index], desc, L1_XLAT_SIZE);
 			/* L2 lookup is not required */
 			return L1_XLAT_SIZE;
 	}
@@ -146,7 +248,7 @@ static uint64_t init_xlat_table(uint64_t base_addr,
 		 * or equal to size addressed by each L2 entry, we can
 		 * directly store a block desc */
 		desc = base_addr | BLOCK_DESC | attr;
-		table[l2_index] = desc;
+		write_desc(&table[l2_index], desc, L2_XLAT_SIZE);
 		/* L3 lookup is not required */
 		return L2_XLAT_SIZE;
 	}
@@ -156,10 +258,112 @@ static uint64_t init_xlat_table(uint64_t base_addr,
 
 	/* L3 table lookup */
 	desc = base_addr | PAGE_DESC | attr;
-	table[l3_index] = desc;
+	write_desc(&table[l3_index], desc, L3_XLAT_SIZE);
 	return L3_XLAT_SIZE;
 }
 
+/* Func : is_leaf_run
+ * Desc : Check whether count entries map one aligned, physically contiguous
+ * range as blocks/pages of xlat_size with identical attributes.
+ */
+static bool is_leaf_run(const uint64_t *table, size_t count, size_t xlat_size)
+{
+	uint64_t first = table[0] & ~BLOCK_CONTIGUOUS;
+	uint64_t type = xlat_size == L3_XLAT_SIZE ? PAGE_DESC : BLOCK_DESC;
+	size_t i;
+
+	if ((first & DESC_MASK) != type ||
+	    !IS_ALIGNED(first & XLAT_ADDR_MASK, count * xlat_size))
+		return false;
+
+	for (i = 1; i < count; i++)
+		if ((table[i] & ~BLOCK_CONTIGUOUS) != first + i * xlat_size)
+			return false;
+
+	return true;
+}
+
+/* Func : fold_table
+ * Desc : Replace the subtable *ptr points to with a single block descriptor if
+ * all of its entries form one uniform run, or with an invalid descriptor if
+ * nothing in it is mapped. xlat_size is the size addressed by *ptr.
+ */
+static void fold_table(uint64_t *ptr, size_t xlat_size)
+{
+	uint64_t *table = (uint64_t *)(*ptr & XLAT_ADDR_MASK);
+	const size_t entries = GRANULE_SIZE/sizeof(*table);
+	uint64_t desc = INVALID_DESC;
+	size_t i;
+
+	/* L0 entries cannot hold block descriptors. */
+	if (xlat_size <= L1_XLAT_SIZE &&
+	    is_leaf_run(table, entries, xlat_size >> BITS_RESOLVED_PER_LVL)) {
+		desc = (table[0] & ~(BLOCK_CONTIGUOUS | DESC_MASK)) | BLOCK_DESC;
+	} else {
+		for (i = 0; i < entries; i++)
+			if (table[i] != INVALID_DESC)
+				return;
+	}
+
+	write_desc(ptr, desc, xlat_size);
+}
+
+/* Func : update_contig_hints
+ * Desc : Set the contiguous bit on every aligned group of CONTIG_ENTRIES
+ * entries in [first, last] that maps one uniform run, and clear it elsewhere.
+ */
+static void update_contig_hints(uint64_t *table, size_t first, size_t last,
+				size_t xlat_size)
+{
+	size_t group, i;
+
+	for (group = ALIGN_DOWN(first, CONTIG_ENTRIES); group <= last;
+	     group += CONTIG_ENTRIES) {
+		bool contig = is_leaf_run(&table[group], CONTIG_ENTRIES,
+					  xlat_size);
+
+		for (i = group; i < group + CONTIG_ENTRIES; i++) {
+			if (contig)
+				table[i] |= BLOCK_CONTIGUOUS;
+			else
+				table[i] &= ~BLOCK_CONTIGUOUS;
+		}
+	}
+}
+
+/* Func : optimize_range
+ * Desc : Walk the tables covering [start, end) bottom up, folding subtables
+ * that became uniform back into their parent entry and refreshing contiguous
+ * hints. shift is the address shift of the level that table belongs to. Both
+ * would take break-before-make on live entries, so this is only called while
+ * the MMU is off.
+ */
+static void optimize_range(uint64_t *table, int shift, uint64_t start,
+			   uint64_t end)
+{
+	const size_t xlat_size = 1UL << shift;
+	const size_t index_mask = (1UL << BITS_RESOLVED_PER_LVL) - 1;
+	size_t first = (start >> shift) & index_mask;
+	size_t last = ((end - 1) >> shift) & index_mask;
+	uint64_t entry_start = ALIGN_DOWN(start, xlat_size);
+	size_t i;
+
+	for (i = first; i <= last; i++, entry_start += xlat_size) {
+		if (shift == L3_ADDR_SHIFT ||
+		    (table[i] & DESC_MASK) != TABLE_DESC)
+			continue;
+
+		optimize_range((uint64_t *)(table[i] & XLAT_ADDR_MASK),
+			       shift - BITS_RESOLVED_PER_LVL,
+			       MAX(start, entry_start),
+			       MIN(end, entry_start + xlat_size));
+		fold_table(&table[i], xlat_size);
+	}
+
+	if (CONFIG(ARM64_MMU_CONTIGUOUS_HINTS))
+		update_contig_hints(table, first, last, xlat_size);
+}
+
 /* Func : sanity_check
  * Desc : Check address/size alignment of a table or page.
  */
@@ -222,11 +426,33 @@ void mmu_config_range(void *start, size_t size, uint64_t tag)
 		temp_size -= init_xlat_table(base_addr + (size - temp_size),
 					     temp_size, tag);
 
-	/* ARMv8 MMUs snoop L1 data cache, no need to flush it. */
-	dsb();
-	tlbiall_el3();
-	dsb();
-	isb();
+	if (!mmu_is_enabled())
+		optimize_range((uint64_t *)_ttb, L0_ADDR_SHIFT, base_addr,
+			       base_addr + size);
+
+	if (!config_batch_depth)
+		flush_tlb();
+}
+
+/* Func : mmu_config_begin
+ * Desc : Start a batch of mmu_config_range() calls that share one TLB
+ * invalidation in mmu_config_commit().
+ */
+void mmu_config_begin(void)
+{
+	config_batch_depth++;
+}
+
+/* Func : mmu_config_commit
+ * Desc : End a batch started with mmu_config_begin(). The outermost commit
+ * invalidates the TLB and releases subtables freed during the batch.
+ */
+void mmu_config_commit(void)
+{
+	assert(config_batch_depth > 0);
+
+	if (--config_batch_depth == 0)
+		flush_tlb();
 }
 
 /* Func : mmu_init
@@ -239,6 +465,8 @@ void mmu_init(void)
 	uint64_t *table = (uint64_t *)_ttb;
 	for (; _ettb - (u8 *)table > 0; table += GRANULE_SIZE/sizeof(*table))
 		table[0] = UNUSED_DESC;
+	next_free_table = (uint64_t *)_ttb;
+	pending_free_count = 0;
 
 	/* Initialize the root table (L0) to be completely unmapped. */
 	uint64_t *root = setup_new_table(INVALID_DESC, L0_XLAT_SIZE);
@@ -287,13 +515,13 @@ void mmu_restore_context(const struct mmu_context *mmu_context)
 	raw_write_tcr_el3(mmu_context->tcr);
 
 	/* invalidate tlb since ttbr is updated. */
-	tlb_invalidate_all();
+	flush_tlb();
 }
 
 void mmu_enable(void)
 {
 	assert_correct_ttb_mapping(_ttb);
-	assert_correct_ttb_mapping(_ettb - 1);
+	assert_correct_ttb_mapping(_ttb + REGION_SIZE(ttb) - 1);
 
 	uint32_t sctlr = raw_read_sctlr_el3();
 	sctlr |= SCTLR_C | SCTLR_M | SCTLR_I;
@@ -40,8 +40,12 @@
 
 #define BLOCK_ACCESS               (1 << 10)
 
+#define BLOCK_CONTIGUOUS           (1UL << 52)
 #define BLOCK_XN                   (1UL << 54)
 
+/* Number of adjacent entries one contiguous hint spans (4KB granule) */
+#define CONTIG_ENTRIES             16
+
 #define BLOCK_SH_SHIFT                 (8)
 #define BLOCK_SH_NON_SHAREABLE         (0 << BLOCK_SH_SHIFT)
 #define BLOCK_SH_UNPREDICTABLE         (1 << BLOCK_SH_SHIFT)
@@ -146,8 +150,14 @@ void mmu_init(void);
 void mmu_save_context(struct mmu_context *mmu_context);
 /* Desc : Restore mmu context using input backed-up context */
 void mmu_restore_context(const struct mmu_context *mmu_context);
-/* Change a memory type for a range of bytes at runtime. */
+/* Change a memory type for a range of bytes at runtime. While the MMU is off,
+   subtables that became uniform are folded, and with
+   ARM64_MMU_CONTIGUOUS_HINTS contiguous hints are set. */
 void mmu_config_range(void *start, size_t size, uint64_t tag);
+/* Defer TLB maintenance of mmu_config_range() calls until the matching
+   mmu_config_commit(). Calls may nest. */
+void mmu_config_begin(void);
+void mmu_config_commit(void);
 /* Enable the MMU (need previous mmu_init() and configured ranges!). */
 void mmu_enable(void);
 /* Disable the MMU (which also disables dcache but not icache). */
@@ -7,6 +7,7 @@
 #include <console/streams.h>
 #include <cpu/x86/cr.h>
 #include <cpu/x86/lapic.h>
+#include <profiler.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -377,6 +378,21 @@ void x86_exception(struct eregs *info);
 
 void x86_exception(struct eregs *info)
 {
+#if ENV_RAMSTAGE && CONFIG(RAMSTAGE_PROFILER)
+	if (info->vector == PROFILER_VECTOR) {
+#if ENV_X86_64
+		profiler_record(info->rip);
+#else
+		profiler_record(info->eip);
+#endif
+		lapic_write(LAPIC_EOI, 0);
+		return;
+	}
+	/* Spurious interrupts are not acknowledged */
+	if (info->vector == PROFILER_SPURIOUS_VECTOR)
+		return;
+#endif
+
 #if CONFIG(GDB_STUB)
 	int signo;
 	memcpy(gdb_stub_registers, info, 8*sizeof(uint32_t));
@@ -582,6 +598,7 @@ struct intr_gate {
 extern u8 vec0[], vec1[], vec2[], vec3[], vec4[], vec5[], vec6[], vec7[];
 extern u8 vec8[], vec9[], vec10[], vec11[], vec12[], vec13[], vec14[], vec15[];
 extern u8 vec16[], vec17[], vec18[], vec19[];
+extern u8 vec48[], vec63[];
 
 static const uintptr_t intr_entries[] = {
 	(uintptr_t)vec0, (uintptr_t)vec1, (uintptr_t)vec2, (uintptr_t)vec3,
@@ -589,6 +606,10 @@ static const uintptr_t intr_entries[] = {
 	(uintptr_t)vec8, (uintptr_t)vec9, (uintptr_t)vec10, (uintptr_t)vec11,
 	(uintptr_t)vec12, (uintptr_t)vec13, (uintptr_t)vec14, (uintptr_t)vec15,
 	(uintptr_t)vec16, (uintptr_t)vec17, (uintptr_t)vec18, (uintptr_t)vec19,
+#if ENV_RAMSTAGE && CONFIG(RAMSTAGE_PROFILER)
+	[PROFILER_VECTOR] = (uintptr_t)vec48,
+	[PROFILER_SPURIOUS_VECTOR] = (uintptr_t)vec63,
+#endif
 };
 
 static struct intr_gate idt[ARRAY_SIZE(intr_entries)] __aligned(8);
@@ -647,6 +668,9 @@ asmlinkage void exception_init(void)
 
 	/* Initialize IDT. */
 	for (i = 0; i < ARRAY_SIZE(idt); i++) {
+		/* Leave the gates of unused vectors not present */
+		if (!intr_entries[i])
+			continue;
 		idt[i].offset_0 = intr_entries[i];
 		idt[i].segsel = segment;
 		idt[i].flags = IGATE_FLAGS;
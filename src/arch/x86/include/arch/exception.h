@@ -11,4 +11,9 @@ asmlinkage void exception_init(void);
 static inline void exception_init(void) { /* not implemented */ }
 #endif
 
+/* Interrupt vector of the ramstage profiler's sampling timer, see vec48 in idt.S. */
+#define PROFILER_VECTOR 48
+/* Spurious interrupt vector of the local APIC while the profiler runs, see vec63 in idt.S. */
+#define PROFILER_SPURIOUS_VECTOR 63
+
 #endif
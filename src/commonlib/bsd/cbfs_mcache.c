@@ -26,6 +26,9 @@
 #define MCACHE_MAGIC_FULL	0x4c4c5546	/* 'FULL' */
 #define MCACHE_MAGIC_END	0x444e4524	/* '$END' */
 
+_Static_assert(CBFS_MDIR_ALIGN == CBFS_MCACHE_ALIGNMENT,
+	       "metadata directory copies must be laid out like mcache entries");
+
 union mcache_entry {
 	union cbfs_mdata file;
 	struct {	/* These fields exactly overlap file.h.magic */
@@ -62,6 +65,124 @@ static cb_err_t build_walker(cbfs_dev_t dev, size_t offset, const union cbfs_mda
 	return CB_CBFS_NOT_FOUND;
 }
 
+/*
+ * Fill the mcache from a metadata directory at the start of the CBFS. The directory copies are
+ * laid out exactly like mcache entries, so they are read straight into the cache in one go and
+ * only have their bookkeeping fields converted. Files after the area the directory describes
+ * are then picked up by a normal walk. Returns false without consuming anything if there is no
+ * usable directory, in which case the caller has to fall back to a full walk.
+ */
+static bool build_from_mdir(cbfs_dev_t dev, struct cbfs_mcache_build_args *args,
+			    struct vb2_hash *metadata_hash, cb_err_t *ret)
+{
+	const bool do_hash = CBFS_ENABLE_HASHING && metadata_hash;
+	union mcache_entry *entry = args->mcache;
+	struct vb2_digest_context dc;
+	struct cbfs_mdir_header dir;
+	uint32_t data_offset, dir_len, count, size, end_offset, min_offset;
+	void *current, *end;
+
+	if (args->end - args->mcache < sizeof(entry->file))
+		return false;
+
+	if (cbfs_dev_read(dev, &entry->file.h, 0, sizeof(entry->file.h)) !=
+	    sizeof(entry->file.h)) {
+		*ret = CB_CBFS_IO;
+		return true;
+	}
+	data_offset = be32toh(entry->file.h.offset);
+	if (memcmp(entry->file.h.magic, CBFS_FILE_MAGIC, sizeof(entry->file.h.magic)) != 0 ||
+	    be32toh(entry->file.h.type) != CBFS_TYPE_METADATA_DIR ||
+	    data_offset <= sizeof(entry->file.h) || data_offset > sizeof(entry->file))
+		return false;
+
+	if (cbfs_dev_read(dev, entry->file.raw + sizeof(entry->file.h), sizeof(entry->file.h),
+			  data_offset - sizeof(entry->file.h)) !=
+				data_offset - sizeof(entry->file.h) ||
+	    cbfs_dev_read(dev, &dir, data_offset, sizeof(dir)) != sizeof(dir)) {
+		*ret = CB_CBFS_IO;
+		return true;
+	}
+
+	count = be32toh(dir.count);
+	size = be32toh(dir.size);
+	end_offset = be32toh(dir.end_offset);
+	dir_len = be32toh(entry->file.h.len);
+	current = args->mcache + ALIGN_UP(data_offset, CBFS_MCACHE_ALIGNMENT);
+	if (be32toh(dir.magic) != CBFS_MDIR_MAGIC || dir_len < sizeof(dir) ||
+	    size > dir_len - sizeof(dir) || end_offset < data_offset + dir_len ||
+	    end_offset > cbfs_dev_size(dev))
+		return false;
+	if (args->end - current < size) {
+		LOG("CBFS metadata directory does not fit into mcache, walking instead\n");
+		return false;
+	}
+
+	if (cbfs_dev_read(dev, current, data_offset + sizeof(dir), size) != size) {
+		*ret = CB_CBFS_IO;
+		return true;
+	}
+
+	if (do_hash && (vb2_digest_init(&dc, metadata_hash->algo) ||
+			vb2_digest_extend(&dc, entry->file.raw, data_offset))) {
+		*ret = CB_ERR;
+		return true;
+	}
+	entry->magic = MCACHE_MAGIC_FILE;
+	entry->offset = 0;
+
+	/*
+	 * The file offsets aren't covered by the metadata hash, so make sure that the files are
+	 * in flash order, don't overlap each other or the directory, and end before end_offset.
+	 */
+	min_offset = data_offset + dir_len;
+	end = current + size;
+	while (count--) {
+		entry = current;
+		if (end - current < sizeof(entry->file.h))
+			goto corrupt;
+
+		const uint32_t offset = be32toh(entry->magic);
+		const uint32_t type = be32toh(entry->file.h.type);
+		const uint32_t len = be32toh(entry->file.h.len);
+		data_offset = be32toh(entry->file.h.offset);
+		if (data_offset <= sizeof(entry->file.h) || data_offset > sizeof(entry->file) ||
+		    end - current < data_offset || offset < min_offset || offset >= end_offset ||
+		    end_offset - offset < data_offset || end_offset - offset - data_offset < len ||
+		    type == CBFS_TYPE_DELETED || type == CBFS_TYPE_NULL)
+			goto corrupt;
+		min_offset = offset + data_offset + len;
+
+		/* Hash the metadata as it is stored in flash, i.e. with the file magic. */
+		if (do_hash && (vb2_digest_extend(&dc, (const uint8_t *)CBFS_FILE_MAGIC,
+						  sizeof(entry->file.h.magic)) ||
+				vb2_digest_extend(&dc, entry->file.raw +
+						  sizeof(entry->file.h.magic),
+						  data_offset - sizeof(entry->file.h.magic)))) {
+			*ret = CB_ERR;
+			return true;
+		}
+
+		entry->magic = MCACHE_MAGIC_FILE;
+		entry->offset = offset;
+		current += ALIGN_UP(data_offset, CBFS_MCACHE_ALIGNMENT);
+	}
+	if (current != end)
+		goto corrupt;
+
+	args->count += be32toh(dir.count) + 1;
+	args->mcache = current;
+	*ret = cbfs_walk_from(dev, end_offset, build_walker, args, &dc, metadata_hash, 0);
+
+	/* Never trust a directory that doesn't match the CBFS, let the full walk decide. */
+	if (*ret != CB_CBFS_HASH_MISMATCH)
+		return true;
+
+corrupt:
+	ERROR("CBFS metadata directory is inconsistent, walking all file headers\n");
+	return false;
+}
+
 cb_err_t cbfs_mcache_build(cbfs_dev_t dev, void *mcache, size_t size,
 			   struct vb2_hash *metadata_hash)
 {
@@ -71,9 +192,14 @@ cb_err_t cbfs_mcache_build(cbfs_dev_t dev, void *mcache, size_t size,
 		       - sizeof(uint32_t), /* leave space for terminating magic */
 		.count = 0,
 	};
+	cb_err_t ret;
 
 	assert(size > sizeof(uint32_t) && IS_ALIGNED((uintptr_t)mcache, CBFS_MCACHE_ALIGNMENT));
-	cb_err_t ret = cbfs_walk(dev, build_walker, &args, metadata_hash, 0);
+	if (!build_from_mdir(dev, &args, metadata_hash, &ret)) {
+		args.mcache = mcache;
+		args.count = 0;
+		ret = cbfs_walk(dev, build_walker, &args, metadata_hash, 0);
+	}
 	union mcache_entry *entry = args.mcache;
 	if (ret == CB_CBFS_NOT_FOUND) {
 		ret = CB_SUCCESS;
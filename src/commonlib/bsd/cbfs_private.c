@@ -22,22 +22,14 @@ static cb_err_t read_next_header(cbfs_dev_t dev, size_t *offset, struct cbfs_fil
 	return CB_CBFS_NOT_FOUND;
 }
 
-cb_err_t cbfs_walk(cbfs_dev_t dev, cb_err_t (*walker)(cbfs_dev_t dev, size_t offset,
-						      const union cbfs_mdata *mdata,
-						      size_t already_read, void *arg),
-		   void *arg, struct vb2_hash *metadata_hash, enum cbfs_walk_flags flags)
+cb_err_t cbfs_walk_from(cbfs_dev_t dev, size_t offset,
+			cb_err_t (*walker)(cbfs_dev_t dev, size_t offset,
+					   const union cbfs_mdata *mdata,
+					   size_t already_read, void *arg),
+			void *arg, struct vb2_digest_context *dc,
+			struct vb2_hash *metadata_hash, enum cbfs_walk_flags flags)
 {
 	const bool do_hash = CBFS_ENABLE_HASHING && metadata_hash;
-	struct vb2_digest_context dc;
-	vb2_error_t vbrv;
-
-	assert(CBFS_ENABLE_HASHING || (!metadata_hash && !(flags & CBFS_WALK_WRITEBACK_HASH)));
-	if (do_hash && (vbrv = vb2_digest_init(&dc, metadata_hash->algo))) {
-		ERROR("Metadata hash digest (%d) init error: %#x\n", metadata_hash->algo, vbrv);
-		return CB_ERR_ARG;
-	}
-
-	size_t offset = 0;
 	cb_err_t ret_header;
 	cb_err_t ret_walker = CB_CBFS_NOT_FOUND;
 	union cbfs_mdata mdata;
@@ -77,7 +69,7 @@ cb_err_t cbfs_walk(cbfs_dev_t dev, cb_err_t (*walker)(cbfs_dev_t dev, size_t off
 			return CB_CBFS_IO;
 		DEBUG("File name: '%s'\n", mdata.h.filename);
 
-		if (do_hash && !empty && vb2_digest_extend(&dc, mdata.raw, data_offset))
+		if (do_hash && !empty && vb2_digest_extend(dc, mdata.raw, data_offset))
 			return CB_ERR;
 
 		if (walker && ret_walker == CB_CBFS_NOT_FOUND)
@@ -97,7 +89,7 @@ next_file:
 	if (do_hash) {
 		uint8_t real_hash[VB2_MAX_DIGEST_SIZE];
 		size_t hash_size = vb2_digest_size(metadata_hash->algo);
-		if (vb2_digest_finalize(&dc, real_hash, hash_size))
+		if (vb2_digest_finalize(dc, real_hash, hash_size))
 			return CB_ERR;
 		if (flags & CBFS_WALK_WRITEBACK_HASH)
 			memcpy(metadata_hash->raw, real_hash, hash_size);
@@ -108,6 +100,24 @@ next_file:
 	return ret_walker;
 }
 
+cb_err_t cbfs_walk(cbfs_dev_t dev, cb_err_t (*walker)(cbfs_dev_t dev, size_t offset,
+						      const union cbfs_mdata *mdata,
+						      size_t already_read, void *arg),
+		   void *arg, struct vb2_hash *metadata_hash, enum cbfs_walk_flags flags)
+{
+	const bool do_hash = CBFS_ENABLE_HASHING && metadata_hash;
+	struct vb2_digest_context dc;
+	vb2_error_t vbrv;
+
+	assert(CBFS_ENABLE_HASHING || (!metadata_hash && !(flags & CBFS_WALK_WRITEBACK_HASH)));
+	if (do_hash && (vbrv = vb2_digest_init(&dc, metadata_hash->algo))) {
+		ERROR("Metadata hash digest (%d) init error: %#x\n", metadata_hash->algo, vbrv);
+		return CB_ERR_ARG;
+	}
+
+	return cbfs_walk_from(dev, 0, walker, arg, &dc, metadata_hash, flags);
+}
+
 cb_err_t cbfs_copy_fill_metadata(union cbfs_mdata *dst, const union cbfs_mdata *src,
 				 size_t already_read, cbfs_dev_t dev, size_t offset)
 {
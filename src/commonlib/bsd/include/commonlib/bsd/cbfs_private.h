@@ -83,6 +83,19 @@ cb_err_t cbfs_walk(cbfs_dev_t dev, cb_err_t (*walker)(cbfs_dev_t dev, size_t off
 						      size_t already_read, void *arg),
 		   void *arg, struct vb2_hash *metadata_hash, enum cbfs_walk_flags);
 
+/*
+ * Finish a walk that the caller began on its own, e.g. from a metadata directory. Works like
+ * cbfs_walk(), but starts looking for file headers at |offset| and extends the digest context
+ * |dc| instead of starting a new hash. If |metadata_hash| is not NULL, |dc| must have been
+ * initialized for its algorithm and fed the metadata of all files before |offset|.
+ */
+cb_err_t cbfs_walk_from(cbfs_dev_t dev, size_t offset,
+			cb_err_t (*walker)(cbfs_dev_t dev, size_t offset,
+					   const union cbfs_mdata *mdata,
+					   size_t already_read, void *arg),
+			void *arg, struct vb2_digest_context *dc,
+			struct vb2_hash *metadata_hash, enum cbfs_walk_flags flags);
+
 /*
  * Helper function that can be used by a |walker| callback to cbfs_walk() to copy the metadata
  * of a file into a permanent buffer. Will copy the |already_read| metadata from |src| into
@@ -101,7 +114,9 @@ cb_err_t cbfs_lookup(cbfs_dev_t dev, const char *name, union cbfs_mdata *mdata_o
 #define CBFS_MCACHE_ALIGNMENT	sizeof(uint32_t)	/* Largest data type used in CBFS */
 
 /* Build an in-memory CBFS metadata cache out of the CBFS on |dev| into a |mcache_size| bytes
- * memory area at |mcache|. Also verify |metadata_hash| unless it is NULL. If this returns
+ * memory area at |mcache|. If the CBFS starts with a metadata directory, the cache is filled
+ * from it with a single read instead of walking all file headers. Also verify |metadata_hash|
+ * unless it is NULL. If this returns
  * CB_CBFS_CACHE_FULL, the mcache is still valid and can be used, but lookups may return
  * CB_CBFS_CACHE_FULL for files that didn't fit to indicate that the caller needs to fall back
  * to cbfs_lookup(). */
@@ -20,6 +20,7 @@ enum cbfs_type {
 	CBFS_TYPE_NULL		= 0xffffffff,
 	CBFS_TYPE_BOOTBLOCK	= 0x01,
 	CBFS_TYPE_CBFSHEADER	= 0x02,
+	CBFS_TYPE_METADATA_DIR	= 0x03,
 	CBFS_TYPE_LEGACY_STAGE	= 0x10,
 	CBFS_TYPE_STAGE		= 0x11,
 	CBFS_TYPE_SELF		= 0x20,
@@ -171,6 +172,30 @@ struct cbfs_file_attr_stageheader {
 } __packed;
 
 
+/*
+ * A metadata directory is an optional file of type CBFS_TYPE_METADATA_DIR that, if present,
+ * must be the very first file in a CBFS. Its data starts with a struct cbfs_mdir_header
+ * followed by a copy of the metadata (header, filename and attributes, exactly as stored in
+ * flash) of every non-empty file after it, in flash order, up to |end_offset|. In each copy the
+ * 8-byte file magic is replaced by the big-endian offset of the file header in the CBFS and
+ * four zero bytes, and each copy is padded to a multiple of CBFS_MDIR_ALIGN bytes.
+ *
+ * Readers that don't know about the directory just see another file. Readers that do can load
+ * all metadata in one read and only need to walk file headers from |end_offset| onwards. Since
+ * the copies reproduce the original metadata byte for byte, hashing them yields the same
+ * metadata hash as a normal walk, so the directory is verified like the files themselves.
+ */
+#define CBFS_MDIR_MAGIC		0x5249444d	/* BE: 'MDIR' */
+#define CBFS_MDIR_ALIGN		4
+#define CBFS_MDIR_NAME		"cbfs metadata directory"
+
+struct cbfs_mdir_header {
+	uint32_t magic;
+	uint32_t count;		/* Number of metadata copies that follow. */
+	uint32_t size;		/* Total length of the copies in bytes. */
+	uint32_t end_offset;	/* First CBFS offset not described by the directory. */
+} __packed;
+
 /*** Component sub-headers ***/
 
 /* Following are component sub-headers for the "standard"
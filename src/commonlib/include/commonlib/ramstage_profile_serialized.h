@@ -0,0 +1,23 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef __RAMSTAGE_PROFILE_SERIALIZED_H__
+#define __RAMSTAGE_PROFILE_SERIALIZED_H__
+
+#include <stdint.h>
+
+/*
+ * Instruction pointers sampled by the ramstage profiler. The samples are a ring buffer,
+ * num_samples counts all samples taken since the profiler started and the next one goes to
+ * samples[num_samples % max_samples]. program_base is the address ramstage's _program symbol
+ * was loaded at, so the samples can be symbolized against a relocated ramstage.debug.
+ */
+struct ramstage_profile {
+	uint32_t	max_samples;
+	uint32_t	num_samples;
+	uint32_t	frequency;	/* Samples per second */
+	uint32_t	reserved;
+	uint64_t	program_base;
+	uint64_t	samples[0]; /* Variable number of samples */
+} __packed;
+
+#endif
@@ -37,6 +37,7 @@ struct mmc_command {
 #define MMC_CMD_SET_BLOCKLEN		16
 #define MMC_CMD_READ_SINGLE_BLOCK	17
 #define MMC_CMD_READ_MULTIPLE_BLOCK	18
+#define MMC_CMD_SET_BLOCK_COUNT		23
 #define MMC_CMD_WRITE_SINGLE_BLOCK	24
 #define MMC_CMD_WRITE_MULTIPLE_BLOCK	25
 #define MMC_CMD_APP_CMD			55
@@ -92,12 +93,14 @@ struct mmc_command {
 	uint32_t flags;
 
 #define CMD_FLAG_IGNORE_INHIBIT	1
+#define CMD_FLAG_PREDEFINED_COUNT	2	/* Block count set by CMD23 */
 };
 
 #define SD_SWITCH_CHECK		0
 #define SD_SWITCH_SWITCH	1
 
 #define SD_DATA_4BIT		0x00040000
+#define SD_CMD23_SUPPORTED	0x00000002
 
 /* SCR definitions in different words */
 #define SD_HIGHSPEED_BUSY	0x00020000
@@ -124,6 +127,10 @@ struct sd_mmc_ctrlr {
 	void (*tuning_start)(struct sd_mmc_ctrlr *ctrlr, int retune);
 	int (*is_tuning_complete)(struct sd_mmc_ctrlr *ctrlr, int *successful);
 
+	/* Optional: read back and reapply the sampling point found by tuning */
+	int (*get_tuning)(struct sd_mmc_ctrlr *ctrlr, uint32_t *tuning);
+	void (*set_tuning)(struct sd_mmc_ctrlr *ctrlr, uint32_t tuning);
+
 	int initialized;
 	unsigned int version;
 	uint32_t voltages;
@@ -181,6 +188,7 @@ struct sd_mmc_ctrlr {
 #define DRVR_CAP_REMOVABLE			0x00000200
 #define DRVR_CAP_DMA_64BIT			0x00000400
 #define DRVR_CAP_HS200_TUNING			0x00000800
+#define DRVR_CAP_CMD23				0x00001000
 
 	uint32_t b_max;
 	uint32_t timing;
@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef __SMI_PROFILE_SERIALIZED_H__
+#define __SMI_PROFILE_SERIALIZED_H__
+
+#include <stdint.h>
+
+/* What caused the SMI, as far as the handlers that ran know. */
+enum smi_profile_source {
+	SMI_PROFILE_SRC_APMC		= 1 << 0,
+	SMI_PROFILE_SRC_SLEEP		= 1 << 1,
+	SMI_PROFILE_SRC_PM1		= 1 << 2,
+	SMI_PROFILE_SRC_GPE0		= 1 << 3,
+	SMI_PROFILE_SRC_GPI		= 1 << 4,
+	SMI_PROFILE_SRC_TCO		= 1 << 5,
+	SMI_PROFILE_SRC_PERIODIC	= 1 << 6,
+	SMI_PROFILE_SRC_ESPI		= 1 << 7,
+	SMI_PROFILE_SRC_IO_TRAP		= 1 << 8,
+	SMI_PROFILE_SRC_SMMSTORE	= 1 << 9,
+	SMI_PROFILE_SRC_GSMI		= 1 << 10,
+};
+
+struct smi_profile_entry {
+	uint64_t	entry_tsc;
+	uint64_t	exit_tsc;
+	uint32_t	sources;	/* enum smi_profile_source */
+	uint32_t	handlers;	/* Chipset specific, e.g. the SMI_STS bits handled */
+	uint8_t		cpu;
+	uint8_t		apmc;		/* APMC command if SMI_PROFILE_SRC_APMC is set */
+	uint16_t	reserved;
+} __packed;
+
+/*
+ * The entries are a ring buffer. num_entries counts all SMIs recorded since boot, the next one
+ * goes to entries[num_entries % max_entries].
+ */
+struct smi_profile_log {
+	uint32_t	max_entries;
+	uint32_t	num_entries;
+	uint16_t	tick_freq_mhz;
+	uint16_t	reserved;
+	struct smi_profile_entry entries[0]; /* Variable number of entries */
+} __packed;
+
+#endif
@@ -54,6 +54,10 @@ enum timestamp_id {
 	TS_END_POSTCAR = 101,
 	TS_DELAY_START = 110,
 	TS_DELAY_END = 111,
+	TS_MP_FLIGHT_PLAN_START = 112,
+	TS_MP_SMM_HANDLERS_LOADED = 113,
+	TS_MP_SMM_RELOCATION_DONE = 114,
+	TS_MP_CPU_INIT_DONE = 115,
 
 	/* 500+ reserved for vendorcode extensions (500-600: google/chromeos) */
 	TS_START_COPYVER = 501,
@@ -191,6 +195,10 @@ static const struct timestamp_id_to_name {
 	{ TS_SELFBOOT_JUMP,	"selfboot jump" },
 	{ TS_DELAY_START,	"Forced delay start" },
 	{ TS_DELAY_END,		"Forced delay end" },
+	{ TS_MP_FLIGHT_PLAN_START, "starting MP flight plan" },
+	{ TS_MP_SMM_HANDLERS_LOADED, "MP: SMM handlers loaded" },
+	{ TS_MP_SMM_RELOCATION_DONE, "MP: SMM relocated on all CPUs" },
+	{ TS_MP_CPU_INIT_DONE,	"MP: all CPUs initialized" },
 
 	{ TS_START_COPYVER,	"starting to load verstage" },
 	{ TS_END_COPYVER,	"finished loading verstage" },
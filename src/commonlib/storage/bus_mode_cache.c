@@ -0,0 +1,151 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Cache of the bus modes negotiated with SD/MMC devices.  The most recently
+ * used devices are kept in a region_file, each entry keyed by the CID of the
+ * device and the capabilities of the controller it was negotiated on.
+ */
+
+#include <commonlib/storage.h>
+#include <fmap.h>
+#include <ip_checksum.h>
+#include <region_file.h>
+#include "sd_mmc.h"
+#include "storage.h"
+#include <string.h>
+
+#define BUS_MODE_CACHE_SIGNATURE	0x43424453	/* 'SDBC' */
+#define BUS_MODE_CACHE_ENTRIES		4
+
+struct bus_mode_cache {
+	uint32_t signature;
+	uint32_t checksum;
+	struct storage_bus_mode entries[BUS_MODE_CACHE_ENTRIES];
+};
+
+static uint32_t bus_mode_cache_checksum(const struct bus_mode_cache *cache)
+{
+	return compute_ip_checksum(cache->entries, sizeof(cache->entries));
+}
+
+static int bus_mode_cache_open(struct region_file *file,
+	struct region_device *backing)
+{
+	const char *name = CONFIG_STORAGE_BUS_MODE_CACHE_REGION;
+
+	if (fmap_locate_area_as_rdev_rw(name, backing) < 0) {
+		sd_mmc_error("Bus mode cache region '%s' not found\n", name);
+		return -1;
+	}
+
+	if (region_file_init(file, backing) < 0) {
+		sd_mmc_error("Bus mode cache region '%s' invalid\n", name);
+		return -1;
+	}
+	return 0;
+}
+
+static int bus_mode_cache_read(const struct region_file *file,
+	struct bus_mode_cache *cache)
+{
+	struct region_device rdev;
+
+	/* The region_file pads the data to its block size */
+	if (region_file_data(file, &rdev) < 0)
+		return -1;
+	if (region_device_sz(&rdev) < sizeof(*cache))
+		return -1;
+	if (rdev_readat(&rdev, cache, 0, sizeof(*cache)) != sizeof(*cache))
+		return -1;
+	if (cache->signature != BUS_MODE_CACHE_SIGNATURE)
+		return -1;
+	if (cache->checksum != bus_mode_cache_checksum(cache))
+		return -1;
+	return 0;
+}
+
+static int bus_mode_cache_find(const struct bus_mode_cache *cache,
+	const uint32_t *cid)
+{
+	int index;
+
+	for (index = 0; index < BUS_MODE_CACHE_ENTRIES; index++) {
+		if (!memcmp(cache->entries[index].cid, cid,
+			sizeof(cache->entries[index].cid)))
+			return index;
+	}
+	return -1;
+}
+
+int storage_bus_mode_load(struct storage_media *media,
+	struct storage_bus_mode *mode)
+{
+	struct region_device backing;
+	struct bus_mode_cache cache;
+	struct region_file file;
+	int index;
+
+	if (bus_mode_cache_open(&file, &backing))
+		return -1;
+	if (bus_mode_cache_read(&file, &cache))
+		return -1;
+
+	index = bus_mode_cache_find(&cache, media->cid);
+	if (index < 0)
+		return -1;
+
+	/* A different controller configuration needs a fresh negotiation */
+	if (cache.entries[index].ctrlr_caps != media->ctrlr->caps)
+		return -1;
+
+	memcpy(mode, &cache.entries[index], sizeof(*mode));
+	return 0;
+}
+
+void storage_bus_mode_save(struct storage_media *media)
+{
+	struct region_device backing;
+	struct bus_mode_cache cache;
+	struct sd_mmc_ctrlr *ctrlr = media->ctrlr;
+	struct region_file file;
+	struct storage_bus_mode mode;
+	int index;
+
+	memset(&mode, 0, sizeof(mode));
+	memcpy(mode.cid, media->cid, sizeof(mode.cid));
+	mode.ctrlr_caps = ctrlr->caps;
+	mode.version = media->version;
+	mode.caps = media->caps;
+	mode.bus_width = ctrlr->bus_width;
+	mode.timing = ctrlr->timing;
+	mode.request_hz = ctrlr->request_hz;
+
+	/* Only save the tuning result if it can be applied again */
+	if ((ctrlr->timing == BUS_TIMING_MMC_HS200) && ctrlr->get_tuning
+		&& ctrlr->set_tuning && !ctrlr->get_tuning(ctrlr, &mode.tuning))
+		mode.flags |= STORAGE_BUS_MODE_TUNED;
+
+	if (bus_mode_cache_open(&file, &backing))
+		return;
+	if (bus_mode_cache_read(&file, &cache))
+		memset(&cache, 0, sizeof(cache));
+
+	/* Avoid flash writes when nothing has changed */
+	index = bus_mode_cache_find(&cache, media->cid);
+	if ((index >= 0) && !memcmp(&cache.entries[index], &mode, sizeof(mode)))
+		return;
+
+	/* Move the device to the front, dropping the least recently used */
+	if (index < 0)
+		index = BUS_MODE_CACHE_ENTRIES - 1;
+	memmove(&cache.entries[1], &cache.entries[0],
+		index * sizeof(cache.entries[0]));
+	cache.entries[0] = mode;
+	cache.signature = BUS_MODE_CACHE_SIGNATURE;
+	cache.checksum = bus_mode_cache_checksum(&cache);
+
+	if (region_file_update_data(&file, &cache, sizeof(cache)) < 0)
+		sd_mmc_error("Failed to update the bus mode cache\n");
+	else
+		sd_mmc_debug("Saved bus mode: timing %d, %d-bit, %d Hz\n",
+			mode.timing, mode.bus_width, mode.request_hz);
+}
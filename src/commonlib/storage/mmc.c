@@ -270,7 +270,8 @@ static int mmc_select_hs400(struct storage_media *media)
 	return ret;
 }
 
-static int mmc_select_hs200(struct storage_media *media)
+static int mmc_select_hs200(struct storage_media *media,
+	const struct storage_bus_mode *mode)
 {
 	struct sd_mmc_ctrlr *ctrlr = media->ctrlr;
 	int ret;
@@ -300,9 +301,14 @@ static int mmc_select_hs200(struct storage_media *media)
 	media->caps |= DRVR_CAP_HS200 | DRVR_CAP_HS52 | DRVR_CAP_HS;
 	mmc_recalculate_clock(media);
 
-	/* Tune the receive sampling point for the bus */
-	if ((!ret) && (ctrlr->caps & DRVR_CAP_HS200_TUNING))
-		ret = mmc_bus_tuning(media);
+	/* Tune the receive sampling point for the bus, or reuse the saved one */
+	if ((!ret) && (ctrlr->caps & DRVR_CAP_HS200_TUNING)) {
+		if (mode && (mode->flags & STORAGE_BUS_MODE_TUNED)
+		    && ctrlr->set_tuning)
+			ctrlr->set_tuning(ctrlr, mode->tuning);
+		else
+			ret = mmc_bus_tuning(media);
+	}
 	return ret;
 }
 
@@ -322,6 +328,9 @@ int mmc_change_freq(struct storage_media *media)
 	if (err)
 		return err;
 
+	/* Version 4 devices support predefined multiple block transfers */
+	media->caps |= DRVR_CAP_CMD23;
+
 	/* Determine if the device supports enhanced strobe */
 	media->caps |= ext_csd[EXT_CSD_STROBE_SUPPORT]
 		? DRVR_CAP_ENHANCED_STROBE : 0;
@@ -331,13 +340,54 @@ int mmc_change_freq(struct storage_media *media)
 		err = mmc_select_hs400(media);
 	else if ((ctrlr->caps & DRVR_CAP_HS200) &&
 		 (ext_csd[EXT_CSD_CARD_TYPE] & MMC_HS_200MHZ))
-		err = mmc_select_hs200(media);
+		err = mmc_select_hs200(media, NULL);
 	else
 		err = mmc_select_hs(media);
 
 	return err;
 }
 
+int mmc_restore_bus_mode(struct storage_media *media,
+	const struct storage_bus_mode *mode)
+{
+	struct sd_mmc_ctrlr *ctrlr = media->ctrlr;
+	int err;
+
+	/* Repeat the switches made by mmc_change_freq without probing */
+	media->caps = mode->caps & DRVR_CAP_ENHANCED_STROBE;
+	switch (mode->timing) {
+	case BUS_TIMING_MMC_HS400:
+	case BUS_TIMING_MMC_HS400ES:
+		err = mmc_select_hs400(media);
+		break;
+	case BUS_TIMING_MMC_HS200:
+		err = mmc_select_hs200(media, mode);
+		break;
+	case BUS_TIMING_MMC_HS:
+		err = mmc_select_hs(media);
+		break;
+	case BUS_TIMING_LEGACY:
+		err = 0;
+		break;
+	default:
+		return -1;
+	}
+	if (err)
+		return err;
+
+	/* HS200 and HS400 have already switched the bus to 8 bits */
+	if ((mode->timing == BUS_TIMING_MMC_HS)
+		|| (mode->timing == BUS_TIMING_LEGACY)) {
+		err = mmc_switch(media, EXT_CSD_BUS_WIDTH, mode->bus_width / 4);
+		if (err)
+			return err;
+		SET_BUS_WIDTH(ctrlr, mode->bus_width);
+	}
+
+	media->caps = mode->caps;
+	return 0;
+}
+
 int mmc_set_bus_width(struct storage_media *media)
 {
 	struct sd_mmc_ctrlr *ctrlr = media->ctrlr;
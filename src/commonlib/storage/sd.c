@@ -117,9 +117,38 @@ static void sd_recalculate_clock(struct storage_media *media)
 	SET_CLOCK(media->ctrlr, clock);
 }
 
-int sd_change_freq(struct storage_media *media)
+static int sd_select_hs(struct storage_media *media, uint32_t *switch_status)
 {
 	int delay;
+	int err;
+	struct sd_mmc_ctrlr *ctrlr = media->ctrlr;
+
+	/* Give the card time to recover after the switch operation.  Wait for
+	 * 9 (>= 8) clock cycles receiving the switch status.
+	 */
+	delay = (9000000 + ctrlr->bus_hz - 1) / ctrlr->bus_hz;
+	udelay(delay);
+
+	/* Switch to high speed */
+	err = sd_switch(ctrlr, SD_SWITCH_SWITCH, 0, 1,
+			(uint8_t *)switch_status);
+	if (err)
+		return err;
+
+	/* Give the card time to perform the switch operation.  Wait for 9
+	 * (>= 8) clock cycles receiving the switch status.
+	 */
+	udelay(delay);
+
+	if ((ntohl(switch_status[4]) & 0x0f000000) == 0x01000000) {
+		media->caps |= DRVR_CAP_HS;
+		SET_TIMING(ctrlr, BUS_TIMING_SD_HS);
+	}
+	return 0;
+}
+
+int sd_change_freq(struct storage_media *media)
+{
 	int err, timeout;
 	struct mmc_command cmd;
 	struct sd_mmc_ctrlr *ctrlr = media->ctrlr;
@@ -179,6 +208,8 @@ int sd_change_freq(struct storage_media *media)
 
 	if (media->scr[0] & SD_DATA_4BIT)
 		media->caps |= DRVR_CAP_4BIT;
+	if (media->scr[0] & SD_CMD23_SUPPORTED)
+		media->caps |= DRVR_CAP_CMD23;
 
 	/* Version 1.0 doesn't support switching */
 	if (media->version == SD_VERSION_1_0)
@@ -209,31 +240,35 @@ int sd_change_freq(struct storage_media *media)
 	if (!((ctrlr->caps & DRVR_CAP_HS52) && (ctrlr->caps & DRVR_CAP_HS)))
 		goto out;
 
-	/* Give the card time to recover after the switch operation.  Wait for
-	 * 9 (>= 8) clock cycles receiving the switch status.
-	 */
-	delay = (9000000 + ctrlr->bus_hz - 1) / ctrlr->bus_hz;
-	udelay(delay);
-
-	/* Switch to high speed */
-	err = sd_switch(ctrlr, SD_SWITCH_SWITCH, 0, 1,
-			(uint8_t *)switch_status);
+	err = sd_select_hs(media, switch_status);
 	if (err)
 		return err;
 
-	/* Give the card time to perform the switch operation.  Wait for 9
-	 * (>= 8) clock cycles receiving the switch status.
-	 */
-	udelay(delay);
+out:
+	sd_recalculate_clock(media);
+	return 0;
+}
 
-	if ((ntohl(switch_status[4]) & 0x0f000000) == 0x01000000) {
-		media->caps |= DRVR_CAP_HS;
-		SET_TIMING(ctrlr, BUS_TIMING_SD_HS);
+int sd_restore_bus_mode(struct storage_media *media,
+	const struct storage_bus_mode *mode)
+{
+	int err;
+	ALLOC_CACHE_ALIGN_BUFFER(uint32_t, switch_status, 16);
+
+	/* Repeat the switch made by sd_change_freq without reading the SCR */
+	media->caps = 0;
+	media->version = mode->version;
+	if (mode->caps & DRVR_CAP_HS) {
+		err = sd_select_hs(media, switch_status);
+		if (err)
+			return err;
+		if (!(media->caps & DRVR_CAP_HS))
+			return CARD_COMM_ERR;
 	}
 
-out:
+	media->caps = mode->caps;
 	sd_recalculate_clock(media);
-	return 0;
+	return sd_set_bus_width(media);
 }
 
 int sd_set_bus_width(struct storage_media *media)
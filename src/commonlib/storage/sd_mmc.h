@@ -10,6 +10,8 @@
 
 #define SD_MMC_IO_RETRIES	1000
 
+struct storage_bus_mode;
+
 #define IS_SD(x)		(x->version & SD_VERSION_SD)
 
 #define SET_BUS_WIDTH(ctrlr, width)		\
@@ -48,12 +50,16 @@ int mmc_send_op_cond(struct storage_media *media);
 int mmc_set_bus_width(struct storage_media *media);
 int mmc_set_partition(struct storage_media *media,
 	unsigned int partition_number);
+int mmc_restore_bus_mode(struct storage_media *media,
+	const struct storage_bus_mode *mode);
 int mmc_update_capacity(struct storage_media *media);
 
 /* SD card support routines */
 int sd_change_freq(struct storage_media *media);
 const char *sd_partition_name(struct storage_media *media,
 	unsigned int partition_number);
+int sd_restore_bus_mode(struct storage_media *media,
+	const struct storage_bus_mode *mode);
 int sd_send_if_cond(struct storage_media *media);
 int sd_send_op_cond(struct storage_media *media);
 int sd_set_bus_width(struct storage_media *media);
@@ -180,14 +180,21 @@ static int sdhci_send_command_bounced(struct sd_mmc_ctrlr *ctrlr,
 		if (data->flags == DATA_FLAG_READ)
 			mode |= SDHCI_TRNS_READ;
 
-		if (data->blocks > 1)
-			mode |= SDHCI_TRNS_BLK_CNT_EN |
-				SDHCI_TRNS_MULTI | SDHCI_TRNS_ACMD12;
+		/* No CMD12 is needed when CMD23 announced the block count */
+		if (data->blocks > 1) {
+			mode |= SDHCI_TRNS_BLK_CNT_EN | SDHCI_TRNS_MULTI;
+			if (!(cmd->flags & CMD_FLAG_PREDEFINED_COUNT))
+				mode |= SDHCI_TRNS_ACMD12;
+		}
 
 		sdhci_writew(sdhci_ctrlr, data->blocks, SDHCI_BLOCK_COUNT);
 
+		/* Transfer directly to or from the caller's buffer using ADMA2,
+		 * falling back to PIO when the buffer is not suitable.
+		 */
 		if (DMA_AVAILABLE && (ctrlr->caps & DRVR_CAP_AUTO_CMD12)
-			&& (cmd->cmdidx != MMC_CMD_AUTO_TUNING_SEQUENCE)) {
+			&& (cmd->cmdidx != MMC_CMD_AUTO_TUNING_SEQUENCE)
+			&& sdhci_can_adma(sdhci_ctrlr, data)) {
 			if (sdhci_setup_adma(sdhci_ctrlr, data))
 				return -1;
 			mode |= SDHCI_TRNS_DMA;
@@ -664,6 +671,9 @@ static int sdhci_pre_init(struct sdhci_ctrlr *sdhci_ctrlr)
 	/* Determine the controller's DMA support */
 	if (caps & SDHCI_CAN_DO_ADMA2)
 		ctrlr->caps |= DRVR_CAP_AUTO_CMD12;
+	if (CONFIG(SDHCI_CMD23) && ((ctrlr->version & SDHCI_SPEC_VER_MASK)
+		>= SDHCI_SPEC_300))
+		ctrlr->caps |= DRVR_CAP_CMD23;
 	if (DMA_AVAILABLE && (caps & SDHCI_CAN_64BIT))
 		ctrlr->caps |= DRVR_CAP_DMA_64BIT;
 
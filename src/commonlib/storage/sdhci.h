@@ -188,6 +188,7 @@
 /* 55-57 reserved */
 
 #define SDHCI_ADMA_ADDRESS	0x58
+#define SDHCI_ADMA_ADDRESS_HI	0x5C
 
 /* 60-FB reserved */
 
@@ -259,6 +260,7 @@ static inline u8 sdhci_readb(struct sdhci_ctrlr *sdhci_ctrlr, int reg)
 
 void sdhci_reset(struct sdhci_ctrlr *sdhci_ctrlr, u8 mask);
 void sdhci_cmd_done(struct sdhci_ctrlr *sdhci_ctrlr, struct mmc_command *cmd);
+int sdhci_can_adma(struct sdhci_ctrlr *sdhci_ctrlr, struct mmc_data *data);
 int sdhci_setup_adma(struct sdhci_ctrlr *sdhci_ctrlr, struct mmc_data *data);
 int sdhci_complete_adma(struct sdhci_ctrlr *sdhci_ctrlr,
 	struct mmc_command *cmd);
@@ -3,6 +3,7 @@
  * Secure Digital (SD) Host Controller interface DMA support code
  */
 
+#include <commonlib/helpers.h>
 #include <commonlib/sdhci.h>
 #include <commonlib/storage.h>
 #include <console/console.h>
@@ -66,6 +67,19 @@ static void sdhci_alloc_adma64_descs(struct sdhci_ctrlr *sdhci_ctrlr,
 		* need_descriptors);
 }
 
+int sdhci_can_adma(struct sdhci_ctrlr *sdhci_ctrlr, struct mmc_data *data)
+{
+	uint64_t start = (uintptr_t)data->dest;
+	uint64_t end = start + data->blocks * data->blocksize;
+
+	/* Descriptors must point at 32-bit (ADMA64: 64-bit) aligned data */
+	if (sdhci_ctrlr->sd_mmc_ctrlr.caps & DRVR_CAP_DMA_64BIT)
+		return IS_ALIGNED(start, sizeof(uint64_t));
+
+	/* Without ADMA64 the data must also be below 4 GiB */
+	return IS_ALIGNED(start, sizeof(uint32_t)) && (end <= 4ULL * GiB);
+}
+
 int sdhci_setup_adma(struct sdhci_ctrlr *sdhci_ctrlr, struct mmc_data *data)
 {
 	int i, togo, need_descriptors;
@@ -105,7 +119,8 @@ int sdhci_setup_adma(struct sdhci_ctrlr *sdhci_ctrlr, struct mmc_data *data)
 		if (dma64) {
 			sdhci_ctrlr->adma64_descs[i].addr =
 				(uintptr_t)buffer_data;
-			sdhci_ctrlr->adma64_descs[i].addr_hi = 0;
+			sdhci_ctrlr->adma64_descs[i].addr_hi =
+				(uint64_t)(uintptr_t)buffer_data >> 32;
 			sdhci_ctrlr->adma64_descs[i].length = desc_length;
 			sdhci_ctrlr->adma64_descs[i].attributes = attributes;
 
@@ -119,10 +134,13 @@ int sdhci_setup_adma(struct sdhci_ctrlr *sdhci_ctrlr, struct mmc_data *data)
 		buffer_data += desc_length;
 	}
 
-	if (dma64)
+	if (dma64) {
 		sdhci_writel(sdhci_ctrlr, (uintptr_t) sdhci_ctrlr->adma64_descs,
 			     SDHCI_ADMA_ADDRESS);
-	else
+		sdhci_writel(sdhci_ctrlr,
+			     (uint64_t)(uintptr_t)sdhci_ctrlr->adma64_descs >> 32,
+			     SDHCI_ADMA_ADDRESS_HI);
+	} else
 		sdhci_writel(sdhci_ctrlr, (uintptr_t) sdhci_ctrlr->adma_descs,
 			     SDHCI_ADMA_ADDRESS);
 
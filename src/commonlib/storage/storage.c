@@ -10,6 +10,7 @@
 #include "sd_mmc.h"
 #include "storage.h"
 #include <string.h>
+#include <timer.h>
 
 #define DECIMAL_CAPACITY_MULTIPLIER	1000ULL
 #define HEX_CAPACITY_MULTIPLIER		1024ULL
@@ -118,9 +119,8 @@ void storage_display_setup(struct storage_media *media)
 	}
 }
 
-int storage_startup(struct storage_media *media)
+static int storage_select_card(struct storage_media *media)
 {
-	int err;
 	uint64_t capacity;
 	uint64_t cmult, csize;
 	struct mmc_command cmd;
@@ -154,7 +154,15 @@ int storage_startup(struct storage_media *media)
 	cmd.resp_type = CARD_RSP_R1;
 	cmd.cmdarg = media->rca << 16;
 	cmd.flags = 0;
-	err = ctrlr->send_cmd(ctrlr, &cmd, NULL);
+	return ctrlr->send_cmd(ctrlr, &cmd, NULL);
+}
+
+int storage_startup(struct storage_media *media)
+{
+	int err;
+	struct sd_mmc_ctrlr *ctrlr = media->ctrlr;
+
+	err = storage_select_card(media);
 	if (err)
 		return err;
 
@@ -180,6 +188,45 @@ int storage_startup(struct storage_media *media)
 	if (err)
 		return err;
 
+	/* Remember the result for the next boot */
+	if (storage_bus_mode_cache_enabled())
+		storage_bus_mode_save(media);
+
+	/* Display the card setup */
+	storage_display_setup(media);
+	return 0;
+}
+
+static int storage_startup_cached(struct storage_media *media,
+	const struct storage_bus_mode *mode)
+{
+	int err;
+	struct sd_mmc_ctrlr *ctrlr = media->ctrlr;
+	ALLOC_CACHE_ALIGN_BUFFER(char, buffer, 512);
+
+	err = storage_select_card(media);
+	if (err)
+		return err;
+
+	/* Apply the saved bus mode */
+	if (CONFIG(COMMONLIB_STORAGE_SD) && IS_SD(media))
+		err = sd_restore_bus_mode(media, mode);
+	else if (CONFIG(COMMONLIB_STORAGE_MMC))
+		err = mmc_restore_bus_mode(media, mode);
+	else
+		err = -1;
+	if (err)
+		return err;
+	if (ctrlr->request_hz != mode->request_hz)
+		SET_CLOCK(ctrlr, mode->request_hz);
+
+	/* Verify the data path with a single block read */
+	if (storage_block_read(media, 0, 1, buffer) != 1)
+		return CARD_COMM_ERR;
+
+	if (CONFIG(COMMONLIB_STORAGE_MMC) && !IS_SD(media))
+		mmc_update_capacity(media);
+
 	/* Display the card setup */
 	storage_display_setup(media);
 	return 0;
@@ -188,6 +235,7 @@ int storage_startup(struct storage_media *media)
 int storage_setup_media(struct storage_media *media, struct sd_mmc_ctrlr *ctrlr)
 {
 	int err;
+	struct storage_bus_mode mode;
 
 	memset(media, 0, sizeof(*media));
 	media->ctrlr = ctrlr;
@@ -195,6 +243,23 @@ int storage_setup_media(struct storage_media *media, struct sd_mmc_ctrlr *ctrlr)
 	err = sd_mmc_enter_standby(media);
 	if (err)
 		return err;
+
+	/* Skip the bus negotiation when this device was seen before */
+	if (storage_bus_mode_cache_enabled()
+		&& !storage_bus_mode_load(media, &mode)) {
+		if (!storage_startup_cached(media, &mode))
+			return 0;
+
+		/* Reset the device and fall back to a full negotiation */
+		sd_mmc_debug("Saved bus mode failed, renegotiating\n");
+		SET_TIMING(ctrlr, BUS_TIMING_LEGACY);
+		memset(media, 0, sizeof(*media));
+		media->ctrlr = ctrlr;
+
+		err = sd_mmc_enter_standby(media);
+		if (err)
+			return err;
+	}
 	return storage_startup(media);
 }
 
@@ -203,9 +268,27 @@ static int storage_read(struct storage_media *media, void *dest, uint32_t start,
 {
 	struct mmc_command cmd;
 	struct sd_mmc_ctrlr *ctrlr = media->ctrlr;
+	int predefined;
+
+	/*
+	 * Announce the transfer length with CMD23 when both the device and
+	 * the controller driver support it, the device then stops on its own
+	 * and no CMD12 needs to follow the data.
+	 */
+	predefined = (block_count > 1) && (block_count <= 0xffff)
+		&& (media->caps & DRVR_CAP_CMD23)
+		&& (ctrlr->caps & DRVR_CAP_CMD23);
+	if (predefined) {
+		cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+		cmd.resp_type = CARD_RSP_R1;
+		cmd.cmdarg = block_count;
+		cmd.flags = 0;
+		if (ctrlr->send_cmd(ctrlr, &cmd, NULL))
+			return 0;
+	}
 
 	cmd.resp_type = CARD_RSP_R1;
-	cmd.flags = 0;
+	cmd.flags = predefined ? CMD_FLAG_PREDEFINED_COUNT : 0;
 
 	if (block_count > 1)
 		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
@@ -226,7 +309,7 @@ static int storage_read(struct storage_media *media, void *dest, uint32_t start,
 	if (ctrlr->send_cmd(ctrlr, &cmd, &data))
 		return 0;
 
-	if ((block_count > 1) && !(ctrlr->caps
+	if ((block_count > 1) && !predefined && !(ctrlr->caps
 		& DRVR_CAP_AUTO_CMD12)) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
@@ -287,12 +370,15 @@ uint64_t storage_block_read(struct storage_media *media, uint64_t start,
 	uint64_t count, void *buffer)
 {
 	uint8_t *dest = (uint8_t *)buffer;
+	struct stopwatch sw;
 
 	if (storage_block_setup(media, start, count, 1) == 0)
 		return 0;
 
 	uint64_t todo = count;
 	struct sd_mmc_ctrlr *ctrlr = media->ctrlr;
+	if (CONFIG(SD_MMC_DEBUG))
+		stopwatch_init(&sw);
 	do {
 		uint32_t cur = (uint32_t)MIN(todo, ctrlr->b_max);
 		if (storage_read(media, dest, start, cur) != cur)
@@ -303,6 +389,16 @@ uint64_t storage_block_read(struct storage_media *media, uint64_t start,
 		start += cur;
 		dest += cur * media->read_bl_len;
 	} while (todo > 0);
+
+	/* Display the achieved read bandwidth */
+	if (CONFIG(SD_MMC_DEBUG)) {
+		uint64_t bytes = count * media->read_bl_len;
+		uint64_t usecs = MAX(stopwatch_duration_usecs(&sw), 1);
+		uint64_t kbps = bytes * 1000 / usecs;
+
+		sd_mmc_debug("Read %lld bytes in %lld usecs, %lld.%03lld MB/s\n",
+			bytes, usecs, kbps / 1000, kbps % 1000);
+	}
 	return count;
 }
 
@@ -17,6 +17,31 @@
 #define dcache_invalidate_by_mva(addr, len)
 #define dcache_clean_invalidate_by_mva(addr, len)
 
+/* Bus mode negotiated with a device, saved across boots */
+struct storage_bus_mode {
+	uint32_t cid[4];	/* Device the mode was negotiated with */
+	uint32_t ctrlr_caps;	/* Controller capabilities at the time */
+	uint32_t version;	/* media->version */
+	uint32_t caps;		/* media->caps */
+	uint32_t bus_width;	/* ctrlr->bus_width */
+	uint32_t timing;	/* ctrlr->timing */
+	uint32_t request_hz;	/* ctrlr->request_hz */
+	uint32_t tuning;	/* Only valid with STORAGE_BUS_MODE_TUNED */
+	uint32_t flags;
+
+#define STORAGE_BUS_MODE_TUNED		1
+};
+
+static inline int storage_bus_mode_cache_enabled(void)
+{
+	/* The cache lives in a region_file, available in romstage and later */
+	return CONFIG(STORAGE_BUS_MODE_CACHE) && (ENV_ROMSTAGE || ENV_RAMSTAGE);
+}
+
+int storage_bus_mode_load(struct storage_media *media,
+	struct storage_bus_mode *mode);
+void storage_bus_mode_save(struct storage_media *media);
+
 /* Storage support routines */
 int storage_startup(struct storage_media *media);
 int storage_block_setup(struct storage_media *media, uint64_t start,
@@ -25,9 +25,9 @@ void console_hw_init(void)
 	__system76_ec_init();
 }
 
-void console_tx_byte(unsigned char byte)
+/* Every console but the CBMEM console, which can take whole runs of bytes. */
+static void console_tx_byte_no_cbmemc(unsigned char byte)
 {
-	__cbmemc_tx_byte(byte);
 	__spkmodem_tx_byte(byte);
 	__qemu_debugcon_tx_byte(byte);
 
@@ -47,6 +47,21 @@ void console_tx_byte(unsigned char byte)
 	__system76_ec_tx_byte(byte);
 }
 
+void console_tx_byte(unsigned char byte)
+{
+	__cbmemc_tx_byte(byte);
+	console_tx_byte_no_cbmemc(byte);
+}
+
+void console_tx_bytes(const void *buf, size_t len)
+{
+	const unsigned char *bytes = buf;
+
+	__cbmemc_write(buf, len);
+	while (len--)
+		console_tx_byte_no_cbmemc(*bytes++);
+}
+
 void console_tx_flush(void)
 {
 	__uart_tx_flush();
@@ -65,8 +80,7 @@ void console_write_line(uint8_t *buffer, size_t number_of_bytes)
 	}
 
 	/* Output the console data */
-	while (number_of_bytes--)
-		console_tx_byte(*buffer++);
+	console_tx_bytes(buffer, number_of_bytes);
 }
 
 #if CONFIG(GDB_STUB) && (ENV_ROMSTAGE || ENV_RAMSTAGE)
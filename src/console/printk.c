@@ -59,14 +59,30 @@ void do_putchar(unsigned char byte)
 	console_time_stop();
 }
 
-static void wrap_putchar(unsigned char byte, void *data)
+/*
+ * Output is collected up to the end of each line, so that consoles that can
+ * take many bytes at once, such as CBMEM, get them that way.
+ */
+struct line_buffer {
+	void (*write)(const void *buf, size_t len);
+	size_t len;
+	unsigned char buf[64];
+};
+
+static void line_buffer_flush(struct line_buffer *lb)
 {
-	console_tx_byte(byte);
+	if (lb->len)
+		lb->write(lb->buf, lb->len);
+	lb->len = 0;
 }
 
-static void wrap_putchar_cbmemc(unsigned char byte, void *data)
+static void wrap_putchar(unsigned char byte, void *data)
 {
-	__cbmemc_tx_byte(byte);
+	struct line_buffer *lb = data;
+
+	lb->buf[lb->len++] = byte;
+	if (byte == '\n' || lb->len == sizeof(lb->buf))
+		line_buffer_flush(lb);
 }
 
 int vprintk(int msg_level, const char *fmt, va_list args)
@@ -85,9 +101,15 @@ int vprintk(int msg_level, const char *fmt, va_list args)
 	console_time_run();
 
 	if (log_this == CONSOLE_LOG_FAST) {
-		i = vtxprintf(wrap_putchar_cbmemc, fmt, args, NULL);
+		struct line_buffer lb = { .write = __cbmemc_write };
+
+		i = vtxprintf(wrap_putchar, fmt, args, &lb);
+		line_buffer_flush(&lb);
 	} else {
-		i = vtxprintf(wrap_putchar, fmt, args, NULL);
+		struct line_buffer lb = { .write = console_tx_bytes };
+
+		i = vtxprintf(wrap_putchar, fmt, args, &lb);
+		line_buffer_flush(&lb);
 		console_tx_flush();
 	}
 
@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <arch/exception.h>
 #include <cpu/cpu.h>
 #include <cpu/x86/lapic.h>
 #include <cpu/x86/lapic_def.h>
@@ -58,7 +59,11 @@ static void lapic_virtual_wire_mode_init(void)
 	lapic_update32(LAPIC_TASKPRI, ~LAPIC_TPRI_MASK, 0);
 
 	/* Put the local APIC in virtual wire mode */
-	lapic_update32(LAPIC_SPIV, ~LAPIC_VECTOR_MASK, LAPIC_SPIV_ENABLE);
+	if (ENV_RAMSTAGE && CONFIG(RAMSTAGE_PROFILER))
+		lapic_update32(LAPIC_SPIV, ~LAPIC_VECTOR_MASK,
+			       LAPIC_SPIV_ENABLE | PROFILER_SPURIOUS_VECTOR);
+	else
+		lapic_update32(LAPIC_SPIV, ~LAPIC_VECTOR_MASK, LAPIC_SPIV_ENABLE);
 
 	uint32_t mask = LAPIC_LVT_MASKED | LAPIC_LVT_LEVEL_TRIGGER | LAPIC_LVT_REMOTE_IRR |
 			LAPIC_INPUT_POLARITY | LAPIC_SEND_PENDING | LAPIC_LVT_RESERVED_1 |
@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <arch/cpu.h>
+#include <arch/exception.h>
+#include <arch/io.h>
+#include <cpu/x86/lapic.h>
+#include <cpu/x86/msr.h>
+#include <delay.h>
+#include <profiler.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <timer.h>
+
+/* The APIC timer has no architectural frequency, measure it over this long */
+#define CALIBRATE_USECS	1000
+
+/* Legacy PIC interrupt mask registers */
+#define MASTER_PIC_IMR	0x21
+#define SLAVE_PIC_IMR	0xa1
+
+static uint32_t timer_count;
+static uint8_t pic_imr[2];
+
+static bool interrupts_enabled(void)
+{
+	unsigned long eflags;
+
+	asm volatile ("pushf\n\tpop %0" : "=r" (eflags) :: "memory");
+	return eflags & X86_EFLAGS_IF;
+}
+
+int arch_profiler_init(unsigned int hz)
+{
+	uint64_t ticks;
+
+	if (!hz)
+		return -1;
+
+	/* The local APIC might not have been set up yet */
+	if (!(rdmsr(LAPIC_BASE_MSR).lo & LAPIC_BASE_MSR_ENABLE))
+		enable_lapic();
+	/* A spurious interrupt on the reset default vector 0xff would hit a missing IDT gate */
+	lapic_update32(LAPIC_SPIV, ~LAPIC_VECTOR_MASK,
+		       LAPIC_SPIV_ENABLE | PROFILER_SPURIOUS_VECTOR);
+
+	lapic_write(LAPIC_LVTT, LAPIC_LVT_MASKED);
+	lapic_write(LAPIC_TDCR, LAPIC_TDR_DIV_1);
+	lapic_write(LAPIC_TMICT, 0xffffffff);
+	udelay(CALIBRATE_USECS);
+	ticks = 0xffffffff - lapic_read(LAPIC_TMCCT);
+	lapic_write(LAPIC_TMICT, 0);
+
+	ticks = ticks * (USECS_PER_SEC / CALIBRATE_USECS) / hz;
+	if (!ticks || ticks > UINT32_MAX)
+		return -1;
+
+	timer_count = ticks;
+	return 0;
+}
+
+void arch_profiler_arm(void)
+{
+	/* Only the sampling timer may interrupt, ramstage has no other handlers */
+	pic_imr[0] = inb(MASTER_PIC_IMR);
+	pic_imr[1] = inb(SLAVE_PIC_IMR);
+	outb(0xff, MASTER_PIC_IMR);
+	outb(0xff, SLAVE_PIC_IMR);
+
+	lapic_write(LAPIC_LVTT, LAPIC_LVT_TIMER_PERIODIC | PROFILER_VECTOR);
+	lapic_write(LAPIC_TMICT, timer_count);
+	asm volatile ("sti" ::: "memory");
+}
+
+void arch_profiler_disarm(void)
+{
+	const unsigned int irr = LAPIC_IRR + (PROFILER_VECTOR / 32) * 0x10;
+
+	lapic_write(LAPIC_LVTT, LAPIC_LVT_MASKED);
+	lapic_write(LAPIC_TMICT, 0);
+
+	/*
+	 * Take a sample that is still pending, so it doesn't hit whoever enables interrupts next.
+	 * It can only be delivered with interrupts enabled, the caller may have disabled them.
+	 */
+	if (!interrupts_enabled())
+		asm volatile ("sti" ::: "memory");
+	while (lapic_read(irr) & (1 << (PROFILER_VECTOR % 32)))
+		;
+	asm volatile ("cli" ::: "memory");
+
+	outb(pic_imr[0], MASTER_PIC_IMR);
+	outb(pic_imr[1], SLAVE_PIC_IMR);
+}
@@ -24,6 +24,7 @@
 #include <smp/spinlock.h>
 #include <symbols.h>
 #include <timer.h>
+#include <timestamp.h>
 #include <thread.h>
 
 #include <security/intel/stm/SmmStm.h>
@@ -50,27 +51,53 @@ static char processor_name[49];
  *
  * Note that ap_call() and bsp_call() can be NULL. In the NULL case the
  * callback will just not be called.
+ *
+ * A record can also block the APs only until the BSP is done with bsp_call,
+ * without the BSP waiting for all APs to check in. Then each AP carries on as
+ * soon as it gets there, instead of when the slowest AP does.
+ *
+ * With MP_INIT_TIMING, ts_done is added to the timestamp table when the last
+ * CPU is done with the record.
  */
 struct mp_flight_record {
 	atomic_t barrier;
 	atomic_t cpus_entered;
 	void (*ap_call)(void);
 	void (*bsp_call)(void);
+	int bsp_waits;
+	enum timestamp_id ts_done;
 } __aligned(CACHELINE_SIZE);
 
-#define _MP_FLIGHT_RECORD(barrier_, ap_func_, bsp_func_) \
+#define _MP_FLIGHT_RECORD(barrier_, wait_, ap_func_, bsp_func_, ts_) \
 	{							\
 		.barrier = ATOMIC_INIT(barrier_),		\
 		.cpus_entered = ATOMIC_INIT(0),			\
 		.ap_call = ap_func_,				\
 		.bsp_call = bsp_func_,				\
+		.bsp_waits = wait_,				\
+		.ts_done = ts_,					\
 	}
 
-#define MP_FR_BLOCK_APS(ap_func_, bsp_func_) \
-	_MP_FLIGHT_RECORD(0, ap_func_, bsp_func_)
+#define MP_FR_BLOCK_APS(ap_func_, bsp_func_, ts_) \
+	_MP_FLIGHT_RECORD(0, 1, ap_func_, bsp_func_, ts_)
+
+#define MP_FR_NOBLOCK_APS(ap_func_, bsp_func_, ts_) \
+	_MP_FLIGHT_RECORD(1, 0, ap_func_, bsp_func_, ts_)
+
+#define MP_FR_BLOCK_APS_ON_BSP(ap_func_, bsp_func_, ts_) \
+	_MP_FLIGHT_RECORD(0, 0, ap_func_, bsp_func_, ts_)
+
+/* When each CPU got to a flight record, got past its barrier and was done. */
+struct mp_record_time {
+	uint64_t arrive;
+	uint64_t start;
+	uint64_t end;
+};
+
+#define MP_MAX_TIMED_RECORDS 8
 
-#define MP_FR_NOBLOCK_APS(ap_func_, bsp_func_) \
-	_MP_FLIGHT_RECORD(1, ap_func_, bsp_func_)
+static struct mp_record_time
+	mp_record_times[CONFIG(MP_INIT_TIMING) ? CONFIG_MAX_CPUS : 1][MP_MAX_TIMED_RECORDS];
 
 /* The mp_params structure provides the arguments to the mp subsystem
  * for bringing up APs. */
@@ -157,18 +184,39 @@ static int wait_for_aps(atomic_t *val, int target, int total_delay,
 	return timeout;
 }
 
+static struct mp_record_time *record_time(int record)
+{
+	const int cpu = cpu_index();
+
+	if (!CONFIG(MP_INIT_TIMING) || record >= MP_MAX_TIMED_RECORDS ||
+	    cpu < 0 || cpu >= CONFIG_MAX_CPUS)
+		return NULL;
+
+	return &mp_record_times[cpu][record];
+}
+
 static void ap_do_flight_plan(void)
 {
 	int i;
 
 	for (i = 0; i < mp_info.num_records; i++) {
 		struct mp_flight_record *rec = &mp_info.records[i];
+		struct mp_record_time *t = record_time(i);
+
+		if (t)
+			t->arrive = timestamp_get();
 
 		atomic_inc(&rec->cpus_entered);
 		barrier_wait(&rec->barrier);
 
+		if (t)
+			t->start = timestamp_get();
+
 		if (rec->ap_call != NULL)
 			rec->ap_call();
+
+		if (t)
+			t->end = timestamp_get();
 	}
 }
 
@@ -506,6 +554,59 @@ static int start_aps(struct bus *cpu_bus, int ap_count, atomic_t *num_aps)
 	return 0;
 }
 
+static uint64_t ticks_to_usecs(uint64_t ticks)
+{
+	const int mhz = timestamp_tick_freq_mhz();
+
+	return mhz > 0 ? ticks / mhz : ticks;
+}
+
+/*
+ * Summarize how long the CPUs waited at and spent in each record. The last
+ * record is left out, the APs may not be done with it.
+ */
+static void report_record_times(struct mp_params *mp_params)
+{
+	const int num_records = MIN(mp_params->num_records - 1, MP_MAX_TIMED_RECORDS);
+	const int num_cpus = MIN(mp_params->num_cpus, CONFIG_MAX_CPUS);
+	int i, cpu;
+
+	for (i = 0; i < num_records; i++) {
+		const struct mp_flight_record *rec = &mp_params->flight_plan[i];
+		uint64_t max_wait = 0, max_run = 0, total_run = 0, last_end = 0;
+		int max_wait_cpu = 0, max_run_cpu = 0;
+
+		for (cpu = 0; cpu < num_cpus; cpu++) {
+			const struct mp_record_time *t = &mp_record_times[cpu][i];
+			const uint64_t wait = t->start - t->arrive;
+			const uint64_t run = t->end - t->start;
+
+			printk(BIOS_SPEW, "MP record %d CPU %d: wait %llu us, run %llu us\n",
+			       i, cpu, ticks_to_usecs(wait), ticks_to_usecs(run));
+
+			if (wait > max_wait) {
+				max_wait = wait;
+				max_wait_cpu = cpu;
+			}
+			if (run > max_run) {
+				max_run = run;
+				max_run_cpu = cpu;
+			}
+			total_run += run;
+			last_end = MAX(last_end, t->end);
+		}
+
+		printk(BIOS_DEBUG, "MP record %d: wait max %llu us (CPU %d), "
+		       "run avg %llu us, max %llu us (CPU %d)\n", i,
+		       ticks_to_usecs(max_wait), max_wait_cpu,
+		       ticks_to_usecs(total_run / num_cpus), ticks_to_usecs(max_run),
+		       max_run_cpu);
+
+		if (rec->ts_done)
+			timestamp_add(rec->ts_done, last_end);
+	}
+}
+
 static int bsp_do_flight_plan(struct mp_params *mp_params)
 {
 	int i;
@@ -523,11 +624,18 @@ static int bsp_do_flight_plan(struct mp_params *mp_params)
 
 	stopwatch_init(&sw);
 
+	if (CONFIG(MP_INIT_TIMING))
+		timestamp_add_now(TS_MP_FLIGHT_PLAN_START);
+
 	for (i = 0; i < mp_params->num_records; i++) {
 		struct mp_flight_record *rec = &mp_params->flight_plan[i];
+		struct mp_record_time *t = record_time(i);
+
+		if (t)
+			t->arrive = timestamp_get();
 
 		/* Wait for APs if the record is not released. */
-		if (atomic_read(&rec->barrier) == 0) {
+		if (rec->bsp_waits) {
 			/* Wait for the APs to check in. */
 			if (wait_for_aps(&rec->cpus_entered, num_aps,
 					 timeout_us, step_us)) {
@@ -536,14 +644,25 @@ static int bsp_do_flight_plan(struct mp_params *mp_params)
 			}
 		}
 
+		if (t)
+			t->start = timestamp_get();
+
 		if (rec->bsp_call != NULL)
 			rec->bsp_call();
 
+		if (t)
+			t->end = timestamp_get();
+
 		release_barrier(&rec->barrier);
 	}
 
 	printk(BIOS_INFO, "%s done after %ld msecs.\n", __func__,
 	       stopwatch_duration_msecs(&sw));
+
+	/* The last record waits for all APs, so they are done with the others. */
+	if (CONFIG(MP_INIT_TIMING) && !ret)
+		report_record_times(mp_params);
+
 	return ret;
 }
 
@@ -1045,13 +1164,22 @@ int mp_park_aps(void)
 
 static struct mp_flight_record mp_steps[] = {
 	/* Once the APs are up load the SMM handlers. */
-	MP_FR_BLOCK_APS(NULL, load_smm_handlers),
+	MP_FR_BLOCK_APS(NULL, load_smm_handlers, TS_MP_SMM_HANDLERS_LOADED),
 	/* Perform SMM relocation. */
-	MP_FR_NOBLOCK_APS(trigger_smm_relocation, trigger_smm_relocation),
-	/* Initialize each CPU through the driver framework. */
-	MP_FR_BLOCK_APS(mp_initialize_cpu, mp_initialize_cpu),
+	MP_FR_NOBLOCK_APS(trigger_smm_relocation, trigger_smm_relocation,
+			  TS_MP_SMM_RELOCATION_DONE),
+	/*
+	 * Initialize each CPU through the driver framework. The BSP goes first, the APs
+	 * either all wait for each other's SMM relocation or each start right after
+	 * its own.
+	 */
+#if CONFIG(MP_INIT_AP_PIPELINE)
+	MP_FR_BLOCK_APS_ON_BSP(mp_initialize_cpu, mp_initialize_cpu, TS_MP_CPU_INIT_DONE),
+#else
+	MP_FR_BLOCK_APS(mp_initialize_cpu, mp_initialize_cpu, TS_MP_CPU_INIT_DONE),
+#endif
 	/* Wait for APs to finish then optionally start looking for work. */
-	MP_FR_BLOCK_APS(ap_wait_for_instruction, NULL),
+	MP_FR_BLOCK_APS(ap_wait_for_instruction, NULL, 0),
 };
 
 static size_t smm_stub_size(void)
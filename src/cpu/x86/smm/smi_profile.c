@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <cbmem.h>
+#include <commonlib/region.h>
+#include <cpu/x86/smi_profile.h>
+#include <cpu/x86/smm.h>
+#include <cpu/x86/tsc.h>
+#include <string.h>
+
+#define SMI_PROFILE_LOG_SIZE	(sizeof(struct smi_profile_log) + \
+				 CONFIG_SMI_PROFILE_ENTRIES * sizeof(struct smi_profile_entry))
+
+#if ENV_RAMSTAGE
+void *smi_profile_log_init(void)
+{
+	struct smi_profile_log *log;
+
+	/* SMM is loaded again on resume, and starts over with the log. */
+	log = cbmem_add(CBMEM_ID_SMI_PROFILE, SMI_PROFILE_LOG_SIZE);
+	if (!log)
+		return NULL;
+
+	memset(log, 0, SMI_PROFILE_LOG_SIZE);
+	log->max_entries = CONFIG_SMI_PROFILE_ENTRIES;
+	if (tsc_constant_rate())
+		log->tick_freq_mhz = tsc_freq_mhz();
+
+	return log;
+}
+#endif
+
+#if ENV_SMM
+/*
+ * The log is in memory the OS can write, so nothing is taken from it. Where the next entry
+ * goes is only kept in SMRAM.
+ */
+static struct smi_profile_log *profile_log;
+static uint32_t num_entries;
+static bool log_checked;
+static struct smi_profile_entry current;
+
+void smi_profile_start(int cpu, uint64_t entry_tsc, uintptr_t log)
+{
+	const struct region r = { .offset = log, .size = SMI_PROFILE_LOG_SIZE };
+
+	if (!log_checked) {
+		if (log && !smm_region_overlaps_handler(&r))
+			profile_log = (void *)log;
+		log_checked = true;
+	}
+
+	memset(&current, 0, sizeof(current));
+	current.entry_tsc = entry_tsc;
+	current.cpu = cpu;
+}
+
+void smi_profile_add_source(uint32_t source)
+{
+	current.sources |= source;
+}
+
+void smi_profile_set_apmc(uint8_t cmd)
+{
+	current.sources |= SMI_PROFILE_SRC_APMC;
+	current.apmc = cmd;
+}
+
+void smi_profile_set_handlers(uint32_t handlers)
+{
+	current.handlers |= handlers;
+}
+
+void smi_profile_end(void)
+{
+	if (!profile_log)
+		return;
+
+	current.exit_tsc = rdtscll();
+	memcpy(&profile_log->entries[num_entries % CONFIG_SMI_PROFILE_ENTRIES], &current,
+	       sizeof(current));
+	profile_log->num_entries = ++num_entries;
+}
+#endif
@@ -3,7 +3,9 @@
 #include <arch/io.h>
 #include <console/console.h>
 #include <commonlib/region.h>
+#include <cpu/x86/smi_profile.h>
 #include <cpu/x86/smm.h>
+#include <cpu/x86/tsc.h>
 #include <rmodule.h>
 
 #if CONFIG(SPI_FLASH_SMM)
@@ -55,6 +57,8 @@ void io_trap_handler(int smif)
 	 */
 	printk(BIOS_DEBUG, "SMI function trap 0x%x: ", smif);
 
+	smi_profile_add_source(SMI_PROFILE_SRC_IO_TRAP);
+
 	if (southbridge_io_trap_handler(smif))
 		return;
 
@@ -122,6 +126,7 @@ asmlinkage void smm_handler_start(void *arg)
 	int cpu;
 	uintptr_t actual_canary;
 	uintptr_t expected_canary;
+	uint64_t entry_tsc = CONFIG(SMI_PROFILE) ? rdtscll() : 0;
 
 	p = arg;
 	cpu = p->cpu;
@@ -148,6 +153,8 @@ asmlinkage void smm_handler_start(void *arg)
 		return;
 	}
 
+	smi_profile_start(cpu, entry_tsc, smm_runtime.smi_profile_ptr);
+
 	smi_backup_pci_address();
 
 	console_init();
@@ -179,6 +186,8 @@ asmlinkage void smm_handler_start(void *arg)
 			die("SMM Handler caused a stack overflow\n");
 	}
 
+	smi_profile_end();
+
 	smi_release_lock();
 
 	/* De-assert SMI# signal to allow another SMI */
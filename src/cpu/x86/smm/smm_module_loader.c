@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <rmodule.h>
+#include <cpu/x86/smi_profile.h>
 #include <cpu/x86/smm.h>
 #include <commonlib/helpers.h>
 #include <console/console.h>
@@ -578,6 +579,7 @@ int smm_load_module(void *smram, size_t size, struct smm_loader_params *params)
 	handler_mod_params->save_state_size = params->real_cpu_save_state_size;
 	handler_mod_params->num_cpus = params->num_concurrent_stacks;
 	handler_mod_params->gnvs_ptr = (uintptr_t)acpi_get_gnvs();
+	handler_mod_params->smi_profile_ptr = (uintptr_t)smi_profile_log_init();
 
 	printk(BIOS_DEBUG, "%s: smram_start: 0x%p\n",
 		 __func__, smram);
@@ -134,6 +134,27 @@ extern void X86API wrl(u32 addr, u32 val);
 typedef void (X86APIP X86EMU_intrFuncs)(int num);
 extern X86EMU_intrFuncs _X86EMU_intrTab[256];
 
+/****************************************************************************
+REMARKS:
+Execution statistics of the emulator, accumulated over all calls to
+X86EMU_exec() since the last X86EMU_resetStats().
+
+HEADER:
+x86emu.h
+
+MEMBERS:
+instructions             - Number of instructions executed
+code_cache_misses        - Code lines loaded into the instruction cache
+code_cache_invalidations - Cached code lines dropped because of writes
+code_cache_bypassed      - Instruction bytes fetched from uncached memory
+****************************************************************************/
+typedef struct {
+	unsigned long long	instructions;
+	unsigned long		code_cache_misses;
+	unsigned long		code_cache_invalidations;
+	unsigned long		code_cache_bypassed;
+	} X86EMU_stats;
+
 /*-------------------------- Function Prototypes --------------------------*/
 
 #ifdef  __cplusplus
@@ -151,6 +172,8 @@ void X86EMU_setMemBase(void *base, size_t size);
 
 void 	X86EMU_exec(void);
 void 	X86EMU_halt_sys(void);
+void 	X86EMU_getStats(X86EMU_stats *stats);
+void 	X86EMU_resetStats(void);
 
 #if CONFIG(X86EMU_DEBUG)
 #define	HALT_SYS()	\
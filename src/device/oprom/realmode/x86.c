@@ -10,6 +10,7 @@
 #include <device/pci_ids.h>
 #include <pc80/i8259.h>
 #include <pc80/i8254.h>
+#include <profiler.h>
 #include <string.h>
 #include <vbe.h>
 #include <framebuffer_info.h>
@@ -404,6 +405,9 @@ void run_bios(struct device *dev, unsigned long addr)
 {
 	u32 num_dev = (dev->bus->secondary << 8) | dev->path.pci.devfn;
 
+	/* The option ROM runs with its own interrupt vectors */
+	profiler_pause();
+
 	/* Setting up required hardware.
 	 * Removing this will cause random illegal instruction exceptions
 	 * in some option roms.
@@ -433,6 +437,8 @@ void run_bios(struct device *dev, unsigned long addr)
 	if ((dev->class >> 8)== PCI_CLASS_DISPLAY_VGA)
 		vbe_set_graphics();
 #endif
+
+	profiler_resume();
 }
 
 /* interrupt_handler() is called from assembler code only,
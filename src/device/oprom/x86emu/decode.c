@@ -53,6 +53,7 @@ static void x86emu_intr_handle(void)
         intno = M.x86.intno;
         if (_X86EMU_intrTab[intno]) {
             (*_X86EMU_intrTab[intno])(intno);
+            x86emu_code_cache_flush();
         } else {
             push_word((u16)M.x86.R_FLG);
             CLEAR_FLAG(F_IF);
@@ -83,6 +84,143 @@ void x86emu_intr_raise(
     M.x86.intr |= INTR_SYNCH;
 }
 
+static X86EMU_stats x86emu_stats;
+
+#if CONFIG(X86EMU_CODE_CACHE)
+
+/*
+ * Instruction bytes are fetched from a small direct mapped cache of code
+ * lines instead of going through (*sys_rdb) for every byte. Loops in option
+ * ROMs run many thousands of times, and every backend access has to check
+ * the address against the translated device ranges.
+ *
+ * Writes by the emulated code go through x86emu_code_cache_write(), which
+ * drops the lines they touch. Memory changed behind the emulator's back, by
+ * the application or its interrupt handlers, is covered by flushing the
+ * whole cache whenever control returns from there.
+ */
+#define CODE_LINE_SHIFT 6
+#define CODE_LINE_SIZE  (1 << CODE_LINE_SHIFT)
+#define CODE_LINES      256
+
+static struct {
+    u32 tag;                    /* line number + 1, 0 if invalid */
+    u8  data[CODE_LINE_SIZE];
+} code_cache[CODE_LINES];
+
+/* Video memory is never cached, neither is anything outside emulated RAM. */
+static int code_line_cacheable(u32 base)
+{
+    if (base >= 0xa0000 && base < 0xc0000)
+        return 0;
+    return base + CODE_LINE_SIZE <= M.mem_size;
+}
+
+static u8 fetch_code_byte(u32 addr)
+{
+    u32 line = addr >> CODE_LINE_SHIFT;
+    u32 base = line << CODE_LINE_SHIFT;
+    uint index = line % CODE_LINES;
+    uint i;
+
+    if (code_cache[index].tag != line + 1) {
+        if (!code_line_cacheable(base)) {
+            x86emu_stats.code_cache_bypassed++;
+            return (*sys_rdb)(addr);
+        }
+        for (i = 0; i < CODE_LINE_SIZE; i += 4) {
+            u32 val = (*sys_rdl)(base + i);
+
+            code_cache[index].data[i] = val;
+            code_cache[index].data[i + 1] = val >> 8;
+            code_cache[index].data[i + 2] = val >> 16;
+            code_cache[index].data[i + 3] = val >> 24;
+        }
+        code_cache[index].tag = line + 1;
+        x86emu_stats.code_cache_misses++;
+    }
+    return code_cache[index].data[addr & (CODE_LINE_SIZE - 1)];
+}
+
+static void code_cache_invalidate(u32 addr)
+{
+    u32 line = addr >> CODE_LINE_SHIFT;
+    uint index = line % CODE_LINES;
+
+    if (code_cache[index].tag == line + 1) {
+        code_cache[index].tag = 0;
+        x86emu_stats.code_cache_invalidations++;
+    }
+}
+
+/****************************************************************************
+PARAMETERS:
+addr    - Emulator memory address that was written
+size    - Number of bytes written
+
+REMARKS:
+Drops the cached code lines overlapping a write to emulator memory.
+****************************************************************************/
+void x86emu_code_cache_write(u32 addr, uint size)
+{
+    code_cache_invalidate(addr);
+    if ((addr ^ (addr + size - 1)) >> CODE_LINE_SHIFT)
+        code_cache_invalidate(addr + size - 1);
+}
+
+/****************************************************************************
+REMARKS:
+Drops all cached code lines.
+****************************************************************************/
+void x86emu_code_cache_flush(void)
+{
+    uint i;
+
+    for (i = 0; i < CODE_LINES; i++)
+        code_cache[i].tag = 0;
+}
+
+#else
+
+static u8 fetch_code_byte(u32 addr)
+{
+    return (*sys_rdb)(addr);
+}
+
+#endif /* CONFIG(X86EMU_CODE_CACHE) */
+
+/****************************************************************************
+RETURNS:
+Next instruction byte at CS:IP, IP is advanced past it.
+****************************************************************************/
+u8 fetch_code_next(void)
+{
+    return fetch_code_byte(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+}
+
+/****************************************************************************
+PARAMETERS:
+stats   - Filled with the statistics since the last X86EMU_resetStats()
+
+REMARKS:
+Returns execution statistics of the emulator.
+****************************************************************************/
+void X86EMU_getStats(X86EMU_stats *stats)
+{
+    *stats = x86emu_stats;
+}
+
+/****************************************************************************
+REMARKS:
+Clears the execution statistics of the emulator.
+****************************************************************************/
+void X86EMU_resetStats(void)
+{
+    static const X86EMU_stats empty;
+
+    x86emu_stats = empty;
+}
+
 /****************************************************************************
 REMARKS:
 Main execution loop for the emulator. We return from here when the system
@@ -95,6 +233,7 @@ void X86EMU_exec(void)
 
     M.x86.intr = 0;
     DB(x86emu_end_instr();)
+    x86emu_code_cache_flush();
 
     for (;;) {
 DB(     if (CHECK_IP_FETCH())
@@ -119,7 +258,8 @@ DB(             if (M.x86.R_SP != 0) {
                 x86emu_intr_handle();
             }
         }
-        op1 = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+        op1 = fetch_code_next();
+        x86emu_stats.instructions++;
         (*x86emu_optab[op1])(op1);
         //if (M.x86.debug & DEBUG_EXIT) {
         //    M.x86.debug &= ~DEBUG_EXIT;
@@ -158,7 +298,7 @@ void fetch_decode_modrm(
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+    fetched = fetch_code_next();
     INC_DECODED_INST_LEN(1);
     *mod  = (fetched >> 6) & 0x03;
     *regh = (fetched >> 3) & 0x07;
@@ -181,7 +321,7 @@ u8 fetch_byte_imm(void)
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+    fetched = fetch_code_next();
     INC_DECODED_INST_LEN(1);
     return fetched;
 }
@@ -202,8 +342,8 @@ u16 fetch_word_imm(void)
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdw)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
-    M.x86.R_IP += 2;
+    fetched = fetch_code_next();
+    fetched |= fetch_code_next() << 8;
     INC_DECODED_INST_LEN(2);
     return fetched;
 }
@@ -224,8 +364,10 @@ u32 fetch_long_imm(void)
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdl)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
-    M.x86.R_IP += 4;
+    fetched = fetch_code_next();
+    fetched |= fetch_code_next() << 8;
+    fetched |= fetch_code_next() << 16;
+    fetched |= (u32)fetch_code_next() << 24;
     INC_DECODED_INST_LEN(4);
     return fetched;
 }
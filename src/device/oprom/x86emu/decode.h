@@ -60,6 +60,7 @@ void    fetch_decode_modrm (int *mod,int *regh,int *regl);
 u8      fetch_byte_imm (void);
 u16     fetch_word_imm (void);
 u32     fetch_long_imm (void);
+u8      fetch_code_next (void);
 u8      fetch_data_byte (uint offset);
 u8      fetch_data_byte_abs (uint segment, uint offset);
 u16     fetch_data_word (uint offset);
@@ -81,6 +82,14 @@ unsigned int decode_rm01_address(int rm);
 unsigned int decode_rm10_address(int rm);
 unsigned int decode_rmXX_address(int mod, int rm);
 
+#if CONFIG(X86EMU_CODE_CACHE)
+void    x86emu_code_cache_write (u32 addr, uint size);
+void    x86emu_code_cache_flush (void);
+#else
+static inline void x86emu_code_cache_write(u32 addr, uint size) {}
+static inline void x86emu_code_cache_flush(void) {}
+#endif
+
 #ifdef  __cplusplus
 }                       			/* End of "C" linkage for C++   	*/
 #endif
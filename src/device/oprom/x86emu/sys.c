@@ -46,6 +46,7 @@
 #include <device/oprom/include/io.h>
 #include "debug.h"
 #include "prim_ops.h"
+#include "decode.h"
 
 #ifdef IN_MODULE
 #include "xf86_ansic.h"
@@ -297,9 +298,38 @@ static void X86API p_outl(X86EMU_pioAddr addr, u32 val)
 u8(X86APIP sys_rdb) (u32 addr) = rdb;
 u16(X86APIP sys_rdw) (u32 addr) = rdw;
 u32(X86APIP sys_rdl) (u32 addr) = rdl;
+#if CONFIG(X86EMU_CODE_CACHE)
+/* Writes go through the code cache, which passes them on to these. */
+static void (X86APIP mem_wrb) (u32 addr, u8 val) = wrb;
+static void (X86APIP mem_wrw) (u32 addr, u16 val) = wrw;
+static void (X86APIP mem_wrl) (u32 addr, u32 val) = wrl;
+
+static void X86API cached_wrb(u32 addr, u8 val)
+{
+	(*mem_wrb)(addr, val);
+	x86emu_code_cache_write(addr, 1);
+}
+
+static void X86API cached_wrw(u32 addr, u16 val)
+{
+	(*mem_wrw)(addr, val);
+	x86emu_code_cache_write(addr, 2);
+}
+
+static void X86API cached_wrl(u32 addr, u32 val)
+{
+	(*mem_wrl)(addr, val);
+	x86emu_code_cache_write(addr, 4);
+}
+
+void (X86APIP sys_wrb) (u32 addr, u8 val) = cached_wrb;
+void (X86APIP sys_wrw) (u32 addr, u16 val) = cached_wrw;
+void (X86APIP sys_wrl) (u32 addr, u32 val) = cached_wrl;
+#else
 void (X86APIP sys_wrb) (u32 addr, u8 val) = wrb;
 void (X86APIP sys_wrw) (u32 addr, u16 val) = wrw;
 void (X86APIP sys_wrl) (u32 addr, u32 val) = wrl;
+#endif
 u8(X86APIP sys_inb) (X86EMU_pioAddr addr) = p_inb;
 u16(X86APIP sys_inw) (X86EMU_pioAddr addr) = p_inw;
 u32(X86APIP sys_inl) (X86EMU_pioAddr addr) = p_inl;
@@ -323,9 +353,16 @@ void X86EMU_setupMemFuncs(X86EMU_memFuncs * funcs)
 	sys_rdb = funcs->rdb;
 	sys_rdw = funcs->rdw;
 	sys_rdl = funcs->rdl;
+#if CONFIG(X86EMU_CODE_CACHE)
+	mem_wrb = funcs->wrb;
+	mem_wrw = funcs->wrw;
+	mem_wrl = funcs->wrl;
+	x86emu_code_cache_flush();
+#else
 	sys_wrb = funcs->wrb;
 	sys_wrw = funcs->wrw;
 	sys_wrl = funcs->wrl;
+#endif
 }
 
 /****************************************************************************
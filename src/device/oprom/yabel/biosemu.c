@@ -88,6 +88,10 @@ biosemu(u8 *biosmem, u32 biosmem_size, struct device * dev, unsigned long rom_ad
 {
 	u8 *rom_image;
 	int i = 0;
+#if !CONFIG(X86EMU_DEBUG)
+	struct stopwatch sw;
+#endif
+	X86EMU_stats stats;
 #if CONFIG(X86EMU_DEBUG)
 	debug_flags = 0;
 #if CONFIG(X86EMU_DEBUG_JMP)
@@ -339,8 +343,22 @@ biosemu(u8 *biosmem, u32 biosmem_size, struct device * dev, unsigned long rom_ad
 	}
 
 	DEBUG_PRINTF("Executing Initialization Vector...\n");
+	X86EMU_resetStats();
+#if !CONFIG(X86EMU_DEBUG)
+	/* util/vgabios builds this with X86EMU_DEBUG, but without a timer. */
+	stopwatch_init(&sw);
+#endif
 	X86EMU_exec();
 	DEBUG_PRINTF("done\n");
+	X86EMU_getStats(&stats);
+#if !CONFIG(X86EMU_DEBUG)
+	printk(BIOS_DEBUG, "YABEL: %llu instructions in %ld ms, code cache: %lu misses, "
+	       "%lu invalidations, %lu bypassed\n", stats.instructions,
+	       stopwatch_duration_msecs(&sw), stats.code_cache_misses,
+	       stats.code_cache_invalidations, stats.code_cache_bypassed);
+#else
+	DEBUG_PRINTF("%llu instructions\n", stats.instructions);
+#endif
 
 	/* According to the PNP BIOS Spec, Option ROMs should upon exit, return
 	 * some boot device status in AX (see PNP BIOS Spec Section 3.3
@@ -402,29 +402,35 @@ static void update_constraints(struct memranges *ranges, const struct device *de
 	       __func__, dev_path(dev), res->index, res->base,
 	       res->base + res->size - 1, resource2str(res));
 
-	memranges_create_hole(ranges, res->base, res->size);
+	memranges_insert(ranges, res->base, res->size, res->flags & IORESOURCE_TYPE_MASK);
 }
 
 /*
  * Scan the entire tree to identify any fixed resources allocated by any device to
  * ensure that the address map for domain resources are appropriately updated.
  *
- * Domains can typically provide memrange for entire address space. So, this function
- * punches holes in the address space for all fixed resources that are already
- * defined. Both IO and normal memory resources are added as fixed. Both need to be
- * removed from address space where dynamic resource allocations are sourced.
+ * Domains can typically provide memrange for entire address space. So, holes need to be
+ * punched in the address space for all fixed resources that are already defined. Both IO
+ * and normal memory resources are added as fixed. Both need to be removed from address
+ * space where dynamic resource allocations are sourced.
+ *
+ * The domain sub-tree is walked only once and the fixed resources are collected into one
+ * sorted list per resource type, which is then used for each resource type of the domain.
  */
-static void avoid_fixed_resources(struct memranges *ranges, const struct device *dev,
-				  unsigned long mask_match)
+static void collect_fixed_resources(struct memranges *fixed_io, struct memranges *fixed_mem,
+				    const struct device *dev)
 {
 	const struct resource *res;
 	const struct device *child;
 	const struct bus *bus;
 
 	for (res = dev->resource_list; res != NULL; res = res->next) {
-		if ((res->flags & mask_match) != mask_match)
+		if (!(res->flags & IORESOURCE_FIXED))
 			continue;
-		update_constraints(ranges, dev, res);
+		if (res->flags & IORESOURCE_IO)
+			update_constraints(fixed_io, dev, res);
+		else if (res->flags & IORESOURCE_MEM)
+			update_constraints(fixed_mem, dev, res);
 	}
 
 	bus = dev->link_list;
@@ -432,14 +438,20 @@ static void avoid_fixed_resources(struct memranges *ranges, const struct device
 		return;
 
 	for (child = bus->children; child != NULL; child = child->sibling)
-		avoid_fixed_resources(ranges, child, mask_match);
+		collect_fixed_resources(fixed_io, fixed_mem, child);
 }
 
-static void constrain_domain_resources(const struct device *domain, struct memranges *ranges,
-				       unsigned long type)
+static void avoid_fixed_resources(struct memranges *ranges, const struct memranges *fixed)
 {
-	unsigned long mask_match = type | IORESOURCE_FIXED;
+	const struct range_entry *r;
+
+	memranges_each_entry(r, fixed)
+		memranges_create_hole(ranges, range_entry_base(r), range_entry_size(r));
+}
 
+static void constrain_domain_resources(struct memranges *ranges, const struct memranges *fixed,
+				       unsigned long type)
+{
 	if (type == IORESOURCE_IO) {
 		/*
 		 * Don't allow allocations in the VGA I/O range. PCI has special cases for
@@ -454,7 +466,7 @@ static void constrain_domain_resources(const struct device *domain, struct memra
 		 */
 	}
 
-	avoid_fixed_resources(ranges, domain, mask_match);
+	avoid_fixed_resources(ranges, fixed);
 }
 
 /*
@@ -464,12 +476,13 @@ static void constrain_domain_resources(const struct device *domain, struct memra
  * downstream devices since there is nothing to allocate from.
  *
  * In case of domain, it applies additional constraints to ensure that the memranges do not
- * overlap any of the fixed resources under that domain. Domain typically seems to provide
- * memrange for entire address space. Thus, it is up to the chipset to add DRAM and all other
- * windows which cannot be used for resource allocation as fixed resources.
+ * overlap any of the fixed resources under that domain, as collected in fixed. Domain typically
+ * seems to provide memrange for entire address space. Thus, it is up to the chipset to add DRAM
+ * and all other windows which cannot be used for resource allocation as fixed resources.
  */
 static void setup_resource_ranges(const struct device *dev, const struct resource *res,
-				  unsigned long type, struct memranges *ranges)
+				  unsigned long type, struct memranges *ranges,
+				  const struct memranges *fixed)
 {
 	printk(BIOS_DEBUG, "%s %s: base: %llx size: %llx align: %d gran: %d limit: %llx\n",
 	       dev_path(dev), resource2str(res), res->base, res->size, res->align,
@@ -477,7 +490,7 @@ static void setup_resource_ranges(const struct device *dev, const struct resourc
 
 	if (dev->path.type == DEVICE_PATH_DOMAIN) {
 		initialize_domain_memranges(ranges, res, type);
-		constrain_domain_resources(dev, ranges, type);
+		constrain_domain_resources(ranges, fixed, type);
 	} else {
 		initialize_bridge_memranges(ranges, res, type);
 	}
@@ -526,7 +539,7 @@ static void allocate_bridge_resources(const struct device *bridge)
 
 		type_match = res->flags & type_mask;
 
-		setup_resource_ranges(bridge, res, type_match, &ranges);
+		setup_resource_ranges(bridge, res, type_match, &ranges, NULL);
 		allocate_child_resources(bus, &ranges, type_mask, type_match);
 		cleanup_resource_ranges(bridge, &ranges, res);
 	}
@@ -569,13 +582,20 @@ static const struct resource *find_domain_resource(const struct device *domain,
 static void allocate_domain_resources(const struct device *domain)
 {
 	struct memranges ranges;
+	struct memranges fixed_io;
+	struct memranges fixed_mem;
 	struct device *child;
 	const struct resource *res;
 
+	/* Keep exact bounds of the fixed resources, the domain ranges apply alignment. */
+	memranges_init_empty_with_alignment(&fixed_io, NULL, 0, 0);
+	memranges_init_empty_with_alignment(&fixed_mem, NULL, 0, 0);
+	collect_fixed_resources(&fixed_io, &fixed_mem, domain);
+
 	/* Resource type I/O */
 	res = find_domain_resource(domain, IORESOURCE_IO);
 	if (res) {
-		setup_resource_ranges(domain, res, IORESOURCE_IO, &ranges);
+		setup_resource_ranges(domain, res, IORESOURCE_IO, &ranges, &fixed_io);
 		allocate_child_resources(domain->link_list, &ranges, IORESOURCE_TYPE_MASK,
 					 IORESOURCE_IO);
 		cleanup_resource_ranges(domain, &ranges, res);
@@ -598,7 +618,7 @@ static void allocate_domain_resources(const struct device *domain)
 	 */
 	res = find_domain_resource(domain, IORESOURCE_MEM);
 	if (res) {
-		setup_resource_ranges(domain, res, IORESOURCE_MEM, &ranges);
+		setup_resource_ranges(domain, res, IORESOURCE_MEM, &ranges, &fixed_mem);
 		allocate_child_resources(domain->link_list, &ranges,
 					 IORESOURCE_TYPE_MASK | IORESOURCE_ABOVE_4G,
 					 IORESOURCE_MEM);
@@ -608,6 +628,9 @@ static void allocate_domain_resources(const struct device *domain)
 		cleanup_resource_ranges(domain, &ranges, res);
 	}
 
+	memranges_teardown(&fixed_io);
+	memranges_teardown(&fixed_mem);
+
 	for (child = domain->link_list->children; child; child = child->sibling) {
 		if (!dev_has_children(child))
 			continue;
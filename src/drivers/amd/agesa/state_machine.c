@@ -5,6 +5,7 @@
 #include <acpi/acpi.h>
 #include <bootstate.h>
 #include <cbfs.h>
+#include <profiler.h>
 #include <timestamp.h>
 
 #include <northbridge/amd/agesa/state_machine.h>
@@ -61,6 +62,7 @@ AGESA_STATUS module_dispatch(AGESA_STRUCT_NAME func,
 	AMD_CONFIG_PARAMS *StdHeader)
 {
 	MODULE_ENTRY dispatcher;
+	AGESA_STATUS status;
 
 #if CONFIG(CPU_AMD_AGESA_OPENSOURCE)
 	dispatcher = AmdAgesaDispatcher;
@@ -72,7 +74,10 @@ AGESA_STATUS module_dispatch(AGESA_STRUCT_NAME func,
 #endif
 
 	StdHeader->Func = func;
-	return dispatcher(StdHeader);
+	profiler_pause();
+	status = dispatcher(StdHeader);
+	profiler_resume();
+	return status;
 }
 
 static AGESA_STATUS amd_create_struct(AMD_INTERFACE_PARAMS *aip,
@@ -694,6 +694,8 @@ static int elog_sync_to_nv(void)
 
 	erase_needed = elog_nv_needs_erase();
 
+	boot_device_rw_batch_begin("ELOG");
+
 	/* Erase if necessary. */
 	if (erase_needed) {
 		elog_nv_erase();
@@ -705,6 +707,9 @@ static int elog_sync_to_nv(void)
 	elog_nv_write(offset, size);
 	elog_nv_increment_last_write(size);
 
+	if (boot_device_rw_batch_end() < 0)
+		printk(BIOS_ERR, "ELOG: NV Write failed\n");
+
 	/*
 	 * If erase wasn't performed then don't rescan. Assume the appended
 	 * write was successful.
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
 #include <acpi/acpigen.h>
+#include <bootstate.h>
 #include <device/mmio.h>
 #include <console/console.h>
 #include <device/device.h>
@@ -307,45 +308,98 @@ static int dw_i2c_wait_for_bus_idle(struct dw_i2c_regs *regs)
 	return -1;
 }
 
-/* Transfer one byte of one segment, sending stop bit if requested */
-static int dw_i2c_transfer_byte(struct dw_i2c_regs *regs,
-				  const struct i2c_msg *segment,
-				  size_t byte, int send_stop)
+/* Advance a segment cursor past completed (and, for reads, non-read) segments */
+static void dw_i2c_next_segment(const struct i2c_msg **segment, size_t *byte,
+				const struct i2c_msg *end, int reads_only)
 {
+	while (*segment < end && (*byte == (*segment)->len ||
+	       (reads_only && !((*segment)->flags & I2C_M_RD)))) {
+		(*segment)++;
+		*byte = 0;
+	}
+}
+
+/*
+ * Move all bytes of the given segments through the FIFOs. Commands are queued
+ * as long as the TX FIFO has room, and read commands only as long as their
+ * data is guaranteed to fit into the RX FIFO, so write-then-read sequences
+ * are sent back to back without waiting for each byte. Stop bit is sent after
+ * the final byte, repeated start will be automatically generated by the
+ * controller on R->W or W->R switch.
+ */
+static int dw_i2c_transfer_segments(struct dw_i2c_regs *regs,
+				    const struct i2c_msg *segments,
+				    size_t count)
+{
+	const uint32_t param = read32(&regs->comp_param1);
+	const size_t tx_depth = ((param >> 16) & 0xff) + 1;
+	const size_t rx_depth = ((param >> 8) & 0xff) + 1;
+	const struct i2c_msg *end = segments + count;
+	const struct i2c_msg *tx_segment = segments;
+	const struct i2c_msg *rx_segment = segments;
+	size_t tx_byte = 0;
+	size_t rx_byte = 0;
+	size_t pending = 0;
 	struct stopwatch sw;
-	uint32_t cmd = CMD_DATA_CMD; /* Read op */
 
 	stopwatch_init_usecs_expire(&sw, DW_I2C_TIMEOUT_US);
 
-	if (!(segment->flags & I2C_M_RD)) {
-		/* Write op only: Wait for FIFO not full */
-		while (!(read32(&regs->status) & STATUS_TX_FIFO_NOT_FULL)) {
-			if (stopwatch_expired(&sw)) {
-				printk(BIOS_ERR, "I2C transmit timeout\n");
-				return -1;
-			}
-		}
-		cmd = segment->buf[byte];
-	}
+	while (1) {
+		size_t level;
+		int progress = 0;
 
-	/* Send stop on last byte, if desired */
-	if (send_stop && byte == segment->len - 1)
-		cmd |= CMD_DATA_STOP;
+		dw_i2c_next_segment(&tx_segment, &tx_byte, end, 0);
+		dw_i2c_next_segment(&rx_segment, &rx_byte, end, 1);
+		if (tx_segment == end && rx_segment == end)
+			return 0;
 
-	write32(&regs->cmd_data, cmd);
+		/* Store the data received so far */
+		for (level = read32(&regs->rx_level); level && rx_segment < end;
+		     level--) {
+			rx_segment->buf[rx_byte++] = read32(&regs->cmd_data);
+			dw_i2c_next_segment(&rx_segment, &rx_byte, end, 1);
+			pending--;
+			progress = 1;
+		}
 
-	if (segment->flags & I2C_M_RD) {
-		/* Read op only: Wait for FIFO data and store it */
-		while (!(read32(&regs->status) & STATUS_RX_FIFO_NOT_EMPTY)) {
-			if (stopwatch_expired(&sw)) {
-				printk(BIOS_ERR, "I2C receive timeout\n");
-				return -1;
+		/* Queue as many commands as the FIFOs can take */
+		level = read32(&regs->tx_level);
+		while (level < tx_depth && tx_segment < end) {
+			uint32_t cmd;
+
+			if (tx_segment->flags & I2C_M_RD) {
+				if (pending >= rx_depth)
+					break;
+				cmd = CMD_DATA_CMD;
+				pending++;
+			} else {
+				cmd = tx_segment->buf[tx_byte];
 			}
+
+			/* Send stop on the last byte of the last segment */
+			if (tx_segment == end - 1 &&
+			    tx_byte == tx_segment->len - 1)
+				cmd |= CMD_DATA_STOP;
+
+			write32(&regs->cmd_data, cmd);
+			tx_byte++;
+			dw_i2c_next_segment(&tx_segment, &tx_byte, end, 0);
+			level++;
+			progress = 1;
 		}
-		segment->buf[byte] = read32(&regs->cmd_data);
-	}
 
-	return 0;
+		/* The controller flushes the FIFOs and stops, report below */
+		if (read32(&regs->raw_intr_stat) & INTR_STAT_TX_ABORT)
+			return 0;
+
+		if (progress) {
+			stopwatch_init_usecs_expire(&sw, DW_I2C_TIMEOUT_US);
+		} else if (stopwatch_expired(&sw)) {
+			printk(BIOS_ERR, "I2C %s timeout\n",
+			       tx_segment < end ? "transmit" : "receive");
+			return -1;
+		}
+	}
 }
 
 static int _dw_i2c_transfer(unsigned int bus, const struct i2c_msg *segments,
@@ -353,7 +407,6 @@ static int _dw_i2c_transfer(unsigned int bus, const struct i2c_msg *segments,
 {
 	struct stopwatch sw;
 	struct dw_i2c_regs *regs;
-	size_t byte;
 	int ret = -1;
 
 	regs = (struct dw_i2c_regs *)dw_i2c_base_address(bus);
@@ -371,40 +424,26 @@ static int _dw_i2c_transfer(unsigned int bus, const struct i2c_msg *segments,
 
 	dw_i2c_enable(regs);
 
-	/* Process each segment */
-	while (count--) {
-		if (CONFIG(DRIVERS_I2C_DESIGNWARE_DEBUG)) {
-			printk(BIOS_DEBUG, "i2c %u:%02x %s %d bytes : ",
-			       bus, segments->slave,
-			       (segments->flags & I2C_M_RD) ? "R" : "W",
-			       segments->len);
-		}
+	/* Process all segments */
+	if (dw_i2c_transfer_segments(regs, segments, count) < 0) {
+		printk(BIOS_ERR, "I2C transfer failed: bus %u addr 0x%02x\n",
+		       bus, segments->slave);
+		goto out;
+	}
 
-		/* Read or write each byte in segment */
-		for (byte = 0; byte < segments->len; byte++) {
-			/*
-			 * Set stop condition on final segment only.
-			 * Repeated start will be automatically generated
-			 * by the controller on R->W or W->R switch.
-			 */
-			if (dw_i2c_transfer_byte(regs, segments, byte,
-						   count == 0) < 0) {
-				printk(BIOS_ERR, "I2C %s failed: bus %u "
-				       "addr 0x%02x\n",
-				       (segments->flags & I2C_M_RD) ?
-				       "read" : "write", bus, segments->slave);
-				goto out;
-			}
-		}
+	if (CONFIG(DRIVERS_I2C_DESIGNWARE_DEBUG)) {
+		size_t i;
+		int j;
 
-		if (CONFIG(DRIVERS_I2C_DESIGNWARE_DEBUG)) {
-			int j;
-			for (j = 0; j < segments->len; j++)
-				printk(BIOS_DEBUG, "%02x ", segments->buf[j]);
+		for (i = 0; i < count; i++) {
+			printk(BIOS_DEBUG, "i2c %u:%02x %s %d bytes : ",
+			       bus, segments[i].slave,
+			       (segments[i].flags & I2C_M_RD) ? "R" : "W",
+			       segments[i].len);
+			for (j = 0; j < segments[i].len; j++)
+				printk(BIOS_DEBUG, "%02x ", segments[i].buf[j]);
 			printk(BIOS_DEBUG, "\n");
 		}
-
-		segments++;
 	}
 
 	/* Wait for interrupt status to indicate transfer is complete */
@@ -452,6 +491,66 @@ out:
 	return ret;
 }
 
+#if CONFIG(DRIVERS_I2C_DESIGNWARE_STATS)
+#define DW_I2C_STATS_BUSES	CONFIG_DRIVERS_I2C_DESIGNWARE_STATS_BUSES
+#else
+#define DW_I2C_STATS_BUSES	0
+#endif
+
+static struct dw_i2c_stats dw_i2c_stats[DW_I2C_STATS_BUSES];
+static bool dw_i2c_stats_overflow;
+
+const struct dw_i2c_stats *dw_i2c_get_stats(unsigned int bus)
+{
+	if (!CONFIG(DRIVERS_I2C_DESIGNWARE_STATS) || bus >= DW_I2C_STATS_BUSES)
+		return NULL;
+	return &dw_i2c_stats[bus];
+}
+
+static void dw_i2c_account(unsigned int bus, const struct i2c_msg *segments,
+			   size_t count, long usecs, int ret)
+{
+	struct dw_i2c_stats *stats;
+	size_t i;
+
+	if (!CONFIG(DRIVERS_I2C_DESIGNWARE_STATS))
+		return;
+
+	if (bus >= DW_I2C_STATS_BUSES) {
+		if (!dw_i2c_stats_overflow)
+			printk(BIOS_WARNING, "I2C bus %u: No statistics beyond bus %u
+",
+			       bus, DW_I2C_STATS_BUSES - 1);
+		dw_i2c_stats_overflow = true;
+		return;
+	}
+
+	stats = &dw_i2c_stats[bus];
+	stats->transactions++;
+	if (ret)
+		stats->errors++;
+	for (i = 0; i < count; i++) {
+		if (segments[i].flags & I2C_M_RD)
+			stats->bytes_read += segments[i].len;
+		else
+			stats->bytes_written += segments[i].len;
+	}
+	stats->usecs += usecs;
+}
+
+static int dw_i2c_transfer_timed(unsigned int bus,
+				 const struct i2c_msg *segments, size_t count)
+{
+	struct stopwatch sw;
+	int ret;
+
+	stopwatch_init(&sw);
+	ret = _dw_i2c_transfer(bus, segments, count);
+	dw_i2c_account(bus, segments, count, stopwatch_duration_usecs(&sw), ret);
+
+	return ret;
+}
+
 int dw_i2c_transfer(unsigned int bus, const struct i2c_msg *msg, size_t count)
 {
 	const struct i2c_msg *orig_msg = msg;
@@ -467,14 +566,15 @@ int dw_i2c_transfer(unsigned int bus, const struct i2c_msg *msg, size_t count)
 
 	for (i = 0, start = 0; i < count; i++, msg++) {
 		if (addr != msg->slave) {
-			if (_dw_i2c_transfer(bus, &orig_msg[start], i - start))
+			if (dw_i2c_transfer_timed(bus, &orig_msg[start],
+						  i - start))
 				return -1;
 			start = i;
 			addr = msg->slave;
 		}
 	}
 
-	return _dw_i2c_transfer(bus, &orig_msg[start], count - start);
+	return dw_i2c_transfer_timed(bus, &orig_msg[start], count - start);
 }
 
 /* Global I2C bus handler, defined in include/device/i2c_simple.h */
@@ -848,3 +948,28 @@ static int dw_i2c_dev_transfer(struct device *dev,
 const struct i2c_bus_operations dw_i2c_bus_ops = {
 	.transfer = dw_i2c_dev_transfer,
 };
+
+#if ENV_RAMSTAGE
+static void dw_i2c_report_stats(void *unused)
+{
+	unsigned int bus;
+
+	if (!CONFIG(DRIVERS_I2C_DESIGNWARE_STATS))
+		return;
+
+	for (bus = 0; bus < DW_I2C_STATS_BUSES; bus++) {
+		const struct dw_i2c_stats *stats = &dw_i2c_stats[bus];
+
+		if (!stats->transactions)
+			continue;
+		printk(BIOS_DEBUG,
+		       "I2C bus %u: %u transactions (%u failed), %llu bytes written, %llu bytes read in %llu us\n",
+		       bus, stats->transactions, stats->errors,
+		       (unsigned long long)stats->bytes_written,
+		       (unsigned long long)stats->bytes_read,
+		       (unsigned long long)stats->usecs);
+	}
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, dw_i2c_report_stats, NULL);
+#endif
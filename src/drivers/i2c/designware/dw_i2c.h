@@ -122,6 +122,22 @@ int dw_i2c_transfer(unsigned int bus,
 			const struct i2c_msg *segments,
 			size_t count);
 
+/* Transfer statistics of one bus, see DRIVERS_I2C_DESIGNWARE_STATS */
+struct dw_i2c_stats {
+	uint32_t transactions;
+	uint32_t errors;
+	uint64_t bytes_written;
+	uint64_t bytes_read;
+	uint64_t usecs;
+};
+
+/*
+ * Get the transfer statistics of the given bus in the current stage.
+ * Return value:
+ * NULL = statistics disabled or bus out of range
+ */
+const struct dw_i2c_stats *dw_i2c_get_stats(unsigned int bus);
+
 /*
  * Map an i2c host controller device to a logical bus number.
  * Return value:
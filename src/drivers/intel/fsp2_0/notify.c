@@ -4,6 +4,7 @@
 #include <console/console.h>
 #include <cpu/x86/mtrr.h>
 #include <fsp/util.h>
+#include <profiler.h>
 #include <timestamp.h>
 #include <mode_switch.h>
 
@@ -31,10 +32,12 @@ static void fsp_notify(enum fsp_notify_phase phase)
 		post_code(POST_FSP_NOTIFY_BEFORE_END_OF_FIRMWARE);
 	}
 
+	profiler_pause();
 	if (ENV_X86_64 && CONFIG(PLATFORM_USES_FSP2_X86_32))
 		ret = protected_mode_call_1arg(fspnotify, (uintptr_t)&notify_params);
 	else
 		ret = fspnotify(&notify_params);
+	profiler_resume();
 
 	if (phase == AFTER_PCI_ENUM) {
 		timestamp_add_now(TS_FSP_AFTER_ENUMERATE);
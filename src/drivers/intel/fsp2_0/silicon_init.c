@@ -8,6 +8,7 @@
 #include <console/console.h>
 #include <fsp/api.h>
 #include <fsp/util.h>
+#include <profiler.h>
 #include <program_loading.h>
 #include <soc/intel/common/vbt.h>
 #include <stage_cache.h>
@@ -121,10 +122,12 @@ static void do_silicon_init(struct fsp_header *hdr)
 	timestamp_add_now(TS_FSP_SILICON_INIT_START);
 	post_code(POST_FSP_SILICON_INIT);
 
+	profiler_pause();
 	if (ENV_X86_64 && CONFIG(PLATFORM_USES_FSP2_X86_32))
 		status = protected_mode_call_1arg(silicon_init, (uintptr_t)upd);
 	else
 		status = silicon_init(upd);
+	profiler_resume();
 
 	printk(BIOS_INFO, "FSPS returned %x\n", status);
 
@@ -162,7 +165,9 @@ static void do_silicon_init(struct fsp_header *hdr)
 	multi_phase_params.multi_phase_action = GET_NUMBER_OF_PHASES;
 	multi_phase_params.phase_index = 0;
 	multi_phase_params.multi_phase_param_ptr = &multi_phase_get_number;
+	profiler_pause();
 	status = multi_phase_si_init(&multi_phase_params);
+	profiler_resume();
 	fsps_return_value_handler(FSP_MULTI_PHASE_SI_INIT_GET_NUMBER_OF_PHASES_API, status);
 
 	/* Execute Multi Phase Execution */
@@ -177,7 +182,9 @@ static void do_silicon_init(struct fsp_header *hdr)
 		multi_phase_params.multi_phase_action = EXECUTE_PHASE;
 		multi_phase_params.phase_index = i;
 		multi_phase_params.multi_phase_param_ptr = NULL;
+		profiler_pause();
 		status = multi_phase_si_init(&multi_phase_params);
+		profiler_resume();
 		fsps_return_value_handler(FSP_MULTI_PHASE_SI_INIT_EXECUTE_PHASE_API, status);
 	}
 	timestamp_add_now(TS_FSP_MULTI_PHASE_SI_INIT_END);
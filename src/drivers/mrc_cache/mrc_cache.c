@@ -441,6 +441,7 @@ static void update_mrc_cache_by_type(int type,
 	struct region_device latest_rdev;
 	const bool fail_bad_data = false;
 	uint32_t hash_idx;
+	int ret;
 
 	cr = lookup_region(&region, type);
 
@@ -494,7 +495,13 @@ static void update_mrc_cache_by_type(int type,
 			.data = new_data,
 		},
 	};
-	if (region_file_update_data_arr(&cache_file, entries, ARRAY_SIZE(entries)) < 0) {
+	/* The metadata is written together with the start of the data. */
+	boot_device_rw_batch_begin("MRC");
+	ret = region_file_update_data_arr(&cache_file, entries, ARRAY_SIZE(entries));
+	if (boot_device_rw_batch_end() < 0)
+		ret = -1;
+
+	if (ret < 0) {
 		printk(BIOS_ERR, "MRC: failed to update '%s'.\n", cr->name);
 		log_event_cache_update(cr->elog_slot, UPDATE_FAILURE);
 	} else {
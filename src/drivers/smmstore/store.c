@@ -177,6 +177,43 @@ static enum cb_err scan_end(struct region_device *store)
 	return CB_SUCCESS;
 
 }
+
+static int write_entry(const struct region_device *store, void *key, uint32_t key_sz,
+		       void *value, uint32_t value_sz)
+{
+	ssize_t offset = 0;
+	uint8_t nul = 0;
+
+	if (rdev_writeat(store, &key_sz, offset, sizeof(key_sz))
+	    != sizeof(key_sz)) {
+		printk(BIOS_WARNING, "failed writing key size\n");
+		return -1;
+	}
+	offset += sizeof(key_sz);
+	if (rdev_writeat(store, &value_sz, offset, sizeof(value_sz))
+	    != sizeof(value_sz)) {
+		printk(BIOS_WARNING, "failed writing value size\n");
+		return -1;
+	}
+	offset += sizeof(value_sz);
+	if (rdev_writeat(store, key, offset, key_sz) != key_sz) {
+		printk(BIOS_WARNING, "failed writing key data\n");
+		return -1;
+	}
+	offset += key_sz;
+	if (rdev_writeat(store, value, offset, value_sz) != value_sz) {
+		printk(BIOS_WARNING, "failed writing value data\n");
+		return -1;
+	}
+	offset += value_sz;
+	if (rdev_writeat(store, &nul, offset, sizeof(nul)) != sizeof(nul)) {
+		printk(BIOS_WARNING, "failed writing termination\n");
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * Append data to region
  *
@@ -192,9 +229,8 @@ int smmstore_append_data(void *key, uint32_t key_sz, void *value,
 		return -1;
 	}
 
-	ssize_t offset = 0;
 	ssize_t size;
-	uint8_t nul = 0;
+	int ret;
 	if (scan_end(&store) != CB_SUCCESS)
 		return -1;
 
@@ -204,40 +240,21 @@ int smmstore_append_data(void *key, uint32_t key_sz, void *value,
 		region_device_offset(&store), region_device_sz(&store));
 
 	size = sizeof(key_sz) + sizeof(value_sz) + key_sz + value_sz
-		+ sizeof(nul);
+		+ sizeof(uint8_t);
 	if (rdev_chain(&store, &store, 0, size)) {
 		printk(BIOS_WARNING, "not enough space for new data\n");
 		return -1;
 	}
 
-	if (rdev_writeat(&store, &key_sz, offset, sizeof(key_sz))
-	    != sizeof(key_sz)) {
-		printk(BIOS_WARNING, "failed writing key size\n");
-		return -1;
-	}
-	offset += sizeof(key_sz);
-	if (rdev_writeat(&store, &value_sz, offset, sizeof(value_sz))
-	    != sizeof(value_sz)) {
-		printk(BIOS_WARNING, "failed writing value size\n");
-		return -1;
-	}
-	offset += sizeof(value_sz);
-	if (rdev_writeat(&store, key, offset, key_sz) != key_sz) {
-		printk(BIOS_WARNING, "failed writing key data\n");
-		return -1;
-	}
-	offset += key_sz;
-	if (rdev_writeat(&store, value, offset, value_sz) != value_sz) {
-		printk(BIOS_WARNING, "failed writing value data\n");
-		return -1;
-	}
-	offset += value_sz;
-	if (rdev_writeat(&store, &nul, offset, sizeof(nul)) != sizeof(nul)) {
-		printk(BIOS_WARNING, "failed writing termination\n");
+	/* The sizes, key, value and termination mostly fit a single page. */
+	boot_device_rw_batch_begin("SMMSTORE");
+	ret = write_entry(&store, key, key_sz, value, value_sz);
+	if (boot_device_rw_batch_end() < 0) {
+		printk(BIOS_WARNING, "failed writing entry\n");
 		return -1;
 	}
 
-	return 0;
+	return ret;
 }
 
 /*
@@ -80,6 +80,24 @@ const struct spi_flash *boot_device_spi_flash(void)
 	return &sfg;
 }
 
+void boot_device_rw_batch_begin(const char *owner)
+{
+	const struct spi_flash *flash = boot_device_spi_flash();
+
+	if (flash)
+		spi_flash_batch_begin(flash, owner);
+}
+
+int boot_device_rw_batch_end(void)
+{
+	const struct spi_flash *flash = boot_device_spi_flash();
+
+	if (flash && spi_flash_batch_end(flash))
+		return -1;
+
+	return 0;
+}
+
 int boot_device_wp_region(const struct region_device *rd,
 			  const enum bootdev_prot_type type)
 {
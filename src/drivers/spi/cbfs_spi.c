@@ -118,3 +118,21 @@ const struct spi_flash *boot_device_spi_flash(void)
 
 	return &spi_flash_info;
 }
+
+void boot_device_rw_batch_begin(const char *owner)
+{
+	const struct spi_flash *flash = boot_device_spi_flash();
+
+	if (flash)
+		spi_flash_batch_begin(flash, owner);
+}
+
+int boot_device_rw_batch_end(void)
+{
+	const struct spi_flash *flash = boot_device_spi_flash();
+
+	if (flash && spi_flash_batch_end(flash))
+		return -1;
+
+	return 0;
+}
@@ -25,6 +25,7 @@ static const struct spi_flash_part_id flash_table[] = {
 		/* GD25T80 */
 		.id[0]				= 0x3114,
 		.nr_sectors_shift		= 8,
+		.block_erase_64k_support	= 1,
 	},
 	{
 		/* GD25Q80 */
@@ -32,6 +33,7 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 8,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.block_erase_64k_support	= 1,
 	},					/* also GD25Q80B */
 	{
 		/* GD25Q16 */
@@ -39,6 +41,7 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 9,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.block_erase_64k_support	= 1,
 	},					/* also GD25Q16B */
 	{
 		/* GD25Q32B */
@@ -46,6 +49,7 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 10,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.block_erase_64k_support	= 1,
 	},					/* also GD25Q32B */
 	{
 		/* GD25Q64 */
@@ -53,6 +57,7 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 11,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.block_erase_64k_support	= 1,
 	},					/* also GD25Q64B, GD25B64C */
 	{
 		/* GD25Q128 */
@@ -60,6 +65,7 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 12,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.block_erase_64k_support	= 1,
 	},					/* also GD25Q128B */
 	{
 		/* GD25VQ80C */
@@ -67,6 +73,7 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 8,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.block_erase_64k_support	= 1,
 	},
 	{
 		/* GD25VQ16C */
@@ -74,6 +81,7 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 9,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.block_erase_64k_support	= 1,
 	},
 	{
 		/* GD25LQ80 */
@@ -81,6 +89,7 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 8,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.block_erase_64k_support	= 1,
 	},
 	{
 		/* GD25LQ16 */
@@ -88,6 +97,7 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 9,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.block_erase_64k_support	= 1,
 	},
 	{
 		/* GD25LQ32 */
@@ -95,6 +105,7 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 10,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.block_erase_64k_support	= 1,
 	},
 	{
 		/* GD25LQ64C */
@@ -102,6 +113,7 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 11,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.block_erase_64k_support	= 1,
 	},					/* also GD25LB64C */
 	{
 		/* GD25LQ128 */
@@ -109,6 +121,7 @@ static const struct spi_flash_part_id flash_table[] = {
 		.nr_sectors_shift		= 12,
 		.fast_read_dual_output_support	= 1,
 		.fast_read_dual_io_support	= 1,
+		.block_erase_64k_support	= 1,
 	},
 };
 
@@ -27,41 +27,49 @@ static const struct spi_flash_part_id flash_table[] = {
 		/* MX25L8005 */
 		.id[0] = 0x2014,
 		.nr_sectors_shift = 8,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25L1605D */
 		.id[0] = 0x2015,
 		.nr_sectors_shift = 9,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25L3205D */
 		.id[0] = 0x2016,
 		.nr_sectors_shift = 10,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25L6405D */
 		.id[0] = 0x2017,
 		.nr_sectors_shift = 11,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25L12805D */
 		.id[0] = 0x2018,
 		.nr_sectors_shift = 12,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25L25635F */
 		.id[0] = 0x2019,
 		.nr_sectors_shift = 13,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX66L51235F */
 		.id[0] = 0x201a,
 		.nr_sectors_shift = 14,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25L1635D */
 		.id[0] = 0x2415,
 		.nr_sectors_shift = 9,
+		.block_erase_64k_support = 1,
 	},
 	/*
 	 * NOTE: C225xx JEDEC IDs are basically useless because Macronix keeps
@@ -78,65 +86,76 @@ static const struct spi_flash_part_id flash_table[] = {
 		.id[0] = 0x2515,
 		.nr_sectors_shift = 9,
 		.fast_read_dual_io_support = 1,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25U8032E */
 		.id[0] = 0x2534,
 		.nr_sectors_shift = 8,
 		.fast_read_dual_io_support = 1,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25U1635E/MX25U1635F */
 		.id[0] = 0x2535,
 		.nr_sectors_shift = 9,
 		.fast_read_dual_io_support = 1,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25U3235E/MX25U3235F */
 		.id[0] = 0x2536,
 		.nr_sectors_shift = 10,
 		.fast_read_dual_io_support = 1,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25U6435E/MX25U6435F */
 		.id[0] = 0x2537,
 		.nr_sectors_shift = 11,
 		.fast_read_dual_io_support = 1,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25U12835F */
 		.id[0] = 0x2538,
 		.nr_sectors_shift = 12,
 		.fast_read_dual_io_support = 1,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25U25635F */
 		.id[0] = 0x2539,
 		.nr_sectors_shift = 13,
 		.fast_read_dual_io_support = 1,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25U51235F */
 		.id[0] = 0x253a,
 		.nr_sectors_shift = 14,
 		.fast_read_dual_io_support = 1,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25L12855E */
 		.id[0] = 0x2618,
 		.nr_sectors_shift = 12,
 		.fast_read_dual_io_support = 1,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25L3235D/MX25L3225D/MX25L3236D/MX25L3237D */
 		.id[0] = 0x5e16,
 		.nr_sectors_shift = 10,
 		.fast_read_dual_io_support = 1,
+		.block_erase_64k_support = 1,
 	},
 	{
 		/* MX25L6495F */
 		.id[0] = 0x9517,
 		.nr_sectors_shift = 11,
+		.block_erase_64k_support = 1,
 	},
 };
 
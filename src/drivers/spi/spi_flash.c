@@ -235,13 +235,29 @@ int spi_flash_cmd_erase(const struct spi_flash *flash, u32 offset, size_t len)
 		return -1;
 	}
 
-	cmd[0] = flash->erase_cmd;
 	start = offset;
 	end = start + len;
 
 	while (offset < end) {
-		spi_flash_addr(offset, cmd);
-		offset += erase_size;
+		unsigned long timeout = SPI_FLASH_PAGE_ERASE_TIMEOUT_MS;
+
+		/*
+		 * Parts with 4KiB sectors that support it can erase a whole
+		 * 64KiB block at once, which takes a fraction of the time of
+		 * 16 sectors.
+		 */
+		if (flash->flags.block_erase && erase_size == 4 * KiB &&
+		    flash->erase_cmd != CMD_BLOCK_ERASE &&
+		    IS_ALIGNED(offset, 64 * KiB) && end - offset >= 64 * KiB) {
+			cmd[0] = CMD_BLOCK_ERASE;
+			timeout = SPI_FLASH_BLOCK_ERASE_TIMEOUT_MS;
+			spi_flash_addr(offset, cmd);
+			offset += 64 * KiB;
+		} else {
+			cmd[0] = flash->erase_cmd;
+			spi_flash_addr(offset, cmd);
+			offset += erase_size;
+		}
 
 #if CONFIG(DEBUG_SPI_FLASH)
 		printk(BIOS_SPEW, "SF: erase %2x %2x %2x %2x (%x)\n", cmd[0], cmd[1],
@@ -255,8 +271,7 @@ int spi_flash_cmd_erase(const struct spi_flash *flash, u32 offset, size_t len)
 		if (ret)
 			goto out;
 
-		ret = spi_flash_cmd_wait_ready(flash,
-				SPI_FLASH_PAGE_ERASE_TIMEOUT_MS);
+		ret = spi_flash_cmd_wait_ready(flash, timeout);
 		if (ret)
 			goto out;
 	}
@@ -384,6 +399,7 @@ static int fill_spi_flash(const struct spi_slave *spi, struct spi_flash *flash,
 
 	flash->flags.dual_output = part->fast_read_dual_output_support;
 	flash->flags.dual_io = part->fast_read_dual_io_support;
+	flash->flags.block_erase = part->block_erase_64k_support;
 
 	flash->ops = &vi->desc->ops;
 	flash->prot_ops = vi->prot_ops;
@@ -518,9 +534,215 @@ int spi_flash_probe(unsigned int bus, unsigned int cs, struct spi_flash *flash)
 	return 0;
 }
 
+/* Largest page size and batch nesting supported by the write batching. */
+#define BATCH_PAGE_SIZE		256
+#define BATCH_MAX_DEPTH		4
+#define BATCH_MAX_OWNERS	8
+
+struct batch_owner {
+	const char *name;
+	unsigned int writes;
+	unsigned int programs;
+	unsigned int erases;
+	long busy_usecs;
+};
+
+static struct batch_owner batch_owners[BATCH_MAX_OWNERS];
+
+static struct {
+	const struct spi_flash *flash;
+	unsigned int depth;
+	struct batch_owner *owner[BATCH_MAX_DEPTH];
+	int error;
+	/* Data held back for the page program starting at 'offset'. */
+	u32 offset;
+	size_t len;
+	u8 data[BATCH_PAGE_SIZE];
+} batch;
+
+static bool batch_active(const struct spi_flash *flash)
+{
+	return CONFIG(SPI_FLASH_WRITE_BATCHING) && batch.depth && batch.flash == flash;
+}
+
+static struct batch_owner *batch_current_owner(void)
+{
+	return batch.owner[MIN(batch.depth, BATCH_MAX_DEPTH) - 1];
+}
+
+static struct batch_owner *batch_find_owner(const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(batch_owners) - 1; i++) {
+		if (!batch_owners[i].name)
+			batch_owners[i].name = name;
+		if (!strcmp(batch_owners[i].name, name))
+			return &batch_owners[i];
+	}
+
+	/* Account everyone else together. */
+	batch_owners[i].name = "others";
+	return &batch_owners[i];
+}
+
+static void batch_report(const struct batch_owner *owner)
+{
+	printk(BIOS_DEBUG, "SF: %s: %u writes in %u page programs, %u erases, busy %ld us\n",
+	       owner->name, owner->writes, owner->programs, owner->erases, owner->busy_usecs);
+}
+
+static int batch_program(u32 offset, size_t len, const void *buf)
+{
+	struct batch_owner *owner = batch_current_owner();
+	const size_t page_size = batch.flash->page_size;
+	struct stopwatch sw;
+	int ret;
+
+	stopwatch_init(&sw);
+	ret = batch.flash->ops->write(batch.flash, offset, len, buf);
+	owner->busy_usecs += stopwatch_duration_usecs(&sw);
+	owner->programs += DIV_ROUND_UP(offset % page_size + len, page_size);
+
+	if (ret && !batch.error)
+		batch.error = ret;
+
+	return ret;
+}
+
+static int batch_flush(void)
+{
+	size_t len = batch.len;
+
+	if (!len)
+		return 0;
+
+	batch.len = 0;
+	return batch_program(batch.offset, len, batch.data);
+}
+
+static int batch_write(u32 offset, size_t len, const void *buf)
+{
+	const size_t page_size = batch.flash->page_size;
+	const u8 *data = buf;
+	size_t chunk;
+	int ret;
+
+	batch_current_owner()->writes++;
+
+	while (len) {
+		/* Only data that continues the pending write can be added to it. */
+		if (batch.len && offset != batch.offset + batch.len) {
+			ret = batch_flush();
+			if (ret)
+				return ret;
+		}
+
+		/* Whole pages are written right away. */
+		if (!batch.len && offset % page_size == 0 && len >= page_size) {
+			chunk = ALIGN_DOWN(len, page_size);
+			ret = batch_program(offset, chunk, data);
+			if (ret)
+				return ret;
+		} else {
+			chunk = MIN(len, page_size - offset % page_size);
+			if (!batch.len)
+				batch.offset = offset;
+			memcpy(&batch.data[batch.len], data, chunk);
+			batch.len += chunk;
+
+			/* Nothing can be added once the end of the page is reached. */
+			if ((offset + chunk) % page_size == 0) {
+				ret = batch_flush();
+				if (ret)
+					return ret;
+			}
+		}
+
+		offset += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+void spi_flash_batch_begin(const struct spi_flash *flash, const char *owner)
+{
+	if (!CONFIG(SPI_FLASH_WRITE_BATCHING))
+		return;
+
+	if (batch.depth == 0) {
+		/* Batching needs the page size, not all drivers provide it. */
+		if (!flash->page_size || !IS_POWER_OF_2(flash->page_size) ||
+		    flash->page_size > sizeof(batch.data)) {
+			printk(BIOS_WARNING, "SF: Page size %u not usable for batching\n",
+			       flash->page_size);
+			return;
+		}
+		batch.flash = flash;
+		batch.error = 0;
+	} else if (batch.flash != flash) {
+		return;
+	}
+
+	if (batch.depth < BATCH_MAX_DEPTH)
+		batch.owner[batch.depth] = batch_find_owner(owner);
+	batch.depth++;
+}
+
+int spi_flash_batch_end(const struct spi_flash *flash)
+{
+	struct batch_owner *owner;
+	int ret;
+
+	if (!batch_active(flash))
+		return 0;
+
+	owner = batch_current_owner();
+	if (batch.depth > 1) {
+		/* Deeper batches than tracked are accounted to the last tracked one. */
+		if (batch.depth <= BATCH_MAX_DEPTH)
+			batch_report(owner);
+		batch.depth--;
+		return 0;
+	}
+
+	if (batch.len) {
+		if (spi_flash_volatile_group_begin(flash))
+			batch.error = -1;
+		else
+			batch_flush();
+
+		if (spi_flash_volatile_group_end(flash))
+			batch.error = -1;
+	}
+
+	batch_report(owner);
+
+	ret = batch.error;
+	batch.error = 0;
+	batch.depth = 0;
+	return ret;
+}
+
 int spi_flash_read(const struct spi_flash *flash, u32 offset, size_t len,
 		void *buf)
 {
+	/* Reads have to see the data that was held back. */
+	if (batch_active(flash) && batch.len &&
+	    offset < batch.offset + batch.len && batch.offset < offset + len) {
+		int ret;
+
+		if (spi_flash_volatile_group_begin(flash))
+			return -1;
+
+		ret = batch_flush();
+
+		if (spi_flash_volatile_group_end(flash) || ret)
+			return -1;
+	}
+
 	return flash->ops->read(flash, offset, len, buf);
 }
 
@@ -532,7 +754,10 @@ int spi_flash_write(const struct spi_flash *flash, u32 offset, size_t len,
 	if (spi_flash_volatile_group_begin(flash))
 		return -1;
 
-	ret = flash->ops->write(flash, offset, len, buf);
+	if (batch_active(flash))
+		ret = batch_write(offset, len, buf);
+	else
+		ret = flash->ops->write(flash, offset, len, buf);
 
 	if (spi_flash_volatile_group_end(flash))
 		return -1;
@@ -542,13 +767,30 @@ int spi_flash_write(const struct spi_flash *flash, u32 offset, size_t len,
 
 int spi_flash_erase(const struct spi_flash *flash, u32 offset, size_t len)
 {
+	struct batch_owner *owner = NULL;
+	struct stopwatch sw;
 	int ret;
 
 	if (spi_flash_volatile_group_begin(flash))
 		return -1;
 
+	if (batch_active(flash)) {
+		/* Keep the order of the writes and erases. */
+		ret = batch_flush();
+		if (ret)
+			goto out;
+		owner = batch_current_owner();
+		stopwatch_init(&sw);
+	}
+
 	ret = flash->ops->erase(flash, offset, len);
 
+	if (owner) {
+		owner->busy_usecs += stopwatch_duration_usecs(&sw);
+		owner->erases++;
+	}
+
+out:
 	if (spi_flash_volatile_group_end(flash))
 		return -1;
 
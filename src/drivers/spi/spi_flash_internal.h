@@ -72,7 +72,8 @@ struct spi_flash_part_id {
 	uint16_t nr_sectors_shift: 4;
 	uint16_t fast_read_dual_output_support : 1;	/*  1-1-2 read */
 	uint16_t fast_read_dual_io_support : 1;		/*  1-2-2 read */
-	uint16_t _reserved_for_flags: 2;
+	uint16_t block_erase_64k_support : 1;		/* 0xd8 erases 64KiB */
+	uint16_t _reserved_for_flags: 1;
 	/* Block protection. Currently used by Winbond. */
 	uint16_t protection_granularity_shift : 5;
 	uint16_t bp_bits : 3;
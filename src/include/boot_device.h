@@ -56,6 +56,16 @@ int boot_device_rw_subregion(const struct region *sub,
 int boot_device_wp_region(const struct region_device *rd,
 				const enum bootdev_prot_type type);
 
+/*
+ * Batch the writes to the read-write boot device, see spi_flash_batch_begin().
+ * Writes may be held back until the matching boot_device_rw_batch_end(), which
+ * returns < 0 if one of them failed. Until then they are not visible through
+ * the read-only boot device. 'owner' names the caller for the flash busy time
+ * statistics.
+ */
+void boot_device_rw_batch_begin(const char *owner);
+int boot_device_rw_batch_end(void);
+
 /*
  * Initialize the boot device. This may be called multiple times within
  * a stage so boot device implementations should account for this behavior.
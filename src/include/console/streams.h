@@ -8,6 +8,8 @@
 
 void console_hw_init(void);
 void console_tx_byte(unsigned char byte);
+/* Same as console_tx_byte() for each byte, but faster for some consoles. */
+void console_tx_bytes(const void *buf, size_t len);
 void console_tx_flush(void);
 
 /*
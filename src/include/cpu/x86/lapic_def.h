@@ -16,10 +16,12 @@
 #define	LAPIC_TASKPRI	0x80
 #define		LAPIC_TPRI_MASK		0xFF
 #define LAPIC_ARBID	0x090
+#define LAPIC_EOI	0x0B0
 #define	LAPIC_RRR	0x0C0
 #define LAPIC_SVR	0x0f0
 #define LAPIC_SPIV	0x0f0
 #define		LAPIC_SPIV_ENABLE  0x100
+#define LAPIC_IRR	0x200
 #define LAPIC_ESR	0x280
 #define		LAPIC_ESR_SEND_CS	0x00001
 #define		LAPIC_ESR_RECV_CS	0x00002
@@ -0,0 +1,37 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef CPU_X86_SMI_PROFILE_H
+#define CPU_X86_SMI_PROFILE_H
+
+#include <commonlib/smi_profile_serialized.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if CONFIG(SMI_PROFILE)
+/* Allocate and clear the SMI profile log in CBMEM. Returns NULL on failure. */
+void *smi_profile_log_init(void);
+#else
+static inline void *smi_profile_log_init(void) { return NULL; }
+#endif
+
+#if CONFIG(SMI_PROFILE) && ENV_SMM
+/*
+ * Start recording an SMI on cpu, with the TSC taken when the handler was entered. log is the
+ * CBMEM log handed over by ramstage.
+ */
+void smi_profile_start(int cpu, uint64_t entry_tsc, uintptr_t log);
+/* Record a source (enum smi_profile_source) of the current SMI. */
+void smi_profile_add_source(uint32_t source);
+void smi_profile_set_apmc(uint8_t cmd);
+void smi_profile_set_handlers(uint32_t handlers);
+/* Commit the current SMI to the log. */
+void smi_profile_end(void);
+#else
+static inline void smi_profile_start(int cpu, uint64_t entry_tsc, uintptr_t log) {}
+static inline void smi_profile_add_source(uint32_t source) {}
+static inline void smi_profile_set_apmc(uint8_t cmd) {}
+static inline void smi_profile_set_handlers(uint32_t handlers) {}
+static inline void smi_profile_end(void) {}
+#endif
+
+#endif /* CPU_X86_SMI_PROFILE_H */
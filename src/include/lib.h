@@ -10,6 +10,13 @@
 /* Defined in src/lib/lzma.c. Returns decompressed size or 0 on error. */
 size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn);
 
+/* Same as ulzman() but uses the caller-provided scratchpad of at least
+   ULZMAN_SCRATCHPAD_SIZE bytes instead of a static one. This allows to run
+   multiple decompressions concurrently. */
+#define ULZMAN_SCRATCHPAD_SIZE 15980
+size_t ulzman_scratchpad(const void *src, size_t srcn, void *dst, size_t dstn,
+			 void *scratchpad);
+
 /* Defined in src/lib/ramtest.c */
 /* Assumption is 32-bit addressable UC memory. */
 void ram_check(uintptr_t start);
@@ -9,10 +9,17 @@
 /* A memranges structure consists of a list of range_entry(s). The structure
  * is exposed so that a memranges can be used on the stack if needed. */
 struct memranges {
+	/* Entries sorted by address, used for iteration. */
 	struct range_entry *entries;
+	/* Root of the search tree indexing the same entries by address. */
+	struct range_entry *root;
 	/* coreboot doesn't have a free() function. Therefore, keep a cache of
-	 * free'd entries.  */
+	 * free'd entries provided by the caller. Entries allocated by the
+	 * library itself are returned to a shared pool instead. */
 	struct range_entry *free_list;
+	/* Caller-provided array of entries backing free_list. */
+	struct range_entry *local_entries;
+	size_t num_local;
 	/* Alignment(log 2) for base and end addresses of the range. */
 	unsigned char align;
 };
@@ -26,6 +33,9 @@ struct range_entry {
 	resource_t end;
 	unsigned long tag;
 	struct range_entry *next;
+	/* Search tree links. Only to be used by the memrange library. */
+	struct range_entry *left;
+	struct range_entry *right;
 };
 
 /* Initialize a range_entry with inclusive beginning address and exclusive
@@ -38,6 +48,8 @@ static inline void range_entry_init(struct range_entry *re,
 	re->end = excl_end - 1;
 	re->tag = tag;
 	re->next = NULL;
+	re->left = NULL;
+	re->right = NULL;
 }
 
 /* Return inclusive base address of memory range. */
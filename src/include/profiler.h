@@ -0,0 +1,31 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <stdint.h>
+
+#if CONFIG(RAMSTAGE_PROFILER) && ENV_RAMSTAGE
+/* Record the interrupted instruction pointer, called from the sampling interrupt. */
+void profiler_record(uintptr_t ip);
+
+/*
+ * Stop sampling around code that installs its own interrupt handlers, like option ROMs or
+ * FSP. Calls nest, sampling resumes when the outermost pause ends.
+ */
+void profiler_pause(void);
+void profiler_resume(void);
+
+/*
+ * Architecture hooks. arch_profiler_init() sets up a periodic interrupt at hz, without
+ * starting it, and returns 0 on success. The interrupt handler calls profiler_record().
+ */
+int arch_profiler_init(unsigned int hz);
+void arch_profiler_arm(void);
+void arch_profiler_disarm(void);
+#else
+static inline void profiler_pause(void) {}
+static inline void profiler_resume(void) {}
+#endif
+
+#endif /* __PROFILER_H__ */
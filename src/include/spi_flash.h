@@ -88,7 +88,8 @@ struct spi_flash {
 		struct {
 			u8 dual_output	: 1;
 			u8 dual_io	: 1;
-			u8 _reserved	: 6;
+			u8 block_erase	: 1;
+			u8 _reserved	: 5;
 		};
 	} flags;
 	u16 model;
@@ -193,6 +194,22 @@ spi_flash_set_write_protected(const struct spi_flash *flash,
 int spi_flash_volatile_group_begin(const struct spi_flash *flash);
 int spi_flash_volatile_group_end(const struct spi_flash *flash);
 
+/*
+ * Write batching: Between spi_flash_batch_begin() and the matching
+ * spi_flash_batch_end(), a write that ends within a flash page is held back,
+ * so that the next one can continue it in the same page program. The pending
+ * data is written before a read of the same range, before any erase and at
+ * the latest when the outermost batch ends. The time the flash is busy with
+ * writes and erases is accounted to 'owner' of the innermost batch, and the
+ * totals of an owner are printed whenever one of its batches ends.
+ *
+ * Batches nest. spi_flash_batch_end() returns non-zero if a write that was
+ * held back failed. Only available with CONFIG(SPI_FLASH_WRITE_BATCHING),
+ * otherwise writes are not held back.
+ */
+void spi_flash_batch_begin(const struct spi_flash *flash, const char *owner);
+int spi_flash_batch_end(const struct spi_flash *flash);
+
 /*
  * These are callbacks for marking the start and end of volatile group as
  * handled by the chipset. Not every chipset requires this special handling. So,
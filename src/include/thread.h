@@ -6,6 +6,7 @@
 #include <bootstate.h>
 #include <commonlib/bsd/cb_err.h>
 #include <stdint.h>
+#include <timer.h>
 
 struct thread_mutex {
 	bool locked;
@@ -13,6 +14,7 @@ struct thread_mutex {
 
 enum thread_state {
 	THREAD_UNINITIALIZED,
+	THREAD_QUEUED,
 	THREAD_STARTED,
 	THREAD_DONE,
 };
@@ -23,9 +25,10 @@ struct thread_handle {
 	enum cb_err error;
 };
 
-/* Run func(arg) on a new thread. Return 0 on successful start of thread, < 0
- * when thread could not be started. The thread handle if populated, will
- * reflect the state and return code of the thread.
+/* Run func(arg) on a new thread. If all threads are busy, func(arg) is queued
+ * and started once one is free. Return 0 on successful start or queueing of
+ * the thread, < 0 when thread could not be started. The thread handle if
+ * populated, will reflect the state and return code of the thread.
  */
 int thread_run(struct thread_handle *handle, enum cb_err (*func)(void *), void *arg);
 
@@ -49,6 +52,13 @@ struct thread {
 	void *entry_arg;
 	int can_yield;
 	struct thread_handle *handle;
+	/* Handle of the thread this one waits for in thread_join(). */
+	struct thread_handle *join_handle;
+	/* Scheduler statistics, printed before the payload is booted. */
+	struct mono_time switched;
+	long run_usecs;
+	long blocked_usecs;
+	unsigned int yields;
 };
 
 void threads_initialize(void);
@@ -45,6 +45,10 @@ void timer_monotonic_get(struct mono_time *mt);
 /* Returns 1 if callbacks still present in the queue. 0 if no timers left. */
 int timers_run(void);
 
+/* Returns the number of microseconds until the next callback expires, 0 if it
+ * already has and < 0 if no callbacks are queued. */
+long timers_usecs_to_next(void);
+
 /* Schedule a callback to be ran microseconds from time of invocation.
  * 0 returned on success, < 0 on error. */
 int timer_sched_callback(struct timeout_callback *tocb, unsigned long us);
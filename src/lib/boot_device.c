@@ -14,6 +14,16 @@ int __weak boot_device_wp_region(const struct region_device *rd,
 	return -1;
 }
 
+void __weak boot_device_rw_batch_begin(const char *owner)
+{
+	/* Writes are not batched by default. */
+}
+
+int __weak boot_device_rw_batch_end(void)
+{
+	return 0;
+}
+
 static int boot_device_subregion(const struct region *sub,
 				struct region_device *subrd,
 				const struct region_device *parent)
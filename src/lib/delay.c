@@ -1,7 +1,17 @@
 #include <delay.h>
+#include <limits.h>
+#include <thread.h>
+#include <timer.h>
+
 void mdelay(unsigned int msecs)
 {
 	unsigned int i;
+
+	/* Yield once for the whole delay instead of once per millisecond. */
+	if (msecs < UINT_MAX / USECS_PER_MSEC &&
+	    !thread_yield_microseconds(msecs * USECS_PER_MSEC + 1))
+		return;
+
 	for (i = 0; i < msecs; i++)
 		udelay(1000);
 }
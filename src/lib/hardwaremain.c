@@ -299,8 +299,10 @@ static void bs_call_callbacks(struct boot_state *state,
 
 		/* Something is blocking this state from transitioning. As
 		 * there are no more callbacks a pending timer needs to be
-		 * ran to unblock the state. */
-		bs_run_timers(0);
+		 * ran to unblock the state. If possible, yield instead so
+		 * that the idle thread can also start queued threads. */
+		if (thread_yield())
+			bs_run_timers(0);
 	}
 }
 
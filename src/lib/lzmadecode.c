@@ -20,7 +20,8 @@
 */
 
 #include "lzmadecode.h"
-#include <types.h>
+#include <stdint.h>
+#include <string.h>
 
 #define kNumTopBits 24
 #define kTopValue ((UInt32)1 << kNumTopBits)
@@ -32,22 +33,35 @@
 /* Use 32-bit reads whenever possible to avoid bad flash performance. Fall back
  * to byte reads for last 4 bytes since RC_TEST returns an error when BufferLim
  * is *reached* (not surpassed!), meaning we can't allow that to happen while
- * there are still bytes to decode from the algorithm's point of view. */
-#define RC_READ_BYTE							\
-	(look_ahead_ptr < 4 ? look_ahead.raw[look_ahead_ptr++]		\
-	: ((((uintptr_t) Buffer & 3)					\
-		|| ((SizeT) (BufferLim - Buffer) <= 4)) ? (*Buffer++)	\
-	: ((look_ahead.dw = *(UInt32 *)Buffer), (Buffer += 4),		\
-		(look_ahead_ptr = 1), look_ahead.raw[0])))
+ * there are still bytes to decode from the algorithm's point of view.
+ * Bytes already held in the look-ahead buffer have been bounds checked when
+ * it was filled, so RC_TEST only needs to run when it is refilled. */
+#define RC_REFILL							\
+	if (((uintptr_t) Buffer & 3)					\
+		|| ((SizeT) (BufferLim - Buffer) <= 4)) {		\
+		look_ahead.raw[3] = *Buffer++;				\
+		look_ahead_ptr = 3;					\
+	} else {							\
+		look_ahead.dw = *(const UInt32 *)Buffer;		\
+		Buffer += 4;						\
+		look_ahead_ptr = 0;					\
+	}
+
+#define RC_READ_BYTE(dst)					\
+{								\
+	if (look_ahead_ptr == 4) {				\
+		RC_TEST;					\
+		RC_REFILL;					\
+	}							\
+	dst = (dst << 8) | look_ahead.raw[look_ahead_ptr++];	\
+}
 
 #define RC_INIT2 Code = 0; Range = 0xFFFFFFFF;		\
 {							\
 	int i;						\
 							\
-	for (i = 0; i < 5; i++) {			\
-		RC_TEST;				\
-		Code = (Code << 8) | RC_READ_BYTE;	\
-	}						\
+	for (i = 0; i < 5; i++)				\
+		RC_READ_BYTE(Code);			\
 }
 
 
@@ -59,37 +73,55 @@
 
 #define RC_NORMALIZE					\
 	if (Range < kTopValue) {			\
-		RC_TEST;				\
 		Range <<= 8;				\
-		Code = (Code << 8) | RC_READ_BYTE;	\
+		RC_READ_BYTE(Code);			\
 	}
 
+/*
+ * The probability is kept in a local: stores to the output buffer may alias
+ * the probability array, which would force the compiler to reload it.
+ */
 #define IfBit0(p)						\
+	ttt = *(p);						\
 	RC_NORMALIZE;						\
-	bound = (Range >> kNumBitModelTotalBits) * *(p);	\
+	bound = (Range >> kNumBitModelTotalBits) * ttt;		\
 	if (Code < bound)
 
 #define UpdateBit0(p)						\
 	Range = bound;						\
-	*(p) += (kBitModelTotal - *(p)) >> kNumMoveBits
+	*(p) = (CProb)(ttt + ((kBitModelTotal - ttt) >> kNumMoveBits))
 
 #define UpdateBit1(p)				\
 	Range -= bound;				\
 	Code -= bound;				\
-	*(p) -= (*(p)) >> kNumMoveBits
-
-#define RC_GET_BIT2(p, mi, A0, A1)			\
-	IfBit0(p) {					\
-		 UpdateBit0(p);				\
-		 mi <<= 1;				\
-		 A0;					\
-	} else {					\
-		UpdateBit1(p);				\
-		mi = (mi + mi) + 1;			\
-		A1;					\
-	}
+	*(p) = (CProb)(ttt - (ttt >> kNumMoveBits))
 
-#define RC_GET_BIT(p, mi) RC_GET_BIT2(p, mi, ;, ;)
+/*
+ * Branchless bit decoding for the bit trees, whose bits are hard to predict.
+ * mask is set to all ones for a 1 bit and to zero for a 0 bit.
+ */
+#define RC_GET_BIT_MASK(p, mi, mask)					\
+{									\
+	UInt32 t0, t1;							\
+									\
+	ttt = *(p);							\
+	RC_NORMALIZE;							\
+	bound = (Range >> kNumBitModelTotalBits) * ttt;			\
+	mask = (UInt32)0 - (Code >= bound);				\
+	Range = bound ^ ((bound ^ (Range - bound)) & mask);		\
+	Code -= bound & mask;						\
+	t0 = ttt + ((kBitModelTotal - ttt) >> kNumMoveBits);		\
+	t1 = ttt - (ttt >> kNumMoveBits);				\
+	*(p) = (CProb)(t0 ^ ((t0 ^ t1) & mask));			\
+	mi = (mi << 1) + (mask & 1);					\
+}
+
+#define RC_GET_BIT(p, mi)			\
+{						\
+	UInt32 mask;				\
+						\
+	RC_GET_BIT_MASK(p, mi, mask);		\
+}
 
 #define RangeDecoderBitTreeDecode(probs, numLevels, res)	\
 {								\
@@ -103,6 +135,9 @@
 	res -= (1 << numLevels);				\
 }
 
+/* Matches at least this long and not overlapping their source use memcpy(). */
+#define kMinMemcpyLen 16
+
 
 #define kNumPosBitsMax 4
 #define kNumPosStatesMax (1 << kNumPosBitsMax)
@@ -225,6 +260,7 @@ int LzmaDecode(CLzmaDecoderState *vs,
 	while (nowPos < outSize) {
 		CProb *prob;
 		UInt32 bound;
+		UInt32 ttt;
 		int posState = (int)((nowPos)&posStateMask);
 
 		prob = p + IsMatch + (state << kNumPosBitsMax) + posState;
@@ -236,24 +272,28 @@ int LzmaDecode(CLzmaDecoderState *vs,
 				+ (previousByte >> (8 - lc))));
 
 			if (state >= kNumLitStates) {
-				int matchByte;
-				matchByte = outStream[nowPos - rep0];
+				/*
+				 * Instead of leaving the matched loop on the
+				 * first mismatching bit, offs is cleared then
+				 * and the remaining bits index the plain
+				 * literal probabilities.
+				 */
+				UInt32 matchByte = outStream[nowPos - rep0];
+				UInt32 offs = 0x100;
 				do {
-					int bit;
+					UInt32 bit, mask;
 					CProb *probLit;
 					matchByte <<= 1;
-					bit = (matchByte & 0x100);
-					probLit = prob + 0x100 + bit + symbol;
-					RC_GET_BIT2(probLit, symbol,
-						if (bit != 0)
-							break,
-						if (bit == 0)
-							break)
+					bit = (matchByte & offs);
+					probLit = prob + offs + bit + symbol;
+					RC_GET_BIT_MASK(probLit, symbol, mask);
+					offs &= bit ^ ~mask;
+				} while (symbol < 0x100);
+			} else {
+				do {
+					CProb *probLit = prob + symbol;
+					RC_GET_BIT(probLit, symbol)
 				} while (symbol < 0x100);
-			}
-			while (symbol < 0x100) {
-				CProb *probLit = prob + symbol;
-				RC_GET_BIT(probLit, symbol)
 			}
 			previousByte = (Byte)symbol;
 
@@ -395,8 +435,11 @@ int LzmaDecode(CLzmaDecoderState *vs,
 						do {
 							CProb *prob3 = prob
 								+ mi;
-							RC_GET_BIT2(prob3, mi,
-								;, rep0 |= i);
+							UInt32 mask;
+
+							RC_GET_BIT_MASK(prob3, mi,
+								mask);
+							rep0 |= i & mask;
 							i <<= 1;
 						} while (--numDirectBits != 0);
 					}
@@ -413,12 +456,26 @@ int LzmaDecode(CLzmaDecoderState *vs,
 			if (rep0 > nowPos)
 				return LZMA_RESULT_DATA_ERROR;
 
+			{
+				SizeT curLen = outSize - nowPos;
+				Byte *dest = outStream + nowPos;
+				const Byte *src = dest - rep0;
 
-			do {
-				previousByte = outStream[nowPos - rep0];
-				len--;
-				outStream[nowPos++] = previousByte;
-			} while (len != 0 && nowPos < outSize);
+				if (curLen > (SizeT)len)
+					curLen = len;
+				nowPos += curLen;
+
+				if (curLen >= kMinMemcpyLen && rep0 >= curLen) {
+					memcpy(dest, src, curLen);
+				} else {
+					const Byte *lim = dest + curLen;
+
+					do {
+						*dest++ = *src++;
+					} while (dest != lim);
+				}
+				previousByte = outStream[nowPos - 1];
+			}
 		}
 	}
 	RC_NORMALIZE;
@@ -6,6 +6,25 @@
 #include <console/console.h>
 #include <memrange.h>
 
+/*
+ * Entries of a memranges are kept in two structures at the same time: a list
+ * sorted by address, which is what memranges_each_entry() walks, and a treap
+ * keyed by the begin address. The treap allows finding the entries affected by
+ * an insert or a removal in O(log n) expected time instead of walking the list
+ * from its head. Since all entries are disjoint, ordering by begin also orders
+ * them by end.
+ *
+ * memranges_update_tag() and memranges_fill_holes_up_to() still visit every
+ * entry, but add or drop entries in the treap one by one. memranges_steal()
+ * searches the entries in order, since a match depends on tag and alignment.
+ */
+
+/* Number of entries allocated at once when the shared pool runs dry. */
+#define RANGE_POOL_CHUNK 32
+
+/* Entries allocated by the library and released by memranges_teardown(). */
+static struct range_entry *range_pool;
+
 static inline void range_entry_link(struct range_entry **prev_ptr,
 				    struct range_entry *r)
 {
@@ -20,28 +39,149 @@ static inline void range_entry_unlink(struct range_entry **prev_ptr,
 	r->next = NULL;
 }
 
-static inline void range_entry_unlink_and_free(struct memranges *ranges,
-					       struct range_entry **prev_ptr,
-					       struct range_entry *r)
+static bool range_entry_is_local(const struct memranges *ranges,
+				 const struct range_entry *r)
+{
+	return r >= ranges->local_entries &&
+	       r < ranges->local_entries + ranges->num_local;
+}
+
+static void free_range(struct memranges *ranges, struct range_entry *r)
 {
-	range_entry_unlink(prev_ptr, r);
-	range_entry_link(&ranges->free_list, r);
+	r->left = NULL;
+	r->right = NULL;
+
+	if (range_entry_is_local(ranges, r))
+		range_entry_link(&ranges->free_list, r);
+	else
+		range_entry_link(&range_pool, r);
 }
 
 static struct range_entry *alloc_range(struct memranges *ranges)
 {
-	if (ranges->free_list != NULL) {
-		struct range_entry *r;
+	struct range_entry **list = NULL;
+	struct range_entry *r;
+
+	if (ranges->free_list != NULL)
+		list = &ranges->free_list;
+	else if (range_pool != NULL)
+		list = &range_pool;
+
+	if (list == NULL && ENV_PAYLOAD_LOADER) {
+		size_t i;
+
+		r = malloc(RANGE_POOL_CHUNK * sizeof(*r));
+		if (r == NULL)
+			return NULL;
+		for (i = 0; i < RANGE_POOL_CHUNK; i++)
+			range_entry_link(&range_pool, &r[i]);
+		list = &range_pool;
+	}
+
+	if (list == NULL)
+		return NULL;
+
+	r = *list;
+	range_entry_unlink(list, r);
+	r->left = NULL;
+	r->right = NULL;
+	return r;
+}
+
+/* Heap priority of a treap node. Derived from the entry address so that no
+ * extra state is needed while still being well distributed. */
+static uint32_t range_entry_priority(const struct range_entry *r)
+{
+	uint64_t x = (uintptr_t)r;
+
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	return (uint32_t)x;
+}
+
+/* Split tree t into l, holding the entries with begin < key (begin <= key if
+ * inclusive is set), and r holding all the others. */
+static void tree_split(struct range_entry *t, resource_t key, bool inclusive,
+		       struct range_entry **l, struct range_entry **r)
+{
+	if (t == NULL) {
+		*l = NULL;
+		*r = NULL;
+		return;
+	}
+
+	if (t->begin < key || (inclusive && t->begin == key)) {
+		tree_split(t->right, key, inclusive, &t->right, r);
+		*l = t;
+	} else {
+		tree_split(t->left, key, inclusive, l, &t->left);
+		*r = t;
+	}
+}
 
-		r = ranges->free_list;
-		range_entry_unlink(&ranges->free_list, r);
+/* Join two trees where every entry of l is below every entry of r. */
+static struct range_entry *tree_merge(struct range_entry *l, struct range_entry *r)
+{
+	if (l == NULL)
 		return r;
+	if (r == NULL)
+		return l;
+
+	if (range_entry_priority(l) > range_entry_priority(r)) {
+		l->right = tree_merge(l->right, r);
+		return l;
 	}
-	if (ENV_PAYLOAD_LOADER)
-		return malloc(sizeof(struct range_entry));
-	return NULL;
+
+	r->left = tree_merge(l, r->left);
+	return r;
+}
+
+static struct range_entry *tree_max(struct range_entry *t)
+{
+	if (t == NULL)
+		return NULL;
+	while (t->right != NULL)
+		t = t->right;
+	return t;
+}
+
+/* Add entry r, which must not overlap any other entry, to the search tree. */
+static void tree_insert(struct memranges *ranges, struct range_entry *r)
+{
+	struct range_entry *lo, *hi;
+
+	tree_split(ranges->root, r->begin, false, &lo, &hi);
+	r->left = NULL;
+	r->right = NULL;
+	ranges->root = tree_merge(tree_merge(lo, r), hi);
+}
+
+/* Take entry r out of the search tree. */
+static void tree_remove(struct memranges *ranges, struct range_entry *r)
+{
+	struct range_entry *lo, *mid, *hi;
+
+	tree_split(ranges->root, r->begin, false, &lo, &mid);
+	tree_split(mid, r->begin, true, &mid, &hi);
+	assert(mid == r);
+	ranges->root = tree_merge(lo, hi);
 }
 
+/* Build the search tree from the sorted list, for a freshly copied list. */
+static void rebuild_tree(struct memranges *ranges)
+{
+	struct range_entry *cur;
+
+	ranges->root = NULL;
+	for (cur = ranges->entries; cur != NULL; cur = cur->next) {
+		cur->left = NULL;
+		cur->right = NULL;
+		ranges->root = tree_merge(ranges->root, cur);
+	}
+}
+
+/* Add a new entry to the sorted list only. Callers must add it to the tree. */
 static inline struct range_entry *
 range_list_add(struct memranges *ranges, struct range_entry **prev_ptr,
 	       resource_t begin, resource_t end, unsigned long tag)
@@ -80,7 +220,9 @@ static void merge_neighbor_entries(struct memranges *ranges)
 		 * the list. */
 		if (prev->end + 1 >= cur->begin && prev->tag == cur->tag) {
 			prev->end = cur->end;
-			range_entry_unlink_and_free(ranges, &prev->next, cur);
+			range_entry_unlink(&prev->next, cur);
+			tree_remove(ranges, cur);
+			free_range(ranges, cur);
 			/* Set cur to prev so cur->next is valid since cur
 			 * was just unlinked and free. */
 			cur = prev;
@@ -95,100 +237,114 @@ static void remove_memranges(struct memranges *ranges,
 			     resource_t begin, resource_t end,
 			     unsigned long unused)
 {
+	struct range_entry *lo, *mid, *hi;
+	struct range_entry *prev;
 	struct range_entry *cur;
 	struct range_entry *next;
-	struct range_entry **prev_ptr;
 
-	prev_ptr = &ranges->entries;
-	for (cur = ranges->entries; cur != NULL; cur = next) {
-		resource_t tmp_end;
+	/* lo: entries starting below the removal range, mid: entries starting
+	 * within it, hi: entries starting after it. */
+	tree_split(ranges->root, begin, false, &lo, &mid);
+	tree_split(mid, end, true, &mid, &hi);
 
-		/* Cache the next value to handle unlinks. */
+	prev = tree_max(lo);
+	cur = prev != NULL ? prev->next : ranges->entries;
+
+	/* Entries starting within the range are removed, except for a tail
+	 * extending past the end of the range. */
+	for (; cur != NULL && cur->begin <= end; cur = next) {
 		next = cur->next;
 
-		/* No other ranges are affected. */
-		if (end < cur->begin)
+		if (cur->end > end) {
+			cur->begin = end + 1;
+			cur->left = NULL;
+			cur->right = NULL;
+			hi = tree_merge(cur, hi);
 			break;
-
-		/* The removal range starts after this one. */
-		if (begin > cur->end) {
-			prev_ptr = &cur->next;
-			continue;
 		}
 
-		/* The removal range overlaps with the current entry either
-		 * partially or fully. However, we need to adjust the removal
-		 * range for any holes. */
-		if (begin <= cur->begin) {
-			begin = cur->begin;
-
-			/* Full removal. */
-			if (end >= cur->end) {
-				begin = cur->end + 1;
-				range_entry_unlink_and_free(ranges, prev_ptr,
-							    cur);
-				continue;
-			}
-		}
-
-		/* prev_ptr can be set now that the unlink path wasn't taken. */
-		prev_ptr = &cur->next;
-
-		/* Clip the end fragment to do proper splitting. */
-		tmp_end = end;
-		if (end > cur->end)
-			tmp_end = cur->end;
+		free_range(ranges, cur);
+	}
 
+	/* The previous entry may overlap with the beginning of the range. */
+	if (prev != NULL && prev->end >= begin) {
 		/* Hole punched in middle of entry. */
-		if (begin > cur->begin && tmp_end < cur->end) {
-			range_list_add(ranges, &cur->next, end + 1, cur->end,
-				       cur->tag);
-			cur->end = begin - 1;
-			break;
+		if (prev->end > end) {
+			struct range_entry *tail = alloc_range(ranges);
+
+			if (tail == NULL) {
+				printk(BIOS_ERR, "Could not allocate range_entry!\n");
+			} else {
+				tail->begin = end + 1;
+				tail->end = prev->end;
+				tail->tag = prev->tag;
+				tail->next = cur;
+				hi = tree_merge(tail, hi);
+				cur = tail;
+			}
 		}
+		prev->end = begin - 1;
+	}
 
-		/* Removal at beginning. */
-		if (begin == cur->begin)
-			cur->begin = tmp_end + 1;
+	if (prev != NULL)
+		prev->next = cur;
+	else
+		ranges->entries = cur;
 
-		/* Removal at end. */
-		if (tmp_end == cur->end)
-			cur->end = begin - 1;
-	}
+	ranges->root = tree_merge(lo, hi);
 }
 
 static void merge_add_memranges(struct memranges *ranges,
 				resource_t begin, resource_t end,
 				unsigned long tag)
 {
+	struct range_entry *lo, *hi;
+	struct range_entry *prev;
+	struct range_entry *next;
 	struct range_entry *cur;
-	struct range_entry **prev_ptr;
-
-	prev_ptr = &ranges->entries;
 
 	/* Remove all existing entries covered by the range. */
 	remove_memranges(ranges, begin, end, -1);
 
-	/* Find the entry to place the new entry after. Since
-	 * remove_memranges() was called above there is a guaranteed
-	 * spot for this new entry. */
-	for (cur = ranges->entries; cur != NULL; cur = cur->next) {
-		/* Found insertion spot before current entry. */
-		if (end < cur->begin)
-			break;
-
-		/* Keep track of previous entry to insert new entry after it. */
-		prev_ptr = &cur->next;
+	/* Since remove_memranges() was called above there is a guaranteed
+	 * spot for this new entry between prev and next. */
+	tree_split(ranges->root, begin, false, &lo, &hi);
+	prev = tree_max(lo);
+	next = prev != NULL ? prev->next : ranges->entries;
+
+	/* Add new entry unless it can be merged with its predecessor. */
+	if (prev != NULL && prev->tag == tag && prev->end + 1 == begin) {
+		prev->end = end;
+		cur = prev;
+	} else {
+		cur = alloc_range(ranges);
+		if (cur == NULL) {
+			printk(BIOS_ERR, "Could not allocate range_entry!\n");
+			ranges->root = tree_merge(lo, hi);
+			return;
+		}
+		cur->begin = begin;
+		cur->end = end;
+		cur->tag = tag;
+		cur->next = next;
+		if (prev != NULL)
+			prev->next = cur;
+		else
+			ranges->entries = cur;
+		lo = tree_merge(lo, cur);
+	}
 
-		/* The new entry starts after this one. */
-		if (begin > cur->end)
-			continue;
+	/* Merge with the following entry, which is the lowest one in hi. */
+	if (next != NULL && next->tag == tag && cur->end + 1 == next->begin) {
+		struct range_entry *first;
 
+		tree_split(hi, next->begin, true, &first, &hi);
+		cur->end = next->end;
+		cur->next = next->next;
+		free_range(ranges, next);
 	}
 
-	/* Add new entry and merge with neighbors. */
-	range_list_add(ranges, prev_ptr, begin, end, tag);
-	merge_neighbor_entries(ranges);
+	ranges->root = tree_merge(lo, hi);
 }
 
 void memranges_update_tag(struct memranges *ranges, unsigned long old_tag,
@@ -287,7 +443,10 @@ void memranges_init_empty_with_alignment(struct memranges *ranges,
 	size_t i;
 
 	ranges->entries = NULL;
+	ranges->root = NULL;
 	ranges->free_list = NULL;
+	ranges->local_entries = to_free;
+	ranges->num_local = num_free;
 	ranges->align = align;
 
 	for (i = 0; i < num_free; i++)
@@ -314,16 +473,24 @@ void memranges_clone(struct memranges *newranges, struct memranges *oldranges)
 	memranges_each_entry(r, oldranges) {
 		cur = range_list_add(newranges, prev_ptr, r->begin, r->end,
 				     r->tag);
+		if (cur == NULL)
+			break;
 		prev_ptr = &cur->next;
 	}
+
+	rebuild_tree(newranges);
 }
 
 void memranges_teardown(struct memranges *ranges)
 {
+	struct range_entry *r;
+
 	while (ranges->entries != NULL) {
-		range_entry_unlink_and_free(ranges, &ranges->entries,
-					    ranges->entries);
+		r = ranges->entries;
+		range_entry_unlink(&ranges->entries, r);
+		free_range(ranges, r);
 	}
+	ranges->root = NULL;
 }
 
 void memranges_fill_holes_up_to(struct memranges *ranges,
@@ -340,16 +507,23 @@ void memranges_fill_holes_up_to(struct memranges *ranges,
 			continue;
 		}
 
+		/* The previous entry already reaches the requested limit. */
+		if (range_entry_end(prev) >= limit)
+			break;
+
 		/* If the previous entry does not directly precede the current
 		 * entry then add a new entry just after the previous one. */
 		if (range_entry_end(prev) != cur->begin) {
+			struct range_entry *hole;
 			resource_t end;
 
 			end = cur->begin - 1;
 			if (end >= limit)
 				end = limit - 1;
-			range_list_add(ranges, &prev->next,
-				       range_entry_end(prev), end, tag);
+			hole = range_list_add(ranges, &prev->next,
+					      range_entry_end(prev), end, tag);
+			if (hole != NULL)
+				tree_insert(ranges, hole);
 		}
 
 		prev = cur;
@@ -362,9 +536,12 @@ void memranges_fill_holes_up_to(struct memranges *ranges,
 
 	/* Handle the case where the limit was never reached. A new entry needs
 	 * to be added to cover the range up to the limit. */
-	if (prev != NULL && range_entry_end(prev) < limit)
-		range_list_add(ranges, &prev->next, range_entry_end(prev),
-			       limit - 1, tag);
+	if (prev != NULL && range_entry_end(prev) < limit) {
+		cur = range_list_add(ranges, &prev->next, range_entry_end(prev),
+				     limit - 1, tag);
+		if (cur != NULL)
+			tree_insert(ranges, cur);
+	}
 
 	/* Merge all entries that were newly added. */
 	merge_neighbor_entries(ranges);
@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootstate.h>
+#include <cbmem.h>
+#include <commonlib/ramstage_profile_serialized.h>
+#include <console/console.h>
+#include <profiler.h>
+#include <string.h>
+#include <symbols.h>
+
+static struct ramstage_profile *profile;
+static unsigned int pause_depth;
+static int running;
+
+void profiler_record(uintptr_t ip)
+{
+	if (!profile)
+		return;
+
+	profile->samples[profile->num_samples++ % profile->max_samples] = ip;
+}
+
+void profiler_pause(void)
+{
+	if (running && pause_depth++ == 0)
+		arch_profiler_disarm();
+}
+
+void profiler_resume(void)
+{
+	if (running && --pause_depth == 0)
+		arch_profiler_arm();
+}
+
+static void profiler_start(void *unused)
+{
+	const size_t size = sizeof(*profile) +
+		CONFIG_RAMSTAGE_PROFILER_SAMPLES * sizeof(profile->samples[0]);
+
+	profile = cbmem_add(CBMEM_ID_PROFILE, size);
+	if (!profile) {
+		printk(BIOS_ERR, "Profiler: could not allocate %zu bytes in CBMEM\n", size);
+		return;
+	}
+
+	memset(profile, 0, sizeof(*profile));
+	profile->max_samples = CONFIG_RAMSTAGE_PROFILER_SAMPLES;
+	profile->frequency = CONFIG_RAMSTAGE_PROFILER_HZ;
+	profile->program_base = (uintptr_t)_program;
+
+	if (arch_profiler_init(CONFIG_RAMSTAGE_PROFILER_HZ)) {
+		printk(BIOS_ERR, "Profiler: no sampling timer available\n");
+		return;
+	}
+
+	printk(BIOS_INFO, "Profiler: sampling ramstage at %u Hz\n",
+	       CONFIG_RAMSTAGE_PROFILER_HZ);
+	running = 1;
+	arch_profiler_arm();
+}
+
+static void profiler_stop(void *unused)
+{
+	if (!running)
+		return;
+
+	if (!pause_depth)
+		arch_profiler_disarm();
+	running = 0;
+
+	printk(BIOS_INFO, "Profiler: %u samples recorded\n", profile->num_samples);
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_ENTRY, profiler_start, NULL);
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, profiler_stop, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, profiler_stop, NULL);
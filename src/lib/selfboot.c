@@ -14,6 +14,13 @@
 #include <timestamp.h>
 #include <cbmem.h>
 
+#if CONFIG(PAYLOAD_PARALLEL_DECOMPRESSION)
+#include <arch/cpu.h>
+#include <cpu/x86/mp.h>
+#include <smp/spinlock.h>
+#include <timer.h>
+#endif
+
 /* The type syntax for C is essentially unparsable. -- Rob Pike */
 typedef int (*checker_t)(struct cbfs_payload_segment *cbfssegs, void *args);
 
@@ -125,6 +132,254 @@ static int load_one_segment(uint8_t *dest,
 	return 1;
 }
 
+#if CONFIG(PAYLOAD_PARALLEL_DECOMPRESSION)
+/*
+ * Segments are independently compressed and target disjoint memory, so they can be
+ * decompressed concurrently. Loadable segments are queued until the entry point is reached,
+ * then the BSP and all APs (which wait for work at this point) pick segments from the queue
+ * until it is empty. A segment overlapping with a queued one flushes the queue first to
+ * preserve the order in which the payload expects them to be loaded.
+ *
+ * An AP that did not accept the work before mp_run_on_aps() timed out keeps the callback
+ * armed and may run it at any later point. Every flush therefore hands a new generation
+ * number to the workers, and a worker started for an older generation returns right away.
+ */
+#define MAX_QUEUED_SEGMENTS 16
+#define MAX_SEGMENT_WORKERS MIN(CONFIG_MAX_CPUS, 8)
+
+struct segment_job {
+	uint8_t *dest;
+	uint8_t *src;
+	size_t len;
+	size_t memsz;
+	uint32_t compression;
+	int flags;
+	/* Bytes produced by decompression, 0 on error. */
+	size_t loaded;
+};
+
+static struct {
+	struct segment_job jobs[MAX_QUEUED_SEGMENTS];
+	size_t num_jobs;
+	/* Following fields are protected by segment_jobs_lock. */
+	size_t next_job;
+	size_t completed;
+	size_t num_workers;
+	size_t active_workers;
+	uintptr_t generation;
+	bool running;
+	uint8_t *scratchpads;
+} segment_queue;
+
+DECLARE_SPIN_LOCK(segment_jobs_lock);
+
+static bool regions_overlap(const uint8_t *a, size_t a_size, const uint8_t *b, size_t b_size)
+{
+	return a < b + b_size && b < a + a_size;
+}
+
+/* Without a scratchpad the job can only run on the BSP, using the static one of ulzman(). */
+static void run_segment_job(struct segment_job *job, void *scratchpad)
+{
+	size_t len = job->len;
+
+	switch (job->compression) {
+	case CBFS_COMPRESS_LZMA:
+		if (scratchpad)
+			len = ulzman_scratchpad(job->src, len, job->dest, job->memsz,
+						scratchpad);
+		else
+			len = ulzman(job->src, len, job->dest, job->memsz);
+		break;
+	case CBFS_COMPRESS_LZ4:
+		len = ulz4fn(job->src, len, job->dest, job->memsz);
+		break;
+	default:
+		memcpy(job->dest, job->src, len);
+		break;
+	}
+
+	if (len < job->memsz)
+		memset(job->dest + len, 0, job->memsz - len);
+
+	job->loaded = len;
+}
+
+/* Runs on the BSP and on every AP. Each worker takes jobs off the queue until it is empty. */
+static void segment_worker(void *arg)
+{
+	struct segment_job *job;
+	size_t worker;
+
+	spin_lock(&segment_jobs_lock);
+	/* Late start from a previous flush, or the queue is already being checked. */
+	if (!segment_queue.running || (uintptr_t)arg != segment_queue.generation) {
+		spin_unlock(&segment_jobs_lock);
+		return;
+	}
+	worker = segment_queue.num_workers++;
+	if (worker < MAX_SEGMENT_WORKERS)
+		segment_queue.active_workers++;
+	spin_unlock(&segment_jobs_lock);
+
+	/* Each worker needs its own LZMA scratchpad. */
+	if (worker >= MAX_SEGMENT_WORKERS)
+		return;
+
+	while (1) {
+		spin_lock(&segment_jobs_lock);
+		if (segment_queue.next_job == segment_queue.num_jobs) {
+			segment_queue.active_workers--;
+			spin_unlock(&segment_jobs_lock);
+			return;
+		}
+		job = &segment_queue.jobs[segment_queue.next_job++];
+		spin_unlock(&segment_jobs_lock);
+
+		run_segment_job(job, segment_queue.scratchpads +
+				worker * ULZMAN_SCRATCHPAD_SIZE);
+
+		spin_lock(&segment_jobs_lock);
+		segment_queue.completed++;
+		spin_unlock(&segment_jobs_lock);
+	}
+}
+
+static bool segment_jobs_done(void)
+{
+	bool done;
+
+	spin_lock(&segment_jobs_lock);
+	done = segment_queue.completed == segment_queue.num_jobs &&
+	       segment_queue.active_workers == 0;
+	/* Keep workers that start from now on away from the queue. */
+	if (done)
+		segment_queue.running = false;
+	spin_unlock(&segment_jobs_lock);
+
+	return done;
+}
+
+static int flush_segment_queue(void)
+{
+	struct segment_job *job;
+	struct stopwatch sw;
+	uintptr_t generation;
+	size_t i;
+	int ret = 0;
+
+	if (segment_queue.num_jobs == 0)
+		return 0;
+
+	if (segment_queue.scratchpads == NULL)
+		segment_queue.scratchpads = malloc(MAX_SEGMENT_WORKERS *
+						   ULZMAN_SCRATCHPAD_SIZE);
+
+	stopwatch_init(&sw);
+
+	if (segment_queue.scratchpads == NULL) {
+		printk(BIOS_WARNING, "No memory for LZMA scratchpads, loading serially\n");
+		for (i = 0; i < segment_queue.num_jobs; i++)
+			run_segment_job(&segment_queue.jobs[i], NULL);
+	} else {
+		spin_lock(&segment_jobs_lock);
+		generation = ++segment_queue.generation;
+		segment_queue.next_job = 0;
+		segment_queue.completed = 0;
+		segment_queue.num_workers = 0;
+		segment_queue.active_workers = 0;
+		segment_queue.running = true;
+		spin_unlock(&segment_jobs_lock);
+
+		/* If the APs can't be reached, the BSP processes all the jobs on its own. */
+		if (mp_run_on_aps(segment_worker, (void *)generation, MP_RUN_ON_ALL_CPUS,
+				  100 * USECS_PER_MSEC))
+			printk(BIOS_WARNING, "Could not hand segments to APs\n");
+		segment_worker((void *)generation);
+
+		while (!segment_jobs_done())
+			cpu_relax();
+	}
+
+	printk(BIOS_DEBUG, "Loaded %zu segments in %lu us\n",
+	       segment_queue.num_jobs, stopwatch_duration_usecs(&sw));
+
+	for (i = 0; i < segment_queue.num_jobs; i++) {
+		job = &segment_queue.jobs[i];
+
+		if (job->compression != CBFS_COMPRESS_NONE && job->loaded == 0) {
+			printk(BIOS_ERR, "Decompression of segment at %p failed\n", job->dest);
+			ret = -1;
+			continue;
+		}
+
+		prog_segment_loaded((uintptr_t)job->dest, job->memsz, job->flags);
+	}
+
+	segment_queue.num_jobs = 0;
+
+	return ret;
+}
+
+/* Returns 0 when the segment was queued, 1 when it has to be loaded right away and < 0 on
+   error. */
+static int queue_segment(uint8_t *dest, uint8_t *src, size_t len, size_t memsz,
+			 uint32_t compression, int flags)
+{
+	struct segment_job *job;
+	size_t i;
+
+	switch (compression) {
+	case CBFS_COMPRESS_LZMA:
+	case CBFS_COMPRESS_LZ4:
+	case CBFS_COMPRESS_NONE:
+		break;
+	default:
+		return 1;
+	}
+
+	for (i = 0; i < segment_queue.num_jobs; i++) {
+		job = &segment_queue.jobs[i];
+
+		if (regions_overlap(dest, memsz, job->dest, job->memsz) ||
+		    regions_overlap(dest, memsz, job->src, job->len) ||
+		    regions_overlap(src, len, job->dest, job->memsz)) {
+			if (flush_segment_queue())
+				return -1;
+			break;
+		}
+	}
+
+	if (segment_queue.num_jobs == MAX_QUEUED_SEGMENTS && flush_segment_queue())
+		return -1;
+
+	printk(BIOS_DEBUG, "Queueing Segment: addr: %p memsz: 0x%016zx filesz: 0x%016zx\n",
+	       dest, memsz, len);
+
+	job = &segment_queue.jobs[segment_queue.num_jobs++];
+	job->dest = dest;
+	job->src = src;
+	job->len = len;
+	job->memsz = memsz;
+	job->compression = compression;
+	job->flags = flags;
+	job->loaded = 0;
+
+	return 0;
+}
+#else
+static int flush_segment_queue(void)
+{
+	return 0;
+}
+
+static int queue_segment(uint8_t *dest, uint8_t *src, size_t len, size_t memsz,
+			 uint32_t compression, int flags)
+{
+	return 1;
+}
+#endif
+
 /* Note: this function is a bit dangerous so is not exported.
  * It assumes you're smart enough not to call it with the very
  * last segment, since it uses seg + 1 */
@@ -164,6 +419,7 @@ static int load_payload_segments(struct cbfs_payload_segment *cbfssegs, uintptr_
 	uint32_t compression;
 	struct cbfs_payload_segment *first_segment, *seg, segment;
 	int flags = 0;
+	int ret;
 
 	for (first_segment = seg = cbfssegs;; ++seg) {
 		printk(BIOS_DEBUG, "Loading segment from ROM address %p\n", seg);
@@ -204,6 +460,10 @@ static int load_payload_segments(struct cbfs_payload_segment *cbfssegs, uintptr_
 			printk(BIOS_DEBUG, "  Entry Point %p\n", (void *)
 				(intptr_t)segment.load_addr);
 
+			/* Wait for all queued segments to be loaded. */
+			if (flush_segment_queue())
+				return -1;
+
 			*entry = segment.load_addr;
 			/* Per definition, a payload always has the entry point
 			 * as last segment. Thus, we use the occurrence of the
@@ -223,6 +483,14 @@ static int load_payload_segments(struct cbfs_payload_segment *cbfssegs, uintptr_
 		 * is always last. */
 		if (last_loadable_segment(seg))
 			flags = SEG_FINAL;
+		ret = queue_segment(dest, src, filesz, memsz, compression, flags);
+		if (ret < 0)
+			return -1;
+		if (ret == 0)
+			continue;
+		/* Segments have to be loaded in order. */
+		if (flush_segment_queue())
+			return -1;
 		if (!load_one_segment(dest, src, filesz, memsz, compression, flags))
 			return -1;
 	}
@@ -6,17 +6,20 @@
 #include <stdlib.h>
 #include <arch/cpu.h>
 #include <bootstate.h>
+#include <cbmem.h>
 #include <commonlib/bsd/compiler.h>
 #include <console/console.h>
+#include <delay.h>
 #include <thread.h>
 #include <timer.h>
 
 static bool initialized;
 
 static void idle_thread_init(void);
+static bool start_queued_work(void);
 
 /* There needs to be at least one thread to run the ramstate state machine. */
-#define TOTAL_NUM_THREADS (CONFIG_NUM_THREADS + 1)
+#define TOTAL_NUM_THREADS (CONFIG_NUM_THREADS + CONFIG_NUM_CBMEM_THREADS + 1)
 
 /* Storage space for the thread structs .*/
 static struct thread all_threads[TOTAL_NUM_THREADS];
@@ -26,6 +29,27 @@ static struct thread all_threads[TOTAL_NUM_THREADS];
 static struct thread *runnable_threads;
 static struct thread *free_threads;
 
+static struct thread *idle;
+
+struct block_boot_state {
+	boot_state_t state;
+	boot_state_sequence_t seq;
+};
+
+/* Work passed to thread_run() or thread_run_until() while all threads were
+ * busy. The idle thread starts it once a thread is free. */
+struct queued_work {
+	struct thread_handle *handle;
+	enum cb_err (*func)(void *);
+	void *arg;
+	bool block;
+	struct block_boot_state bbs;
+};
+
+static struct queued_work work_queue[CONFIG_THREAD_QUEUE_SIZE];
+static size_t work_queue_first;
+static size_t work_queue_count;
+
 static inline struct cpu_info *thread_cpu_info(const struct thread *t)
 {
 	return (void *)(t->stack_orig);
@@ -81,6 +105,30 @@ static inline struct thread *pop_runnable(void)
 	return pop_thread(&runnable_threads);
 }
 
+/* The stacks of the threads beyond CONFIG_NUM_THREADS are allocated in CBMEM
+ * the first time one of them is needed. */
+static int thread_alloc_cbmem_stack(struct thread *t)
+{
+	static u8 *cbmem_stacks;
+	int index = t->id - CONFIG_NUM_THREADS - 1;
+
+	if (cbmem_stacks == NULL) {
+		/* cpu_info() requires the stacks to be aligned to their size. */
+		void *p = cbmem_add(CBMEM_ID_THREAD_STACKS,
+				    (CONFIG_NUM_CBMEM_THREADS + 1) * CONFIG_STACK_SIZE);
+
+		if (p == NULL) {
+			printk(BIOS_ERR, "Could not allocate thread stacks in CBMEM!\n");
+			return -1;
+		}
+		cbmem_stacks = (u8 *)ALIGN_UP((uintptr_t)p, CONFIG_STACK_SIZE);
+	}
+
+	t->stack_orig = (uintptr_t)&cbmem_stacks[(index + 1) * CONFIG_STACK_SIZE] -
+			sizeof(struct cpu_info);
+	return 0;
+}
+
 static inline struct thread *get_free_thread(void)
 {
 	struct thread *t;
@@ -92,6 +140,11 @@ static inline struct thread *get_free_thread(void)
 
 	t = pop_thread(&free_threads);
 
+	if (!t->stack_orig && thread_alloc_cbmem_stack(t)) {
+		push_thread(&free_threads, t);
+		return NULL;
+	}
+
 	ci = cpu_info();
 
 	/* Initialize the cpu_info structure on the new stack. */
@@ -112,18 +165,38 @@ static inline void free_thread(struct thread *t)
 
 /* The idle thread is ran whenever there isn't anything else that is runnable.
  * It's sole responsibility is to ensure progress is made by running the timer
- * callbacks. */
+ * callbacks. Only those make threads runnable again, so it simply delays until
+ * the next one expires. */
 __noreturn static enum cb_err idle_thread(void *unused)
 {
+	long usecs;
+
 	/* This thread never voluntarily yields. */
 	thread_coop_disable();
-	while (1)
+	while (1) {
+		if (start_queued_work())
+			continue;
+
+		usecs = timers_usecs_to_next();
+		if (usecs < 0)
+			die("All threads are blocked and no timers are pending!\n");
+		if (usecs > 0)
+			udelay(usecs);
 		timers_run();
+	}
+}
+
+/* Account the time since the last switch to or from t. */
+static void thread_account(struct thread *t, const struct mono_time *now, long *usecs)
+{
+	*usecs += mono_time_diff_microseconds(&t->switched, now);
+	t->switched = *now;
 }
 
 static void schedule(struct thread *t)
 {
 	struct thread *current = current_thread();
+	struct mono_time now;
 
 	/* If t is NULL need to find new runnable thread. */
 	if (t == NULL) {
@@ -138,14 +211,35 @@ static void schedule(struct thread *t)
 	if (t->handle)
 		t->handle->state = THREAD_STARTED;
 
+	timer_monotonic_get(&now);
+	thread_account(current, &now, &current->run_usecs);
+	thread_account(t, &now, &t->blocked_usecs);
+
 	switch_to_thread(t->stack_current, &current->stack_current);
 }
 
+/* Make the threads waiting for handle in thread_join() runnable again. */
+static void wake_joiners(struct thread_handle *handle)
+{
+	int i;
+
+	for (i = 0; i < TOTAL_NUM_THREADS; i++) {
+		struct thread *t = &all_threads[i];
+
+		if (t->join_handle != handle)
+			continue;
+
+		t->join_handle = NULL;
+		push_runnable(t);
+	}
+}
+
 static void terminate_thread(struct thread *t, enum cb_err error)
 {
 	if (t->handle) {
 		t->handle->error = error;
 		t->handle->state = THREAD_DONE;
+		wake_joiners(t->handle);
 	}
 
 	free_thread(t);
@@ -162,11 +256,6 @@ static void asmlinkage call_wrapper(void *unused)
 	terminate_thread(current, error);
 }
 
-struct block_boot_state {
-	boot_state_t state;
-	boot_state_sequence_t seq;
-};
-
 /* Block the provided state until thread is complete. */
 static void asmlinkage call_wrapper_block_state(void *arg)
 {
@@ -180,6 +269,19 @@ static void asmlinkage call_wrapper_block_state(void *arg)
 	terminate_thread(current, error);
 }
 
+/* Unblock the provided state, which was blocked when the work was queued, once
+ * the thread is complete. */
+static void asmlinkage call_wrapper_unblock_state(void *arg)
+{
+	struct block_boot_state *bbs = arg;
+	struct thread *current = current_thread();
+	enum cb_err error;
+
+	error = current->entry(current->entry_arg);
+	boot_state_unblock(bbs->state, bbs->seq);
+	terminate_thread(current, error);
+}
+
 /* Prepare a thread so that it starts by executing thread_entry(thread_arg).
  * Within thread_entry() it will call func(arg). */
 static void prepare_thread(struct thread *t, struct thread_handle *handle,
@@ -196,6 +298,9 @@ static void prepare_thread(struct thread *t, struct thread_handle *handle,
 	/* Pointer used to publish the state of thread */
 	t->handle = handle;
 
+	/* The thread waits to be scheduled from now on. */
+	timer_monotonic_get(&t->switched);
+
 	arch_prepare_thread(t, thread_entry, thread_arg);
 }
 
@@ -219,6 +324,7 @@ static void idle_thread_init(void)
 	/* Queue idle thread to run once all other threads have yielded. */
 	prepare_thread(t, NULL, idle_thread, NULL, call_wrapper, NULL);
 	push_runnable(t);
+	idle = t;
 }
 
 /* Don't inline this function so the timeout_callback won't have its storage
@@ -233,6 +339,8 @@ thread_yield_timed_callback(struct timeout_callback *tocb,
 	if (timer_sched_callback(tocb, microsecs))
 		return -1;
 
+	current_thread()->yields++;
+
 	/* The timer callback will wake up the current thread. */
 	schedule(NULL);
 	return 0;
@@ -247,6 +355,67 @@ static void *thread_alloc_space(struct thread *t, size_t bytes)
 	return (void *)t->stack_current;
 }
 
+static int queue_work(struct thread_handle *handle, enum cb_err (*func)(void *), void *arg,
+		      const struct block_boot_state *bbs)
+{
+	struct queued_work *w;
+
+	if (work_queue_count == ARRAY_SIZE(work_queue)) {
+		printk(BIOS_ERR, "thread_run() No more threads!\n");
+		return -1;
+	}
+
+	w = &work_queue[(work_queue_first + work_queue_count) % ARRAY_SIZE(work_queue)];
+	work_queue_count++;
+
+	w->handle = handle;
+	w->func = func;
+	w->arg = arg;
+	w->block = bbs != NULL;
+	if (bbs) {
+		/* The state must not be left before the work even started. */
+		w->bbs = *bbs;
+		boot_state_block(bbs->state, bbs->seq);
+	}
+
+	if (handle)
+		handle->state = THREAD_QUEUED;
+
+	return 0;
+}
+
+/* Start the oldest queued work if a thread is free. Only called by the idle
+ * thread, so the stack of a thread that just terminated isn't in use. */
+static bool start_queued_work(void)
+{
+	struct queued_work *w;
+	struct block_boot_state *bbs;
+	struct thread *t;
+
+	if (!work_queue_count)
+		return false;
+
+	t = get_free_thread();
+
+	if (t == NULL)
+		return false;
+
+	w = &work_queue[work_queue_first];
+	work_queue_first = (work_queue_first + 1) % ARRAY_SIZE(work_queue);
+	work_queue_count--;
+
+	if (w->block) {
+		bbs = thread_alloc_space(t, sizeof(*bbs));
+		*bbs = w->bbs;
+		prepare_thread(t, w->handle, w->func, w->arg, call_wrapper_unblock_state, bbs);
+	} else {
+		prepare_thread(t, w->handle, w->func, w->arg, call_wrapper, NULL);
+	}
+	schedule(t);
+
+	return true;
+}
+
 void threads_initialize(void)
 {
 	int i;
@@ -265,13 +434,23 @@ void threads_initialize(void)
 	t->stack_orig = (uintptr_t)ci;
 	t->id = 0;
 	t->can_yield = 1;
+	timer_monotonic_get(&t->switched);
 
-	stack_top = &thread_stacks[CONFIG_STACK_SIZE] - sizeof(struct cpu_info);
-	for (i = 1; i < TOTAL_NUM_THREADS; i++) {
+	/* Free the threads with stacks in CBMEM first, so that they are used
+	 * last. Their stacks are allocated when needed. */
+	for (i = TOTAL_NUM_THREADS - 1; i > CONFIG_NUM_THREADS; i--) {
+		t = &all_threads[i];
+		t->id = i;
+		free_thread(t);
+	}
+
+	stack_top = &thread_stacks[CONFIG_NUM_THREADS * CONFIG_STACK_SIZE] -
+		    sizeof(struct cpu_info);
+	for (i = CONFIG_NUM_THREADS; i > 0; i--) {
 		t = &all_threads[i];
 		t->stack_orig = (uintptr_t)stack_top;
 		t->id = i;
-		stack_top += CONFIG_STACK_SIZE;
+		stack_top -= CONFIG_STACK_SIZE;
 		free_thread(t);
 	}
 
@@ -295,10 +474,8 @@ int thread_run(struct thread_handle *handle, enum cb_err (*func)(void *), void *
 
 	t = get_free_thread();
 
-	if (t == NULL) {
-		printk(BIOS_ERR, "thread_run() No more threads!\n");
-		return -1;
-	}
+	if (t == NULL)
+		return queue_work(handle, func, arg, NULL);
 
 	prepare_thread(t, handle, func, arg, call_wrapper, NULL);
 	schedule(t);
@@ -324,8 +501,9 @@ int thread_run_until(struct thread_handle *handle, enum cb_err (*func)(void *),
 	t = get_free_thread();
 
 	if (t == NULL) {
-		printk(BIOS_ERR, "thread_run() No more threads!\n");
-		return -1;
+		const struct block_boot_state queued = { .state = state, .seq = seq };
+
+		return queue_work(handle, func, arg, &queued);
 	}
 
 	bbs = thread_alloc_space(t, sizeof(*bbs));
@@ -400,8 +578,12 @@ enum cb_err thread_join(struct thread_handle *handle)
 
 	printk(BIOS_SPEW, "waiting for thread\n");
 
-	while (handle->state != THREAD_DONE)
-		assert(thread_yield() == 0);
+	/* The thread is woken up when the one it waits for terminates. */
+	assert(thread_can_yield(current));
+	while (handle->state != THREAD_DONE) {
+		current->join_handle = handle;
+		schedule(NULL);
+	}
 
 	printk(BIOS_SPEW, "took %lu us\n", stopwatch_duration_usecs(&sw));
 
@@ -426,3 +608,30 @@ void thread_mutex_unlock(struct thread_mutex *mutex)
 	assert(mutex->locked);
 	mutex->locked = 0;
 }
+
+static void threads_print_stats(void *unused)
+{
+	struct thread *current = current_thread();
+	struct mono_time now;
+	int i;
+
+	if (current == NULL)
+		return;
+
+	timer_monotonic_get(&now);
+	thread_account(current, &now, &current->run_usecs);
+
+	printk(BIOS_DEBUG, "Thread statistics:\n");
+	for (i = 0; i < TOTAL_NUM_THREADS; i++) {
+		struct thread *t = &all_threads[i];
+
+		if (!t->run_usecs)
+			continue;
+
+		printk(BIOS_DEBUG, "  thread %d%s: %ld us running, %ld us blocked, %u yields\n",
+		       t->id, t == idle ? " (idle)" : "", t->run_usecs, t->blocked_usecs,
+		       t->yields);
+	}
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, threads_print_stats, NULL);
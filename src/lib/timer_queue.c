@@ -179,3 +179,21 @@ int timers_run(void)
 
 	return !timer_queue_empty(&global_timer_queue);
 }
+
+long timers_usecs_to_next(void)
+{
+	struct timeout_callback *tocb;
+	struct mono_time current_time;
+
+	tocb = timer_queue_head(&global_timer_queue);
+
+	if (tocb == NULL)
+		return -1;
+
+	timer_monotonic_get(&current_time);
+
+	if (!mono_time_before(&current_time, &tocb->expiration))
+		return 0;
+
+	return mono_time_diff_microseconds(&current_time, &tocb->expiration);
+}
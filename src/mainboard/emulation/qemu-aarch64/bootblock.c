@@ -7,6 +7,7 @@
 void bootblock_mainboard_init(void)
 {
 	mmu_init();
+	mmu_config_begin();
 
 	/* Everything below DRAM is device memory */
 	mmu_config_range((void *)0, (uintptr_t)_dram, MA_DEV | MA_RW);
@@ -20,5 +21,6 @@ void bootblock_mainboard_init(void)
 
 	mmu_config_range(_bl31, REGION_SIZE(bl31), MA_MEM | MA_S | MA_RW);
 
+	mmu_config_commit();
 	mmu_enable();
 }
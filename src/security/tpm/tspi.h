@@ -54,6 +54,38 @@ uint32_t tpm_extend_pcr(int pcr, enum vb2_hash_algorithm digest_algo,
 			uint8_t *digest, size_t digest_len,
 			const char *name);
 
+/* Number of PCR extends that can be pending in ramstage. */
+#define TPM_EXTEND_QUEUE_SIZE 16
+
+/**
+ * Add the digest to the TCPA log and queue the PCR extend. The extend is done
+ * later by a cooperative thread or by tpm_extend_queue_flush(). Only available
+ * in ramstage with TPM_MEASURED_BOOT_DEFERRED_EXTEND.
+ * @param pcr sets the pcr index
+ * @param diget_algo sets the digest algorithm
+ * @param digest sets the hash to extend into the tpm
+ * @param digest_len the length of the digest
+ * @param name sets additional info where the digest comes from
+ * @return TPM_SUCCESS on success. If not a tpm error is returned
+ */
+uint32_t tpm_extend_queue_add(int pcr, enum vb2_hash_algorithm digest_algo,
+			      const uint8_t *digest, size_t digest_len,
+			      const char *name);
+
+#if ENV_RAMSTAGE && CONFIG(TPM_MEASURED_BOOT_DEFERRED_EXTEND)
+/**
+ * Send all queued PCR extends to the TPM. Needs to be called before anything
+ * relies on the PCR values.
+ * @return TPM_SUCCESS on success. If not a tpm error is returned
+ */
+uint32_t tpm_extend_queue_flush(void);
+#else
+static inline uint32_t tpm_extend_queue_flush(void)
+{
+	return TPM_SUCCESS;
+}
+#endif
+
 /**
  * Issue a TPM_Clear and reenable/reactivate the TPM.
  * @return TPM_SUCCESS on success. If not a tpm error is returned
@@ -0,0 +1,180 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootstate.h>
+#include <console/console.h>
+#include <security/tpm/tspi.h>
+#include <security/tpm/tss.h>
+#include <string.h>
+#include <thread.h>
+
+/*
+ * PCR extends requested in ramstage are recorded in the TCPA log right away, but only sent
+ * to the TPM later: either by a cooperative thread while the boot thread waits, or when the
+ * queue is flushed. Every boundary which relies on the PCR values flushes the queue first.
+ */
+
+static struct thread_mutex tpm_cmd_mutex;
+
+void tpm_cmd_lock(void)
+{
+	thread_mutex_lock(&tpm_cmd_mutex);
+}
+
+void tpm_cmd_unlock(void)
+{
+	thread_mutex_unlock(&tpm_cmd_mutex);
+}
+
+struct pending_extend {
+	int pcr;
+	uint8_t digest[TPM_PCR_MAX_LEN];
+	char name[TCPA_PCR_HASH_NAME];
+};
+
+static struct {
+	struct pending_extend entries[TPM_EXTEND_QUEUE_SIZE];
+	size_t head;
+	size_t count;
+} queue;
+
+/* Once set, extends are sent right away instead of being queued. */
+static bool extend_now;
+
+static struct thread_handle extend_thread;
+
+/* Send the oldest pending extend to the TPM and remove it from the queue on success. */
+static uint32_t extend_next(void)
+{
+	struct pending_extend *e = &queue.entries[queue.head];
+	uint32_t result;
+
+	result = tlcl_lib_init();
+	if (result != TPM_SUCCESS) {
+		printk(BIOS_ERR, "TPM: Can't initialize library.\n");
+		return result;
+	}
+
+	printk(BIOS_DEBUG, "TPM: Extending digest for %s into PCR %d\n", e->name, e->pcr);
+	result = tlcl_extend(e->pcr, e->digest, NULL);
+	if (result != TPM_SUCCESS) {
+		printk(BIOS_ERR, "TPM: Extending digest for %s into PCR %d failed: %#x\n",
+		       e->name, e->pcr, result);
+		return result;
+	}
+
+	queue.head = (queue.head + 1) % TPM_EXTEND_QUEUE_SIZE;
+	queue.count--;
+
+	return TPM_SUCCESS;
+}
+
+static enum cb_err extend_thread_entry(void *unused)
+{
+	uint32_t result;
+
+	while (queue.count) {
+		/* Let the boot thread go on, the extends are done when it waits. */
+		thread_yield();
+		if (!queue.count)
+			break;
+
+		/* Don't start a command while the boot thread waits for a TPM response. */
+		tpm_cmd_lock();
+		tpm_cmd_unlock();
+
+		/* The boot thread must not issue a TPM command before this one is done. */
+		thread_coop_disable();
+		result = extend_next();
+		thread_coop_enable();
+
+		/* The error is reported again by the next flush. */
+		if (result != TPM_SUCCESS)
+			return CB_ERR;
+	}
+
+	return CB_SUCCESS;
+}
+
+static void start_extend_thread(void)
+{
+	if (!CONFIG(COOP_MULTITASKING))
+		return;
+
+	if (extend_thread.state == THREAD_STARTED)
+		return;
+
+	if (thread_run(&extend_thread, extend_thread_entry, NULL))
+		printk(BIOS_INFO, "TPM: Deferred PCR extends wait for the next flush\n");
+}
+
+uint32_t tpm_extend_queue_flush(void)
+{
+	uint32_t result;
+
+	while (queue.count) {
+		result = extend_next();
+		if (result != TPM_SUCCESS)
+			return result;
+	}
+
+	return TPM_SUCCESS;
+}
+
+uint32_t tpm_extend_queue_add(int pcr, enum vb2_hash_algorithm digest_algo,
+			      const uint8_t *digest, size_t digest_len, const char *name)
+{
+	struct pending_extend *e;
+	uint32_t result;
+
+	if (!digest || digest_len > sizeof(e->digest))
+		return TPM_E_INVALID_ARG;
+
+	if (queue.count == TPM_EXTEND_QUEUE_SIZE) {
+		result = tpm_extend_queue_flush();
+		if (result != TPM_SUCCESS)
+			return result;
+	}
+
+	tcpa_log_add_table_entry(name, pcr, digest_algo, digest, digest_len);
+
+	e = &queue.entries[(queue.head + queue.count) % TPM_EXTEND_QUEUE_SIZE];
+	e->pcr = pcr;
+	memcpy(e->digest, digest, digest_len);
+	strncpy(e->name, name ? name : "", sizeof(e->name) - 1);
+	e->name[sizeof(e->name) - 1] = '\0';
+	queue.count++;
+
+	if (extend_now)
+		return tpm_extend_queue_flush();
+
+	start_extend_thread();
+
+	return TPM_SUCCESS;
+}
+
+static void flush_extend_queue(void *unused)
+{
+	if (tpm_extend_queue_flush() != TPM_SUCCESS)
+		die_with_post_code(POST_TPM_FAILURE, "TPM: Deferred PCR extends failed!\n");
+}
+
+/*
+ * Chipset lockdown runs in BS_DEV_RESOURCES, so the queue is drained in the state before it,
+ * as hooks of the same state run in no particular order.
+ */
+BOOT_STATE_INIT_ENTRY(BS_DEV_ENUMERATE, BS_ON_EXIT, flush_extend_queue, NULL);
+BOOT_STATE_INIT_ENTRY(BS_POST_DEVICE, BS_ON_ENTRY, flush_extend_queue, NULL);
+
+/*
+ * The OS resume and payload paths measure and lock things down in their own boot states.
+ * From there on, every extend is sent before tpm_extend_pcr() returns.
+ */
+static void stop_deferring_extends(void *unused)
+{
+	flush_extend_queue(NULL);
+	extend_now = true;
+}
+
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME_CHECK, BS_ON_ENTRY, stop_deferring_extends, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_LOAD, BS_ON_ENTRY, stop_deferring_extends, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, flush_extend_queue, NULL);
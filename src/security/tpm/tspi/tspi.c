@@ -228,6 +228,10 @@ uint32_t tpm_extend_pcr(int pcr, enum vb2_hash_algorithm digest_algo,
 		return TPM_E_IOERROR;
 
 	if (tspi_tpm_is_setup()) {
+		if (ENV_RAMSTAGE && CONFIG(TPM_MEASURED_BOOT_DEFERRED_EXTEND))
+			return tpm_extend_queue_add(pcr, digest_algo, digest,
+						    digest_len, name);
+
 		result = tlcl_lib_init();
 		if (result != TPM_SUCCESS) {
 			printk(BIOS_ERR, "TPM: Can't initialize library.\n");
@@ -15,6 +15,19 @@
 #include <security/tpm/tss_errors.h>
 #include <security/tpm/tss/vendor/cr50/cr50.h>
 
+/*
+ * Held while a command is exchanged with the TPM, so that the thread sending
+ * deferred PCR extends can't start a command while another thread waits for a
+ * response. Only needed in ramstage with deferred extends.
+ */
+#if ENV_RAMSTAGE && CONFIG(TPM_MEASURED_BOOT_DEFERRED_EXTEND)
+void tpm_cmd_lock(void);
+void tpm_cmd_unlock(void);
+#else
+static inline void tpm_cmd_lock(void) {}
+static inline void tpm_cmd_unlock(void) {}
+#endif
+
 #if CONFIG(TPM1)
 
 #include <security/tpm/tss/tcg-1.2/tss_structures.h>
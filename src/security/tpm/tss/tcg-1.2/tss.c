@@ -30,7 +30,12 @@ static int tpm_send_receive(const uint8_t *request,
 				uint32_t *response_length)
 {
 	size_t len = *response_length;
-	if (tis_sendrecv(request, request_length, response, &len))
+	int ret;
+
+	tpm_cmd_lock();
+	ret = tis_sendrecv(request, request_length, response, &len);
+	tpm_cmd_unlock();
+	if (ret)
 		return VB2_ERROR_UNKNOWN;
 	/* check 64->32bit overflow and (re)check response buffer overflow */
 	if (len > *response_length)
@@ -23,6 +23,7 @@ void *tpm_process_command(TPM_CC command, void *command_body)
 	size_t out_size;
 	size_t in_size;
 	const uint8_t *sendb;
+	int ret;
 	/* Command/response buffer. */
 	static uint8_t cr_buffer[TPM_BUFFER_SIZE];
 
@@ -36,7 +37,10 @@ void *tpm_process_command(TPM_CC command, void *command_body)
 	sendb = obuf_contents(&ob, &out_size);
 
 	in_size = sizeof(cr_buffer);
-	if (tis_sendrecv(sendb, out_size, cr_buffer, &in_size)) {
+	tpm_cmd_lock();
+	ret = tis_sendrecv(sendb, out_size, cr_buffer, &in_size);
+	tpm_cmd_unlock();
+	if (ret) {
 		printk(BIOS_ERR, "tpm transaction failed\n");
 		return NULL;
 	}
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <console/console.h>
+#include <ec/google/chromeec/ec.h>
+#include <security/vboot/vboot_common.h>
+
+/*
+ * Ask the EC to hash its active RW image now, so that the hash is ready by
+ * the time EC software sync asks for it.  The EC calculates it while the AP
+ * keeps booting; the result is collected in ec_hash_image().
+ */
+void vboot_start_ec_hash(void)
+{
+	struct ec_response_vboot_hash resp;
+
+	if (google_chromeec_get_vboot_hash(EC_VBOOT_HASH_OFFSET_ACTIVE, &resp))
+		return;
+
+	/* The hash is already being calculated or ready */
+	if (resp.status != EC_VBOOT_HASH_STATUS_NONE)
+		return;
+
+	if (google_chromeec_start_vboot_hash(EC_VBOOT_HASH_TYPE_SHA256,
+					     EC_VBOOT_HASH_OFFSET_ACTIVE, &resp))
+		printk(BIOS_WARNING, "Failed to start EC image hash\n");
+}
@@ -72,4 +72,10 @@ void vboot_save_data(struct vb2_context *ctx);
  */
 void vboot_sync_ec(void);
 
+/*
+ * Start the EC's hash of its active RW image ahead of EC software sync,
+ * without waiting for the result.
+ */
+void vboot_start_ec_hash(void);
+
 #endif /* __VBOOT_VBOOT_COMMON_H__ */
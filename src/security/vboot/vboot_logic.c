@@ -283,6 +283,10 @@ void verstage_main(void)
 	/* Set up context and work buffer */
 	ctx = vboot_get_context();
 
+	/* Let the EC hash its RW image while we verify the AP firmware. */
+	if (CONFIG(VBOOT_EARLY_EC_SYNC))
+		vboot_start_ec_hash();
+
 	/* Initialize and read nvdata from non-volatile storage. */
 	vbnv_init(ctx->nvdata);
 
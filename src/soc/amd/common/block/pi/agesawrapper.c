@@ -2,6 +2,7 @@
 
 #include <acpi/acpi.h>
 #include <console/console.h>
+#include <profiler.h>
 #include <timestamp.h>
 #include <amdblocks/biosram.h>
 #include <amdblocks/s3_resume.h>
@@ -31,12 +32,16 @@ static AGESA_STATUS module_dispatch(AGESA_STRUCT_NAME func,
 	AMD_CONFIG_PARAMS *StdHeader)
 {
 	MODULE_ENTRY dispatcher = agesa_get_dispatcher();
+	AGESA_STATUS status;
 
 	if (!dispatcher)
 		return AGESA_UNSUPPORTED;
 
 	StdHeader->Func = func;
-	return dispatcher(StdHeader);
+	profiler_pause();
+	status = dispatcher(StdHeader);
+	profiler_resume();
+	return status;
 }
 
 static AGESA_STATUS amd_dispatch(void *Params)
@@ -384,8 +384,8 @@ send_one_message(uint32_t hdr, const void *buff)
 	return pend_len;
 }
 
-int
-heci_send(const void *msg, size_t len, uint8_t host_addr, uint8_t client_addr)
+static int
+send_message(const void *msg, size_t len, uint8_t host_addr, uint8_t client_addr)
 {
 	uint8_t retry;
 	uint32_t csr, hdr;
@@ -487,16 +487,14 @@ recv_one_message(uint32_t *hdr, void *buff, size_t maxlen)
 	return recv_len;
 }
 
-int heci_receive(void *buff, size_t *maxlen)
+/* Receive a message and return the header of its last fragment in 'hdr_out'. */
+static int receive_message(void *buff, size_t *maxlen, uint32_t *hdr_out)
 {
 	uint8_t retry;
 	size_t left, received;
 	uint32_t hdr = 0;
 	uint8_t *p;
 
-	if (!buff || !maxlen || !*maxlen)
-		return 0;
-
 	clear_int();
 
 	for (retry = 0; retry < MAX_HECI_MESSAGE_RETRY_COUNT; retry++) {
@@ -527,12 +525,197 @@ int heci_receive(void *buff, size_t *maxlen)
 
 		if ((hdr & MEI_HDR_IS_COMPLETE) && received) {
 			*maxlen = p - (uint8_t *) buff;
+			*hdr_out = hdr;
 			return 1;
 		}
 	}
 	return 0;
 }
 
+/*
+ * Split-phase requests. At most one request per CSE client is outstanding. Its reply is received
+ * into a bounce buffer and copied to the caller's buffer once the MEI header tells which client
+ * it came from, so replies from different clients may arrive in any order.
+ */
+#define HECI_MAX_REQUESTS	4
+#define HECI_MAX_ASYNC_REPLY	128
+
+enum heci_request_state {
+	HECI_REQUEST_FREE,
+	HECI_REQUEST_SENT,
+	HECI_REQUEST_DONE,
+	HECI_REQUEST_FAILED,
+};
+
+static struct heci_request {
+	enum heci_request_state state;
+	uint8_t client_addr;
+	void *reply;
+	size_t reply_size;
+} requests[HECI_MAX_REQUESTS];
+
+static struct heci_request *find_request(uint8_t client_addr)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(requests); i++) {
+		if (requests[i].state != HECI_REQUEST_FREE &&
+		    requests[i].client_addr == client_addr)
+			return &requests[i];
+	}
+	return NULL;
+}
+
+static bool requests_outstanding(void)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(requests); i++) {
+		if (requests[i].state == HECI_REQUEST_SENT)
+			return true;
+	}
+	return false;
+}
+
+/* The replies to requests that were sent are not going to arrive anymore. */
+static void fail_requests(void)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(requests); i++) {
+		if (requests[i].state == HECI_REQUEST_SENT)
+			requests[i].state = HECI_REQUEST_FAILED;
+	}
+}
+
+/* Receive one message and hand it to the request it answers. Returns 0 on failure. */
+static int collect_reply(void)
+{
+	uint8_t buf[HECI_MAX_ASYNC_REPLY];
+	size_t size = sizeof(buf);
+	struct heci_request *req;
+	uint8_t client_addr;
+	uint32_t hdr = 0;
+
+	if (!receive_message(buf, &size, &hdr)) {
+		printk(BIOS_ERR, "HECI: Failed to receive reply\n");
+		fail_requests();
+		return 0;
+	}
+
+	client_addr = (hdr & MEI_HDR_CSE_ADDR) >> MEI_HDR_CSE_ADDR_START;
+	req = find_request(client_addr);
+	if (!req || req->state != HECI_REQUEST_SENT) {
+		printk(BIOS_WARNING, "HECI: Dropping unexpected message from client 0x%x\n",
+		       client_addr);
+		return 1;
+	}
+
+	if (size > req->reply_size) {
+		printk(BIOS_ERR, "HECI: response is too big\n");
+		req->state = HECI_REQUEST_FAILED;
+		return 1;
+	}
+
+	memcpy(req->reply, buf, size);
+	req->reply_size = size;
+	req->state = HECI_REQUEST_DONE;
+	return 1;
+}
+
+static void collect_replies(void)
+{
+	while (requests_outstanding()) {
+		if (!collect_reply())
+			return;
+	}
+}
+
+int heci_send_async(const void *msg, size_t len, uint8_t client_addr, void *reply,
+		    size_t reply_size)
+{
+	struct heci_request *req;
+
+	if (!reply || !reply_size || reply_size > HECI_MAX_ASYNC_REPLY)
+		return 0;
+
+	if (find_request(client_addr)) {
+		printk(BIOS_ERR, "HECI: Request to client 0x%x still outstanding\n", client_addr);
+		return 0;
+	}
+
+	for (req = requests; req < requests + ARRAY_SIZE(requests); req++) {
+		if (req->state == HECI_REQUEST_FREE)
+			break;
+	}
+	if (req == requests + ARRAY_SIZE(requests)) {
+		printk(BIOS_ERR, "HECI: Too many outstanding requests\n");
+		return 0;
+	}
+
+	if (!send_message(msg, len, BIOS_HOST_ADDR, client_addr))
+		return 0;
+
+	req->client_addr = client_addr;
+	req->reply = reply;
+	req->reply_size = reply_size;
+	req->state = HECI_REQUEST_SENT;
+	return 1;
+}
+
+bool heci_reply_pending(uint8_t client_addr)
+{
+	struct heci_request *req = find_request(client_addr);
+
+	/* Take whatever the CSE has written so far, without waiting for more. */
+	while (req && req->state == HECI_REQUEST_SENT && cse_filled_slots()) {
+		if (!collect_reply())
+			break;
+	}
+
+	return req && req->state == HECI_REQUEST_SENT;
+}
+
+int heci_receive_async(uint8_t client_addr, size_t *reply_size)
+{
+	struct heci_request *req = find_request(client_addr);
+	int ret;
+
+	if (!req)
+		return 0;
+
+	while (req->state == HECI_REQUEST_SENT) {
+		if (!collect_reply())
+			break;
+	}
+
+	ret = req->state == HECI_REQUEST_DONE;
+	if (ret && reply_size)
+		*reply_size = req->reply_size;
+	req->state = HECI_REQUEST_FREE;
+
+	return ret;
+}
+
+int
+heci_send(const void *msg, size_t len, uint8_t host_addr, uint8_t client_addr)
+{
+	/* Replies to split-phase requests must not be taken for the reply to this message. */
+	collect_replies();
+
+	return send_message(msg, len, host_addr, client_addr);
+}
+
+int heci_receive(void *buff, size_t *maxlen)
+{
+	uint32_t hdr;
+
+	if (!buff || !maxlen || !*maxlen)
+		return 0;
+
+	return receive_message(buff, maxlen, &hdr);
+}
+
 int heci_send_receive(const void *snd_msg, size_t snd_sz, void *rcv_msg, size_t *rcv_sz)
 {
 	if (!heci_send(snd_msg, snd_sz, BIOS_HOST_ADDR, HECI_MKHI_ADDR)) {
@@ -560,6 +743,8 @@ int heci_reset(void)
 	/* Clear post code to prevent eventlog entry from unknown code. */
 	post_code(0);
 
+	fail_requests();
+
 	/* Send reset request */
 	csr = read_host_csr();
 	csr |= (CSR_RESET | CSR_IG);
@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <acpi/acpi.h>
 #include <bootstate.h>
 #include <console/console.h>
 #include <intelblocks/cse.h>
@@ -17,8 +18,18 @@ enum cse_eop_result {
 	CSE_EOP_RESULT_GLOBAL_RESET_REQUESTED,
 	CSE_EOP_RESULT_SUCCESS,
 	CSE_EOP_RESULT_ERROR,
+	CSE_EOP_RESULT_PENDING,
 };
 
+struct end_of_post_resp {
+	struct mkhi_hdr hdr;
+	uint32_t requested_actions;
+} __packed;
+
+/* The reply is received in the background when EOP is sent early. */
+static struct end_of_post_resp eop_resp;
+static enum cse_eop_result eop_result = CSE_EOP_RESULT_ERROR;
+
 static bool cse_disable_mei_bus(void)
 {
 	struct bus_disable_message {
@@ -71,10 +82,6 @@ static bool cse_disable_mei_devices(void)
 
 static enum cse_eop_result cse_send_eop(void)
 {
-	enum {
-		EOP_REQUESTED_ACTION_CONTINUE = 0,
-		EOP_REQUESTED_ACTION_GLOBAL_RESET = 1,
-	};
 	struct end_of_post_msg {
 		struct mkhi_hdr hdr;
 	} __packed msg = {
@@ -83,11 +90,6 @@ static enum cse_eop_result cse_send_eop(void)
 			.command = MKHI_END_OF_POST,
 		},
 	};
-	struct end_of_post_resp {
-		struct mkhi_hdr hdr;
-		uint32_t requested_actions;
-	} __packed resp = {};
-	size_t resp_size = sizeof(resp);
 
 	/* For a CSE-Lite SKU, if the CSE is running RO FW and the board is
 	   running vboot in recovery mode, the CSE is expected to be in SOFT
@@ -112,19 +114,36 @@ static enum cse_eop_result cse_send_eop(void)
 
 	printk(BIOS_INFO, "HECI: Sending End-of-Post\n");
 
-	if (!heci_send_receive(&msg, sizeof(msg), &resp, &resp_size)) {
-		printk(BIOS_ERR, "HECI: EOP send/receive fail\n");
+	if (!heci_send_async(&msg, sizeof(msg), HECI_MKHI_ADDR, &eop_resp, sizeof(eop_resp))) {
+		printk(BIOS_ERR, "HECI: EOP send fail\n");
+		return CSE_EOP_RESULT_ERROR;
+	}
+
+	return CSE_EOP_RESULT_PENDING;
+}
+
+static enum cse_eop_result cse_receive_eop(void)
+{
+	enum {
+		EOP_REQUESTED_ACTION_CONTINUE = 0,
+		EOP_REQUESTED_ACTION_GLOBAL_RESET = 1,
+	};
+	size_t resp_size;
+
+	if (!heci_receive_async(HECI_MKHI_ADDR, &resp_size) ||
+	    resp_size < sizeof(eop_resp)) {
+		printk(BIOS_ERR, "HECI: EOP receive fail\n");
 		return CSE_EOP_RESULT_ERROR;
 	}
 
-	if (resp.hdr.result) {
-		printk(BIOS_ERR, "HECI: EOP Resp Failed: %u\n", resp.hdr.result);
+	if (eop_resp.hdr.result) {
+		printk(BIOS_ERR, "HECI: EOP Resp Failed: %u\n", eop_resp.hdr.result);
 		return CSE_EOP_RESULT_ERROR;
 	}
 
 	printk(BIOS_INFO, "CSE: EOP requested action: ");
 
-	switch (resp.requested_actions) {
+	switch (eop_resp.requested_actions) {
 	case EOP_REQUESTED_ACTION_GLOBAL_RESET:
 		printk(BIOS_INFO, "global reset\n");
 		return CSE_EOP_RESULT_GLOBAL_RESET_REQUESTED;
@@ -132,7 +151,7 @@ static enum cse_eop_result cse_send_eop(void)
 		printk(BIOS_INFO, "continue boot\n");
 		return CSE_EOP_RESULT_SUCCESS;
 	default:
-		printk(BIOS_INFO, "unknown %u\n", resp.requested_actions);
+		printk(BIOS_INFO, "unknown %u\n", eop_resp.requested_actions);
 		return CSE_EOP_RESULT_ERROR;
 	}
 }
@@ -178,13 +197,42 @@ static void handle_cse_eop_result(enum cse_eop_result result)
 	}
 }
 
-static void set_cse_end_of_post(void *unused)
+static void send_cse_end_of_post(void *unused)
 {
 	timestamp_add_now(TS_ME_BEFORE_END_OF_POST);
-	handle_cse_eop_result(cse_send_eop());
+	eop_result = cse_send_eop();
+}
+
+static void set_cse_end_of_post(void *unused)
+{
+	if (!CONFIG(SOC_INTEL_CSE_SEND_EOP_EARLY))
+		send_cse_end_of_post(NULL);
+	if (eop_result == CSE_EOP_RESULT_PENDING)
+		eop_result = cse_receive_eop();
+	handle_cse_eop_result(eop_result);
 	timestamp_add_now(TS_ME_AFTER_END_OF_POST);
 }
 
+#if CONFIG(SOC_INTEL_CSE_SEND_EOP_EARLY)
+/*
+ * Nothing in ramstage needs Pre-Boot commands once devices are initialized, so EOP can be
+ * sent then. The CSE processes it while coreboot writes its tables. Any HECI message sent
+ * in the meantime first waits for the EOP reply, see heci_send().
+ *
+ * The reply is only handled when loading the payload, which doesn't happen on S3 resume,
+ * so don't send EOP early then.
+ */
+static void send_cse_end_of_post_early(void *unused)
+{
+	if (acpi_is_wakeup_s3())
+		return;
+
+	send_cse_end_of_post(NULL);
+}
+
+BOOT_STATE_INIT_ENTRY(BS_POST_DEVICE, BS_ON_ENTRY, send_cse_end_of_post_early, NULL);
+#endif
+
 /*
  * Ideally, to give coreboot maximum flexibility, sending EOP would be done as
  * late possible, just before loading the payload, which would be BS_ON_EXIT
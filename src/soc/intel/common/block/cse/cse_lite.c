@@ -9,6 +9,10 @@
 #include <security/vboot/vboot_common.h>
 #include <security/vboot/misc.h>
 #include <soc/intel/common/reset.h>
+#include <string.h>
+#include <timer.h>
+
+#include "cse_lite_rw.h"
 
 /* Converts bp index to boot partition string */
 #define GET_BP_STR(bp_index) (bp_index ? "RW" : "RO")
@@ -16,9 +20,6 @@
 /* CSE RW boot partition signature */
 #define CSE_RW_SIGNATURE	0x000055aa
 
-/* CSE RW boot partition signature size */
-#define CSE_RW_SIGN_SIZE	sizeof(uint32_t)
-
 /*
  * CSE Firmware supports 3 boot partitions. For CSE Lite SKU, only 2 boot partitions are
  * used and 3rd boot partition is set to BP_STATUS_PARTITION_NOT_PRESENT.
@@ -555,17 +556,6 @@ static bool cse_erase_rw_region(const struct region_device *target_rdev)
 	return true;
 }
 
-static bool cse_copy_rw(const struct region_device *target_rdev, const void *buf,
-		size_t offset, size_t size)
-{
-	if (rdev_writeat(target_rdev, buf, offset, size) < 0) {
-		printk(BIOS_ERR, "cse_lite: Failed to update CSE firmware\n");
-		return false;
-	}
-
-	return true;
-}
-
 static bool cse_is_rw_version_latest(const struct cse_bp_info *cse_bp_info,
 		const struct cse_rw_metadata *source_metadata)
 {
@@ -586,43 +576,35 @@ static bool cse_is_update_required(const struct cse_bp_info *cse_bp_info,
 			!cse_is_rw_version_latest(cse_bp_info, source_metadata));
 }
 
-static bool cse_write_rw_region(const struct region_device *target_rdev,
-		const void *cse_cbfs_rw, const size_t cse_cbfs_rw_sz)
-{
-	/* Points to CSE CBFS RW image after boot partition signature */
-	uint8_t *cse_cbfs_rw_wo_sign = (uint8_t *)cse_cbfs_rw + CSE_RW_SIGN_SIZE;
-
-	/* Size of CSE CBFS RW image without boot partition signature */
-	uint32_t cse_cbfs_rw_wo_sign_sz = cse_cbfs_rw_sz - CSE_RW_SIGN_SIZE;
-
-	/* Update except CSE RW signature */
-	if (!cse_copy_rw(target_rdev, cse_cbfs_rw_wo_sign, CSE_RW_SIGN_SIZE,
-				cse_cbfs_rw_wo_sign_sz))
-		return false;
-
-	/* Update CSE RW signature to indicate update is complete */
-	if (!cse_copy_rw(target_rdev, (void *)cse_cbfs_rw, 0, CSE_RW_SIGN_SIZE))
-		return false;
-
-	printk(BIOS_INFO, "cse_lite: CSE RW Update Successful\n");
-	return true;
-}
-
 static enum csme_failure_reason cse_update_rw(const struct cse_bp_info *cse_bp_info,
 		const void *cse_cbfs_rw, const size_t cse_blob_sz,
 		struct region_device *target_rdev)
 {
+	struct stopwatch sw;
+	size_t written = 0;
+
 	if (region_device_sz(target_rdev) < cse_blob_sz) {
 		printk(BIOS_ERR, "RW update does not fit. CSE RW flash region size: %zx, Update blob size:%zx\n",
 				region_device_sz(target_rdev), cse_blob_sz);
 		return CSE_LITE_SKU_LAYOUT_MISMATCH_ERROR;
 	}
 
-	if (!cse_erase_rw_region(target_rdev))
-		return CSE_LITE_SKU_FW_UPDATE_ERROR;
+	stopwatch_init(&sw);
+
+	if (CONFIG(SOC_INTEL_CSE_RW_UPDATE_DIFF)) {
+		if (!cse_write_rw_region_diff(target_rdev, cse_cbfs_rw, cse_blob_sz, &written))
+			return CSE_LITE_SKU_FW_UPDATE_ERROR;
+	} else {
+		if (!cse_erase_rw_region(target_rdev))
+			return CSE_LITE_SKU_FW_UPDATE_ERROR;
+
+		if (!cse_write_rw_region(target_rdev, cse_cbfs_rw, cse_blob_sz))
+			return CSE_LITE_SKU_FW_UPDATE_ERROR;
+		written = cse_blob_sz;
+	}
 
-	if (!cse_write_rw_region(target_rdev, cse_cbfs_rw, cse_blob_sz))
-		return CSE_LITE_SKU_FW_UPDATE_ERROR;
+	printk(BIOS_INFO, "cse_lite: Wrote %zu bytes of CSE RW in %ld ms\n", written,
+	       stopwatch_duration_msecs(&sw));
 
 	return CSE_NO_ERROR;
 }
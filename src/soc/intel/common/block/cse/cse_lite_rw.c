@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/region.h>
+#include <console/console.h>
+#include <string.h>
+#include <types.h>
+
+#include "cse_lite_rw.h"
+
+/* CSE RW partition contents are compared in chunks of this size */
+#define CSE_RW_CMP_CHUNK	256
+
+static bool cse_copy_rw(const struct region_device *target_rdev, const void *buf,
+		size_t offset, size_t size)
+{
+	if (rdev_writeat(target_rdev, buf, offset, size) < 0) {
+		printk(BIOS_ERR, "cse_lite: Failed to update CSE firmware\n");
+		return false;
+	}
+
+	return true;
+}
+
+bool cse_write_rw_region(const struct region_device *target_rdev,
+		const void *cse_cbfs_rw, const size_t cse_cbfs_rw_sz)
+{
+	/* Points to CSE CBFS RW image after boot partition signature */
+	uint8_t *cse_cbfs_rw_wo_sign = (uint8_t *)cse_cbfs_rw + CSE_RW_SIGN_SIZE;
+
+	/* Size of CSE CBFS RW image without boot partition signature */
+	uint32_t cse_cbfs_rw_wo_sign_sz = cse_cbfs_rw_sz - CSE_RW_SIGN_SIZE;
+
+	/* Update except CSE RW signature */
+	if (!cse_copy_rw(target_rdev, cse_cbfs_rw_wo_sign, CSE_RW_SIGN_SIZE,
+				cse_cbfs_rw_wo_sign_sz))
+		return false;
+
+	/* Update CSE RW signature to indicate update is complete */
+	if (!cse_copy_rw(target_rdev, (void *)cse_cbfs_rw, 0, CSE_RW_SIGN_SIZE))
+		return false;
+
+	printk(BIOS_INFO, "cse_lite: CSE RW Update Successful\n");
+	return true;
+}
+
+/*
+ * Check whether the block at 'offset' in the CSE RW partition already holds the image data,
+ * and is erased after the end of the image.
+ */
+static bool cse_rw_block_matches(const struct region_device *target_rdev,
+		const uint8_t *cse_cbfs_rw, size_t cse_blob_sz, size_t offset, size_t size)
+{
+	uint8_t buf[CSE_RW_CMP_CHUNK];
+	size_t i, len, data_len;
+
+	for (i = 0; i < size; i += len) {
+		len = MIN(size - i, sizeof(buf));
+		if (rdev_readat(target_rdev, buf, offset + i, len) != len)
+			return false;
+
+		data_len = offset + i < cse_blob_sz ? MIN(len, cse_blob_sz - offset - i) : 0;
+		if (memcmp(buf, cse_cbfs_rw + offset + i, data_len))
+			return false;
+		for (; data_len < len; data_len++) {
+			if (buf[data_len] != 0xff)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/* Erase a block of the CSE RW partition and write the image data belonging there. */
+static bool cse_rewrite_rw_block(const struct region_device *target_rdev,
+		const uint8_t *cse_cbfs_rw, size_t cse_blob_sz, size_t offset, size_t size,
+		size_t *written)
+{
+	size_t start = offset ? offset : CSE_RW_SIGN_SIZE;
+	size_t end = MIN(offset + size, cse_blob_sz);
+
+	if (rdev_eraseat(target_rdev, offset, size) < 0) {
+		printk(BIOS_ERR, "cse_lite: CSE RW partition could not be erased\n");
+		return false;
+	}
+
+	/* The signature is written last, when everything else is in place. */
+	if (start < end) {
+		if (!cse_copy_rw(target_rdev, cse_cbfs_rw + start, start, end - start))
+			return false;
+		*written += end - start;
+	}
+
+	return true;
+}
+
+bool cse_write_rw_region_diff(const struct region_device *target_rdev,
+		const void *cse_cbfs_rw, const size_t cse_cbfs_rw_sz, size_t *written)
+{
+	size_t target_sz = region_device_sz(target_rdev);
+	size_t offset, size, rewritten = 0;
+
+	for (offset = 0; offset < target_sz; offset += CSE_RW_BLOCK_SIZE) {
+		size = MIN(target_sz - offset, CSE_RW_BLOCK_SIZE);
+		if (!cse_rw_block_matches(target_rdev, cse_cbfs_rw, cse_cbfs_rw_sz, offset,
+					  size))
+			break;
+	}
+
+	if (offset >= target_sz) {
+		printk(BIOS_INFO, "cse_lite: CSE RW partition already matches CBFS RW\n");
+		return true;
+	}
+
+	for (offset = 0; offset < target_sz; offset += CSE_RW_BLOCK_SIZE) {
+		size = MIN(target_sz - offset, CSE_RW_BLOCK_SIZE);
+		if (offset && cse_rw_block_matches(target_rdev, cse_cbfs_rw, cse_cbfs_rw_sz,
+						   offset, size))
+			continue;
+		if (!cse_rewrite_rw_block(target_rdev, cse_cbfs_rw, cse_cbfs_rw_sz, offset,
+					  size, written))
+			return false;
+		rewritten++;
+	}
+
+	/* Update CSE RW signature to indicate update is complete */
+	if (!cse_copy_rw(target_rdev, cse_cbfs_rw, 0, CSE_RW_SIGN_SIZE))
+		return false;
+	*written += CSE_RW_SIGN_SIZE;
+
+	printk(BIOS_INFO, "cse_lite: Rewrote %zu of %zu CSE RW blocks\n", rewritten,
+	       DIV_ROUND_UP(target_sz, CSE_RW_BLOCK_SIZE));
+	printk(BIOS_INFO, "cse_lite: CSE RW Update Successful\n");
+	return true;
+}
@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef SOC_INTEL_COMMON_BLOCK_CSE_LITE_RW_H
+#define SOC_INTEL_COMMON_BLOCK_CSE_LITE_RW_H
+
+#include <commonlib/region.h>
+#include <types.h>
+
+/* CSE RW boot partition signature size */
+#define CSE_RW_SIGN_SIZE	sizeof(uint32_t)
+
+/* Granularity of the block-diffed CSE RW update, the SPI flash erase size */
+#define CSE_RW_BLOCK_SIZE	(4 * KiB)
+
+/*
+ * Write the CSE RW image to the erased CSE RW partition. The boot partition signature at the
+ * start of the image is written last, so that it is only valid once the update is complete.
+ * Returns true on success.
+ */
+bool cse_write_rw_region(const struct region_device *target_rdev,
+		const void *cse_cbfs_rw, const size_t cse_cbfs_rw_sz);
+
+/*
+ * Update only the blocks of the CSE RW partition that differ from the image. The first block
+ * is always rewritten when anything changes, because erasing it invalidates the signature
+ * until the update is complete. The signature is written last. 'written' is increased by the
+ * number of bytes written. Returns true on success.
+ */
+bool cse_write_rw_region_diff(const struct region_device *target_rdev,
+		const void *cse_cbfs_rw, const size_t cse_cbfs_rw_sz, size_t *written);
+
+#endif /* SOC_INTEL_COMMON_BLOCK_CSE_LITE_RW_H */
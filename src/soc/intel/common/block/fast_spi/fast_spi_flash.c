@@ -1,8 +1,11 @@
 /* SPDX-License-Identifier: GPL-2.0-only */
 
+#include <bootstate.h>
 #include <device/mmio.h>
 #include <commonlib/helpers.h>
 #include <console/console.h>
+#include <cpu/x86/cache.h>
+#include <cpu/x86/mp.h>
 #include <fast_spi_def.h>
 #include <intelblocks/fast_spi.h>
 #include <soc/pci_devs.h>
@@ -37,6 +40,51 @@ static void _fast_spi_flash_get_ctx(struct fast_spi_flash_ctx *ctx)
 	ctx->mmio_base = (uintptr_t)fast_spi_get_bar();
 }
 
+/* Throughput counters, per stage. */
+enum fast_spi_flash_op {
+	OP_READ,
+	OP_MMAP_READ,
+	OP_WRITE,
+	OP_ERASE,
+	OP_COUNT,
+};
+
+static const char *const op_names[OP_COUNT] = {
+	[OP_READ] = "read",
+	[OP_MMAP_READ] = "mmap read",
+	[OP_WRITE] = "write",
+	[OP_ERASE] = "erase",
+};
+
+static struct {
+	uint64_t bytes;
+	uint64_t usecs;
+	uint32_t cycles;
+} op_stats[OP_COUNT];
+
+static void account_op(enum fast_spi_flash_op op, size_t bytes, uint32_t cycles,
+		       struct stopwatch *sw)
+{
+	stopwatch_tick(sw);
+	op_stats[op].bytes += bytes;
+	op_stats[op].cycles += cycles;
+	op_stats[op].usecs += stopwatch_duration_usecs(sw);
+}
+
+void fast_spi_flash_print_stats(void)
+{
+	int op;
+
+	for (op = 0; op < OP_COUNT; op++) {
+		if (!op_stats[op].bytes)
+			continue;
+		printk(BIOS_DEBUG, "FAST_SPI: %s: %llu bytes, %u cycles, %llu us (%llu KiB/s)\n",
+		       op_names[op], op_stats[op].bytes, op_stats[op].cycles,
+		       op_stats[op].usecs,
+		       op_stats[op].bytes * USECS_PER_SEC / KiB / MAX(op_stats[op].usecs, 1));
+	}
+}
+
 /* Read register from the FAST_SPI flash controller. */
 static uint32_t fast_spi_flash_ctrlr_reg_read(struct fast_spi_flash_ctx *ctx,
 	uint16_t reg)
@@ -154,12 +202,120 @@ static size_t get_xfer_len(const struct spi_flash *flash, uint32_t addr,
 	return xfer_len;
 }
 
+/*
+ * The BIOS region is decoded into the host address space, and reading it there is a lot faster
+ * than moving 64 bytes per hardware sequencing cycle. The CPU caches don't see the writes done
+ * through the hardware sequencer, though. Every write and erase therefore flushes the cache
+ * lines of the range it modified. That keeps the mapping current for all later stages and SMM,
+ * whichever stage modified the flash. The stage that modified the flash keeps reading through
+ * the sequencer, so that nothing it reads can come from the prefetch buffer of the controller.
+ */
+/* Fixed and extended BIOS decode windows. */
+#define MAX_MMAP_WINDOWS	2
+
+static bool flash_modified;
+
+static size_t mmap_windows(const struct flash_mmap_window **out)
+{
+	static struct flash_mmap_window windows[MAX_MMAP_WINDOWS];
+	static uint32_t num_windows;
+	static bool init_done;
+	size_t bios_start, bios_size;
+	uint32_t i, start, end;
+
+	if (!init_done) {
+		num_windows = spi_flash_get_mmap_windows(windows);
+
+		/* Only the BIOS region is decoded, whatever the windows claim. */
+		bios_start = fast_spi_get_bios_region(&bios_size);
+		for (i = 0; i < num_windows; i++) {
+			start = MAX(windows[i].flash_base, bios_start);
+			end = MIN(windows[i].flash_base + windows[i].size,
+				  bios_start + bios_size);
+			if (start >= end) {
+				windows[i].size = 0;
+				continue;
+			}
+			windows[i].host_base += start - windows[i].flash_base;
+			windows[i].flash_base = start;
+			windows[i].size = end - start;
+		}
+		init_done = true;
+	}
+
+	*out = windows;
+	return num_windows;
+}
+
+static bool mmap_read(uint32_t addr, size_t len, void *buf)
+{
+	const struct flash_mmap_window *windows;
+	size_t i, num_windows;
+
+	if (!CONFIG(FAST_SPI_MMAP_READ) || flash_modified)
+		return false;
+
+	num_windows = mmap_windows(&windows);
+	for (i = 0; i < num_windows; i++) {
+		if (addr < windows[i].flash_base ||
+		    addr - windows[i].flash_base + len > windows[i].size)
+			continue;
+		memcpy(buf, (void *)(uintptr_t)(windows[i].host_base +
+						 addr - windows[i].flash_base), len);
+		return true;
+	}
+
+	return false;
+}
+
+/* Drop the cached copies of a modified flash range. */
+static void mmap_flush(uint32_t addr, size_t len)
+{
+	const struct flash_mmap_window *windows;
+	size_t i, num_windows;
+	uint32_t start, end;
+	uintptr_t line;
+
+	flash_modified = true;
+
+	if (!CONFIG(FAST_SPI_MMAP_READ))
+		return;
+
+	num_windows = mmap_windows(&windows);
+	for (i = 0; i < num_windows; i++) {
+		start = MAX(addr, windows[i].flash_base);
+		end = MIN(addr + len, windows[i].flash_base + windows[i].size);
+		if (start >= end)
+			continue;
+
+		line = ALIGN_DOWN(windows[i].host_base + start - windows[i].flash_base,
+				  CACHELINE_SIZE);
+		for (; line < windows[i].host_base + end - windows[i].flash_base;
+		     line += CACHELINE_SIZE)
+			clflush((void *)line);
+	}
+
+	/* clflush is only ordered by fences. */
+	mfence();
+}
+
+/* Programming only clears bits, so there is nothing to do for all-ones data. */
+static bool is_erased(const uint8_t *data, size_t len)
+{
+	while (len--) {
+		if (*data++ != 0xff)
+			return false;
+	}
+	return true;
+}
+
 static int fast_spi_flash_erase(const struct spi_flash *flash,
 				uint32_t offset, size_t len)
 {
-	int ret;
-	size_t erase_size;
-	uint32_t erase_cycle;
+	int ret = SUCCESS;
+	size_t erase_size, total = len;
+	uint32_t erase_cycle, cycles = 0, start = offset;
+	struct stopwatch sw;
 
 	BOILERPLATE_CREATE_CTX(ctx);
 
@@ -168,6 +324,8 @@ static int fast_spi_flash_erase(const struct spi_flash *flash,
 		return E_ARGUMENT;
 	}
 
+	stopwatch_init(&sw);
+
 	while (len) {
 		if (IS_ALIGNED(offset, 64 * KiB) && (len >= 64 * KiB)) {
 			erase_size = 64 * KiB;
@@ -181,12 +339,19 @@ static int fast_spi_flash_erase(const struct spi_flash *flash,
 
 		ret = exec_sync_hwseq_xfer(ctx, erase_cycle, offset, 0);
 		if (ret != SUCCESS)
-			return ret;
+			break;
 
+		cycles++;
 		offset += erase_size;
 		len -= erase_size;
 	}
 
+	/* Even a failed cycle may have changed the flash. */
+	mmap_flush(start, total);
+	if (ret != SUCCESS)
+		return ret;
+
+	account_op(OP_ERASE, total, cycles, &sw);
 	return SUCCESS;
 }
 
@@ -194,11 +359,20 @@ static int fast_spi_flash_read(const struct spi_flash *flash,
 			uint32_t addr, size_t len, void *buf)
 {
 	int ret;
-	size_t xfer_len;
+	size_t xfer_len, total = len;
+	uint32_t cycles = 0;
 	uint8_t *data = buf;
+	struct stopwatch sw;
 
 	BOILERPLATE_CREATE_CTX(ctx);
 
+	stopwatch_init(&sw);
+
+	if (mmap_read(addr, len, buf)) {
+		account_op(OP_MMAP_READ, total, 0, &sw);
+		return SUCCESS;
+	}
+
 	while (len) {
 		xfer_len = get_xfer_len(flash, addr, len);
 
@@ -209,37 +383,58 @@ static int fast_spi_flash_read(const struct spi_flash *flash,
 
 		drain_xfer_fifo(ctx, data, xfer_len);
 
+		cycles++;
 		addr += xfer_len;
 		data += xfer_len;
 		len -= xfer_len;
 	}
 
+	account_op(OP_READ, total, cycles, &sw);
 	return SUCCESS;
 }
 
 static int fast_spi_flash_write(const struct spi_flash *flash,
 		uint32_t addr, size_t len, const void *buf)
 {
-	int ret;
-	size_t xfer_len;
+	int ret = SUCCESS;
+	size_t xfer_len, total = len;
+	uint32_t cycles = 0, start = addr;
 	const uint8_t *data = buf;
+	struct stopwatch sw;
 
 	BOILERPLATE_CREATE_CTX(ctx);
 
+	stopwatch_init(&sw);
+
+	/*
+	 * The sequencer transmits from FDATAn while the cycle runs and waits for the flash to
+	 * finish programming before it sets FDONE, so HSFSTS is the only thing to poll and the
+	 * FIFO can't be filled ahead of time. Skip the cycles that wouldn't change anything.
+	 */
 	while (len) {
 		xfer_len = get_xfer_len(flash, addr, len);
-		fill_xfer_fifo(ctx, data, xfer_len);
 
-		ret = exec_sync_hwseq_xfer(ctx, SPIBAR_HSFSTS_CYCLE_WRITE,
-						addr, xfer_len);
-		if (ret != SUCCESS)
-			return ret;
+		if (!is_erased(data, xfer_len)) {
+			fill_xfer_fifo(ctx, data, xfer_len);
+
+			ret = exec_sync_hwseq_xfer(ctx, SPIBAR_HSFSTS_CYCLE_WRITE,
+							addr, xfer_len);
+			if (ret != SUCCESS)
+				break;
+
+			cycles++;
+		}
 
 		addr += xfer_len;
 		data += xfer_len;
 		len -= xfer_len;
 	}
 
+	mmap_flush(start, total);
+	if (ret != SUCCESS)
+		return ret;
+
+	account_op(OP_WRITE, total, cycles, &sw);
 	return SUCCESS;
 }
 
@@ -258,6 +453,15 @@ static int fast_spi_flash_status(const struct spi_flash *flash,
 	return ret;
 }
 
+#if ENV_RAMSTAGE
+static void print_stats(void *unused)
+{
+	fast_spi_flash_print_stats();
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_LOAD, BS_ON_EXIT, print_stats, NULL);
+#endif
+
 const struct spi_flash_ops fast_spi_flash_ops = {
 	.read = fast_spi_flash_read,
 	.write = fast_spi_flash_write,
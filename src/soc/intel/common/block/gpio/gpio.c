@@ -232,8 +232,7 @@ bool gpio_routes_ioapic_irq(uint32_t irq)
 	return (gpio_ioapic_irqs_used[word_offset] & BIT(bit_offset)) != 0;
 }
 
-static void gpio_configure_itss(const struct pad_config *cfg, uint16_t port,
-	uint16_t  pad_cfg_offset)
+static void gpio_configure_itss(const struct pad_config *cfg, uint32_t pad_cfg1)
 {
 	/* No ITSS configuration in SMM. */
 	if (ENV_SMM)
@@ -254,8 +253,7 @@ static void gpio_configure_itss(const struct pad_config *cfg, uint16_t port,
 	if (!(cfg->pad_config[0] & PAD_CFG0_ROUTE_IOAPIC))
 		return;
 
-	irq = pcr_read32(port, PAD_CFG1_OFFSET(pad_cfg_offset));
-	irq &= PAD_CFG1_IRQ_MASK;
+	irq = pad_cfg1 & PAD_CFG1_IRQ_MASK;
 	if (!irq) {
 		printk(BIOS_ERR, "GPIO %u doesn't support APIC routing,\n",
 			cfg->pad);
@@ -304,11 +302,13 @@ static const int mask[4] = {
 	PAD_DW0_MASK, PAD_DW1_MASK, PAD_DW2_MASK, PAD_DW3_MASK
 };
 
-static void gpio_configure_pad(const struct pad_config *cfg)
+/* Program the DWx registers of a pad, skipping those that don't change. */
+static void gpio_configure_pad_regs(const struct pad_config *cfg,
+				    const struct pad_community *comm)
 {
-	const struct pad_community *comm = gpio_get_community(cfg->pad);
 	uint16_t config_offset;
 	uint32_t pad_conf, soc_pad_conf;
+	uint32_t pad_cfg1 = 0;
 	int i;
 
 	config_offset = pad_config_offset(comm, cfg->pad);
@@ -334,21 +334,23 @@ static void gpio_configure_pad(const struct pad_config *cfg)
 			pad_conf,/* old value */
 			cfg->pad_config[i],/* value passed from gpio table */
 			soc_pad_conf);/*new value*/
-		pcr_write32(comm->port, PAD_CFG_OFFSET(config_offset, i),
-			soc_pad_conf);
+		if (soc_pad_conf != pad_conf)
+			pcr_write32(comm->port, PAD_CFG_OFFSET(config_offset, i),
+				soc_pad_conf);
+		if (i == 1)
+			pad_cfg1 = soc_pad_conf;
 	}
-	gpio_configure_itss(cfg, comm->port, config_offset);
-	gpio_configure_owner(cfg, comm);
-	gpi_enable_smi(cfg, comm);
-	gpi_enable_nmi(cfg, comm);
+	gpio_configure_itss(cfg, pad_cfg1);
 }
 
-void gpio_configure_pads(const struct pad_config *cfg, size_t num_pads)
+static void gpio_configure_pad(const struct pad_config *cfg)
 {
-	size_t i;
+	const struct pad_community *comm = gpio_get_community(cfg->pad);
 
-	for (i = 0; i < num_pads; i++)
-		gpio_configure_pad(cfg + i);
+	gpio_configure_pad_regs(cfg, comm);
+	gpio_configure_owner(cfg, comm);
+	gpi_enable_smi(cfg, comm);
+	gpi_enable_nmi(cfg, comm);
 }
 
 /*
@@ -373,19 +375,140 @@ static const struct pad_config *gpio_get_config(const struct pad_config *c,
 	return c;
 }
 
-void gpio_configure_pads_with_override(const struct pad_config *base_cfg,
-					size_t base_num_pads,
-					const struct pad_config *override_cfg,
-					size_t override_num_pads)
+/* Group registers updated at once for all pads of a batch. */
+#define GPIO_BATCH_MAX_GROUPS	8
+
+struct gpio_group_batch {
+	uint32_t own_mask;
+	uint32_t own_value;
+	uint32_t smi_en;
+	uint32_t nmi_en;
+};
+
+static void gpio_update_group_regs(const struct pad_community *comm, size_t group,
+				   const struct gpio_group_batch *batch)
 {
-	size_t i;
+	uint16_t hostsw_own_offset;
+	uint32_t hostsw_own, new_hostsw_own;
+
+	if (batch->own_mask) {
+		hostsw_own_offset = comm->host_own_reg_0 + group * sizeof(uint32_t);
+		hostsw_own = pcr_read32(comm->port, hostsw_own_offset);
+		new_hostsw_own = (hostsw_own & ~batch->own_mask) | batch->own_value;
+		if (new_hostsw_own != hostsw_own)
+			pcr_write32(comm->port, hostsw_own_offset, new_hostsw_own);
+	}
+
+	if (batch->smi_en) {
+		/* Write back 1 to reset the sts bits */
+		pcr_rmw32(comm->port, GPI_SMI_STS_OFFSET(comm, group), batch->smi_en, 0);
+		pcr_or32(comm->port, GPI_SMI_EN_OFFSET(comm, group), batch->smi_en);
+	}
+
+	if (batch->nmi_en) {
+		pcr_rmw32(comm->port, GPI_NMI_STS_OFFSET(comm, group), batch->nmi_en, 0);
+		pcr_or32(comm->port, GPI_NMI_EN_OFFSET(comm, group), batch->nmi_en);
+	}
+}
+
+/*
+ * Configure the pads of the table that belong to 'comm'. The ownership, SMI
+ * and NMI bits of all pads are collected per group, so each group register is
+ * accessed once. Returns the number of pads configured.
+ */
+static size_t gpio_configure_community(const struct pad_community *comm,
+				       const struct pad_config *base_cfg,
+				       size_t base_num_pads,
+				       const struct pad_config *override_cfg,
+				       size_t override_num_pads)
+{
+	struct gpio_group_batch groups[GPIO_BATCH_MAX_GROUPS] = { 0 };
 	const struct pad_config *c;
+	size_t count = 0;
+	size_t i, group;
+	unsigned int pin;
+	uint32_t bit;
 
 	for (i = 0; i < base_num_pads; i++) {
-		c = gpio_get_config(base_cfg + i, override_cfg,
-				override_num_pads);
-		gpio_configure_pad(c);
+		c = gpio_get_config(base_cfg + i, override_cfg, override_num_pads);
+		if (c->pad < comm->first_pad || c->pad > comm->last_pad)
+			continue;
+
+		count++;
+
+		if (comm->num_groups > ARRAY_SIZE(groups)) {
+			gpio_configure_pad(c);
+			continue;
+		}
+
+		gpio_configure_pad_regs(c, comm);
+
+		pin = relative_pad_in_comm(comm, c->pad);
+		group = gpio_group_index(comm, pin);
+		bit = 1U << (pin - comm->groups[group].first_pad);
+
+		groups[group].own_mask |= bit;
+		if (c->pad_config[1] & PAD_CFG_OWN_GPIO_DRIVER)
+			groups[group].own_value |= bit;
+		else
+			groups[group].own_value &= ~bit;
+
+		if ((c->pad_config[0] & PAD_CFG0_ROUTE_SMI) == PAD_CFG0_ROUTE_SMI)
+			groups[group].smi_en |= bit;
+
+		/* Do not configure NMI if the platform doesn't support it */
+		if ((c->pad_config[0] & PAD_CFG0_ROUTE_NMI) == PAD_CFG0_ROUTE_NMI &&
+		    comm->gpi_nmi_sts_reg_0 && comm->gpi_nmi_en_reg_0)
+			groups[group].nmi_en |= bit;
 	}
+
+	for (group = 0; group < MIN(comm->num_groups, ARRAY_SIZE(groups)); group++)
+		gpio_update_group_regs(comm, group, &groups[group]);
+
+	return count;
+}
+
+static void gpio_configure_pad_table(const struct pad_config *base_cfg,
+				     size_t base_num_pads,
+				     const struct pad_config *override_cfg,
+				     size_t override_num_pads)
+{
+	const struct pad_community *comm;
+	size_t num_communities;
+	size_t i, count = 0;
+
+	if (!CONFIG(SOC_INTEL_COMMON_BLOCK_GPIO_BATCH)) {
+		for (i = 0; i < base_num_pads; i++)
+			gpio_configure_pad(gpio_get_config(base_cfg + i, override_cfg,
+							   override_num_pads));
+		return;
+	}
+
+	comm = soc_gpio_get_community(&num_communities);
+	for (i = 0; i < num_communities; i++, comm++)
+		count += gpio_configure_community(comm, base_cfg, base_num_pads,
+						  override_cfg, override_num_pads);
+
+	/* Some pad isn't in any community, have gpio_get_community() complain. */
+	if (count != base_num_pads) {
+		for (i = 0; i < base_num_pads; i++)
+			gpio_get_community(gpio_get_config(base_cfg + i, override_cfg,
+							   override_num_pads)->pad);
+	}
+}
+
+void gpio_configure_pads(const struct pad_config *cfg, size_t num_pads)
+{
+	gpio_configure_pad_table(cfg, num_pads, NULL, 0);
+}
+
+void gpio_configure_pads_with_override(const struct pad_config *base_cfg,
+					size_t base_num_pads,
+					const struct pad_config *override_cfg,
+					size_t override_num_pads)
+{
+	gpio_configure_pad_table(base_cfg, base_num_pads, override_cfg,
+				 override_num_pads);
 }
 
 void *gpio_dwx_address(const gpio_t pad)
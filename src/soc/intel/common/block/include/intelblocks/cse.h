@@ -154,6 +154,30 @@ heci_send(const void *msg, size_t len, uint8_t host_addr, uint8_t cse_addr);
  */
 int heci_send_receive(const void *snd_msg, size_t snd_sz, void *rcv_msg, size_t *rcv_sz);
 
+/*
+ * Split-phase messaging. Send message msg of size len to the CSE client cse_addr and return
+ * without waiting for the reply. The reply is received into 'reply', which must stay valid
+ * until heci_receive_async() is called, and must not be bigger than 128 bytes. Only one
+ * request per client may be outstanding. heci_send() collects all outstanding replies before
+ * sending, heci_reset() drops them.
+ * Returns 0 on failure and 1 on success.
+ */
+int heci_send_async(const void *msg, size_t len, uint8_t cse_addr, void *reply,
+		    size_t reply_size);
+
+/*
+ * Returns true if the reply to the request sent to cse_addr hasn't arrived yet. Never waits
+ * for the CSE.
+ */
+bool heci_reply_pending(uint8_t cse_addr);
+
+/*
+ * Wait for the reply to the request sent to cse_addr. reply_size is updated with the size of
+ * the reply, if not NULL. This ends the request, also on failure.
+ * Returns 0 on failure and 1 on success.
+ */
+int heci_receive_async(uint8_t cse_addr, size_t *reply_size);
+
 /*
  * Attempt device reset. This is useful and perhaps only thing left to do when
  * CPU and CSE are out of sync or CSE fails to respond.
@@ -95,5 +95,10 @@ uint32_t soc_get_spi_dmi_destination_id(void);
  */
 struct postcar_frame;
 void fast_spi_cache_ext_bios_postcar(struct postcar_frame *pcf);
+/*
+ * Print the number of bytes, hardware sequencing cycles and time spent per flash operation
+ * in the current stage.
+ */
+void fast_spi_flash_print_stats(void);
 
 #endif	/* SOC_INTEL_COMMON_BLOCK_FAST_SPI_H */
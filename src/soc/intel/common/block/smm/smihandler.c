@@ -7,6 +7,7 @@
 #include <console/console.h>
 #include <cpu/x86/cache.h>
 #include <cpu/x86/msr.h>
+#include <cpu/x86/smi_profile.h>
 #include <cpu/x86/smm.h>
 #include <cpu/intel/em64t100_save_state.h>
 #include <cpu/intel/em64t101_save_state.h>
@@ -153,6 +154,8 @@ void smihandler_southbridge_sleep(
 	uint32_t reg32;
 	uint8_t slp_typ;
 
+	smi_profile_add_source(SMI_PROFILE_SRC_SLEEP);
+
 	/* First, disable further SMIs */
 	pmc_disable_smi(SLP_SMI_EN);
 	/* Figure out SLP_TYP */
@@ -258,6 +261,8 @@ static void southbridge_smi_gsmi(
 	/* Parameter buffer in EBX */
 	reg_ebx = save_state_ops->get_reg(io_smi, RBX);
 
+	smi_profile_add_source(SMI_PROFILE_SRC_GSMI);
+
 	/* drivers/elog/gsmi.c */
 	ret = gsmi_exec(sub_command, &reg_ebx);
 	save_state_ops->set_reg(io_smi, RAX, ret);
@@ -293,6 +298,8 @@ static void southbridge_smi_store(
 	/* Parameter buffer in EBX */
 	reg_ebx = save_state_ops->get_reg(io_smi, RBX);
 
+	smi_profile_add_source(SMI_PROFILE_SRC_SMMSTORE);
+
 	const bool wp_enabled = !fast_spi_wpd_status();
 	if (wp_enabled) {
 		set_insmm_sts(true);
@@ -347,6 +354,8 @@ void smihandler_southbridge_apmc(
 	uint8_t reg8;
 
 	reg8 = apm_get_apmc();
+	smi_profile_set_apmc(reg8);
+
 	switch (reg8) {
 	case APM_CNT_ACPI_DISABLE:
 		pmc_disable_pm1_control(SCI_EN);
@@ -376,6 +385,8 @@ void smihandler_southbridge_pm1(
 	uint16_t pm1_sts = pmc_clear_pm1_status();
 	u16 pm1_en = pmc_read_pm1_enable();
 
+	smi_profile_add_source(SMI_PROFILE_SRC_PM1);
+
 	/*
 	 * While OSPM is not active, poweroff immediately
 	 * on a power button event.
@@ -391,6 +402,7 @@ void smihandler_southbridge_pm1(
 void smihandler_southbridge_gpe0(
 	const struct smm_save_state_ops *save_state_ops)
 {
+	smi_profile_add_source(SMI_PROFILE_SRC_GPE0);
 	pmc_clear_all_gpe_status();
 }
 
@@ -399,6 +411,8 @@ void smihandler_southbridge_tco(
 {
 	uint32_t tco_sts = pmc_clear_tco_status();
 
+	smi_profile_add_source(SMI_PROFILE_SRC_TCO);
+
 	/*
 	 * SPI synchronous SMIs are TCO SMIs, but they do not have a status
 	 * bit in the TCO_STS register. Furthermore, the TCO_STS bit in the
@@ -456,6 +470,7 @@ void smihandler_southbridge_periodic(
 	/* Are periodic SMIs enabled? */
 	if ((reg32 & PERIODIC_EN) == 0)
 		return;
+	smi_profile_add_source(SMI_PROFILE_SRC_PERIODIC);
 	printk(BIOS_DEBUG, "Periodic SMI.\n");
 }
 
@@ -464,6 +479,7 @@ void smihandler_southbridge_gpi(
 {
 	struct gpi_status smi_sts;
 
+	smi_profile_add_source(SMI_PROFILE_SRC_GPI);
 	gpi_clear_get_smi_status(&smi_sts);
 	mainboard_smi_gpi_handler(&smi_sts);
 
@@ -474,6 +490,7 @@ void smihandler_southbridge_gpi(
 void smihandler_southbridge_espi(
 	const struct smm_save_state_ops *save_state_ops)
 {
+	smi_profile_add_source(SMI_PROFILE_SRC_ESPI);
 	mainboard_smi_espi_handler();
 }
 
@@ -502,6 +519,8 @@ void southbridge_smi_handler(void)
 	if (!smi_sts)
 		return;
 
+	smi_profile_set_handlers(smi_sts);
+
 	save_state_ops = get_smm_save_state_ops();
 
 	/* Call SMI sub handler for each of the status bits */
@@ -7,6 +7,7 @@
 #include <console/console.h>
 #include <cpu/x86/cache.h>
 #include <device/pci_def.h>
+#include <cpu/x86/smi_profile.h>
 #include <cpu/x86/smm.h>
 #include <cpu/intel/em64t101_save_state.h>
 #include <elog.h>
@@ -113,6 +114,8 @@ static void southbridge_smi_sleep(void)
 	u32 reg32;
 	u8 slp_typ;
 
+	smi_profile_add_source(SMI_PROFILE_SRC_SLEEP);
+
 	/* First, disable further SMIs */
 	write_pmbase8(SMI_EN, read_pmbase8(SMI_EN) & ~SLP_SMI_EN);
 
@@ -245,6 +248,8 @@ static void southbridge_smi_gsmi(void)
 	/* Parameter buffer in EBX */
 	param = (u32*)&io_smi->rbx;
 
+	smi_profile_add_source(SMI_PROFILE_SRC_GSMI);
+
 	/* drivers/elog/gsmi.c */
 	*ret = gsmi_exec(sub_command, param);
 }
@@ -264,6 +269,8 @@ static void southbridge_smi_store(void)
 	/* Parameter buffer in EBX */
 	reg_rbx = (uintptr_t)io_smi->rbx;
 
+	smi_profile_add_source(SMI_PROFILE_SRC_SMMSTORE);
+
 	/* drivers/smmstore/smi.c */
 	ret = smmstore_exec(sub_command, (void *)reg_rbx);
 	io_smi->rax = ret;
@@ -276,6 +283,8 @@ static void southbridge_smi_apmc(void)
 	u8 reg8;
 
 	reg8 = apm_get_apmc();
+	smi_profile_set_apmc(reg8);
+
 	switch (reg8) {
 	case APM_CNT_ACPI_DISABLE:
 		write_pmbase32(PM1_CNT, read_pmbase32(PM1_CNT) & ~SCI_EN);
@@ -309,6 +318,8 @@ static void southbridge_smi_pm1(void)
 {
 	u16 pm1_sts;
 
+	smi_profile_add_source(SMI_PROFILE_SRC_PM1);
+
 	pm1_sts = reset_pm1_status();
 	dump_pm1_status(pm1_sts);
 
@@ -328,6 +339,8 @@ static void southbridge_smi_gpe0(void)
 {
 	u32 gpe0_sts;
 
+	smi_profile_add_source(SMI_PROFILE_SRC_GPE0);
+
 	gpe0_sts = reset_gpe0_status();
 	dump_gpe0_status(gpe0_sts);
 }
@@ -336,6 +349,8 @@ static void southbridge_smi_gpi(void)
 {
 	u16 reg16;
 
+	smi_profile_add_source(SMI_PROFILE_SRC_GPI);
+
 	reg16 = reset_alt_gp_smi_status();
 	reg16 &= read_pmbase16(ALT_GP_SMI_EN);
 
@@ -364,6 +379,8 @@ static void southbridge_smi_tco(void)
 {
 	u32 tco_sts;
 
+	smi_profile_add_source(SMI_PROFILE_SRC_TCO);
+
 	tco_sts = reset_tco_status();
 
 	/* Any TCO event? */
@@ -408,6 +425,7 @@ static void southbridge_smi_periodic(void)
 	if ((reg32 & PERIODIC_EN) == 0)
 		return;
 
+	smi_profile_add_source(SMI_PROFILE_SRC_PERIODIC);
 	printk(BIOS_DEBUG, "Periodic SMI.\n");
 }
 
@@ -460,6 +478,7 @@ void southbridge_smi_handler(void)
 	 * happening in the following calls.
 	 */
 	smi_sts = reset_smi_status();
+	smi_profile_set_handlers(smi_sts);
 
 	/* Call SMI sub handler for each of the status bits */
 	for (i = 0; i < 31; i++) {
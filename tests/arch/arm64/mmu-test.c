@@ -0,0 +1,280 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <arch/lib_helpers.h>
+#include <arch/mmu.h>
+#include <stdint.h>
+#include <symbols.h>
+#include <tests/test.h>
+
+/*
+ * The table walker is not modelled. The tests look at the tables themselves, and at what the
+ * entry given by watch held when the TLB was invalidated first.
+ */
+#define TTB_TABLES 8
+__aligned(GRANULE_SIZE) TEST_REGION(ttb, TTB_TABLES * GRANULE_SIZE);
+
+static uint64_t sctlr;
+static int tlb_flushes;
+static uint64_t *watch;
+static uint64_t watched;
+
+void dsb(void) {}
+void isb(void) {}
+void dmb(void) {}
+void iciallu(void) {}
+
+void tlbiall_el3(void)
+{
+	if (watch && !tlb_flushes)
+		watched = *watch;
+	tlb_flushes++;
+}
+
+uint64_t raw_read_sctlr_el3(void)
+{
+	return sctlr;
+}
+
+void raw_write_sctlr_el3(uint64_t value)
+{
+	sctlr = value;
+}
+
+uint64_t raw_read_mair_el3(void)
+{
+	return 0;
+}
+
+void raw_write_mair_el3(uint64_t mair) {}
+
+uint64_t raw_read_tcr_el3(void)
+{
+	return 0;
+}
+
+void raw_write_tcr_el3(uint64_t tcr) {}
+void raw_write_ttbr0_el3(uint64_t ttbr0) {}
+
+void die(const char *fmt, ...)
+{
+	fail_msg("%s", fmt);
+	__builtin_unreachable();
+}
+
+static int used_tables(void)
+{
+	uint64_t *table = (uint64_t *)_ttb;
+	int count = 0;
+
+	for (; _ettb - (u8 *)table > 0; table += GRANULE_SIZE/sizeof(*table))
+		if (table[0] != UNUSED_DESC)
+			count++;
+
+	return count;
+}
+
+/* Returns the entry that maps addr. */
+static uint64_t *pte_ptr(uint64_t addr)
+{
+	uint64_t *table = (uint64_t *)_ttb;
+	int shift = L0_ADDR_SHIFT;
+
+	while (1) {
+		uint64_t *ptr = &table[(addr >> shift) &
+				       ((1UL << BITS_RESOLVED_PER_LVL) - 1)];
+
+		if ((*ptr & DESC_MASK) != TABLE_DESC || shift <= GRANULE_SIZE_SHIFT)
+			return ptr;
+
+		table = (uint64_t *)(*ptr & XLAT_ADDR_MASK);
+		shift -= BITS_RESOLVED_PER_LVL;
+	}
+}
+
+static uint64_t pte(uint64_t addr)
+{
+	return *pte_ptr(addr);
+}
+
+static int setup_mmu(void **state)
+{
+	sctlr = 0;
+	mmu_init();
+	tlb_flushes = 0;
+	watch = NULL;
+	return 0;
+}
+
+static void test_mmu_block_mapping(void **state)
+{
+	mmu_config_range((void *)0, 4UL * GiB, MA_DEV | MA_RW);
+
+	/* Root table and one L1 table, every 1GiB mapped by a single block. */
+	assert_int_equal(2, used_tables());
+	assert_int_equal(BLOCK_DESC, pte(0) & DESC_MASK);
+	assert_int_equal(1 * GiB, pte(1 * GiB) & XLAT_ADDR_MASK);
+	assert_int_equal(1, tlb_flushes);
+}
+
+static void test_mmu_split_and_fold(void **state)
+{
+	const uint64_t page = 1 * GiB + 5 * MiB + 12 * KiB;
+
+	mmu_config_range((void *)0, 4UL * GiB, MA_DEV | MA_RW);
+	mmu_config_range((void *)page, 4 * KiB, MA_MEM | MA_RW);
+
+	/* The page needs an L2 and an L3 table below the 1GiB block. */
+	assert_int_equal(4, used_tables());
+	assert_int_equal(PAGE_DESC, pte(page) & DESC_MASK);
+	assert_int_equal(BLOCK_INDEX_MEM_NORMAL,
+			 (pte(page) >> BLOCK_INDEX_SHIFT) & BLOCK_INDEX_MASK);
+	assert_int_equal(PAGE_DESC, pte(page + 4 * KiB) & DESC_MASK);
+	assert_int_equal(BLOCK_DESC, pte(page + 2 * MiB) & DESC_MASK);
+
+	/* Restoring the attributes folds both tables back into one block... */
+	mmu_config_range((void *)page, 4 * KiB, MA_DEV | MA_RW);
+	assert_int_equal(BLOCK_DESC, pte(page) & DESC_MASK);
+	assert_int_equal(1 * GiB, pte(page) & XLAT_ADDR_MASK);
+
+	/* ...and releases them once the TLB has been invalidated. */
+	assert_int_equal(2, used_tables());
+}
+
+static void test_mmu_contiguous_hint(void **state)
+{
+	const uint64_t base = 2 * MiB;
+	int i;
+
+	mmu_config_range((void *)base, 2 * MiB, MA_MEM | MA_RW);
+	mmu_config_range((void *)(base + 64 * KiB), 64 * KiB, MA_DEV | MA_RW);
+
+	if (!CONFIG(ARM64_MMU_CONTIGUOUS_HINTS)) {
+		for (i = 0; i < 512; i++)
+			assert_false(pte(base + i * 4 * KiB) & BLOCK_CONTIGUOUS);
+		return;
+	}
+
+	/* Every aligned 64KiB run of uniform pages carries the hint. */
+	for (i = 0; i < 32; i++)
+		assert_true(pte(base + i * 4 * KiB) & BLOCK_CONTIGUOUS);
+
+	/* A single differing page drops the hint from its group only. */
+	mmu_config_range((void *)(base + 68 * KiB), 4 * KiB, MA_MEM | MA_RW);
+	for (i = 0; i < 16; i++)
+		assert_true(pte(base + i * 4 * KiB) & BLOCK_CONTIGUOUS);
+	for (i = 16; i < 32; i++)
+		assert_false(pte(base + i * 4 * KiB) & BLOCK_CONTIGUOUS);
+
+	/* Hints are never set on a run that is not naturally aligned. */
+	mmu_config_range((void *)base, 2 * MiB, MA_MEM | MA_RW);
+	mmu_config_range((void *)(base + 4 * KiB), 64 * KiB, MA_DEV | MA_RW);
+	assert_false(pte(base + 4 * KiB) & BLOCK_CONTIGUOUS);
+	assert_false(pte(base + 64 * KiB) & BLOCK_CONTIGUOUS);
+}
+
+static void test_mmu_batch_single_flush(void **state)
+{
+	const uint64_t page = 1 * GiB + 12 * KiB;
+
+	mmu_config_begin();
+	mmu_config_range((void *)0, 4UL * GiB, MA_DEV | MA_RW);
+	mmu_config_range((void *)page, 4 * KiB, MA_MEM | MA_RW);
+	mmu_config_range((void *)page, 4 * KiB, MA_DEV | MA_RW);
+	assert_int_equal(0, tlb_flushes);
+
+	/* Folded tables may still be cached until the batch is committed. */
+	assert_int_equal(4, used_tables());
+
+	mmu_config_commit();
+	assert_int_equal(1, tlb_flushes);
+	assert_int_equal(2, used_tables());
+}
+
+static void test_mmu_remap_does_not_exhaust_ttb(void **state)
+{
+	int i;
+
+	/* Without reclaiming subtables this would need far more than TTB_TABLES. */
+	mmu_config_range((void *)0, 4UL * GiB, MA_DEV | MA_RW);
+	for (i = 0; i < 64; i++) {
+		uint64_t page = (uint64_t)(i % 4) * GiB + i * 2 * MiB;
+
+		mmu_config_range((void *)page, 4 * KiB, MA_MEM | MA_RW);
+		mmu_config_range((void *)page, 4 * KiB, MA_DEV | MA_RW);
+	}
+
+	assert_int_equal(2, used_tables());
+}
+
+static void test_mmu_enabled_no_fold(void **state)
+{
+	const uint64_t page = 1 * GiB + 5 * MiB + 12 * KiB;
+
+	mmu_config_range((void *)0, 4UL * GiB, MA_DEV | MA_RW);
+	sctlr |= SCTLR_M;
+
+	/* Splitting works as before, but the new tables get no hints... */
+	mmu_config_range((void *)page, 4 * KiB, MA_MEM | MA_RW);
+	assert_int_equal(4, used_tables());
+	assert_false(pte(page + 64 * KiB) & BLOCK_CONTIGUOUS);
+
+	/* ...and are not folded into the live parent entry again. */
+	mmu_config_range((void *)page, 4 * KiB, MA_DEV | MA_RW);
+	assert_int_equal(PAGE_DESC, pte(page) & DESC_MASK);
+	assert_int_equal(4, used_tables());
+}
+
+static void test_mmu_enabled_breaks_hinted_group(void **state)
+{
+	const uint64_t base = 2 * MiB;
+
+	mmu_config_range((void *)base, 2 * MiB, MA_MEM | MA_RW);
+	mmu_config_range((void *)(base + 64 * KiB), 64 * KiB, MA_DEV | MA_RW);
+
+	sctlr |= SCTLR_M;
+	tlb_flushes = 0;
+	watch = pte_ptr(base + 4 * KiB);
+	mmu_config_range((void *)base, 4 * KiB, MA_DEV | MA_RW);
+
+	if (!CONFIG(ARM64_MMU_CONTIGUOUS_HINTS)) {
+		/* Without hints only the remapped entry is written. */
+		assert_int_equal(base + 4 * KiB, watched & XLAT_ADDR_MASK);
+		assert_int_equal(1, tlb_flushes);
+		assert_int_equal(BLOCK_INDEX_MEM_DEV_NGNRNE,
+				 (pte(base) >> BLOCK_INDEX_SHIFT) & BLOCK_INDEX_MASK);
+		return;
+	}
+
+	/* The neighbours were unmapped before the hint went away... */
+	assert_int_equal(INVALID_DESC, watched);
+	assert_int_equal(2, tlb_flushes);
+
+	/* ...and came back unchanged otherwise. */
+	assert_int_equal(PAGE_DESC, pte(base + 4 * KiB) & DESC_MASK);
+	assert_false(pte(base + 4 * KiB) & BLOCK_CONTIGUOUS);
+	assert_int_equal(base + 4 * KiB, pte(base + 4 * KiB) & XLAT_ADDR_MASK);
+	assert_int_equal(BLOCK_INDEX_MEM_NORMAL,
+			 (pte(base + 4 * KiB) >> BLOCK_INDEX_SHIFT) & BLOCK_INDEX_MASK);
+	assert_int_equal(BLOCK_INDEX_MEM_DEV_NGNRNE,
+			 (pte(base) >> BLOCK_INDEX_SHIFT) & BLOCK_INDEX_MASK);
+
+	/* Groups that were not touched keep their hint. */
+	assert_true(pte(base + 64 * KiB) & BLOCK_CONTIGUOUS);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_mmu_block_mapping, setup_mmu),
+		cmocka_unit_test_setup(test_mmu_split_and_fold, setup_mmu),
+		cmocka_unit_test_setup(test_mmu_contiguous_hint, setup_mmu),
+		cmocka_unit_test_setup(test_mmu_batch_single_flush, setup_mmu),
+		cmocka_unit_test_setup(test_mmu_remap_does_not_exhaust_ttb,
+				       setup_mmu),
+		cmocka_unit_test_setup(test_mmu_enabled_no_fold, setup_mmu),
+		cmocka_unit_test_setup(test_mmu_enabled_breaks_hinted_group,
+				       setup_mmu),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,335 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/bsd/cbfs_private.h>
+#include <commonlib/region.h>
+#include <endian.h>
+#include <string.h>
+#include <tests/test.h>
+
+#define FLASH_SIZE	0x4000
+#define MDIR_SIZE	0x200
+#define FILE_COUNT	6
+
+static u8 flash[FLASH_SIZE];
+static u8 mcache[0x1000] __aligned(CBFS_MCACHE_ALIGNMENT);
+static int read_count;
+
+static ssize_t flash_readat(const struct region_device *rd, void *b, size_t offset,
+			    size_t size)
+{
+	read_count++;
+	memcpy(b, &flash[offset], size);
+	return size;
+}
+
+static const struct region_device_ops flash_ops = {
+	.readat = flash_readat,
+};
+
+static const struct region_device flash_rdev = REGION_DEV_INIT(&flash_ops, 0, FLASH_SIZE);
+
+/*
+ * The metadata hash only has to tell different metadata apart here, so the vboot digest API is
+ * implemented with a 64-bit FNV-1a repeated over the digest. Only one digest is ever in flight.
+ */
+static uint64_t fnv;
+
+size_t vb2_digest_size(enum vb2_hash_algorithm hash_alg)
+{
+	return hash_alg == VB2_HASH_SHA256 ? VB2_SHA256_DIGEST_SIZE : 0;
+}
+
+vb2_error_t vb2_digest_init(struct vb2_digest_context *dc, enum vb2_hash_algorithm algo)
+{
+	fnv = 0xcbf29ce484222325ULL;
+	return algo == VB2_HASH_SHA256 ? VB2_SUCCESS : VB2_ERROR_UNKNOWN;
+}
+
+vb2_error_t vb2_digest_extend(struct vb2_digest_context *dc, const uint8_t *buf, uint32_t size)
+{
+	while (size--)
+		fnv = (fnv ^ *buf++) * 0x100000001b3ULL;
+	return VB2_SUCCESS;
+}
+
+vb2_error_t vb2_digest_finalize(struct vb2_digest_context *dc, uint8_t *digest,
+				uint32_t digest_size)
+{
+	for (uint32_t i = 0; i < digest_size; i++)
+		digest[i] = fnv >> (i % 8 * 8);
+	return VB2_SUCCESS;
+}
+
+static const char *const names[FILE_COUNT] = {
+	"fallback/romstage", "fallback/ramstage", "config", "revision", "a", "fallback/payload",
+};
+static size_t file_offsets[FILE_COUNT];
+
+/* Write a file header and name at |offset|. Returns the offset of the next file. */
+static size_t add_file(size_t offset, const char *name, uint32_t type, uint32_t len)
+{
+	struct cbfs_file *h = (struct cbfs_file *)&flash[offset];
+	const uint32_t data_offset = ALIGN_UP(sizeof(*h) + strlen(name) + 1, 16);
+
+	memset(h, 0, data_offset);
+	memcpy(h->magic, CBFS_FILE_MAGIC, sizeof(h->magic));
+	h->len = htobe32(len);
+	h->type = htobe32(type);
+	h->offset = htobe32(data_offset);
+	strcpy(h->filename, name);
+	memset(&flash[offset + data_offset], type, len);
+
+	return ALIGN_UP(offset + data_offset + len, CBFS_ALIGNMENT);
+}
+
+static struct cbfs_mdir_header *mdir_header(void)
+{
+	const struct cbfs_file *h = (const struct cbfs_file *)flash;
+
+	return (struct cbfs_mdir_header *)&flash[be32toh(h->offset)];
+}
+
+/* Returns the copy of the metadata of file |i| inside the directory. */
+static struct cbfs_file *mdir_copy(int i)
+{
+	u8 *copy = (u8 *)(mdir_header() + 1);
+
+	while (i--)
+		copy += ALIGN_UP(be32toh(((struct cbfs_file *)copy)->offset), CBFS_MDIR_ALIGN);
+
+	return (struct cbfs_file *)copy;
+}
+
+/* Point the copy of file |i| at |offset|, which replaces the file magic in the directory. */
+static void set_copy_offset(int i, uint32_t offset)
+{
+	const uint32_t be_offset = htobe32(offset);
+
+	memcpy(mdir_copy(i)->magic, &be_offset, sizeof(be_offset));
+}
+
+/*
+ * Build a CBFS like cbfstool does: a metadata directory first, then FILE_COUNT files and an
+ * empty file spanning the rest of the flash. The directory describes the first |covered| files.
+ */
+static void setup_cbfs(int covered)
+{
+	struct cbfs_mdir_header *dir;
+	size_t offset;
+	u8 *copy;
+	int i;
+
+	memset(flash, 0xff, sizeof(flash));
+	offset = add_file(0, CBFS_MDIR_NAME, CBFS_TYPE_METADATA_DIR, MDIR_SIZE);
+	for (i = 0; i < FILE_COUNT; i++) {
+		file_offsets[i] = offset;
+		offset = add_file(offset, names[i], CBFS_TYPE_RAW, 0x100 + i * 0x30);
+	}
+	add_file(offset, "", CBFS_TYPE_NULL, FLASH_SIZE - offset - 0x40);
+
+	dir = mdir_header();
+	memset(dir, 0, MDIR_SIZE);
+	copy = (u8 *)(dir + 1);
+	for (i = 0; i < covered; i++) {
+		const struct cbfs_file *h = (const struct cbfs_file *)&flash[file_offsets[i]];
+		const uint32_t data_offset = be32toh(h->offset);
+		uint32_t *magic = (uint32_t *)copy;
+
+		memcpy(copy, h, data_offset);
+		magic[0] = htobe32(file_offsets[i]);
+		magic[1] = 0;
+		copy += ALIGN_UP(data_offset, CBFS_MDIR_ALIGN);
+	}
+	dir->magic = htobe32(CBFS_MDIR_MAGIC);
+	dir->count = htobe32(covered);
+	dir->size = htobe32(copy - (u8 *)(dir + 1));
+	dir->end_offset = htobe32(covered < FILE_COUNT ? file_offsets[covered] : offset);
+}
+
+static struct vb2_hash metadata_hash(void)
+{
+	struct vb2_hash hash = { .algo = VB2_HASH_SHA256 };
+
+	assert_int_equal(CB_CBFS_NOT_FOUND, cbfs_walk(&flash_rdev, NULL, NULL, &hash,
+						      CBFS_WALK_WRITEBACK_HASH));
+	return hash;
+}
+
+/* Build the mcache and check that it finds every file where a walk finds it. */
+static void assert_mcache_good(struct vb2_hash *hash)
+{
+	union cbfs_mdata mdata;
+	size_t data_offset;
+	int i;
+
+	read_count = 0;
+	assert_int_equal(CB_SUCCESS, cbfs_mcache_build(&flash_rdev, mcache, sizeof(mcache),
+						       hash));
+
+	for (i = 0; i < FILE_COUNT; i++) {
+		assert_int_equal(CB_SUCCESS, cbfs_mcache_lookup(mcache, sizeof(mcache), names[i],
+								&mdata, &data_offset));
+		assert_int_equal(file_offsets[i] + be32toh(mdata.h.offset), data_offset);
+		assert_string_equal(names[i], mdata.h.filename);
+	}
+	assert_int_equal(CB_CBFS_NOT_FOUND, cbfs_mcache_lookup(mcache, sizeof(mcache), "b",
+							       &mdata, &data_offset));
+}
+
+/*
+ * Number of reads for the mcache when the directory is rejected by its header and every file
+ * header has to be walked. Rejecting it any later only adds reads.
+ */
+static int full_walk_reads(void)
+{
+	struct vb2_hash hash = metadata_hash();
+	int reads;
+
+	mdir_header()->magic = 0;
+	assert_mcache_good(&hash);
+	reads = read_count;
+	mdir_header()->magic = htobe32(CBFS_MDIR_MAGIC);
+
+	return reads;
+}
+
+static void test_mdir_good(void **state)
+{
+	struct vb2_hash hash;
+
+	setup_cbfs(FILE_COUNT);
+	hash = metadata_hash();
+	assert_mcache_good(&hash);
+
+	/* File header, rest of its metadata, directory header, copies and the empty file. */
+	assert_int_equal(5, read_count);
+	assert_true(full_walk_reads() > 5 + FILE_COUNT);
+
+	/* Without verification the directory is used all the same. */
+	assert_mcache_good(NULL);
+	assert_int_equal(5, read_count);
+}
+
+static void test_mdir_partial(void **state)
+{
+	struct vb2_hash hash;
+
+	/* Files behind end_offset are picked up by walking from there. */
+	setup_cbfs(FILE_COUNT - 2);
+	hash = metadata_hash();
+	assert_mcache_good(&hash);
+	assert_int_equal(5 + 2 * 2, read_count);
+}
+
+static void test_mdir_truncated(void **state)
+{
+	struct cbfs_mdir_header *dir;
+	struct vb2_hash hash;
+	int walk_reads;
+
+	setup_cbfs(FILE_COUNT);
+	hash = metadata_hash();
+	walk_reads = full_walk_reads();
+	dir = mdir_header();
+
+	/* Fewer copies than the count says. */
+	dir->size = htobe32((u8 *)mdir_copy(FILE_COUNT - 1) - (u8 *)(dir + 1));
+	assert_mcache_good(&hash);
+	assert_true(read_count >= walk_reads);
+	assert_mcache_good(NULL);
+
+	/* More copies than the count says. */
+	setup_cbfs(FILE_COUNT);
+	dir->count = htobe32(FILE_COUNT - 1);
+	assert_mcache_good(&hash);
+	assert_true(read_count >= walk_reads);
+	assert_mcache_good(NULL);
+
+	/* Copies that run past the directory file. */
+	setup_cbfs(FILE_COUNT);
+	dir->size = htobe32(MDIR_SIZE);
+	assert_mcache_good(&hash);
+	assert_true(read_count >= walk_reads);
+	assert_mcache_good(NULL);
+
+	/* A copy cut off in the middle of its header. */
+	setup_cbfs(FILE_COUNT);
+	dir->size = htobe32((u8 *)mdir_copy(FILE_COUNT - 1) - (u8 *)(dir + 1) + 8);
+	assert_mcache_good(&hash);
+	assert_true(read_count >= walk_reads);
+	assert_mcache_good(NULL);
+}
+
+static void test_mdir_hash_mismatch(void **state)
+{
+	struct vb2_hash hash;
+	int walk_reads;
+
+	setup_cbfs(FILE_COUNT);
+	hash = metadata_hash();
+	walk_reads = full_walk_reads();
+
+	/* A copy that doesn't match its file is caught by the hash, the walk then succeeds. */
+	mdir_copy(2)->filename[0] = 'C';
+	assert_mcache_good(&hash);
+	assert_true(read_count >= walk_reads);
+
+	/* A CBFS that doesn't match the hash fails no matter where the metadata came from. */
+	setup_cbfs(FILE_COUNT);
+	hash.raw[0] ^= 1;
+	assert_int_equal(CB_CBFS_HASH_MISMATCH,
+			 cbfs_mcache_build(&flash_rdev, mcache, sizeof(mcache), &hash));
+}
+
+static void test_mdir_bad_offsets(void **state)
+{
+	struct cbfs_mdir_header *dir;
+	struct vb2_hash hash;
+
+	/* Offsets aren't hashed, so each of these has to be caught by the directory checks. */
+	setup_cbfs(FILE_COUNT);
+	hash = metadata_hash();
+	dir = mdir_header();
+
+	/* Out of flash order. */
+	set_copy_offset(3, file_offsets[1]);
+	assert_mcache_good(&hash);
+	assert_mcache_good(NULL);
+
+	/* Overlapping the previous file. */
+	setup_cbfs(FILE_COUNT);
+	set_copy_offset(3, file_offsets[3] - 0x40);
+	assert_mcache_good(&hash);
+	assert_mcache_good(NULL);
+
+	/* Overlapping the directory. */
+	setup_cbfs(FILE_COUNT);
+	set_copy_offset(0, 0x40);
+	assert_mcache_good(&hash);
+	assert_mcache_good(NULL);
+
+	/* At or beyond end_offset. */
+	setup_cbfs(FILE_COUNT);
+	dir->end_offset = htobe32(file_offsets[FILE_COUNT - 1]);
+	assert_mcache_good(&hash);
+	assert_mcache_good(NULL);
+
+	/* end_offset outside of the CBFS. */
+	setup_cbfs(FILE_COUNT);
+	dir->end_offset = htobe32(FLASH_SIZE + 0x40);
+	assert_mcache_good(&hash);
+	assert_mcache_good(NULL);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_mdir_good),
+		cmocka_unit_test(test_mdir_partial),
+		cmocka_unit_test(test_mdir_truncated),
+		cmocka_unit_test(test_mdir_hash_mismatch),
+		cmocka_unit_test(test_mdir_bad_offsets),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,224 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/sd_mmc_ctrlr.h>
+#include <commonlib/storage.h>
+#include <fmap.h>
+#include <region_file.h>
+#include <string.h>
+#include <tests/test.h>
+
+#include "storage.h"
+
+#define FLASH_SIZE	0x1000
+#define CACHE_ENTRIES	4
+#define TUNING		0x2a
+
+static u8 flash[FLASH_SIZE];
+static struct mem_region_device flash_rdev = MEM_REGION_DEV_RW_INIT(flash, FLASH_SIZE);
+static bool have_region;
+
+static struct sd_mmc_ctrlr ctrlr;
+static struct storage_media media;
+
+int fmap_locate_area_as_rdev_rw(const char *name, struct region_device *area)
+{
+	assert_string_equal(CONFIG_STORAGE_BUS_MODE_CACHE_REGION, name);
+	if (!have_region)
+		return -1;
+	return rdev_chain_full(area, &flash_rdev.rdev);
+}
+
+static int get_tuning(struct sd_mmc_ctrlr *c, uint32_t *tuning)
+{
+	*tuning = TUNING;
+	return 0;
+}
+
+static void set_tuning(struct sd_mmc_ctrlr *c, uint32_t tuning)
+{
+}
+
+/* Pretend that device |id| was fully negotiated in HS200 mode. */
+static void negotiate(uint32_t id)
+{
+	memset(&media, 0, sizeof(media));
+	media.ctrlr = &ctrlr;
+	media.cid[0] = 0x15010038;
+	media.cid[3] = id;
+	media.version = MMC_VERSION_4;
+	media.caps = DRVR_CAP_HS | DRVR_CAP_HS200 | DRVR_CAP_8BIT;
+	ctrlr.bus_width = 8;
+	ctrlr.timing = BUS_TIMING_MMC_HS200;
+	ctrlr.request_hz = 200000000;
+}
+
+static int setup_cache(void **state)
+{
+	memset(flash, 0xff, sizeof(flash));
+	have_region = true;
+
+	memset(&ctrlr, 0, sizeof(ctrlr));
+	ctrlr.caps = DRVR_CAP_HS | DRVR_CAP_HS200 | DRVR_CAP_8BIT;
+	ctrlr.get_tuning = get_tuning;
+	ctrlr.set_tuning = set_tuning;
+	return 0;
+}
+
+static void test_bus_mode_cache_empty(void **state)
+{
+	struct storage_bus_mode mode;
+
+	negotiate(1);
+	assert_int_equal(-1, storage_bus_mode_load(&media, &mode));
+
+	/* Without the FMAP region nothing is saved or loaded. */
+	have_region = false;
+	storage_bus_mode_save(&media);
+	assert_int_equal(-1, storage_bus_mode_load(&media, &mode));
+	have_region = true;
+	assert_int_equal(-1, storage_bus_mode_load(&media, &mode));
+}
+
+static void test_bus_mode_cache_save_restore(void **state)
+{
+	struct storage_bus_mode mode;
+
+	negotiate(1);
+	storage_bus_mode_save(&media);
+
+	/* A later boot finds the same device on the same controller. */
+	negotiate(1);
+	ctrlr.bus_width = 1;
+	ctrlr.timing = BUS_TIMING_LEGACY;
+	ctrlr.request_hz = 400000;
+	assert_int_equal(0, storage_bus_mode_load(&media, &mode));
+
+	assert_memory_equal(media.cid, mode.cid, sizeof(mode.cid));
+	assert_int_equal(ctrlr.caps, mode.ctrlr_caps);
+	assert_int_equal(MMC_VERSION_4, mode.version);
+	assert_int_equal(DRVR_CAP_HS | DRVR_CAP_HS200 | DRVR_CAP_8BIT, mode.caps);
+	assert_int_equal(8, mode.bus_width);
+	assert_int_equal(BUS_TIMING_MMC_HS200, mode.timing);
+	assert_int_equal(200000000, mode.request_hz);
+	assert_int_equal(STORAGE_BUS_MODE_TUNED, mode.flags);
+	assert_int_equal(TUNING, mode.tuning);
+}
+
+static void test_bus_mode_cache_untuned(void **state)
+{
+	struct storage_bus_mode mode;
+
+	/* The tuning result is only kept if the controller can apply it again. */
+	ctrlr.set_tuning = NULL;
+	negotiate(1);
+	storage_bus_mode_save(&media);
+	assert_int_equal(0, storage_bus_mode_load(&media, &mode));
+	assert_int_equal(0, mode.flags);
+
+	/* Nothing to tune outside of HS200. */
+	ctrlr.set_tuning = set_tuning;
+	negotiate(2);
+	ctrlr.timing = BUS_TIMING_MMC_HS;
+	ctrlr.request_hz = 52000000;
+	storage_bus_mode_save(&media);
+	assert_int_equal(0, storage_bus_mode_load(&media, &mode));
+	assert_int_equal(0, mode.flags);
+	assert_int_equal(BUS_TIMING_MMC_HS, mode.timing);
+}
+
+static void test_bus_mode_cache_unchanged(void **state)
+{
+	static u8 saved[FLASH_SIZE];
+
+	negotiate(1);
+	storage_bus_mode_save(&media);
+	memcpy(saved, flash, sizeof(saved));
+
+	/* The same result again is not written to the flash. */
+	negotiate(1);
+	storage_bus_mode_save(&media);
+	assert_memory_equal(saved, flash, sizeof(saved));
+
+	/* A different one is. */
+	negotiate(1);
+	ctrlr.request_hz = 150000000;
+	storage_bus_mode_save(&media);
+	assert_memory_not_equal(saved, flash, sizeof(saved));
+}
+
+static void test_bus_mode_cache_stale(void **state)
+{
+	struct storage_bus_mode mode;
+	struct region_file file;
+	struct region_device data;
+	u8 *entries;
+
+	negotiate(1);
+	storage_bus_mode_save(&media);
+
+	/* A different device needs a full negotiation. */
+	negotiate(2);
+	assert_int_equal(-1, storage_bus_mode_load(&media, &mode));
+
+	/* So does the same device behind a controller with other capabilities. */
+	negotiate(1);
+	ctrlr.caps &= ~DRVR_CAP_HS200;
+	assert_int_equal(-1, storage_bus_mode_load(&media, &mode));
+	ctrlr.caps |= DRVR_CAP_HS200;
+	assert_int_equal(0, storage_bus_mode_load(&media, &mode));
+
+	/* A corrupted cache is ignored as a whole. */
+	assert_int_equal(0, region_file_init(&file, &flash_rdev.rdev));
+	assert_int_equal(0, region_file_data(&file, &data));
+	entries = rdev_mmap_full(&data);
+	entries[8 + offsetof(struct storage_bus_mode, bus_width)] ^= 0x0c;
+	rdev_munmap(&data, entries);
+	assert_int_equal(-1, storage_bus_mode_load(&media, &mode));
+
+	/* The next full negotiation replaces it. */
+	storage_bus_mode_save(&media);
+	assert_int_equal(0, storage_bus_mode_load(&media, &mode));
+	assert_int_equal(8, mode.bus_width);
+}
+
+static void test_bus_mode_cache_lru(void **state)
+{
+	struct storage_bus_mode mode;
+	uint32_t id;
+
+	for (id = 1; id <= CACHE_ENTRIES; id++) {
+		negotiate(id);
+		storage_bus_mode_save(&media);
+	}
+
+	/* Using device 1 again makes device 2 the least recently used one. */
+	negotiate(1);
+	ctrlr.request_hz = 100000000;
+	storage_bus_mode_save(&media);
+
+	negotiate(CACHE_ENTRIES + 1);
+	storage_bus_mode_save(&media);
+
+	for (id = 1; id <= CACHE_ENTRIES + 1; id++) {
+		negotiate(id);
+		assert_int_equal(id == 2 ? -1 : 0, storage_bus_mode_load(&media, &mode));
+	}
+
+	negotiate(1);
+	assert_int_equal(0, storage_bus_mode_load(&media, &mode));
+	assert_int_equal(100000000, mode.request_hz);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_bus_mode_cache_empty, setup_cache),
+		cmocka_unit_test_setup(test_bus_mode_cache_save_restore, setup_cache),
+		cmocka_unit_test_setup(test_bus_mode_cache_untuned, setup_cache),
+		cmocka_unit_test_setup(test_bus_mode_cache_unchanged, setup_cache),
+		cmocka_unit_test_setup(test_bus_mode_cache_stale, setup_cache),
+		cmocka_unit_test_setup(test_bus_mode_cache_lru, setup_cache),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
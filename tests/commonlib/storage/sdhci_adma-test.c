@@ -0,0 +1,151 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <arch/mmio.h>
+#include <commonlib/sd_mmc_ctrlr.h>
+#include <commonlib/sdhci.h>
+#include <commonlib/storage.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tests/test.h>
+
+#include "sdhci.h"
+
+static u8 regs[0x100];
+static struct sdhci_ctrlr sdhci = { .ioaddr = regs };
+static u32 buffer[1024];
+
+void die(const char *fmt, ...)
+{
+	fail_msg("%s", fmt);
+	__builtin_unreachable();
+}
+
+void write32(volatile void *addr, uint32_t value)
+{
+	memcpy((void *)addr, &value, sizeof(value));
+}
+
+static uint32_t reg32(int reg)
+{
+	uint32_t value;
+
+	memcpy(&value, &regs[reg], sizeof(value));
+	return value;
+}
+
+static struct mmc_data read_data(uintptr_t dest, uint32_t blocks)
+{
+	struct mmc_data data = {
+		.dest = (char *)dest,
+		.blocks = blocks,
+		.blocksize = 512,
+		.flags = DATA_FLAG_READ,
+	};
+
+	return data;
+}
+
+static int setup_sdhci(void **state)
+{
+	memset(regs, 0, sizeof(regs));
+	sdhci.sd_mmc_ctrlr.caps = DRVR_CAP_AUTO_CMD12;
+	return 0;
+}
+
+static int teardown_sdhci(void **state)
+{
+	free(sdhci.adma_descs);
+	free(sdhci.adma64_descs);
+	sdhci.adma_descs = NULL;
+	sdhci.adma64_descs = NULL;
+	sdhci.adma_desc_count = 0;
+	return 0;
+}
+
+/* 32-bit ADMA needs 32-bit aligned data below 4 GiB, anything else is read with PIO. */
+static void test_sdhci_can_adma32(void **state)
+{
+	struct mmc_data data;
+
+	data = read_data(0x10000000, 8);
+	assert_true(sdhci_can_adma(&sdhci, &data));
+
+	data = read_data(0x10000002, 8);
+	assert_false(sdhci_can_adma(&sdhci, &data));
+
+	data = read_data(0x100000000ULL, 8);
+	assert_false(sdhci_can_adma(&sdhci, &data));
+
+	/* The whole buffer has to be below 4 GiB, not just its start. */
+	data = read_data(0x100000000ULL - 4 * 512, 4);
+	assert_true(sdhci_can_adma(&sdhci, &data));
+	data = read_data(0x100000000ULL - 4 * 512, 5);
+	assert_false(sdhci_can_adma(&sdhci, &data));
+}
+
+/* ADMA64 reaches any address, but needs 64-bit aligned data. */
+static void test_sdhci_can_adma64(void **state)
+{
+	struct mmc_data data;
+
+	sdhci.sd_mmc_ctrlr.caps |= DRVR_CAP_DMA_64BIT;
+
+	data = read_data(0x100000000ULL, 8);
+	assert_true(sdhci_can_adma(&sdhci, &data));
+
+	data = read_data(0x10000004, 8);
+	assert_false(sdhci_can_adma(&sdhci, &data));
+}
+
+/* Descriptors point straight at the caller's buffer, including the upper address bits. */
+static void test_sdhci_setup_adma64(void **state)
+{
+	const uint64_t dest = 0x123400000ULL;
+	struct mmc_data data = read_data(dest, 300);
+	uintptr_t descs;
+
+	sdhci.sd_mmc_ctrlr.caps |= DRVR_CAP_DMA_64BIT;
+	assert_int_equal(0, sdhci_setup_adma(&sdhci, &data));
+
+	assert_int_equal((uint32_t)dest, sdhci.adma64_descs[0].addr);
+	assert_int_equal(dest >> 32, sdhci.adma64_descs[0].addr_hi);
+	/* A length of 0 stands for 64 KiB. */
+	assert_int_equal(0, sdhci.adma64_descs[0].length);
+	assert_int_equal((uint32_t)(dest + SDHCI_MAX_PER_DESCRIPTOR),
+			 sdhci.adma64_descs[1].addr);
+	assert_int_equal(300 * 512 - 2 * SDHCI_MAX_PER_DESCRIPTOR,
+			 sdhci.adma64_descs[2].length);
+	assert_true(sdhci.adma64_descs[2].attributes & SDHCI_ADMA_END);
+	assert_false(sdhci.adma64_descs[1].attributes & SDHCI_ADMA_END);
+
+	descs = (uintptr_t)sdhci.adma64_descs;
+	assert_int_equal((uint32_t)descs, reg32(SDHCI_ADMA_ADDRESS));
+	assert_int_equal((uint64_t)descs >> 32, reg32(SDHCI_ADMA_ADDRESS_HI));
+}
+
+static void test_sdhci_setup_adma32(void **state)
+{
+	struct mmc_data data = read_data((uintptr_t)buffer, 4);
+
+	assert_int_equal(0, sdhci_setup_adma(&sdhci, &data));
+	assert_int_equal((uint32_t)(uintptr_t)buffer, sdhci.adma_descs[0].addr);
+	assert_int_equal(4 * 512, sdhci.adma_descs[0].length);
+	assert_true(sdhci.adma_descs[0].attributes & SDHCI_ADMA_END);
+	assert_int_equal((uint32_t)(uintptr_t)sdhci.adma_descs, reg32(SDHCI_ADMA_ADDRESS));
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_sdhci_can_adma32, setup_sdhci,
+						teardown_sdhci),
+		cmocka_unit_test_setup_teardown(test_sdhci_can_adma64, setup_sdhci,
+						teardown_sdhci),
+		cmocka_unit_test_setup_teardown(test_sdhci_setup_adma64, setup_sdhci,
+						teardown_sdhci),
+		cmocka_unit_test_setup_teardown(test_sdhci_setup_adma32, setup_sdhci,
+						teardown_sdhci),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/sd_mmc_ctrlr.h>
+#include <commonlib/storage.h>
+#include <string.h>
+#include <tests/test.h>
+
+#include "mmc.h"
+#include "storage.h"
+
+#define BLOCK_SIZE	512
+#define B_MAX		128
+#define MAX_CMDS	32
+
+/* Commands received by the controller, in order. */
+static struct {
+	uint32_t cmdidx;
+	uint32_t cmdarg;
+	uint32_t flags;
+	uint32_t blocks;
+} cmds[MAX_CMDS];
+static size_t num_cmds;
+
+static struct sd_mmc_ctrlr ctrlr;
+static struct storage_media media;
+static u8 buffer[300 * BLOCK_SIZE];
+
+void udelay(unsigned int usecs)
+{
+}
+
+static int send_cmd(struct sd_mmc_ctrlr *c, struct mmc_command *cmd, struct mmc_data *data)
+{
+	assert_true(num_cmds < MAX_CMDS);
+	cmds[num_cmds].cmdidx = cmd->cmdidx;
+	cmds[num_cmds].cmdarg = cmd->cmdarg;
+	cmds[num_cmds].flags = cmd->flags;
+	cmds[num_cmds].blocks = data ? data->blocks : 0;
+	num_cmds++;
+
+	/* The card is always ready for the next transfer. */
+	cmd->response[0] = MMC_STATUS_RDY_FOR_DATA;
+	return 0;
+}
+
+static void check_cmd(size_t i, uint32_t cmdidx, uint32_t cmdarg, uint32_t blocks)
+{
+	assert_true(i < num_cmds);
+	assert_int_equal(cmdidx, cmds[i].cmdidx);
+	assert_int_equal(cmdarg, cmds[i].cmdarg);
+	assert_int_equal(blocks, cmds[i].blocks);
+}
+
+static int setup_storage(void **state)
+{
+	memset(&ctrlr, 0, sizeof(ctrlr));
+	ctrlr.send_cmd = send_cmd;
+	ctrlr.b_max = B_MAX;
+	ctrlr.timing = BUS_TIMING_MMC_HS200;
+	ctrlr.caps = DRVR_CAP_CMD23;
+
+	memset(&media, 0, sizeof(media));
+	media.ctrlr = &ctrlr;
+	media.caps = DRVR_CAP_CMD23;
+	media.high_capacity = 1;
+	media.read_bl_len = BLOCK_SIZE;
+	media.capacity[0] = 1024 * BLOCK_SIZE;
+
+	num_cmds = 0;
+	return 0;
+}
+
+/* Every chunk is announced with CMD23 and read with CMD18, nothing stops it. */
+static void test_storage_read_cmd23(void **state)
+{
+	assert_int_equal(300, storage_block_read(&media, 10, 300, buffer));
+
+	assert_int_equal(7, num_cmds);
+	check_cmd(0, MMC_CMD_SET_BLOCKLEN, BLOCK_SIZE, 0);
+	check_cmd(1, MMC_CMD_SET_BLOCK_COUNT, B_MAX, 0);
+	check_cmd(2, MMC_CMD_READ_MULTIPLE_BLOCK, 10, B_MAX);
+	check_cmd(3, MMC_CMD_SET_BLOCK_COUNT, B_MAX, 0);
+	check_cmd(4, MMC_CMD_READ_MULTIPLE_BLOCK, 10 + B_MAX, B_MAX);
+	check_cmd(5, MMC_CMD_SET_BLOCK_COUNT, 300 - 2 * B_MAX, 0);
+	check_cmd(6, MMC_CMD_READ_MULTIPLE_BLOCK, 10 + 2 * B_MAX, 300 - 2 * B_MAX);
+	assert_int_equal(CMD_FLAG_PREDEFINED_COUNT, cmds[2].flags);
+	assert_int_equal(CMD_FLAG_PREDEFINED_COUNT, cmds[6].flags);
+}
+
+/* Single blocks need neither CMD23 nor CMD12. */
+static void test_storage_read_single(void **state)
+{
+	assert_int_equal(1, storage_block_read(&media, 3, 1, buffer));
+
+	assert_int_equal(2, num_cmds);
+	check_cmd(0, MMC_CMD_SET_BLOCKLEN, BLOCK_SIZE, 0);
+	check_cmd(1, MMC_CMD_READ_SINGLE_BLOCK, 3, 1);
+	assert_int_equal(0, cmds[1].flags);
+}
+
+/* Without CMD23 on both sides the read is stopped with CMD12 as before. */
+static void test_storage_read_no_cmd23(void **state)
+{
+	ctrlr.caps = 0;
+	assert_int_equal(16, storage_block_read(&media, 0, 16, buffer));
+	check_cmd(1, MMC_CMD_READ_MULTIPLE_BLOCK, 0, 16);
+	assert_int_equal(0, cmds[1].flags);
+	check_cmd(2, MMC_CMD_STOP_TRANSMISSION, 0, 0);
+
+	/* A controller with Auto CMD12 stops it itself. */
+	setup_storage(state);
+	ctrlr.caps = DRVR_CAP_AUTO_CMD12;
+	assert_int_equal(16, storage_block_read(&media, 0, 16, buffer));
+	assert_int_equal(2, num_cmds);
+	check_cmd(1, MMC_CMD_READ_MULTIPLE_BLOCK, 0, 16);
+
+	/* The device has to support CMD23 as well. */
+	setup_storage(state);
+	media.caps = 0;
+	assert_int_equal(16, storage_block_read(&media, 0, 16, buffer));
+	check_cmd(1, MMC_CMD_READ_MULTIPLE_BLOCK, 0, 16);
+	check_cmd(2, MMC_CMD_STOP_TRANSMISSION, 0, 0);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_storage_read_cmd23, setup_storage),
+		cmocka_unit_test_setup(test_storage_read_single, setup_storage),
+		cmocka_unit_test_setup(test_storage_read_no_cmd23, setup_storage),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
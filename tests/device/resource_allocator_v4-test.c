@@ -0,0 +1,304 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/helpers.h>
+#include <device/device.h>
+#include <device/resource.h>
+#include <lib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tests/test.h>
+
+/*
+ * Synthetic device tree used to exercise the allocator with a large number of resources:
+ *
+ *   root
+ *    +- domain[d] (I/O and memory windows)
+ *        +- leaf[d][0..NUM_LEAVES-1] (I/O and memory requests, every FIXED_STRIDE one also
+ *        |                            has fixed I/O and memory resources)
+ *        +- bridge[d] (I/O and memory windows)
+ *            +- child[d][0..NUM_CHILDREN-1] (I/O and memory requests)
+ */
+#define NUM_DOMAINS 2
+#define NUM_LEAVES 1024
+#define NUM_CHILDREN 64
+#define FIXED_STRIDE 16
+
+/* Leaf resources: I/O request, memory request, fixed I/O, fixed memory. */
+#define LEAF_RESOURCES 4
+
+#define FIXED_IO_BASE 0x2000
+#define FIXED_IO_STRIDE 0x100
+#define FIXED_IO_SIZE 0x20
+#define FIXED_MEM_STRIDE (16 * MiB)
+#define FIXED_MEM_SIZE (1 * MiB)
+
+#define VGA_IO_BASE 0x3b0
+#define VGA_IO_END 0x3df
+
+struct test_domain {
+	struct device dev;
+	struct bus bus;
+	struct resource res[2];
+	struct device leaves[NUM_LEAVES];
+	struct resource leaf_res[NUM_LEAVES][LEAF_RESOURCES];
+	struct device bridge;
+	struct bus bridge_bus;
+	struct resource bridge_res[2];
+	struct device children[NUM_CHILDREN];
+	struct resource child_res[NUM_CHILDREN][2];
+};
+
+static struct device root;
+static struct bus root_bus;
+static struct test_domain *domains;
+
+/* Used by search_global_resources(), not needed by the allocator. */
+DEVTREE_CONST struct device *DEVTREE_CONST all_devices = &root;
+
+void die(const char *msg, ...)
+{
+	fail_msg("Unexpected call to die()");
+}
+
+/* Memory windows of the domains, below 4G. */
+static const resource_t domain_mem_base[NUM_DOMAINS] = { 0x40000000, 0x80000000 };
+
+static void init_request(struct resource *res, unsigned long index, unsigned long type,
+			 resource_t size, resource_t limit)
+{
+	res->index = index;
+	res->flags = type;
+	res->size = size;
+	res->align = log2(size);
+	res->gran = res->align;
+	res->limit = limit;
+}
+
+static void init_fixed(struct resource *res, unsigned long index, unsigned long type,
+		       resource_t base, resource_t size)
+{
+	res->index = index;
+	res->flags = type | IORESOURCE_FIXED | IORESOURCE_ASSIGNED;
+	res->base = base;
+	res->size = size;
+	res->limit = base + size - 1;
+}
+
+static void link_resources(struct device *dev, struct resource *res, size_t count)
+{
+	size_t i;
+
+	for (i = 0; i + 1 < count; i++)
+		res[i].next = &res[i + 1];
+	dev->resource_list = &res[0];
+}
+
+static void init_leaf(struct device *dev, struct resource *res, unsigned int idx,
+		      struct bus *bus, resource_t mem_base)
+{
+	const unsigned int fixed = idx / FIXED_STRIDE;
+	size_t count = 2;
+
+	dev->path.type = DEVICE_PATH_PCI;
+	dev->path.pci.devfn = idx & 0xff;
+	dev->enabled = 1;
+	dev->bus = bus;
+
+	init_request(&res[0], 0x10, IORESOURCE_IO, 0x10 << (idx % 3), 0xffff);
+	init_request(&res[1], 0x14, IORESOURCE_MEM, 4 * KiB << (idx % 5), 0xffffffff);
+
+	if (idx % FIXED_STRIDE == 0) {
+		init_fixed(&res[2], 0x20, IORESOURCE_IO,
+			   FIXED_IO_BASE + fixed * FIXED_IO_STRIDE, FIXED_IO_SIZE);
+		init_fixed(&res[3], 0x24, IORESOURCE_MEM,
+			   mem_base + fixed * FIXED_MEM_STRIDE, FIXED_MEM_SIZE);
+		count = 4;
+	}
+
+	link_resources(dev, res, count);
+}
+
+static void init_domain(struct test_domain *d, unsigned int domain)
+{
+	struct device **next_sibling;
+	size_t i;
+
+	d->dev.path.type = DEVICE_PATH_DOMAIN;
+	d->dev.path.domain.domain = domain;
+	d->dev.enabled = 1;
+	d->dev.bus = &root_bus;
+	d->dev.link_list = &d->bus;
+	d->bus.dev = &d->dev;
+
+	d->res[0].flags = IORESOURCE_IO | IORESOURCE_ASSIGNED;
+	d->res[0].base = 0;
+	d->res[0].limit = 0xffff;
+	d->res[1].flags = IORESOURCE_MEM | IORESOURCE_ASSIGNED;
+	d->res[1].base = domain_mem_base[domain];
+	d->res[1].limit = domain_mem_base[domain] + 1 * GiB - 1;
+	link_resources(&d->dev, d->res, ARRAY_SIZE(d->res));
+
+	next_sibling = &d->bus.children;
+	for (i = 0; i < NUM_LEAVES; i++) {
+		init_leaf(&d->leaves[i], d->leaf_res[i], i, &d->bus, domain_mem_base[domain]);
+		*next_sibling = &d->leaves[i];
+		next_sibling = &d->leaves[i].sibling;
+	}
+
+	d->bridge.path.type = DEVICE_PATH_PCI;
+	d->bridge.path.pci.devfn = 0xf8;
+	d->bridge.enabled = 1;
+	d->bridge.bus = &d->bus;
+	d->bridge.link_list = &d->bridge_bus;
+	d->bridge_bus.dev = &d->bridge;
+	d->bridge_res[0].index = 0x1c;
+	d->bridge_res[0].flags = IORESOURCE_IO | IORESOURCE_BRIDGE;
+	d->bridge_res[0].align = 12;
+	d->bridge_res[0].gran = 12;
+	d->bridge_res[0].limit = 0xffff;
+	d->bridge_res[1].index = 0x20;
+	d->bridge_res[1].flags = IORESOURCE_MEM | IORESOURCE_BRIDGE;
+	d->bridge_res[1].align = 20;
+	d->bridge_res[1].gran = 20;
+	d->bridge_res[1].limit = 0xffffffff;
+	link_resources(&d->bridge, d->bridge_res, ARRAY_SIZE(d->bridge_res));
+	*next_sibling = &d->bridge;
+
+	next_sibling = &d->bridge_bus.children;
+	for (i = 0; i < NUM_CHILDREN; i++) {
+		struct device *child = &d->children[i];
+
+		child->path.type = DEVICE_PATH_PCI;
+		child->path.pci.devfn = i;
+		child->enabled = 1;
+		child->bus = &d->bridge_bus;
+		init_request(&d->child_res[i][0], 0x10, IORESOURCE_IO, 0x20, 0xffff);
+		init_request(&d->child_res[i][1], 0x14, IORESOURCE_MEM, 64 * KiB, 0xffffffff);
+		link_resources(child, d->child_res[i], ARRAY_SIZE(d->child_res[i]));
+		*next_sibling = child;
+		next_sibling = &child->sibling;
+	}
+}
+
+static int setup_tree(void **state)
+{
+	struct device **next_sibling;
+	size_t i;
+
+	domains = calloc(NUM_DOMAINS, sizeof(*domains));
+	if (domains == NULL)
+		return -1;
+
+	memset(&root, 0, sizeof(root));
+	memset(&root_bus, 0, sizeof(root_bus));
+	root.path.type = DEVICE_PATH_ROOT;
+	root.enabled = 1;
+	root.link_list = &root_bus;
+	root_bus.dev = &root;
+
+	next_sibling = &root_bus.children;
+	for (i = 0; i < NUM_DOMAINS; i++) {
+		init_domain(&domains[i], i);
+		*next_sibling = &domains[i].dev;
+		next_sibling = &domains[i].dev.sibling;
+	}
+
+	return 0;
+}
+
+static int teardown_tree(void **state)
+{
+	free(domains);
+	domains = NULL;
+	return 0;
+}
+
+/* Check that resources of the given type assigned within a domain do not overlap. */
+static void check_no_overlap(struct test_domain *d, unsigned long type)
+{
+	const size_t max = NUM_LEAVES * LEAF_RESOURCES + NUM_CHILDREN;
+	struct resource **list = calloc(max, sizeof(*list));
+	size_t count = 0;
+	size_t i, j;
+
+	assert_non_null(list);
+
+	for (i = 0; i < NUM_LEAVES; i++) {
+		for (j = 0; j < LEAF_RESOURCES; j++) {
+			struct resource *res = &d->leaf_res[i][j];
+
+			if (res->size && (res->flags & IORESOURCE_TYPE_MASK) == type)
+				list[count++] = res;
+		}
+	}
+	/* Children are covered by the bridge window, the window itself is checked. */
+	for (i = 0; i < ARRAY_SIZE(d->bridge_res); i++) {
+		if ((d->bridge_res[i].flags & IORESOURCE_TYPE_MASK) == type)
+			list[count++] = &d->bridge_res[i];
+	}
+
+	for (i = 0; i < count; i++) {
+		for (j = i + 1; j < count; j++) {
+			assert_true(list[i]->base + list[i]->size <= list[j]->base ||
+				    list[j]->base + list[j]->size <= list[i]->base);
+		}
+	}
+
+	free(list);
+}
+
+static void check_assigned(const struct resource *res, resource_t window_base,
+			   resource_t window_limit)
+{
+	assert_true(res->flags & IORESOURCE_ASSIGNED);
+	assert_true(IS_ALIGNED(res->base, POWER_OF_2(res->align)));
+	assert_true(res->base >= window_base);
+	assert_true(res->base + res->size - 1 <= window_limit);
+
+	/* Allocations must avoid the VGA I/O range. */
+	if (res->flags & IORESOURCE_IO)
+		assert_true(res->base > VGA_IO_END || res->base + res->size <= VGA_IO_BASE);
+}
+
+/*
+ * This test runs the allocator over the synthetic tree with thousands of resources and checks
+ * that every request was satisfied within the windows of its domain or bridge, without
+ * overlapping fixed resources or other allocations.
+ */
+static void test_allocate_large_tree(void **state)
+{
+	size_t i, j;
+
+	allocate_resources(&root);
+
+	for (i = 0; i < NUM_DOMAINS; i++) {
+		struct test_domain *d = &domains[i];
+
+		for (j = 0; j < NUM_LEAVES; j++) {
+			check_assigned(&d->leaf_res[j][0], d->res[0].base, d->res[0].limit);
+			check_assigned(&d->leaf_res[j][1], d->res[1].base, d->res[1].limit);
+		}
+
+		check_assigned(&d->bridge_res[0], d->res[0].base, d->res[0].limit);
+		check_assigned(&d->bridge_res[1], d->res[1].base, d->res[1].limit);
+		for (j = 0; j < NUM_CHILDREN; j++) {
+			check_assigned(&d->child_res[j][0], d->bridge_res[0].base,
+				       d->bridge_res[0].limit);
+			check_assigned(&d->child_res[j][1], d->bridge_res[1].base,
+				       d->bridge_res[1].limit);
+		}
+
+		check_no_overlap(d, IORESOURCE_IO);
+		check_no_overlap(d, IORESOURCE_MEM);
+	}
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_allocate_large_tree, setup_tree,
+						teardown_tree),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,421 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <console/console.h>
+#include <spi_flash.h>
+#include <spi-generic.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <tests/test.h>
+#include <timer.h>
+
+#include "spi_flash_internal.h"
+
+/*
+ * In-memory SPI NOR flash behind an emulated controller. Page programs and erases take their
+ * typical time, during which the status register reports write-in-progress. Every transfer on
+ * the bus takes some time as well.
+ */
+#define PAGE_PROGRAM		0x02
+#define SECTOR_ERASE		0x20
+
+#define FLASH_SIZE		(256 * KiB)
+#define PAGE_SIZE		256
+#define SECTOR_SIZE		(4 * KiB)
+#define BLOCK_SIZE		(64 * KiB)
+
+#define PAGE_PROGRAM_US		700
+#define SECTOR_ERASE_US		(45 * USECS_PER_MSEC)
+#define BLOCK_ERASE_US		(150 * USECS_PER_MSEC)
+#define XFER_US			2
+
+static struct {
+	u8 data[FLASH_SIZE];
+	bool selected;
+	bool write_enabled;
+	long busy_until;
+	bool fail;
+
+	/* The command and its data as sent while the chip was selected. */
+	u8 cmd[4 + PAGE_SIZE];
+	size_t cmd_len;
+
+	int page_programs;
+	int sector_erases;
+	int block_erases;
+} chip;
+
+static long now;
+
+void timer_monotonic_get(struct mono_time *mt)
+{
+	mono_time_set_usecs(mt, now);
+}
+
+static u32 cmd_addr(void)
+{
+	return chip.cmd[1] << 16 | chip.cmd[2] << 8 | chip.cmd[3];
+}
+
+static int emu_claim_bus(const struct spi_slave *slave)
+{
+	assert_false(chip.selected);
+	chip.selected = true;
+	chip.cmd_len = 0;
+	return 0;
+}
+
+static void erase(u32 addr, size_t size, long usecs)
+{
+	assert_true(chip.write_enabled);
+	assert_int_equal(0, addr % size);
+	memset(&chip.data[addr], 0xff, size);
+	chip.busy_until = now + usecs;
+}
+
+/* Like on a real chip, programs and erases start when the chip select goes high. */
+static void emu_release_bus(const struct spi_slave *slave)
+{
+	u32 addr = cmd_addr();
+	size_t i;
+
+	assert_true(chip.selected);
+	chip.selected = false;
+
+	switch (chip.cmd[0]) {
+	case CMD_WRITE_ENABLE:
+		chip.write_enabled = true;
+		return;
+	case PAGE_PROGRAM:
+		assert_true(chip.write_enabled);
+		/* The address wraps around within the page. */
+		for (i = 4; i < chip.cmd_len; i++)
+			chip.data[ALIGN_DOWN(addr, PAGE_SIZE) + (addr + i - 4) % PAGE_SIZE] &=
+				chip.cmd[i];
+		chip.busy_until = now + PAGE_PROGRAM_US;
+		chip.page_programs++;
+		break;
+	case SECTOR_ERASE:
+		erase(addr, SECTOR_SIZE, SECTOR_ERASE_US);
+		chip.sector_erases++;
+		break;
+	case CMD_BLOCK_ERASE:
+		erase(addr, BLOCK_SIZE, BLOCK_ERASE_US);
+		chip.block_erases++;
+		break;
+	default:
+		return;
+	}
+	chip.write_enabled = false;
+}
+
+static int emu_xfer(const struct spi_slave *slave, const void *dout, size_t bytesout,
+		    void *din, size_t bytesin)
+{
+	u8 *in = din;
+
+	assert_true(chip.selected);
+	now += XFER_US;
+
+	if (chip.fail)
+		return -1;
+
+	assert_true(chip.cmd_len + bytesout <= sizeof(chip.cmd));
+	memcpy(&chip.cmd[chip.cmd_len], dout, bytesout);
+	chip.cmd_len += bytesout;
+
+	if (!bytesin)
+		return 0;
+
+	switch (chip.cmd[0]) {
+	case CMD_READ_STATUS:
+		assert_int_equal(1, bytesin);
+		in[0] = now < chip.busy_until ? STATUS_WIP : 0;
+		break;
+	case CMD_READ_ARRAY_FAST:
+		/* Reading while busy returns garbage. */
+		assert_true(now >= chip.busy_until);
+		assert_true(cmd_addr() + bytesin <= FLASH_SIZE);
+		memcpy(in, &chip.data[cmd_addr()], bytesin);
+		break;
+	default:
+		fail_msg("Unexpected command %#x", chip.cmd[0]);
+	}
+
+	return 0;
+}
+
+static const struct spi_ctrlr emu_ctrlr = {
+	.claim_bus = emu_claim_bus,
+	.release_bus = emu_release_bus,
+	.xfer = emu_xfer,
+	.max_xfer_size = PAGE_SIZE,
+};
+
+const struct spi_ctrlr_buses spi_ctrlr_bus_map[] = {
+	{ .ctrlr = &emu_ctrlr },
+};
+const size_t spi_ctrlr_bus_map_count = ARRAY_SIZE(spi_ctrlr_bus_map);
+
+static struct spi_flash flash = {
+	.spi = { .ctrlr = &emu_ctrlr },
+	.size = FLASH_SIZE,
+	.sector_size = SECTOR_SIZE,
+	.page_size = PAGE_SIZE,
+	.erase_cmd = SECTOR_ERASE,
+	.status_cmd = CMD_READ_STATUS,
+	.pp_cmd = PAGE_PROGRAM,
+	.wren_cmd = CMD_WRITE_ENABLE,
+	.flags.block_erase = 1,
+	.ops = &spi_flash_pp_0x20_sector_desc.ops,
+};
+
+/* Owners of the batch statistics printed so far. */
+static char reports[64];
+
+int printk(int msg_level, const char *fmt, ...)
+{
+	char line[128];
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	len = vsnprintf(line, sizeof(line), fmt, args);
+	va_end(args);
+
+	if (!strncmp(line, "SF: ", 4) && strstr(line, " writes in ")) {
+		size_t used = strlen(reports);
+
+		*strchr(line + 4, ':') = '\0';
+		snprintf(reports + used, sizeof(reports) - used, "%s ", line + 4);
+	}
+
+	return len;
+}
+
+static u8 buf[4 * PAGE_SIZE];
+
+static int setup_chip(void **state)
+{
+	size_t i;
+
+	memset(&chip, 0, sizeof(chip));
+	memset(chip.data, 0xff, sizeof(chip.data));
+	memset(reports, 0, sizeof(reports));
+	now = 0;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i * 3 + 1;
+
+	return 0;
+}
+
+/* Write 'buf' as a sequence of writes of the given sizes. */
+static void write_pieces(u32 offset, const size_t *sizes, size_t count)
+{
+	size_t i, done = 0;
+
+	for (i = 0; i < count; i++) {
+		assert_int_equal(0, spi_flash_write(&flash, offset + done, sizes[i],
+						    &buf[done]));
+		done += sizes[i];
+	}
+}
+
+static void test_spi_flash_unbatched_writes(void **state)
+{
+	const size_t sizes[] = { 4, 4, 16, 1 };
+
+	write_pieces(0x1000, sizes, ARRAY_SIZE(sizes));
+	assert_int_equal(4, chip.page_programs);
+	assert_memory_equal(buf, &chip.data[0x1000], 25);
+	assert_true(now >= 4 * PAGE_PROGRAM_US);
+}
+
+static void test_spi_flash_batch_combines_writes(void **state)
+{
+	const size_t sizes[] = { 4, 4, 16, 1 };
+
+	spi_flash_batch_begin(&flash, "test");
+	write_pieces(0x1000, sizes, ARRAY_SIZE(sizes));
+
+	/* Nothing was written yet. */
+	assert_int_equal(0, chip.page_programs);
+	assert_int_equal(0xff, chip.data[0x1000]);
+
+	assert_int_equal(0, spi_flash_batch_end(&flash));
+	assert_int_equal(1, chip.page_programs);
+	assert_memory_equal(buf, &chip.data[0x1000], 25);
+	assert_true(now < 2 * PAGE_PROGRAM_US);
+}
+
+static void test_spi_flash_batch_page_boundaries(void **state)
+{
+	const size_t sizes[] = { 8, 20, 3 * PAGE_SIZE, 10 };
+
+	spi_flash_batch_begin(&flash, "test");
+
+	/* The write reaching the end of the first page completes it. */
+	write_pieces(0x2000 + PAGE_SIZE - 20, sizes, 2);
+	assert_int_equal(1, chip.page_programs);
+
+	/* Whole pages are not held back. */
+	write_pieces(0x3000, &sizes[2], 2);
+	assert_int_equal(5, chip.page_programs);
+
+	assert_int_equal(0, spi_flash_batch_end(&flash));
+	assert_int_equal(6, chip.page_programs);
+	assert_memory_equal(buf, &chip.data[0x2000 + PAGE_SIZE - 20], 28);
+	assert_memory_equal(buf, &chip.data[0x3000], 3 * PAGE_SIZE + 10);
+}
+
+static void test_spi_flash_batch_read_and_nesting(void **state)
+{
+	u8 data[8];
+
+	spi_flash_batch_begin(&flash, "outer");
+	spi_flash_batch_begin(&flash, "inner");
+	assert_int_equal(0, spi_flash_write(&flash, 0x4000, 4, buf));
+
+	/* Reads elsewhere don't write the pending data. */
+	assert_int_equal(0, spi_flash_read(&flash, 0x5000, sizeof(data), data));
+	assert_int_equal(0, chip.page_programs);
+
+	/* The inner batch ending doesn't either. */
+	assert_int_equal(0, spi_flash_batch_end(&flash));
+	assert_int_equal(0, chip.page_programs);
+	assert_int_equal(0, spi_flash_write(&flash, 0x4004, 4, &buf[4]));
+
+	/* Reading it does. */
+	assert_int_equal(0, spi_flash_read(&flash, 0x4000, sizeof(data), data));
+	assert_int_equal(1, chip.page_programs);
+	assert_memory_equal(buf, data, sizeof(data));
+
+	assert_int_equal(0, spi_flash_batch_end(&flash));
+	assert_int_equal(1, chip.page_programs);
+
+	/* Both owners reported their statistics. */
+	assert_string_equal("inner outer ", reports);
+}
+
+static void test_spi_flash_batch_erase(void **state)
+{
+	spi_flash_batch_begin(&flash, "test");
+	assert_int_equal(0, spi_flash_write(&flash, 0x6000, 4, buf));
+
+	/* Pending writes go out before the erase. */
+	assert_int_equal(0, spi_flash_erase(&flash, 0x6000, SECTOR_SIZE));
+	assert_int_equal(1, chip.page_programs);
+	assert_int_equal(1, chip.sector_erases);
+	assert_int_equal(0xff, chip.data[0x6000]);
+
+	assert_int_equal(0, spi_flash_batch_end(&flash));
+	assert_int_equal(1, chip.page_programs);
+}
+
+static void test_spi_flash_batch_write_failure(void **state)
+{
+	spi_flash_batch_begin(&flash, "test");
+	assert_int_equal(0, spi_flash_write(&flash, 0x7000, 4, buf));
+
+	chip.fail = true;
+	assert_int_not_equal(0, spi_flash_batch_end(&flash));
+
+	/* The next batch starts without the error. */
+	chip.fail = false;
+	spi_flash_batch_begin(&flash, "test");
+	assert_int_equal(0, spi_flash_batch_end(&flash));
+}
+
+static void test_spi_flash_batch_erase_after_write_failure(void **state)
+{
+	spi_flash_batch_begin(&flash, "test");
+	assert_int_equal(0, spi_flash_write(&flash, 0x7000, 4, buf));
+
+	/* The erase must not go ahead of the write that failed. */
+	chip.fail = true;
+	assert_int_not_equal(0, spi_flash_erase(&flash, 0x7000, SECTOR_SIZE));
+	assert_int_equal(0, chip.sector_erases);
+
+	chip.fail = false;
+	assert_int_not_equal(0, spi_flash_batch_end(&flash));
+}
+
+/* Like controllers that program the flash on their own and don't report its page size. */
+static int controller_write(const struct spi_flash *f, u32 offset, size_t len, const void *b)
+{
+	return flash.ops->write(&flash, offset, len, b);
+}
+
+static const struct spi_flash_ops controller_ops = {
+	.write = controller_write,
+};
+
+static void test_spi_flash_batch_no_page_size(void **state)
+{
+	struct spi_flash controller_flash = {
+		.spi = { .ctrlr = &emu_ctrlr },
+		.size = FLASH_SIZE,
+		.sector_size = SECTOR_SIZE,
+		.ops = &controller_ops,
+	};
+
+	/* Without a page size nothing is batched. */
+	spi_flash_batch_begin(&controller_flash, "test");
+	assert_int_equal(0, spi_flash_write(&controller_flash, 0x8000, 4, buf));
+	assert_int_equal(0, spi_flash_write(&controller_flash, 0x8004, 4, &buf[4]));
+	assert_int_equal(2, chip.page_programs);
+	assert_int_equal(0, spi_flash_batch_end(&controller_flash));
+
+	assert_int_equal(2, chip.page_programs);
+	assert_memory_equal(buf, &chip.data[0x8000], 8);
+}
+
+static void test_spi_flash_block_erase(void **state)
+{
+	memset(chip.data, 0, sizeof(chip.data));
+
+	/* 15 sectors up to the first 64KiB block, the block and one more sector. */
+	assert_int_equal(0, spi_flash_erase(&flash, BLOCK_SIZE - 15 * SECTOR_SIZE,
+					    16 * SECTOR_SIZE + BLOCK_SIZE));
+	assert_int_equal(16, chip.sector_erases);
+	assert_int_equal(1, chip.block_erases);
+	assert_int_equal(0, chip.data[BLOCK_SIZE - 15 * SECTOR_SIZE - 1]);
+	assert_int_equal(0xff, chip.data[BLOCK_SIZE - 15 * SECTOR_SIZE]);
+	assert_int_equal(0xff, chip.data[2 * BLOCK_SIZE + SECTOR_SIZE - 1]);
+	assert_int_equal(0, chip.data[2 * BLOCK_SIZE + SECTOR_SIZE]);
+	assert_true(now < 16 * SECTOR_ERASE_US + 2 * BLOCK_ERASE_US);
+}
+
+static void test_spi_flash_no_block_erase(void **state)
+{
+	memset(chip.data, 0, sizeof(chip.data));
+
+	/* Parts that don't support 0xd8 only get sector erases. */
+	flash.flags.block_erase = 0;
+	assert_int_equal(0, spi_flash_erase(&flash, BLOCK_SIZE, BLOCK_SIZE));
+	flash.flags.block_erase = 1;
+
+	assert_int_equal(BLOCK_SIZE / SECTOR_SIZE, chip.sector_erases);
+	assert_int_equal(0, chip.block_erases);
+	assert_int_equal(0xff, chip.data[BLOCK_SIZE]);
+	assert_int_equal(0xff, chip.data[2 * BLOCK_SIZE - 1]);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_spi_flash_unbatched_writes, setup_chip),
+		cmocka_unit_test_setup(test_spi_flash_batch_combines_writes, setup_chip),
+		cmocka_unit_test_setup(test_spi_flash_batch_page_boundaries, setup_chip),
+		cmocka_unit_test_setup(test_spi_flash_batch_read_and_nesting, setup_chip),
+		cmocka_unit_test_setup(test_spi_flash_batch_erase, setup_chip),
+		cmocka_unit_test_setup(test_spi_flash_batch_write_failure, setup_chip),
+		cmocka_unit_test_setup(test_spi_flash_batch_erase_after_write_failure, setup_chip),
+		cmocka_unit_test_setup(test_spi_flash_batch_no_page_size, setup_chip),
+		cmocka_unit_test_setup(test_spi_flash_block_erase, setup_chip),
+		cmocka_unit_test_setup(test_spi_flash_no_block_erase, setup_chip),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _TESTS_MOCKS_ARCH_MMIO_H_
+#define _TESTS_MOCKS_ARCH_MMIO_H_
+
+#include <stdint.h>
+
+/*
+ * MMIO accesses are calls instead of memory accesses, so that tests can model the registers
+ * of a device. Tests define the functions they need.
+ */
+uint8_t read8(const volatile void *addr);
+uint16_t read16(const volatile void *addr);
+uint32_t read32(const volatile void *addr);
+uint64_t read64(const volatile void *addr);
+void write8(volatile void *addr, uint8_t value);
+void write16(volatile void *addr, uint16_t value);
+void write32(volatile void *addr, uint32_t value);
+void write64(volatile void *addr, uint64_t value);
+
+static inline uint8_t read8p(const uintptr_t addr)
+{
+	return read8((void *)addr);
+}
+
+static inline uint16_t read16p(const uintptr_t addr)
+{
+	return read16((void *)addr);
+}
+
+static inline uint32_t read32p(const uintptr_t addr)
+{
+	return read32((void *)addr);
+}
+
+static inline uint64_t read64p(const uintptr_t addr)
+{
+	return read64((void *)addr);
+}
+
+static inline void write8p(const uintptr_t addr, const uint8_t value)
+{
+	write8((void *)addr, value);
+}
+
+static inline void write16p(const uintptr_t addr, const uint16_t value)
+{
+	write16((void *)addr, value);
+}
+
+static inline void write32p(const uintptr_t addr, const uint32_t value)
+{
+	write32((void *)addr, value);
+}
+
+static inline void write64p(const uintptr_t addr, const uint64_t value)
+{
+	write64((void *)addr, value);
+}
+
+#endif /* _TESTS_MOCKS_ARCH_MMIO_H_ */
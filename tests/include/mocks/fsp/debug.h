@@ -0,0 +1,15 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _TESTS_MOCKS_FSP_DEBUG_H_
+#define _TESTS_MOCKS_FSP_DEBUG_H_
+
+#include <stddef.h>
+
+/*
+ * The real header needs the FSP headers of a platform. Code under test only uses the GPIO
+ * snapshot callbacks.
+ */
+void gpio_snapshot(void);
+size_t gpio_verify_snapshot(void);
+
+#endif /* _TESTS_MOCKS_FSP_DEBUG_H_ */
@@ -0,0 +1,11 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _TESTS_ARCH_ARM64_BARRIER_H_
+#define _TESTS_ARCH_ARM64_BARRIER_H_
+
+/* Barriers are calls, so that tests can check what they order. */
+void dsb(void);
+void isb(void);
+void dmb(void);
+
+#endif /* _TESTS_ARCH_ARM64_BARRIER_H_ */
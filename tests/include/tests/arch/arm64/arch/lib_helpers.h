@@ -0,0 +1,28 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef _TESTS_ARCH_ARM64_LIB_HELPERS_H_
+#define _TESTS_ARCH_ARM64_LIB_HELPERS_H_
+
+#include <stdint.h>
+
+/*
+ * The real header accesses system registers with inline assembly. The accessors are calls
+ * instead, so that tests can model the registers they need. Tests define the functions they
+ * use.
+ */
+#define SCTLR_M		(1 << 0)	/* MMU enable			*/
+#define SCTLR_C		(1 << 2)	/* Data/unified cache enable	*/
+#define SCTLR_I		(1 << 12)	/* Instruction cache enable	*/
+
+uint64_t raw_read_sctlr_el3(void);
+void raw_write_sctlr_el3(uint64_t sctlr);
+uint64_t raw_read_mair_el3(void);
+void raw_write_mair_el3(uint64_t mair);
+uint64_t raw_read_tcr_el3(void);
+void raw_write_tcr_el3(uint64_t tcr);
+void raw_write_ttbr0_el3(uint64_t ttbr0);
+
+void iciallu(void);
+void tlbiall_el3(void);
+
+#endif /* _TESTS_ARCH_ARM64_LIB_HELPERS_H_ */
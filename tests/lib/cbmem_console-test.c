@@ -116,6 +116,32 @@ void test_cbmemc_tx_byte_overflow(void **state)
 	free(check_buffer);
 }
 
+void test_cbmemc_write(void **state)
+{
+	u32 cursor;
+	const uint32_t console_size = current_console->size;
+	const unsigned char data[] = "Bulk write testing string\n";
+	const int data_size = ARRAY_SIZE(data) - 1;
+	int i;
+
+	/* Plain bulk write must match the bytewise path. */
+	cbmemc_write(data, data_size);
+	cursor = current_console->cursor & CURSOR_MASK;
+	assert_int_equal(data_size, cursor);
+	assert_memory_equal(data, current_console->body, data_size);
+
+	/* Fill up to just before the end and write across the wrap point. */
+	for (i = data_size; i < console_size - 5; ++i)
+		cbmemc_tx_byte('x');
+	cbmemc_write(data, data_size);
+
+	cursor = current_console->cursor & CURSOR_MASK;
+	assert_int_equal(data_size - 5, cursor);
+	assert_int_equal(OVERFLOW, current_console->cursor & OVERFLOW);
+	assert_memory_equal(&current_console->body[console_size - 5], data, 5);
+	assert_memory_equal(current_console->body, data + 5, data_size - 5);
+}
+
 int main(void)
 {
 #if ENV_ROMSTAGE_OR_BEFORE
@@ -130,6 +156,8 @@ int main(void)
 						setup_cbmemc, teardown_cbmemc),
 		cmocka_unit_test_setup_teardown(test_cbmemc_tx_byte_overflow,
 						setup_cbmemc, teardown_cbmemc),
+		cmocka_unit_test_setup_teardown(test_cbmemc_write,
+						setup_cbmemc, teardown_cbmemc),
 	};
 
 	return cmocka_run_group_tests_name(test_name, tests, NULL, NULL);
@@ -618,6 +618,237 @@ static void test_memrange_add_resources_filter(void **state)
 	memranges_teardown(&test_memrange);
 }
 
+/* Number of 4KiB pages in the address space used by the randomized tests. */
+#define MODEL_PAGES 64
+/* Tag value meaning "not covered by any entry" in the reference model. */
+#define MODEL_NO_TAG 0
+
+static uint32_t prng_state;
+
+static uint32_t prng_next(void)
+{
+	/* Deterministic xorshift so that failures are reproducible. */
+	prng_state ^= prng_state << 13;
+	prng_state ^= prng_state >> 17;
+	prng_state ^= prng_state << 5;
+	return prng_state;
+}
+
+static size_t count_tree_entries(const struct range_entry *t, const struct range_entry **prev)
+{
+	size_t count;
+
+	if (t == NULL)
+		return 0;
+
+	count = count_tree_entries(t->left, prev);
+	/* In-order traversal of the search tree has to follow the list order. */
+	if (*prev != NULL)
+		assert_ptr_equal((*prev)->next, t);
+	*prev = t;
+	return count + 1 + count_tree_entries(t->right, prev);
+}
+
+/* Check that ranges describe exactly what the model holds: entries are sorted, disjoint,
+   neighbors with the same tag are merged, and the search tree indexes the same entries. */
+static void check_against_model(struct memranges *ranges, const unsigned long *model)
+{
+	const struct range_entry *prev = NULL;
+	struct range_entry *ptr;
+	size_t page = 0;
+	size_t count = 0;
+
+	memranges_each_entry(ptr, ranges) {
+		const size_t first = range_entry_base(ptr) / MEMRANGE_ALIGN;
+		const size_t last = range_entry_end(ptr) / MEMRANGE_ALIGN;
+
+		assert_true(first >= page);
+		assert_true(last <= MODEL_PAGES);
+		assert_true(first < last);
+		if (prev != NULL && range_entry_end(prev) == range_entry_base(ptr))
+			assert_int_not_equal(range_entry_tag(prev), range_entry_tag(ptr));
+
+		for (; page < first; page++)
+			assert_int_equal(model[page], MODEL_NO_TAG);
+		for (; page < last; page++)
+			assert_int_equal(model[page], range_entry_tag(ptr));
+
+		prev = ptr;
+		count++;
+	}
+	for (; page < MODEL_PAGES; page++)
+		assert_int_equal(model[page], MODEL_NO_TAG);
+
+	prev = NULL;
+	assert_int_equal(count_tree_entries(ranges->root, &prev), count);
+}
+
+/* Reference implementation of memranges_steal() on the model. */
+static bool model_steal(unsigned long *model, size_t limit, size_t pages, size_t align_pages,
+			unsigned long tag, size_t *stolen)
+{
+	size_t begin, end, base, i;
+
+	for (begin = 0; begin < MODEL_PAGES; begin = end) {
+		for (end = begin + 1; end < MODEL_PAGES && model[end] == model[begin]; end++)
+			;
+		if (model[begin] != tag)
+			continue;
+
+		base = ALIGN_UP(begin, align_pages);
+		if (base + pages > end)
+			continue;
+		if (base + pages - 1 > limit)
+			break;
+
+		for (i = base; i < base + pages; i++)
+			model[i] = MODEL_NO_TAG;
+		*stolen = base;
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * This test applies a long sequence of random operations both to the memranges and to a
+ * page-granular reference model, and verifies after each step that both describe the same
+ * address space. It covers memranges_insert(), memranges_create_hole(), memranges_steal(),
+ * memranges_update_tag(), memranges_fill_holes_up_to() and memranges_clone().
+ */
+static void test_memrange_random_operations(void **state)
+{
+	unsigned long model[MODEL_PAGES] = { MODEL_NO_TAG };
+	struct range_entry local_entries[8];
+	struct memranges test_memrange, clone_memrange;
+	size_t step, i;
+
+	prng_state = 0x1234567;
+	memranges_init_empty(&test_memrange, &local_entries[0], ARRAY_SIZE(local_entries));
+
+	for (step = 0; step < 5000; step++) {
+		const size_t first = prng_next() % MODEL_PAGES;
+		const size_t pages = 1 + prng_next() % (MODEL_PAGES - first);
+		const unsigned long tag = 1 + prng_next() % 3;
+		/* Unaligned base and size are rounded out to whole pages. */
+		const resource_t offset = prng_next() % MEMRANGE_ALIGN;
+		const resource_t base = first * MEMRANGE_ALIGN + offset;
+		const resource_t size = pages * MEMRANGE_ALIGN - offset;
+
+		switch (prng_next() % 8) {
+		case 0:
+		case 1:
+		case 2:
+			memranges_insert(&test_memrange, base, size, tag);
+			for (i = first; i < first + pages; i++)
+				model[i] = tag;
+			break;
+		case 3:
+		case 4:
+			memranges_create_hole(&test_memrange, base, size);
+			for (i = first; i < first + pages; i++)
+				model[i] = MODEL_NO_TAG;
+			break;
+		case 5: {
+			const size_t align_pages = 1 << (prng_next() % 3);
+			const size_t limit = prng_next() % MODEL_PAGES;
+			resource_t stolen;
+			size_t model_stolen;
+			bool found;
+
+			found = model_steal(model, limit, pages, align_pages, tag, &model_stolen);
+			assert_int_equal(memranges_steal(&test_memrange,
+							 (limit + 1) * MEMRANGE_ALIGN - 1,
+							 pages * MEMRANGE_ALIGN,
+							 12 + __builtin_ctz(align_pages), tag,
+							 &stolen), found);
+			if (found)
+				assert_int_equal(stolen, model_stolen * MEMRANGE_ALIGN);
+			break;
+		}
+		case 6: {
+			const unsigned long new_tag = 1 + prng_next() % 3;
+
+			memranges_update_tag(&test_memrange, tag, new_tag);
+			for (i = 0; i < MODEL_PAGES; i++) {
+				if (model[i] == tag)
+					model[i] = new_tag;
+			}
+			break;
+		}
+		case 7:
+			memranges_fill_holes_up_to(&test_memrange, first * MEMRANGE_ALIGN, tag);
+			for (i = 0; i < MODEL_PAGES && model[i] == MODEL_NO_TAG; i++)
+				;
+			for (; i < first; i++) {
+				if (model[i] == MODEL_NO_TAG)
+					model[i] = tag;
+			}
+			break;
+		}
+
+		check_against_model(&test_memrange, model);
+	}
+
+	/* A clone has to be independent of the original. */
+	memranges_clone(&clone_memrange, &test_memrange);
+	check_against_model(&clone_memrange, model);
+	memranges_create_hole(&test_memrange, 0, MODEL_PAGES * MEMRANGE_ALIGN);
+	assert_true(memranges_is_empty(&test_memrange));
+	check_against_model(&clone_memrange, model);
+
+	memranges_teardown(&clone_memrange);
+	memranges_teardown(&test_memrange);
+}
+
+/*
+ * This test verifies that large numbers of entries, inserted out of order, are kept sorted and
+ * that entries released by memranges_teardown() are reused by subsequent memranges.
+ */
+static void test_memrange_many_entries(void **state)
+{
+	const size_t num_entries = 4096;
+	struct memranges test_memrange;
+	struct range_entry *ptr;
+	struct range_entry *first_entry;
+	resource_t prev_end = 0;
+	size_t count = 0;
+	size_t i;
+
+	memranges_init_empty(&test_memrange, NULL, 0);
+
+	/* Insert every other page in pseudo-random order. Stepping with an odd stride visits
+	   each slot exactly once. */
+	for (i = 0; i < num_entries; i++) {
+		const size_t slot = (i * 2654435761u) % num_entries;
+
+		memranges_insert(&test_memrange, 2 * slot * MEMRANGE_ALIGN, MEMRANGE_ALIGN,
+				 CACHEABLE_TAG);
+	}
+
+	memranges_each_entry(ptr, &test_memrange) {
+		assert_true(range_entry_base(ptr) >= prev_end);
+		assert_int_equal(range_entry_size(ptr), MEMRANGE_ALIGN);
+		prev_end = range_entry_end(ptr);
+		count++;
+	}
+	assert_int_equal(count, num_entries);
+
+	/* Filling the gaps with the same tag merges everything into one entry. */
+	memranges_fill_holes_up_to(&test_memrange, 2 * num_entries * MEMRANGE_ALIGN,
+				   CACHEABLE_TAG);
+	check_range_entries_count_and_alignment(&test_memrange, 1, MEMRANGE_ALIGN);
+
+	/* Released entries go back to the pool and are handed out again. */
+	first_entry = test_memrange.entries;
+	memranges_teardown(&test_memrange);
+	memranges_init_empty(&test_memrange, NULL, 0);
+	memranges_insert(&test_memrange, 0, MEMRANGE_ALIGN, CACHEABLE_TAG);
+	assert_ptr_equal(test_memrange.entries, first_entry);
+
+	memranges_teardown(&test_memrange);
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -629,10 +860,17 @@ int main(void)
 		cmocka_unit_test(test_memrange_add_resources_filter),
 	};
 
+	const struct CMUnitTest property_tests[] = {
+		cmocka_unit_test(test_memrange_random_operations),
+		cmocka_unit_test(test_memrange_many_entries),
+	};
+
 	return cmocka_run_group_tests_name("Boundary on 4GiB",
 						tests, setup_test_1, NULL) +
 		cmocka_run_group_tests_name("Boundaries 1 byte from 4GiB",
 						tests, setup_test_2, NULL) +
 		cmocka_run_group_tests_name("Range over 4GiB boundary",
-						tests, setup_test_3, NULL);
+						tests, setup_test_3, NULL) +
+		cmocka_run_group_tests_name("Random operations",
+						property_tests, NULL, NULL);
 }
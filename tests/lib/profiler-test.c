@@ -0,0 +1,163 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include "../lib/profiler.c"
+
+#include <tests/test.h>
+
+#define SAMPLES CONFIG_RAMSTAGE_PROFILER_SAMPLES
+
+TEST_REGION_UNALLOCATED(program, 0x10000000, 0x40000);
+
+static u8 cbmem_buffer[sizeof(struct ramstage_profile) + SAMPLES * sizeof(uint64_t)];
+static bool have_cbmem;
+static int init_result;
+static int num_arms, num_disarms;
+
+void *cbmem_add(u32 id, u64 size)
+{
+	assert_int_equal(CBMEM_ID_PROFILE, id);
+	assert_int_equal(sizeof(cbmem_buffer), size);
+	return have_cbmem ? cbmem_buffer : NULL;
+}
+
+int arch_profiler_init(unsigned int hz)
+{
+	assert_int_equal(CONFIG_RAMSTAGE_PROFILER_HZ, hz);
+	return init_result;
+}
+
+void arch_profiler_arm(void)
+{
+	/* Arming twice would lose track of the pending tick. */
+	assert_int_equal(num_arms, num_disarms);
+	num_arms++;
+}
+
+void arch_profiler_disarm(void)
+{
+	num_disarms++;
+	assert_int_equal(num_arms, num_disarms);
+}
+
+static int setup_profiler(void **state)
+{
+	profile = NULL;
+	pause_depth = 0;
+	running = 0;
+
+	memset(cbmem_buffer, 0xff, sizeof(cbmem_buffer));
+	have_cbmem = true;
+	init_result = 0;
+	num_arms = 0;
+	num_disarms = 0;
+	return 0;
+}
+
+static void test_profiler_start_stop(void **state)
+{
+	profiler_start(NULL);
+	assert_non_null(profile);
+	assert_int_equal(SAMPLES, profile->max_samples);
+	assert_int_equal(0, profile->num_samples);
+	assert_int_equal(CONFIG_RAMSTAGE_PROFILER_HZ, profile->frequency);
+	assert_int_equal((uintptr_t)_program, profile->program_base);
+	assert_int_equal(1, num_arms);
+
+	profiler_stop(NULL);
+	assert_int_equal(1, num_disarms);
+
+	/* Both the payload and the OS resume path stop it, only the first one counts. */
+	profiler_stop(NULL);
+	assert_int_equal(1, num_disarms);
+}
+
+/* Once the buffer is full the oldest samples are overwritten, num_samples keeps counting. */
+static void test_profiler_ring_wrap(void **state)
+{
+	uint32_t i;
+
+	/* Nowhere to record to yet. */
+	profiler_record(0x1234);
+
+	profiler_start(NULL);
+	for (i = 0; i < SAMPLES + 3; i++)
+		profiler_record(0x10000000 + i);
+
+	assert_int_equal(SAMPLES + 3, profile->num_samples);
+	for (i = 0; i < SAMPLES; i++) {
+		const uint32_t sample = i < 3 ? SAMPLES + i : i;
+
+		assert_int_equal(0x10000000 + sample, profile->samples[i]);
+	}
+}
+
+static void test_profiler_nested_pause(void **state)
+{
+	profiler_start(NULL);
+
+	profiler_pause();
+	assert_int_equal(1, num_disarms);
+	profiler_pause();
+	profiler_resume();
+	assert_int_equal(1, num_arms);
+	assert_int_equal(1, num_disarms);
+
+	/* Sampling only resumes when the outermost pause ends. */
+	profiler_resume();
+	assert_int_equal(2, num_arms);
+
+	profiler_pause();
+	profiler_resume();
+	assert_int_equal(3, num_arms);
+	assert_int_equal(2, num_disarms);
+}
+
+/* A profiler that is stopped while paused isn't disarmed twice or armed again. */
+static void test_profiler_stop_paused(void **state)
+{
+	profiler_start(NULL);
+	profiler_pause();
+	profiler_stop(NULL);
+	assert_int_equal(1, num_disarms);
+
+	profiler_resume();
+	profiler_pause();
+	profiler_resume();
+	assert_int_equal(1, num_arms);
+	assert_int_equal(1, num_disarms);
+}
+
+/* Without CBMEM or a timer nothing is sampled and pausing is a no-op. */
+static void test_profiler_unavailable(void **state)
+{
+	have_cbmem = false;
+	profiler_start(NULL);
+	assert_null(profile);
+	profiler_record(0x1234);
+
+	setup_profiler(state);
+	init_result = -1;
+	profiler_start(NULL);
+
+	profiler_pause();
+	profiler_resume();
+	profiler_stop(NULL);
+	assert_int_equal(0, num_arms);
+	assert_int_equal(0, num_disarms);
+}
+
+/* main was renamed for <bootstate.h> by profiler-test-cflags. */
+#undef main
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_profiler_start_stop, setup_profiler),
+		cmocka_unit_test_setup(test_profiler_ring_wrap, setup_profiler),
+		cmocka_unit_test_setup(test_profiler_nested_pause, setup_profiler),
+		cmocka_unit_test_setup(test_profiler_stop_paused, setup_profiler),
+		cmocka_unit_test_setup(test_profiler_unavailable, setup_profiler),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
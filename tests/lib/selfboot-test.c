@@ -0,0 +1,272 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootmem.h>
+#include <cbfs.h>
+#include <cbmem.h>
+#include <commonlib/bsd/compression.h>
+#include <commonlib/endian.h>
+#include <cpu/x86/mp.h>
+#include <lib.h>
+#include <program_loading.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tests/test.h>
+#include <timer.h>
+
+/*
+ * Payload segments are loaded into host buffers. The decompressors copy their input and
+ * remember which scratchpad they got. mp_run_on_aps() either runs the worker on every AP
+ * before returning, or times out and keeps the callback for a late start.
+ */
+#define NUM_APS		3
+#define SEGMENT_SIZE	256
+#define MAX_SEGMENTS	4
+
+enum ap_mode {
+	APS_RUN,
+	APS_TIMEOUT,
+};
+
+static struct {
+	enum ap_mode ap_mode;
+	int ap_calls;
+	void (*late_func)(void *);
+	void *late_arg;
+
+	bool fail_malloc;
+	int lzma_static;
+	int lzma_scratchpad;
+	int loaded_segments;
+} env;
+
+static uint8_t payload[sizeof(struct cbfs_payload_segment) * (MAX_SEGMENTS + 1) +
+		       MAX_SEGMENTS * SEGMENT_SIZE];
+static uint8_t dest[MAX_SEGMENTS * SEGMENT_SIZE * 2];
+
+#define SLOT(i)		(dest + (i) * SEGMENT_SIZE * 2)
+
+/* Linked with --wrap=malloc, so that only the test's objects get this malloc(). */
+void *__real_malloc(size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+	if (env.fail_malloc)
+		return NULL;
+	return __real_malloc(size);
+}
+
+void timer_monotonic_get(struct mono_time *mt)
+{
+	mono_time_set_usecs(mt, 0);
+}
+
+int mp_run_on_aps(void (*func)(void *), void *arg, int logical_cpu_num, long expire_us)
+{
+	int i;
+
+	env.ap_calls++;
+
+	if (env.ap_mode == APS_TIMEOUT) {
+		env.late_func = func;
+		env.late_arg = arg;
+		return -1;
+	}
+
+	for (i = 0; i < NUM_APS; i++)
+		func(arg);
+
+	return 0;
+}
+
+size_t ulzman_scratchpad(const void *src, size_t srcn, void *dst, size_t dstn,
+			 void *scratchpad)
+{
+	assert_non_null(scratchpad);
+	env.lzma_scratchpad++;
+	memcpy(dst, src, MIN(srcn, dstn));
+	return MIN(srcn, dstn);
+}
+
+size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
+{
+	env.lzma_static++;
+	memcpy(dst, src, MIN(srcn, dstn));
+	return MIN(srcn, dstn);
+}
+
+size_t ulz4fn(const void *src, size_t srcn, void *dst, size_t dstn)
+{
+	memcpy(dst, src, MIN(srcn, dstn));
+	return MIN(srcn, dstn);
+}
+
+void prog_segment_loaded(uintptr_t start, size_t size, int flags)
+{
+	env.loaded_segments++;
+}
+
+void *cbmem_find(u32 id)
+{
+	return NULL;
+}
+
+int prog_locate_hook(struct prog *prog)
+{
+	return 0;
+}
+
+void *_cbfs_alloc(const char *name, cbfs_allocator_t allocator, void *arg,
+		  size_t *size_out, bool force_ro, enum cbfs_type *type)
+{
+	return NULL;
+}
+
+void cbfs_unmap(void *mapping)
+{
+}
+
+int bootmem_region_targets_type(uint64_t start, uint64_t size, enum bootmem_type dest_type)
+{
+	return 1;
+}
+
+void bootmem_dump_ranges(void)
+{
+}
+
+/* Builds a payload of num LZMA segments, segment i filled with i + 1 and loaded at to[i]. */
+static void build_payload(uint8_t *to[], size_t num)
+{
+	struct cbfs_payload_segment *seg = (struct cbfs_payload_segment *)payload;
+	uint32_t data = sizeof(*seg) * (num + 1);
+	size_t i;
+
+	for (i = 0; i < num; i++, seg++) {
+		write_be32(&seg->type, PAYLOAD_SEGMENT_DATA);
+		write_be32(&seg->compression, CBFS_COMPRESS_LZMA);
+		write_be32(&seg->offset, data);
+		write_be64(&seg->load_addr, (uintptr_t)to[i]);
+		write_be32(&seg->len, SEGMENT_SIZE);
+		write_be32(&seg->mem_len, SEGMENT_SIZE * 2);
+		memset(payload + data, i + 1, SEGMENT_SIZE);
+		data += SEGMENT_SIZE;
+	}
+
+	write_be32(&seg->type, PAYLOAD_SEGMENT_ENTRY);
+	write_be64(&seg->load_addr, 0x1000);
+}
+
+static void load_payload(uint8_t *to[], size_t num)
+{
+	struct prog prog = PROG_INIT(PROG_PAYLOAD, CONFIG_CBFS_PREFIX "/payload");
+
+	build_payload(to, num);
+	memset(dest, 0xff, sizeof(dest));
+	assert_true(selfload_mapped(&prog, payload, BM_MEM_RAM));
+	assert_ptr_equal(prog_entry(&prog), (void *)0x1000);
+}
+
+static void check_segment(const uint8_t *to, uint8_t value)
+{
+	size_t i;
+
+	for (i = 0; i < SEGMENT_SIZE; i++)
+		assert_int_equal(to[i], value);
+	for (; i < SEGMENT_SIZE * 2; i++)
+		assert_int_equal(to[i], 0);
+}
+
+static int setup_env(void **state)
+{
+	memset(&env, 0, sizeof(env));
+	return 0;
+}
+
+/* Must run first: the scratchpads are only allocated once. */
+static void test_no_scratchpads(void **state)
+{
+	uint8_t *to[] = { SLOT(0), SLOT(1), SLOT(2) };
+
+	env.fail_malloc = true;
+	load_payload(to, ARRAY_SIZE(to));
+
+	/* Without scratchpads the BSP loads everything on its own. */
+	assert_int_equal(env.ap_calls, 0);
+	assert_int_equal(env.lzma_static, 3);
+	assert_int_equal(env.lzma_scratchpad, 0);
+	assert_int_equal(env.loaded_segments, 3);
+	check_segment(SLOT(0), 1);
+	check_segment(SLOT(1), 2);
+	check_segment(SLOT(2), 3);
+}
+
+static void test_parallel_load(void **state)
+{
+	uint8_t *to[] = { SLOT(0), SLOT(1), SLOT(2), SLOT(3) };
+
+	load_payload(to, ARRAY_SIZE(to));
+
+	assert_int_equal(env.ap_calls, 1);
+	assert_int_equal(env.lzma_static, 0);
+	assert_int_equal(env.lzma_scratchpad, 4);
+	assert_int_equal(env.loaded_segments, 4);
+	check_segment(SLOT(0), 1);
+	check_segment(SLOT(1), 2);
+	check_segment(SLOT(2), 3);
+	check_segment(SLOT(3), 4);
+}
+
+/* A segment overlapping a queued one is only loaded once the queue has been flushed. */
+static void test_overlap_flushes_queue(void **state)
+{
+	uint8_t *to[] = { SLOT(0), SLOT(2), SLOT(0) + SEGMENT_SIZE };
+	size_t i;
+
+	load_payload(to, ARRAY_SIZE(to));
+
+	assert_int_equal(env.ap_calls, 2);
+	assert_int_equal(env.loaded_segments, 3);
+	for (i = 0; i < SEGMENT_SIZE; i++)
+		assert_int_equal(SLOT(0)[i], 1);
+	check_segment(SLOT(0) + SEGMENT_SIZE, 3);
+	check_segment(SLOT(2), 2);
+}
+
+static void test_late_ap_is_ignored(void **state)
+{
+	uint8_t *to[] = { SLOT(0), SLOT(1) };
+
+	env.ap_mode = APS_TIMEOUT;
+	load_payload(to, ARRAY_SIZE(to));
+
+	assert_int_equal(env.lzma_scratchpad, 2);
+	check_segment(SLOT(0), 1);
+	check_segment(SLOT(1), 2);
+
+	/* The AP that missed the deadline must not touch the finished queue. */
+	memset(dest, 0xff, sizeof(dest));
+	env.late_func(env.late_arg);
+	assert_int_equal(env.lzma_scratchpad, 2);
+	assert_int_equal(*SLOT(0), 0xff);
+
+	/* Nor the queue of the next payload. */
+	env.ap_mode = APS_RUN;
+	load_payload(to, ARRAY_SIZE(to));
+	env.late_func(env.late_arg);
+	assert_int_equal(env.lzma_scratchpad, 4);
+	assert_int_equal(env.loaded_segments, 4);
+	check_segment(SLOT(0), 1);
+	check_segment(SLOT(1), 2);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_no_scratchpads, setup_env),
+		cmocka_unit_test_setup(test_parallel_load, setup_env),
+		cmocka_unit_test_setup(test_overlap_flushes_queue, setup_env),
+		cmocka_unit_test_setup(test_late_ap_is_ignored, setup_env),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,261 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <bootstate.h>
+#include <cbmem.h>
+#include <delay.h>
+#include <string.h>
+#include <tests/test.h>
+#include <thread.h>
+#include <timer.h>
+#include <ucontext.h>
+
+/*
+ * Threads run on host contexts. Like in coreboot, all stacks, including the one the tests run
+ * on, are aligned to CONFIG_STACK_SIZE with struct cpu_info at the top, so that cpu_info()
+ * finds the current thread.
+ */
+static u8 thread_stacks[CONFIG_NUM_THREADS * CONFIG_STACK_SIZE] __aligned(CONFIG_STACK_SIZE);
+static u8 cbmem_stacks[(CONFIG_NUM_CBMEM_THREADS + 1) * CONFIG_STACK_SIZE];
+static u8 main_stack[CONFIG_STACK_SIZE] __aligned(CONFIG_STACK_SIZE);
+
+/* Threads that are busy at most at the same time, the idle thread takes one. */
+#define NUM_WORKERS (CONFIG_NUM_THREADS - 1 + CONFIG_NUM_CBMEM_THREADS)
+#define MAX_WORK (NUM_WORKERS + CONFIG_THREAD_QUEUE_SIZE)
+
+struct thread_context {
+	ucontext_t uc;
+	asmlinkage void (*entry)(void *);
+	void *arg;
+};
+
+static ucontext_t *switching_to;
+
+static long now;
+static int cbmem_adds;
+static int blocked;
+
+struct work {
+	struct thread_handle handle;
+	long usecs;
+	bool started;
+	bool done;
+	long start_time;
+};
+
+static struct work work[MAX_WORK + 1];
+
+void *arch_get_thread_stackbase(void)
+{
+	return thread_stacks;
+}
+
+static void thread_start(void)
+{
+	struct thread_context *ctx = (struct thread_context *)switching_to;
+
+	ctx->entry(ctx->arg);
+	fail_msg("Thread entry returned");
+}
+
+void arch_prepare_thread(struct thread *t, asmlinkage void (*thread_entry)(void *), void *arg)
+{
+	uintptr_t stack_base = t->stack_orig + sizeof(struct cpu_info) - CONFIG_STACK_SIZE;
+	struct thread_context *ctx;
+
+	t->stack_current = ALIGN_DOWN(t->stack_current - sizeof(*ctx), 16);
+	ctx = (void *)t->stack_current;
+	ctx->entry = thread_entry;
+	ctx->arg = arg;
+
+	getcontext(&ctx->uc);
+	ctx->uc.uc_stack.ss_sp = (void *)stack_base;
+	ctx->uc.uc_stack.ss_size = t->stack_current - stack_base;
+	ctx->uc.uc_link = NULL;
+	makecontext(&ctx->uc, thread_start, 0);
+}
+
+asmlinkage void switch_to_thread(uintptr_t new_stack, uintptr_t *saved_stack)
+{
+	ucontext_t self;
+
+	*saved_stack = (uintptr_t)&self;
+	switching_to = (ucontext_t *)new_stack;
+	swapcontext(&self, switching_to);
+}
+
+void *cbmem_add(u32 id, u64 size)
+{
+	assert_int_equal(CBMEM_ID_THREAD_STACKS, id);
+	assert_true(size <= sizeof(cbmem_stacks));
+	cbmem_adds++;
+
+	return cbmem_stacks;
+}
+
+void timer_monotonic_get(struct mono_time *mt)
+{
+	mono_time_set_usecs(mt, now);
+}
+
+/* Only the idle thread delays, it can't yield. */
+void udelay(unsigned int usecs)
+{
+	now += usecs;
+}
+
+int boot_state_block(boot_state_t state, boot_state_sequence_t seq)
+{
+	assert_int_equal(BS_DEV_INIT, state);
+	assert_int_equal(BS_ON_EXIT, seq);
+	blocked++;
+
+	return 0;
+}
+
+int boot_state_unblock(boot_state_t state, boot_state_sequence_t seq)
+{
+	assert_int_equal(BS_DEV_INIT, state);
+	assert_int_equal(BS_ON_EXIT, seq);
+	assert_true(blocked > 0);
+	blocked--;
+
+	return 0;
+}
+
+void die(const char *msg, ...)
+{
+	fail_msg("Unexpected call to die(): %s", msg);
+}
+
+static enum cb_err worker(void *arg)
+{
+	struct work *w = arg;
+
+	w->started = true;
+	w->start_time = now;
+	assert_int_equal(0, thread_yield_microseconds(w->usecs));
+	w->done = true;
+
+	return CB_SUCCESS;
+}
+
+static int setup_work(void **state)
+{
+	memset(work, 0, sizeof(work));
+	return 0;
+}
+
+static int run(struct work *w, long usecs)
+{
+	w->usecs = usecs;
+	return thread_run(&w->handle, worker, w);
+}
+
+static void join_all(int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		assert_int_equal(CB_SUCCESS, thread_join(&work[i].handle));
+		assert_true(work[i].done);
+	}
+}
+
+static void test_thread_run_join(void **state)
+{
+	long start = now;
+
+	assert_int_equal(0, run(&work[0], 100));
+
+	/* The thread runs right away, until it yields. */
+	assert_true(work[0].started);
+	assert_false(work[0].done);
+	assert_int_equal(THREAD_STARTED, work[0].handle.state);
+
+	join_all(1);
+	assert_int_equal(THREAD_DONE, work[0].handle.state);
+	assert_true(now - start >= 100);
+}
+
+static void test_thread_queue(void **state)
+{
+	long start = now;
+	int i;
+
+	for (i = 0; i < NUM_WORKERS; i++) {
+		assert_int_equal(0, run(&work[i], 1000));
+		assert_true(work[i].started);
+	}
+	/* The stacks beyond CONFIG_NUM_THREADS come from CBMEM. */
+	assert_int_equal(1, cbmem_adds);
+
+	for (; i < MAX_WORK; i++) {
+		assert_int_equal(0, run(&work[i], 1000));
+		assert_false(work[i].started);
+		assert_int_equal(THREAD_QUEUED, work[i].handle.state);
+	}
+
+	/* The queue is full. */
+	assert_int_not_equal(0, run(&work[i], 1000));
+
+	join_all(MAX_WORK);
+	for (i = NUM_WORKERS; i < MAX_WORK; i++)
+		assert_true(work[i].start_time >= start + 1000);
+
+	/* The CBMEM stacks are allocated only once. */
+	assert_int_equal(1, cbmem_adds);
+}
+
+static void test_thread_run_until_queued(void **state)
+{
+	int i;
+
+	for (i = 0; i < NUM_WORKERS; i++)
+		assert_int_equal(0, run(&work[i], 500));
+
+	work[i].usecs = 500;
+	assert_int_equal(0, thread_run_until(&work[i].handle, worker, &work[i], BS_DEV_INIT,
+					     BS_ON_EXIT));
+
+	/* The boot state is blocked while the thread is still queued. */
+	assert_false(work[i].started);
+	assert_int_equal(1, blocked);
+
+	join_all(NUM_WORKERS + 1);
+	assert_int_equal(0, blocked);
+}
+
+static int setup_threads(void **state)
+{
+	threads_initialize();
+	return 0;
+}
+
+static ucontext_t main_ctx, test_ctx;
+static int result;
+
+static void run_tests(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_thread_run_join, setup_work),
+		cmocka_unit_test_setup(test_thread_queue, setup_work),
+		cmocka_unit_test_setup(test_thread_run_until_queued, setup_work),
+	};
+
+	result = cmocka_run_group_tests(tests, setup_threads, NULL);
+}
+
+/* main was renamed for <bootstate.h> by thread-test-cflags. */
+#undef main
+
+int main(void)
+{
+	getcontext(&test_ctx);
+	test_ctx.uc_stack.ss_sp = main_stack;
+	test_ctx.uc_stack.ss_size = sizeof(main_stack) - sizeof(struct cpu_info);
+	test_ctx.uc_link = &main_ctx;
+	makecontext(&test_ctx, run_tests, 0);
+	swapcontext(&main_ctx, &test_ctx);
+
+	return result;
+}
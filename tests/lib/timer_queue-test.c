@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <tests/test.h>
+#include <timer.h>
+
+/* Must match MAX_TIMER_QUEUE_ENTRIES in timer_queue.c */
+#define MAX_ENTRIES 64
+
+static long now;
+static struct timeout_callback *fired[MAX_ENTRIES];
+static int num_fired;
+
+void timer_monotonic_get(struct mono_time *mt)
+{
+	mono_time_set_usecs(mt, now);
+}
+
+static void callback(struct timeout_callback *tocb)
+{
+	assert_true(num_fired < MAX_ENTRIES);
+	fired[num_fired++] = tocb;
+}
+
+/* Run all expired callbacks until the queue is empty. */
+static void drain(void)
+{
+	while (1) {
+		long usecs = timers_usecs_to_next();
+
+		if (usecs < 0)
+			break;
+		now += usecs;
+		timers_run();
+	}
+}
+
+static int setup_timers(void **state)
+{
+	now = 0;
+	num_fired = 0;
+	return 0;
+}
+
+static void test_timers_empty(void **state)
+{
+	assert_true(timers_usecs_to_next() < 0);
+	assert_int_equal(0, timers_run());
+	assert_int_equal(0, num_fired);
+}
+
+static void test_timers_order(void **state)
+{
+	const unsigned long delays[] = { 300, 100, 500, 200, 400, 100 };
+	struct timeout_callback tocbs[ARRAY_SIZE(delays)];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(delays); i++) {
+		tocbs[i].callback = callback;
+		assert_int_equal(0, timer_sched_callback(&tocbs[i], delays[i]));
+	}
+
+	assert_int_equal(100, timers_usecs_to_next());
+	now = 50;
+	assert_int_equal(50, timers_usecs_to_next());
+
+	/* Nothing has expired yet. */
+	assert_int_equal(1, timers_run());
+	assert_int_equal(0, num_fired);
+
+	now = 150;
+	assert_int_equal(0, timers_usecs_to_next());
+	assert_int_equal(1, timers_run());
+	assert_int_equal(1, timers_run());
+	assert_int_equal(2, num_fired);
+	assert_int_equal(50, timers_usecs_to_next());
+
+	drain();
+	assert_int_equal(ARRAY_SIZE(delays), num_fired);
+	assert_int_equal(500, now);
+	for (i = 1; i < num_fired; i++)
+		assert_true(mono_time_cmp(&fired[i - 1]->expiration, &fired[i]->expiration) <= 0);
+}
+
+static void test_timers_full(void **state)
+{
+	struct timeout_callback tocbs[MAX_ENTRIES + 1];
+	int i;
+
+	for (i = 0; i < MAX_ENTRIES; i++) {
+		tocbs[i].callback = callback;
+		assert_int_equal(0, timer_sched_callback(&tocbs[i], MAX_ENTRIES - i));
+	}
+	tocbs[i].callback = callback;
+	assert_int_not_equal(0, timer_sched_callback(&tocbs[i], 1));
+
+	assert_int_equal(1, timers_usecs_to_next());
+	drain();
+	assert_int_equal(MAX_ENTRIES, num_fired);
+	assert_ptr_equal(&tocbs[MAX_ENTRIES - 1], fired[0]);
+	assert_ptr_equal(&tocbs[0], fired[MAX_ENTRIES - 1]);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_timers_empty, setup_timers),
+		cmocka_unit_test_setup(test_timers_order, setup_timers),
+		cmocka_unit_test_setup(test_timers_full, setup_timers),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <console/console.h>
+#include <security/tpm/tspi.h>
+#include <security/tpm/tss.h>
+#include <string.h>
+#include <tests/test.h>
+
+#define MAX_EXTENDS (TPM_EXTEND_QUEUE_SIZE * 4)
+
+/* PCR extends and TCPA log entries in the order they were received. */
+static struct {
+	int pcr;
+	uint8_t digest0;
+} extends[MAX_EXTENDS], log_entries[MAX_EXTENDS];
+static size_t num_extends, num_log_entries;
+static uint32_t extend_result;
+
+void post_code(uint8_t value)
+{
+}
+
+void die(const char *msg, ...)
+{
+	fail_msg("Unexpected call to die()");
+}
+
+uint32_t tlcl_lib_init(void)
+{
+	return TPM_SUCCESS;
+}
+
+uint32_t tlcl_extend(int pcr_num, const uint8_t *in_digest, uint8_t *out_digest)
+{
+	if (extend_result != TPM_SUCCESS)
+		return extend_result;
+
+	assert_true(num_extends < MAX_EXTENDS);
+	extends[num_extends].pcr = pcr_num;
+	extends[num_extends].digest0 = in_digest[0];
+	num_extends++;
+
+	return TPM_SUCCESS;
+}
+
+void tcpa_log_add_table_entry(const char *name, const uint32_t pcr,
+			      enum vb2_hash_algorithm digest_algo, const uint8_t *digest,
+			      const size_t digest_len)
+{
+	assert_true(num_log_entries < MAX_EXTENDS);
+	log_entries[num_log_entries].pcr = pcr;
+	log_entries[num_log_entries].digest0 = digest[0];
+	num_log_entries++;
+}
+
+static int setup_queue(void **state)
+{
+	/* Drop whatever a failed test left in the queue. */
+	extend_result = TPM_SUCCESS;
+	if (tpm_extend_queue_flush() != TPM_SUCCESS)
+		return -1;
+
+	num_extends = 0;
+	num_log_entries = 0;
+
+	return 0;
+}
+
+static uint32_t add(int pcr, uint8_t tag)
+{
+	uint8_t digest[VB2_SHA256_DIGEST_SIZE];
+
+	memset(digest, tag, sizeof(digest));
+	return tpm_extend_queue_add(pcr, VB2_HASH_SHA256, digest, sizeof(digest), "test");
+}
+
+static void check_extend(size_t index, int pcr, uint8_t tag)
+{
+	assert_int_equal(pcr, extends[index].pcr);
+	assert_int_equal(tag, extends[index].digest0);
+}
+
+/* Entries are logged right away but only sent to the TPM in order when flushed. */
+static void test_extend_queue_flush(void **state)
+{
+	size_t i;
+
+	for (i = 0; i < 5; i++)
+		assert_int_equal(TPM_SUCCESS, add(i % 2, i));
+
+	assert_int_equal(5, num_log_entries);
+	assert_int_equal(0, num_extends);
+	for (i = 0; i < 5; i++) {
+		assert_int_equal(i % 2, log_entries[i].pcr);
+		assert_int_equal(i, log_entries[i].digest0);
+	}
+
+	assert_int_equal(TPM_SUCCESS, tpm_extend_queue_flush());
+	assert_int_equal(5, num_extends);
+	for (i = 0; i < 5; i++)
+		check_extend(i, i % 2, i);
+
+	/* Nothing left to do. */
+	assert_int_equal(TPM_SUCCESS, tpm_extend_queue_flush());
+	assert_int_equal(5, num_extends);
+}
+
+/* Adding to a full queue flushes the pending entries first. */
+static void test_extend_queue_full(void **state)
+{
+	size_t i;
+
+	for (i = 0; i < TPM_EXTEND_QUEUE_SIZE; i++)
+		assert_int_equal(TPM_SUCCESS, add(2, i));
+	assert_int_equal(0, num_extends);
+
+	assert_int_equal(TPM_SUCCESS, add(3, TPM_EXTEND_QUEUE_SIZE));
+	assert_int_equal(TPM_EXTEND_QUEUE_SIZE, num_extends);
+	assert_int_equal(TPM_EXTEND_QUEUE_SIZE + 1, num_log_entries);
+
+	assert_int_equal(TPM_SUCCESS, tpm_extend_queue_flush());
+	assert_int_equal(TPM_EXTEND_QUEUE_SIZE + 1, num_extends);
+	for (i = 0; i < TPM_EXTEND_QUEUE_SIZE; i++)
+		check_extend(i, 2, i);
+	check_extend(TPM_EXTEND_QUEUE_SIZE, 3, TPM_EXTEND_QUEUE_SIZE);
+}
+
+/* A failed extend is reported and stays queued until it succeeds. */
+static void test_extend_queue_failure(void **state)
+{
+	assert_int_equal(TPM_SUCCESS, add(0, 0xaa));
+	assert_int_equal(TPM_SUCCESS, add(1, 0xbb));
+
+	extend_result = TPM_E_IOERROR;
+	assert_int_equal(TPM_E_IOERROR, tpm_extend_queue_flush());
+	assert_int_equal(0, num_extends);
+
+	extend_result = TPM_SUCCESS;
+	assert_int_equal(TPM_SUCCESS, tpm_extend_queue_flush());
+	assert_int_equal(2, num_extends);
+	check_extend(0, 0, 0xaa);
+	check_extend(1, 1, 0xbb);
+}
+
+static void test_extend_queue_invalid(void **state)
+{
+	uint8_t digest[TPM_PCR_MAX_LEN + 1] = { 0 };
+
+	assert_int_equal(TPM_E_INVALID_ARG,
+			 tpm_extend_queue_add(0, VB2_HASH_SHA256, NULL, 0, "test"));
+	assert_int_equal(TPM_E_INVALID_ARG,
+			 tpm_extend_queue_add(0, VB2_HASH_SHA256, digest, sizeof(digest),
+					      "test"));
+	assert_int_equal(0, num_log_entries);
+	assert_int_equal(TPM_SUCCESS, tpm_extend_queue_flush());
+	assert_int_equal(0, num_extends);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_extend_queue_flush, setup_queue),
+		cmocka_unit_test_setup(test_extend_queue_full, setup_queue),
+		cmocka_unit_test_setup(test_extend_queue_failure, setup_queue),
+		cmocka_unit_test_setup(test_extend_queue_invalid, setup_queue),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
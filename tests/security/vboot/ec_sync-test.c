@@ -0,0 +1,289 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <cbfs.h>
+#include <delay.h>
+#include <ec/google/chromeec/ec.h>
+#include <security/vboot/vboot_common.h>
+#include <string.h>
+#include <tests/test.h>
+#include <timer.h>
+#include <vb2_api.h>
+
+/*
+ * Mock EC behind google_chromeec_command(). It hashes in the background like a real EC, with
+ * the time it takes measured in mdelay() calls made by the code under test.
+ */
+#define EC_RW_OFFSET		0x40000
+#define EC_RW_SIZE		0x8000
+#define EC_MAX_REQUEST		0x220
+#define EC_WRITE_BLOCK		4
+
+#define EC_HASH_TIME_US		(60 * USECS_PER_MSEC)
+#define EC_ERASE_TIME_US	(50 * USECS_PER_MSEC)
+#define CBFS_MAP_TIME_US	(80 * USECS_PER_MSEC)
+
+#define IMAGE_SIZE		10001
+
+static struct {
+	uint8_t hash_status;
+	long hash_done;
+	int hash_starts;
+
+	int erase_result;
+	int erases;
+	bool erased_at_map;
+
+	uint8_t flash[EC_RW_SIZE];
+	size_t written;
+} ec;
+
+static long now;
+static uint8_t image[IMAGE_SIZE];
+static size_t image_size;
+
+void timer_monotonic_get(struct mono_time *mt)
+{
+	mono_time_set_usecs(mt, now);
+}
+
+void mdelay(unsigned int msecs)
+{
+	now += msecs * USECS_PER_MSEC;
+}
+
+void *_cbfs_alloc(const char *name, cbfs_allocator_t allocator, void *arg, size_t *size_out,
+		  bool force_ro, enum cbfs_type *type)
+{
+	assert_string_equal("ecrw", name);
+
+	ec.erased_at_map = ec.erases;
+
+	/* Loading and verifying the image takes a while. */
+	now += CBFS_MAP_TIME_US;
+
+	if (!image_size)
+		return NULL;
+
+	*size_out = image_size;
+	return image;
+}
+
+void cbfs_unmap(void *mapping)
+{
+	assert_ptr_equal(image, mapping);
+}
+
+static int ec_vboot_hash(const struct ec_params_vboot_hash *p, struct ec_response_vboot_hash *r)
+{
+	assert_int_equal(EC_VBOOT_HASH_OFFSET_ACTIVE, p->offset);
+
+	if (p->cmd == EC_VBOOT_HASH_START) {
+		ec.hash_starts++;
+		ec.hash_done = now + EC_HASH_TIME_US;
+		ec.hash_status = EC_VBOOT_HASH_STATUS_BUSY;
+	} else if (ec.hash_status == EC_VBOOT_HASH_STATUS_BUSY && now >= ec.hash_done) {
+		ec.hash_status = EC_VBOOT_HASH_STATUS_DONE;
+	}
+
+	memset(r, 0, sizeof(*r));
+	r->status = ec.hash_status;
+	r->hash_type = EC_VBOOT_HASH_TYPE_SHA256;
+	r->digest_size = VB2_SHA256_DIGEST_SIZE;
+	memset(r->hash_digest, 0xa5, r->digest_size);
+
+	return EC_RES_SUCCESS;
+}
+
+static int ec_flash_erase(const struct chromeec_command *cmd)
+{
+	const struct ec_params_flash_erase *p = cmd->cmd_data_in;
+
+	assert_int_equal(0, cmd->cmd_version);
+	assert_int_equal(EC_RW_OFFSET, p->offset);
+	assert_int_equal(EC_RW_SIZE, p->size);
+
+	ec.erases++;
+	now += EC_ERASE_TIME_US;
+	if (ec.erase_result != EC_RES_SUCCESS)
+		return ec.erase_result;
+
+	memset(ec.flash, 0xff, sizeof(ec.flash));
+
+	return EC_RES_SUCCESS;
+}
+
+static int ec_flash_write(const struct chromeec_command *cmd)
+{
+	const struct ec_params_flash_write *p = cmd->cmd_data_in;
+	const uint8_t *data = (const uint8_t *)(p + 1);
+	size_t i;
+
+	assert_true(cmd->cmd_size_in <= EC_MAX_REQUEST - sizeof(struct ec_host_request));
+	assert_int_equal(cmd->cmd_size_in, sizeof(*p) + p->size);
+	assert_int_equal(EC_RW_OFFSET + ec.written, p->offset);
+	assert_true(p->offset + p->size <= EC_RW_OFFSET + EC_RW_SIZE);
+
+	for (i = 0; i < p->size; i++) {
+		assert_int_equal(0xff, ec.flash[p->offset - EC_RW_OFFSET + i]);
+		ec.flash[p->offset - EC_RW_OFFSET + i] = data[i];
+	}
+	ec.written += p->size;
+
+	return EC_RES_SUCCESS;
+}
+
+static int ec_command(struct chromeec_command *cmd)
+{
+	struct ec_response_flash_protect *protect = cmd->cmd_data_out;
+	struct ec_response_flash_region_info *region = cmd->cmd_data_out;
+	struct ec_response_get_protocol_info *proto = cmd->cmd_data_out;
+	struct ec_response_flash_info *info = cmd->cmd_data_out;
+
+	switch (cmd->cmd_code) {
+	case EC_CMD_VBOOT_HASH:
+		return ec_vboot_hash(cmd->cmd_data_in, cmd->cmd_data_out);
+	case EC_CMD_FLASH_PROTECT:
+		memset(protect, 0, sizeof(*protect));
+		return EC_RES_SUCCESS;
+	case EC_CMD_FLASH_REGION_INFO:
+		region->offset = EC_RW_OFFSET;
+		region->size = EC_RW_SIZE;
+		return EC_RES_SUCCESS;
+	case EC_CMD_FLASH_ERASE:
+		return ec_flash_erase(cmd);
+	case EC_CMD_GET_PROTOCOL_INFO:
+		memset(proto, 0, sizeof(*proto));
+		proto->max_request_packet_size = EC_MAX_REQUEST;
+		return EC_RES_SUCCESS;
+	case EC_CMD_FLASH_INFO:
+		memset(info, 0, sizeof(*info));
+		info->write_block_size = EC_WRITE_BLOCK;
+		return EC_RES_SUCCESS;
+	case EC_CMD_FLASH_WRITE:
+		return ec_flash_write(cmd);
+	case EC_CMD_EFS_VERIFY:
+		return EC_RES_SUCCESS;
+	default:
+		fail_msg("Unexpected EC command %#x", cmd->cmd_code);
+		return EC_RES_INVALID_COMMAND;
+	}
+}
+
+/* Like the real transports, report the EC result in cmd_code and as a negative value. */
+int google_chromeec_command(struct chromeec_command *cmd)
+{
+	int rv = ec_command(cmd);
+
+	cmd->cmd_code = rv;
+	return -rv;
+}
+
+static int setup_ec(void **state)
+{
+	size_t i;
+
+	memset(&ec, 0, sizeof(ec));
+	ec.hash_status = EC_VBOOT_HASH_STATUS_NONE;
+	ec.erase_result = EC_RES_SUCCESS;
+	memset(ec.flash, 0x5a, sizeof(ec.flash));
+	now = 0;
+
+	for (i = 0; i < sizeof(image); i++)
+		image[i] = i * 7 + (i >> 8);
+	image_size = sizeof(image);
+
+	return 0;
+}
+
+static void test_ec_hash_started_early(void **state)
+{
+	const uint8_t *hash;
+	int hash_size;
+	long start;
+
+	vboot_start_ec_hash();
+	assert_int_equal(1, ec.hash_starts);
+	assert_int_equal(0, now);
+
+	/* Starting it again does not restart a hash in progress. */
+	vboot_start_ec_hash();
+	assert_int_equal(1, ec.hash_starts);
+
+	/* The AP verifies its own firmware meanwhile. */
+	now += 2 * EC_HASH_TIME_US;
+
+	start = now;
+	assert_int_equal(VB2_SUCCESS, vb2ex_ec_hash_image(VB_SELECT_FIRMWARE_EC_ACTIVE,
+							  &hash, &hash_size));
+	assert_int_equal(start, now);
+	assert_int_equal(1, ec.hash_starts);
+	assert_int_equal(VB2_SHA256_DIGEST_SIZE, hash_size);
+	assert_int_equal(0xa5, hash[0]);
+}
+
+static void test_ec_hash_on_demand(void **state)
+{
+	const uint8_t *hash;
+	int hash_size;
+
+	assert_int_equal(VB2_SUCCESS, vb2ex_ec_hash_image(VB_SELECT_FIRMWARE_EC_ACTIVE,
+							  &hash, &hash_size));
+	assert_int_equal(1, ec.hash_starts);
+	assert_true(now >= EC_HASH_TIME_US);
+	assert_int_equal(VB2_SHA256_DIGEST_SIZE, hash_size);
+}
+
+static void test_ec_update(void **state)
+{
+	assert_int_equal(VB2_SUCCESS, vb2ex_ec_update_image(VB_SELECT_FIRMWARE_EC_ACTIVE));
+	assert_int_equal(1, ec.erases);
+
+	/* The region is only erased once the image is known to fit. */
+	assert_false(ec.erased_at_map);
+	assert_int_equal(CBFS_MAP_TIME_US + EC_ERASE_TIME_US, now);
+
+	assert_int_equal(sizeof(image), ec.written);
+	assert_memory_equal(image, ec.flash, sizeof(image));
+	assert_int_equal(0xff, ec.flash[sizeof(image)]);
+}
+
+static void test_ec_update_erase_failure(void **state)
+{
+	ec.erase_result = EC_RES_ERROR;
+
+	assert_int_not_equal(VB2_SUCCESS, vb2ex_ec_update_image(VB_SELECT_FIRMWARE_EC_ACTIVE));
+	assert_int_equal(1, ec.erases);
+	assert_int_equal(0, ec.written);
+}
+
+static void test_ec_update_image_too_large(void **state)
+{
+	image_size = EC_RW_SIZE + 1;
+
+	assert_int_not_equal(VB2_SUCCESS, vb2ex_ec_update_image(VB_SELECT_FIRMWARE_EC_ACTIVE));
+	assert_int_equal(0, ec.erases);
+	assert_int_equal(0x5a, ec.flash[0]);
+}
+
+static void test_ec_update_image_missing(void **state)
+{
+	image_size = 0;
+
+	assert_int_not_equal(VB2_SUCCESS, vb2ex_ec_update_image(VB_SELECT_FIRMWARE_EC_ACTIVE));
+	assert_int_equal(0, ec.erases);
+	assert_int_equal(0x5a, ec.flash[0]);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_ec_hash_started_early, setup_ec),
+		cmocka_unit_test_setup(test_ec_hash_on_demand, setup_ec),
+		cmocka_unit_test_setup(test_ec_update, setup_ec),
+		cmocka_unit_test_setup(test_ec_update_erase_failure, setup_ec),
+		cmocka_unit_test_setup(test_ec_update_image_too_large, setup_ec),
+		cmocka_unit_test_setup(test_ec_update_image_missing, setup_ec),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
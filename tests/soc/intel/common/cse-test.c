@@ -0,0 +1,324 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <delay.h>
+#include <device/pci_def.h>
+#include <device/pci_type.h>
+#include <intelblocks/cse.h>
+#include <soc/pci_devs.h>
+#include <string.h>
+#include <tests/test.h>
+#include <timer.h>
+
+/*
+ * Model of the HECI registers. The CSE takes the messages in its circular buffer when the host
+ * generates an interrupt, and echoes each of them back to the sender after some time that
+ * depends on the client.
+ */
+#define CSE_BAR			0xfed10000
+
+#define MMIO_CSE_CB_WW		0x00
+#define MMIO_HOST_CSR		0x04
+#define MMIO_CSE_CB_RW		0x08
+#define MMIO_CSE_CSR		0x0c
+
+#define CSR_IG			(1 << 2)
+#define CSR_READY		(1 << 3)
+#define CSR_RESET		(1 << 4)
+
+#define HOST_CB_DEPTH		32
+#define MAX_REPLIES		8
+
+#define MKHI_REPLY_US		(10 * USECS_PER_MSEC)
+#define MEI_REPLY_US		(1 * USECS_PER_MSEC)
+
+static struct {
+	uint32_t host_cb[HOST_CB_DEPTH];
+	uint8_t host_wp;
+	uint8_t host_rp;
+
+	uint32_t cse_cb[256];
+	uint8_t cse_wp;
+	uint8_t cse_rp;
+
+	/* Replies the CSE is still working on. */
+	struct {
+		uint32_t slots[HOST_CB_DEPTH];
+		size_t count;
+		long ready;
+	} replies[MAX_REPLIES];
+	size_t num_replies;
+} cse;
+
+static long now;
+
+/* PCI configuration space of bus 0, for the BAR of the CSE. */
+static u8 pci_cfg[256 * 4096];
+u8 *const pci_mmconf = pci_cfg;
+
+void timer_monotonic_get(struct mono_time *mt)
+{
+	mono_time_set_usecs(mt, now);
+}
+
+void udelay(unsigned int usecs)
+{
+	now += usecs;
+}
+
+void post_code(u8 value)
+{
+}
+
+static uint8_t hdr_cse_addr(uint32_t hdr)
+{
+	return hdr & 0xff;
+}
+
+static size_t hdr_length(uint32_t hdr)
+{
+	return (hdr >> 16) & 0x1ff;
+}
+
+static void queue_reply(uint32_t hdr)
+{
+	size_t i, slots = DIV_ROUND_UP(hdr_length(hdr), sizeof(uint32_t));
+
+	assert_true(cse.num_replies < MAX_REPLIES);
+	cse.replies[cse.num_replies].slots[0] = hdr;
+	cse.replies[cse.num_replies].count = 1 + slots;
+	for (i = 0; i < slots; i++)
+		cse.replies[cse.num_replies].slots[1 + i] =
+			cse.host_cb[(uint8_t)(cse.host_rp + i) % HOST_CB_DEPTH];
+	cse.replies[cse.num_replies].ready = now + (hdr_cse_addr(hdr) == HECI_MKHI_ADDR ?
+						      MKHI_REPLY_US : MEI_REPLY_US);
+	cse.num_replies++;
+}
+
+/* Take the fragments in the host's circular buffer, one per interrupt. */
+static void cse_interrupt(void)
+{
+	uint32_t hdr;
+
+	while (cse.host_wp != cse.host_rp) {
+		hdr = cse.host_cb[cse.host_rp++ % HOST_CB_DEPTH];
+		assert_true((uint8_t)(cse.host_wp - cse.host_rp) * sizeof(uint32_t) >=
+			    hdr_length(hdr));
+		/* Fragments fit into the buffer, the model only echoes single fragments. */
+		assert_true(hdr & (1U << 31));
+		queue_reply(hdr);
+		cse.host_rp += DIV_ROUND_UP(hdr_length(hdr), sizeof(uint32_t));
+	}
+}
+
+/* Replies become visible to the host when they are ready, the quickest first. */
+static void cse_update(void)
+{
+	size_t i, next;
+
+	while (cse.num_replies) {
+		next = 0;
+		for (i = 1; i < cse.num_replies; i++) {
+			if (cse.replies[i].ready < cse.replies[next].ready)
+				next = i;
+		}
+		if (cse.replies[next].ready > now)
+			return;
+
+		for (i = 0; i < cse.replies[next].count; i++)
+			cse.cse_cb[cse.cse_wp++] = cse.replies[next].slots[i];
+		cse.num_replies--;
+		memmove(&cse.replies[next], &cse.replies[next + 1],
+			(cse.num_replies - next) * sizeof(cse.replies[0]));
+	}
+}
+
+static void cse_reset(void)
+{
+	cse.host_wp = cse.host_rp = 0;
+	cse.cse_wp = cse.cse_rp = 0;
+	cse.num_replies = 0;
+}
+
+static uint32_t csr(uint8_t wp, uint8_t rp)
+{
+	return HOST_CB_DEPTH << 24 | wp << 16 | rp << 8 | CSR_READY;
+}
+
+uint32_t read32(const volatile void *addr)
+{
+	uintptr_t offset = (uintptr_t)addr - CSE_BAR;
+
+	cse_update();
+
+	switch (offset) {
+	case MMIO_HOST_CSR:
+		return csr(cse.host_wp, cse.host_rp);
+	case MMIO_CSE_CSR:
+		return csr(cse.cse_wp, cse.cse_rp);
+	case MMIO_CSE_CB_RW:
+		assert_int_not_equal(cse.cse_wp, cse.cse_rp);
+		return cse.cse_cb[cse.cse_rp++];
+	default:
+		fail_msg("Unexpected read at %#lx", offset);
+		return 0;
+	}
+}
+
+void write32(volatile void *addr, uint32_t value)
+{
+	uintptr_t offset = (uintptr_t)addr - CSE_BAR;
+
+	switch (offset) {
+	case MMIO_HOST_CSR:
+		if (value & CSR_RESET)
+			cse_reset();
+		else if (value & CSR_IG)
+			cse_interrupt();
+		break;
+	case MMIO_CSE_CB_WW:
+		assert_true((uint8_t)(cse.host_wp - cse.host_rp) < HOST_CB_DEPTH);
+		cse.host_cb[cse.host_wp++ % HOST_CB_DEPTH] = value;
+		break;
+	default:
+		fail_msg("Unexpected write at %#lx", offset);
+	}
+}
+
+static int setup_cse(void **state)
+{
+	uint32_t bar = CSE_BAR;
+
+	memset(&cse, 0, sizeof(cse));
+	memcpy(&pci_cfg[PCI_DEVFN_OFFSET(PCH_DEV_CSE) + PCI_BASE_ADDRESS_0], &bar, sizeof(bar));
+
+	/* Nothing may be outstanding from the previous test. */
+	heci_reset();
+
+	return 0;
+}
+
+static const uint8_t mkhi_msg[] = { 0xff, 0x02, 0x00, 0x00, 0x11, 0x22, 0x33 };
+static const uint8_t mei_msg[] = { 0x0c, 0x00, 0x00, 0x00 };
+
+static void test_heci_send_receive(void **state)
+{
+	uint8_t reply[16];
+	size_t reply_size = sizeof(reply);
+	long start = now;
+
+	assert_int_equal(1, heci_send_receive(mkhi_msg, sizeof(mkhi_msg), reply, &reply_size));
+	assert_int_equal(sizeof(mkhi_msg), reply_size);
+	assert_memory_equal(mkhi_msg, reply, sizeof(mkhi_msg));
+	assert_true(now - start >= MKHI_REPLY_US);
+}
+
+static void test_heci_async(void **state)
+{
+	uint8_t reply[16];
+	size_t reply_size;
+	long start = now;
+
+	assert_int_equal(1, heci_send_async(mkhi_msg, sizeof(mkhi_msg), HECI_MKHI_ADDR, reply,
+					    sizeof(reply)));
+	assert_true(heci_reply_pending(HECI_MKHI_ADDR));
+
+	/* Sending doesn't wait for the CSE. */
+	assert_true(now - start < MKHI_REPLY_US);
+
+	now = start + MKHI_REPLY_US;
+	assert_false(heci_reply_pending(HECI_MKHI_ADDR));
+
+	/* The reply was taken already. */
+	start = now;
+	assert_int_equal(1, heci_receive_async(HECI_MKHI_ADDR, &reply_size));
+	assert_int_equal(start, now);
+	assert_int_equal(sizeof(mkhi_msg), reply_size);
+	assert_memory_equal(mkhi_msg, reply, sizeof(mkhi_msg));
+
+	/* The request is done. */
+	assert_int_equal(0, heci_receive_async(HECI_MKHI_ADDR, &reply_size));
+}
+
+static void test_heci_async_two_clients(void **state)
+{
+	uint8_t mkhi_reply[16], mei_reply[16];
+	size_t reply_size;
+	long start = now;
+
+	assert_int_equal(1, heci_send_async(mkhi_msg, sizeof(mkhi_msg), HECI_MKHI_ADDR,
+					    mkhi_reply, sizeof(mkhi_reply)));
+	assert_int_equal(1, heci_send_async(mei_msg, sizeof(mei_msg), HECI_MEI_ADDR, mei_reply,
+					    sizeof(mei_reply)));
+
+	/* Only one request per client. */
+	assert_int_equal(0, heci_send_async(mkhi_msg, sizeof(mkhi_msg), HECI_MKHI_ADDR,
+					    mkhi_reply, sizeof(mkhi_reply)));
+
+	/* The MEI reply comes first and is kept for later. */
+	assert_int_equal(1, heci_receive_async(HECI_MKHI_ADDR, &reply_size));
+	assert_true(now - start >= MKHI_REPLY_US);
+	assert_int_equal(sizeof(mkhi_msg), reply_size);
+	assert_memory_equal(mkhi_msg, mkhi_reply, sizeof(mkhi_msg));
+
+	assert_false(heci_reply_pending(HECI_MEI_ADDR));
+	start = now;
+	assert_int_equal(1, heci_receive_async(HECI_MEI_ADDR, &reply_size));
+	assert_int_equal(start, now);
+	assert_int_equal(sizeof(mei_msg), reply_size);
+	assert_memory_equal(mei_msg, mei_reply, sizeof(mei_msg));
+}
+
+static void test_heci_send_receive_with_request_outstanding(void **state)
+{
+	const uint8_t msg[] = { 0xff, 0x03, 0x00, 0x00 };
+	uint8_t async_reply[16], reply[16];
+	size_t reply_size = sizeof(reply);
+
+	assert_int_equal(1, heci_send_async(mkhi_msg, sizeof(mkhi_msg), HECI_MKHI_ADDR,
+					    async_reply, sizeof(async_reply)));
+
+	assert_int_equal(1, heci_send_receive(msg, sizeof(msg), reply, &reply_size));
+	assert_int_equal(sizeof(msg), reply_size);
+	assert_memory_equal(msg, reply, sizeof(msg));
+
+	/* The outstanding reply was collected before the message was sent. */
+	assert_false(heci_reply_pending(HECI_MKHI_ADDR));
+
+	assert_int_equal(1, heci_receive_async(HECI_MKHI_ADDR, &reply_size));
+	assert_int_equal(sizeof(mkhi_msg), reply_size);
+	assert_memory_equal(mkhi_msg, async_reply, sizeof(mkhi_msg));
+}
+
+static void test_heci_async_small_buffer(void **state)
+{
+	uint8_t reply[4];
+
+	assert_int_equal(1, heci_send_async(mkhi_msg, sizeof(mkhi_msg), HECI_MKHI_ADDR, reply,
+					    sizeof(reply)));
+	assert_int_equal(0, heci_receive_async(HECI_MKHI_ADDR, NULL));
+}
+
+static void test_heci_reset_drops_requests(void **state)
+{
+	uint8_t reply[16];
+
+	assert_int_equal(1, heci_send_async(mkhi_msg, sizeof(mkhi_msg), HECI_MKHI_ADDR, reply,
+					    sizeof(reply)));
+	assert_int_equal(1, heci_reset());
+	assert_false(heci_reply_pending(HECI_MKHI_ADDR));
+	assert_int_equal(0, heci_receive_async(HECI_MKHI_ADDR, NULL));
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_heci_send_receive, setup_cse),
+		cmocka_unit_test_setup(test_heci_async, setup_cse),
+		cmocka_unit_test_setup(test_heci_async_two_clients, setup_cse),
+		cmocka_unit_test_setup(test_heci_send_receive_with_request_outstanding, setup_cse),
+		cmocka_unit_test_setup(test_heci_async_small_buffer, setup_cse),
+		cmocka_unit_test_setup(test_heci_reset_drops_requests, setup_cse),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,181 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <commonlib/region.h>
+#include <string.h>
+#include <tests/test.h>
+#include <types.h>
+
+#include "cse_lite_rw.h"
+
+#define FLASH_BLOCKS	8
+#define FLASH_SIZE	(FLASH_BLOCKS * CSE_RW_BLOCK_SIZE)
+
+/* Emulated SPI flash: erase sets bytes to 0xff, and a write can only clear bits. */
+static uint8_t flash[FLASH_SIZE];
+static uint8_t image[FLASH_SIZE];
+static bool erased[FLASH_BLOCKS];
+static size_t erase_count;
+
+static void *flash_mmap(const struct region_device *rd, size_t offset, size_t size)
+{
+	return &flash[offset];
+}
+
+static int flash_munmap(const struct region_device *rd, void *mapping)
+{
+	return 0;
+}
+
+static ssize_t flash_readat(const struct region_device *rd, void *b, size_t offset,
+			    size_t size)
+{
+	memcpy(b, &flash[offset], size);
+	return size;
+}
+
+static ssize_t flash_writeat(const struct region_device *rd, const void *b, size_t offset,
+			     size_t size)
+{
+	const uint8_t *buf = b;
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		flash[offset + i] &= buf[i];
+
+	return size;
+}
+
+static ssize_t flash_eraseat(const struct region_device *rd, size_t offset, size_t size)
+{
+	size_t i;
+
+	assert_int_equal(0, offset % CSE_RW_BLOCK_SIZE);
+	assert_int_equal(0, size % CSE_RW_BLOCK_SIZE);
+
+	memset(&flash[offset], 0xff, size);
+	for (i = offset / CSE_RW_BLOCK_SIZE; i < (offset + size) / CSE_RW_BLOCK_SIZE; i++) {
+		erased[i] = true;
+		erase_count++;
+	}
+
+	return size;
+}
+
+static const struct region_device_ops flash_ops = {
+	.mmap = flash_mmap,
+	.munmap = flash_munmap,
+	.readat = flash_readat,
+	.writeat = flash_writeat,
+	.eraseat = flash_eraseat,
+};
+
+static const struct region_device flash_rdev = REGION_DEV_INIT(&flash_ops, 0, FLASH_SIZE);
+
+/* Fill the image with a pattern and program it to flash, padded with 0xff. */
+static size_t setup_flash(size_t image_sz)
+{
+	size_t i;
+
+	for (i = 0; i < image_sz; i++)
+		image[i] = i * 7 + 3;
+	memset(flash, 0xff, sizeof(flash));
+	memcpy(flash, image, image_sz);
+	memset(erased, 0, sizeof(erased));
+	erase_count = 0;
+
+	return image_sz;
+}
+
+static void assert_flash_holds_image(size_t image_sz)
+{
+	size_t i;
+
+	assert_memory_equal(flash, image, image_sz);
+	for (i = image_sz; i < FLASH_SIZE; i++)
+		assert_int_equal(0xff, flash[i]);
+}
+
+static void test_cse_write_rw_region_diff_unchanged(void **state)
+{
+	size_t image_sz = setup_flash(5 * CSE_RW_BLOCK_SIZE + 100);
+	size_t written = 0;
+
+	assert_true(cse_write_rw_region_diff(&flash_rdev, image, image_sz, &written));
+	assert_int_equal(0, written);
+	assert_int_equal(0, erase_count);
+	assert_flash_holds_image(image_sz);
+}
+
+static void test_cse_write_rw_region_diff_one_block(void **state)
+{
+	size_t image_sz = setup_flash(5 * CSE_RW_BLOCK_SIZE + 100);
+	size_t written = 0;
+
+	image[3 * CSE_RW_BLOCK_SIZE + 17] ^= 0x5a;
+
+	assert_true(cse_write_rw_region_diff(&flash_rdev, image, image_sz, &written));
+	assert_flash_holds_image(image_sz);
+
+	/* The changed block and the block holding the signature are rewritten. */
+	assert_int_equal(2, erase_count);
+	assert_true(erased[0]);
+	assert_true(erased[3]);
+	assert_int_equal(2 * CSE_RW_BLOCK_SIZE, written);
+}
+
+static void test_cse_write_rw_region_diff_signature(void **state)
+{
+	size_t image_sz = setup_flash(2 * CSE_RW_BLOCK_SIZE);
+	size_t written = 0;
+
+	/* An invalidated signature alone must be restored. */
+	memset(flash, 0, CSE_RW_SIGN_SIZE);
+
+	assert_true(cse_write_rw_region_diff(&flash_rdev, image, image_sz, &written));
+	assert_flash_holds_image(image_sz);
+	assert_int_equal(1, erase_count);
+	assert_true(erased[0]);
+}
+
+static void test_cse_write_rw_region_diff_stale_tail(void **state)
+{
+	size_t image_sz = setup_flash(6 * CSE_RW_BLOCK_SIZE);
+	size_t written = 0;
+
+	/* The new image is shorter, the old data after its end must be erased. */
+	image_sz = 4 * CSE_RW_BLOCK_SIZE - 10;
+
+	assert_true(cse_write_rw_region_diff(&flash_rdev, image, image_sz, &written));
+	assert_flash_holds_image(image_sz);
+	assert_true(erased[0]);
+	assert_true(erased[3]);
+	assert_true(erased[4]);
+	assert_true(erased[5]);
+	assert_false(erased[1]);
+	assert_false(erased[2]);
+	assert_false(erased[6]);
+	assert_false(erased[7]);
+}
+
+static void test_cse_write_rw_region(void **state)
+{
+	size_t image_sz = setup_flash(3 * CSE_RW_BLOCK_SIZE + 1);
+
+	memset(flash, 0xff, sizeof(flash));
+
+	assert_true(cse_write_rw_region(&flash_rdev, image, image_sz));
+	assert_flash_holds_image(image_sz);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_cse_write_rw_region_diff_unchanged),
+		cmocka_unit_test(test_cse_write_rw_region_diff_one_block),
+		cmocka_unit_test(test_cse_write_rw_region_diff_signature),
+		cmocka_unit_test(test_cse_write_rw_region_diff_stale_tail),
+		cmocka_unit_test(test_cse_write_rw_region),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
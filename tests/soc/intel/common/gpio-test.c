@@ -0,0 +1,276 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#include <intelblocks/gpio.h>
+#include <intelblocks/pcr.h>
+#include <string.h>
+#include <tests/test.h>
+
+/*
+ * Two GPIO communities with two groups each, behind a stub of the PCR access functions that
+ * records the register contents and counts the accesses.
+ */
+#define PORT_A		0xa5
+#define PORT_B		0xb7
+#define PORT_SIZE	0x800
+
+#define OWN_REG_0	0x80
+#define SMI_STS_REG_0	0x180
+#define SMI_EN_REG_0	0x1a0
+#define NMI_STS_REG_0	0x1c0
+#define NMI_EN_REG_0	0x1e0
+#define PAD_CFG_REG_0	0x400
+
+#define PAD_DW1_MASK	(PAD_CFG1_IOSTERM_MASK | PAD_CFG1_PULL_MASK | PAD_CFG1_IOSSTATE_MASK)
+
+static const struct pad_group groups[] = {
+	{ .first_pad = 0, .size = 8 },
+	{ .first_pad = 8, .size = 8 },
+};
+
+static const struct pad_community communities[] = {
+	{
+		.name = "A",
+		.first_pad = 0,
+		.last_pad = 15,
+		.host_own_reg_0 = OWN_REG_0,
+		.gpi_smi_sts_reg_0 = SMI_STS_REG_0,
+		.gpi_smi_en_reg_0 = SMI_EN_REG_0,
+		.gpi_nmi_sts_reg_0 = NMI_STS_REG_0,
+		.gpi_nmi_en_reg_0 = NMI_EN_REG_0,
+		.pad_cfg_base = PAD_CFG_REG_0,
+		.port = PORT_A,
+		.groups = groups,
+		.num_groups = ARRAY_SIZE(groups),
+	},
+	{
+		/* Without NMI support. */
+		.name = "B",
+		.first_pad = 16,
+		.last_pad = 31,
+		.host_own_reg_0 = OWN_REG_0,
+		.gpi_smi_sts_reg_0 = SMI_STS_REG_0,
+		.gpi_smi_en_reg_0 = SMI_EN_REG_0,
+		.pad_cfg_base = PAD_CFG_REG_0,
+		.port = PORT_B,
+		.groups = groups,
+		.num_groups = ARRAY_SIZE(groups),
+	},
+};
+
+static struct {
+	uint32_t regs[PORT_SIZE / sizeof(uint32_t)];
+	int reads;
+	int writes;
+	int pad_cfg_writes;
+} ports[2];
+
+const struct pad_community *soc_gpio_get_community(size_t *num_communities)
+{
+	*num_communities = ARRAY_SIZE(communities);
+	return communities;
+}
+
+void die(const char *msg, ...)
+{
+	fail_msg("Unexpected call to die(): %s", msg);
+}
+
+static uint32_t *reg(uint8_t pid, uint16_t offset)
+{
+	assert_true(pid == PORT_A || pid == PORT_B);
+	assert_int_equal(0, offset % sizeof(uint32_t));
+	assert_true(offset < PORT_SIZE);
+
+	return &ports[pid == PORT_B].regs[offset / sizeof(uint32_t)];
+}
+
+uint32_t pcr_read32(uint8_t pid, uint16_t offset)
+{
+	ports[pid == PORT_B].reads++;
+	return *reg(pid, offset);
+}
+
+void pcr_write32(uint8_t pid, uint16_t offset, uint32_t indata)
+{
+	uint32_t *r = reg(pid, offset);
+
+	ports[pid == PORT_B].writes++;
+	if (offset >= PAD_CFG_REG_0) {
+		ports[pid == PORT_B].pad_cfg_writes++;
+		/* The RX state and the IRQ number are read-only. */
+		if (offset % (GPIO_NUM_PAD_CFG_REGS * sizeof(uint32_t)) == 0)
+			indata = (indata & ~PAD_CFG0_RX_STATE) | (*r & PAD_CFG0_RX_STATE);
+		else
+			indata = (indata & ~PAD_CFG1_IRQ_MASK) | (*r & PAD_CFG1_IRQ_MASK);
+	} else if (offset >= SMI_STS_REG_0 && offset < SMI_EN_REG_0) {
+		/* Status bits are cleared by writing 1. */
+		indata = *r & ~indata;
+	} else if (offset >= NMI_STS_REG_0 && offset < NMI_EN_REG_0) {
+		indata = *r & ~indata;
+	}
+	*r = indata;
+}
+
+void pcr_rmw32(uint8_t pid, uint16_t offset, uint32_t anddata, uint32_t ordata)
+{
+	pcr_write32(pid, offset, (pcr_read32(pid, offset) & anddata) | ordata);
+}
+
+void pcr_or32(uint8_t pid, uint16_t offset, uint32_t ordata)
+{
+	pcr_write32(pid, offset, pcr_read32(pid, offset) | ordata);
+}
+
+static uint32_t pad_dw(gpio_t pad, int dw)
+{
+	const struct pad_community *comm = &communities[pad >= 16];
+
+	return *reg(comm->port, comm->pad_cfg_base +
+		    ((pad - comm->first_pad) * GPIO_NUM_PAD_CFG_REGS + dw) * sizeof(uint32_t));
+}
+
+static uint32_t group_reg(gpio_t pad, uint16_t reg_0)
+{
+	return *reg(communities[pad >= 16].port, reg_0 + (pad % 16) / 8 * sizeof(uint32_t));
+}
+
+static uint32_t pad_bit(gpio_t pad)
+{
+	return 1U << (pad % 8);
+}
+
+static int setup_gpio(void **state)
+{
+	gpio_t pad;
+
+	memset(ports, 0, sizeof(ports));
+
+	for (pad = 0; pad < 32; pad++) {
+		const struct pad_community *comm = &communities[pad >= 16];
+		uint16_t offset = comm->pad_cfg_base +
+			(pad - comm->first_pad) * GPIO_NUM_PAD_CFG_REGS * sizeof(uint32_t);
+
+		*reg(comm->port, offset) = PAD_CFG0_RX_STATE;
+		*reg(comm->port, offset + sizeof(uint32_t)) = 0x20 + pad;
+	}
+
+	/* Pending SMIs and NMIs everywhere, and pads owned by the driver. */
+	*reg(PORT_A, SMI_STS_REG_0) = *reg(PORT_A, SMI_STS_REG_0 + 4) = 0xff;
+	*reg(PORT_B, SMI_STS_REG_0) = *reg(PORT_B, SMI_STS_REG_0 + 4) = 0xff;
+	*reg(PORT_A, NMI_STS_REG_0) = *reg(PORT_A, NMI_STS_REG_0 + 4) = 0xff;
+	*reg(PORT_A, OWN_REG_0 + 4) = 0xff;
+
+	return 0;
+}
+
+static const struct pad_config pads[] = {
+	PAD_CFG_GPO(1, 1, DEEP),
+	PAD_CFG_GPI_GPIO_DRIVER(17, UP_20K, PLTRST),
+	PAD_CFG_GPI_SMI(2, NONE, DEEP, EDGE_SINGLE, INVERT),
+	PAD_CFG_GPI(9, DN_20K, DEEP),
+	PAD_CFG_GPI_NMI(10, NONE, DEEP, LEVEL, NONE),
+	PAD_CFG_GPI_SMI(25, NONE, DEEP, LEVEL, NONE),
+	PAD_CFG_NF(3, NONE, DEEP, NF2),
+	PAD_CFG_GPI_GPIO_DRIVER(4, NONE, DEEP),
+	/* Not supported in community B. */
+	PAD_CFG_GPI_NMI(26, NONE, DEEP, LEVEL, NONE),
+};
+
+static void check_pad(const struct pad_config *cfg)
+{
+	assert_int_equal(cfg->pad_config[0] | PAD_CFG0_RX_STATE, pad_dw(cfg->pad, 0));
+	assert_int_equal((cfg->pad_config[1] & PAD_DW1_MASK) | (0x20 + cfg->pad),
+			 pad_dw(cfg->pad, 1));
+}
+
+static void check_pads(const struct pad_config *cfg, size_t num)
+{
+	size_t i;
+
+	for (i = 0; i < num; i++)
+		check_pad(&cfg[i]);
+
+	/* Host ownership */
+	assert_int_equal(pad_bit(4), group_reg(4, OWN_REG_0));
+	assert_int_equal(0xff & ~pad_bit(9) & ~pad_bit(10), group_reg(9, OWN_REG_0));
+	assert_int_equal(pad_bit(17), group_reg(17, OWN_REG_0));
+	assert_int_equal(0, group_reg(25, OWN_REG_0));
+
+	/* SMI and NMI, with the pending status cleared. */
+	assert_int_equal(pad_bit(2), group_reg(2, SMI_EN_REG_0));
+	assert_int_equal(0xff & ~pad_bit(2), group_reg(2, SMI_STS_REG_0));
+	assert_int_equal(pad_bit(25), group_reg(25, SMI_EN_REG_0));
+	assert_int_equal(0xff & ~pad_bit(25), group_reg(25, SMI_STS_REG_0));
+	assert_int_equal(pad_bit(10), group_reg(10, NMI_EN_REG_0));
+	assert_int_equal(0xff & ~pad_bit(10), group_reg(10, NMI_STS_REG_0));
+	assert_int_equal(0, group_reg(2, NMI_EN_REG_0));
+
+	/* Pads not in the table are left alone. */
+	assert_int_equal(PAD_CFG0_RX_STATE, pad_dw(0, 0));
+	assert_int_equal(0x20 + 30, pad_dw(30, 1));
+}
+
+static int pad_cfg_writes(void)
+{
+	return ports[0].pad_cfg_writes + ports[1].pad_cfg_writes;
+}
+
+static int group_reg_writes(void)
+{
+	return ports[0].writes + ports[1].writes - pad_cfg_writes();
+}
+
+static void test_gpio_configure_pads(void **state)
+{
+	gpio_configure_pads(pads, ARRAY_SIZE(pads));
+	check_pads(pads, ARRAY_SIZE(pads));
+
+	/*
+	 * One ownership write for each of the three groups that change, and one status and
+	 * one enable write for each of the three groups with SMI or NMI pads.
+	 */
+	if (CONFIG(SOC_INTEL_COMMON_BLOCK_GPIO_BATCH))
+		assert_int_equal(3 + 2 * 3, group_reg_writes());
+}
+
+static void test_gpio_configure_pads_unchanged(void **state)
+{
+	int writes;
+
+	gpio_configure_pads(pads, ARRAY_SIZE(pads));
+	writes = pad_cfg_writes();
+
+	/* The pad configuration registers are not written again. */
+	gpio_configure_pads(pads, ARRAY_SIZE(pads));
+	check_pads(pads, ARRAY_SIZE(pads));
+	assert_int_equal(writes, pad_cfg_writes());
+
+	if (CONFIG(SOC_INTEL_COMMON_BLOCK_GPIO_BATCH))
+		assert_int_equal(3 + 2 * 3 + 2 * 3, group_reg_writes());
+}
+
+static void test_gpio_configure_pads_with_override(void **state)
+{
+	const struct pad_config override[] = {
+		PAD_CFG_GPO(9, 0, PLTRST),
+	};
+	struct pad_config expected[ARRAY_SIZE(pads)];
+
+	memcpy(expected, pads, sizeof(pads));
+	expected[3] = override[0];
+
+	gpio_configure_pads_with_override(pads, ARRAY_SIZE(pads), override,
+					  ARRAY_SIZE(override));
+	check_pads(expected, ARRAY_SIZE(expected));
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup(test_gpio_configure_pads, setup_gpio),
+		cmocka_unit_test_setup(test_gpio_configure_pads_unchanged, setup_gpio),
+		cmocka_unit_test_setup(test_gpio_configure_pads_with_override, setup_gpio),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
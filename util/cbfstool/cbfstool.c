@@ -236,10 +236,100 @@ static int update_anchor(struct mh_cache *mhc, uint8_t *fmap_hash)
 
 }
 
+struct mdir_args {
+	uint8_t *pos;
+	uint8_t *end;
+	uint32_t count;
+	uint32_t end_offset;
+	bool full;
+};
+
+static cb_err_t mdir_walker(cbfs_dev_t dev, size_t offset,
+			    const union cbfs_mdata *mdata, size_t already_read,
+			    void *arg)
+{
+	struct mdir_args *args = arg;
+	const uint32_t data_offset = be32toh(mdata->h.offset);
+	const size_t copy_size = ALIGN_UP(data_offset, CBFS_MDIR_ALIGN);
+	union cbfs_mdata copy;
+
+	if (offset == 0)
+		return CB_CBFS_NOT_FOUND;	/* the directory itself */
+
+	if ((size_t)(args->end - args->pos) < copy_size) {
+		args->end_offset = offset;
+		args->full = true;
+		return CB_CBFS_CACHE_FULL;
+	}
+
+	if (cbfs_copy_fill_metadata(&copy, mdata, already_read, dev, offset))
+		return CB_CBFS_IO;
+
+	memset(args->pos, 0, copy_size);
+	memcpy(args->pos, &copy, data_offset);
+	write_be32(args->pos, offset);
+
+	args->pos += copy_size;
+	args->count++;
+	args->end_offset = ALIGN_UP(offset + data_offset + be32toh(mdata->h.len),
+				    CBFS_ALIGNMENT);
+	return CB_CBFS_NOT_FOUND;
+}
+
+/* This should be called after every time the set of files in a CBFS or their
+   placement might have changed. If the CBFS starts with a metadata directory,
+   it is regenerated to describe the current files. */
+static int maybe_update_metadata_dir(struct cbfs_image *cbfs)
+{
+	struct cbfs_file *dir_file = buffer_get(&cbfs->buffer);
+
+	if (buffer_size(&cbfs->buffer) < sizeof(*dir_file) ||
+	    memcmp(dir_file->magic, CBFS_FILE_MAGIC, sizeof(dir_file->magic)) ||
+	    ntohl(dir_file->type) != CBFS_TYPE_METADATA_DIR)
+		return 0;
+
+	struct cbfs_mdir_header *dir = CBFS_SUBHEADER(dir_file);
+	const size_t capacity = ntohl(dir_file->len) - sizeof(*dir);
+	uint8_t *copies = malloc(capacity);
+	struct mdir_args args = {
+		.pos = copies,
+		.end = copies + capacity,
+		.end_offset = ALIGN_UP(ntohl(dir_file->offset) +
+				       ntohl(dir_file->len), CBFS_ALIGNMENT),
+	};
+
+	if (!copies)
+		return -1;
+
+	cb_err_t err = cbfs_walk(cbfs, mdir_walker, &args, NULL, 0);
+	if (err != CB_CBFS_NOT_FOUND && err != CB_CBFS_CACHE_FULL) {
+		ERROR("Unexpected cbfs_walk() error %d\n", err);
+		free(copies);
+		return -1;
+	}
+	if (args.full)
+		WARN("CBFS metadata directory too small, only covers %u files up to %#x\n",
+		     args.count, args.end_offset);
+
+	dir->magic = htonl(CBFS_MDIR_MAGIC);
+	dir->count = htonl(args.count);
+	dir->size = htonl(args.pos - copies);
+	dir->end_offset = htonl(args.end_offset);
+	memcpy(dir + 1, copies, args.pos - copies);
+	memset((uint8_t *)(dir + 1) + (args.pos - copies), 0xff,
+	       capacity - (args.pos - copies));
+
+	free(copies);
+	return 0;
+}
+
 /* This should be called after every time CBFS metadata might have changed. It
    will recalculate and update the metadata hash in the bootblock if needed. */
 static int maybe_update_metadata_hash(struct cbfs_image *cbfs)
 {
+	if (maybe_update_metadata_dir(cbfs))
+		return -1;
+
 	if (strcmp(param.region_name, SECTION_NAME_PRIMARY_CBFS))
 		return 0;  /* Metadata hash only embedded in primary CBFS. */
 
@@ -772,6 +862,51 @@ done:
 	return ret;
 }
 
+static int cbfs_add_metadata_dir(void)
+{
+	struct cbfs_image image;
+	struct cbfs_file *header;
+	struct buffer buffer;
+	int ret = 1;
+
+	if (param.size < sizeof(struct cbfs_mdir_header)) {
+		ERROR("You need to specify a valid -s/--size.\n");
+		return 1;
+	}
+
+	if (cbfs_image_from_buffer(&image, param.image_region,
+		param.headeroffset)) {
+		ERROR("Selected image region is not a CBFS.\n");
+		return 1;
+	}
+
+	if (cbfs_get_entry(&image, CBFS_MDIR_NAME)) {
+		ERROR("'%s' already in ROM image.\n", CBFS_MDIR_NAME);
+		return 1;
+	}
+
+	if (buffer_create(&buffer, param.size, CBFS_MDIR_NAME) != 0)
+		return 1;
+	memset(buffer.data, 0xff, buffer.size);
+
+	/* Readers only look for the directory at the very start of the CBFS,
+	   and it must not carry a hash attribute (its contents keep changing). */
+	header = cbfs_create_file_header(CBFS_TYPE_METADATA_DIR,
+		buffer_size(&buffer), CBFS_MDIR_NAME);
+	if (cbfs_add_entry(&image, &buffer, ntohl(header->offset), header,
+			   0) != 0) {
+		ERROR("Failed to add metadata directory at the start of the CBFS.\n");
+		goto done;
+	}
+
+	ret = maybe_update_metadata_hash(&image);
+
+done:
+	free(header);
+	buffer_delete(&buffer);
+	return ret;
+}
+
 static int add_topswap_bootblock(struct buffer *buffer, uint32_t *offset)
 {
 	size_t bb_buf_size = buffer_size(buffer);
@@ -1671,7 +1806,15 @@ static int cbfs_copy(void)
 	if (cbfs_image_from_buffer(&src_image, &src_buf, param.headeroffset))
 		return 1;
 
-	return cbfs_copy_instance(&src_image, param.image_region);
+	if (cbfs_copy_instance(&src_image, param.image_region))
+		return 1;
+
+	/* Copying compacts the files, so a metadata directory must follow. */
+	struct cbfs_image dst_image;
+	if (cbfs_image_from_buffer(&dst_image, param.image_region,
+				   param.headeroffset))
+		return 1;
+	return maybe_update_metadata_dir(&dst_image);
 }
 
 static int cbfs_compact(void)
@@ -1681,7 +1824,7 @@ static int cbfs_compact(void)
 							param.headeroffset))
 		return 1;
 	WARN("Compacting a CBFS doesn't honor alignment or fixed addresses!\n");
-	return cbfs_compact_instance(&image);
+	return cbfs_compact_instance(&image) || maybe_update_metadata_dir(&image);
 }
 
 static int cbfs_expand(void)
@@ -1725,6 +1868,7 @@ static const struct command commands[] = {
 				true, true},
 	{"add-int", "H:r:i:n:b:vgh?", cbfs_add_integer, true, true},
 	{"add-master-header", "H:r:vh?j:", cbfs_add_master_header, true, true},
+	{"add-metadata-dir", "H:r:s:vh?", cbfs_add_metadata_dir, true, true},
 	{"compact", "r:h?", cbfs_compact, true, true},
 	{"copy", "r:R:h?", cbfs_copy, true, true},
 	{"create", "M:r:s:B:b:H:o:m:vh?", cbfs_create, true, true},
@@ -1922,6 +2066,8 @@ static void usage(char *name)
 	     " add-master-header [-r image,regions] \\                   \n"
 	     "        [-j topswap-size] (Intel CPUs only)                  "
 			"Add a legacy CBFS master header\n"
+	     " add-metadata-dir [-r image,regions] -s size                 "
+			"Add a metadata directory\n"
 	     " remove [-r image,regions] -n NAME                           "
 			"Remove a component\n"
 	     " compact -r image,regions                                    "
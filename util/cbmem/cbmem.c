@@ -17,9 +17,12 @@
 #include <libgen.h>
 #include <assert.h>
 #include <regex.h>
+#include <elf.h>
 #include <commonlib/cbmem_id.h>
 #include <commonlib/timestamp_serialized.h>
 #include <commonlib/tcpa_log_serialized.h>
+#include <commonlib/smi_profile_serialized.h>
+#include <commonlib/ramstage_profile_serialized.h>
 #include <commonlib/coreboot_tables.h>
 
 #ifdef __OpenBSD__
@@ -706,6 +709,454 @@ static void dump_tcpa_log(void)
 	unmap_memory(&tcpa_mapping);
 }
 
+static const struct {
+	uint32_t source;
+	const char *name;
+} smi_sources[] = {
+	{ SMI_PROFILE_SRC_APMC, "apmc" },
+	{ SMI_PROFILE_SRC_SLEEP, "sleep" },
+	{ SMI_PROFILE_SRC_PM1, "pm1" },
+	{ SMI_PROFILE_SRC_GPE0, "gpe0" },
+	{ SMI_PROFILE_SRC_GPI, "gpi" },
+	{ SMI_PROFILE_SRC_TCO, "tco" },
+	{ SMI_PROFILE_SRC_PERIODIC, "periodic" },
+	{ SMI_PROFILE_SRC_ESPI, "espi" },
+	{ SMI_PROFILE_SRC_IO_TRAP, "io-trap" },
+	{ SMI_PROFILE_SRC_SMMSTORE, "smmstore" },
+	{ SMI_PROFILE_SRC_GSMI, "gsmi" },
+};
+
+/* Latency buckets are powers of two microseconds, the last one takes the rest. */
+#define SMI_HIST_BUCKETS 20
+
+struct smi_latency_stats {
+	const char *name;
+	u32 count;
+	u64 min, max, total;
+	u32 hist[SMI_HIST_BUCKETS];
+};
+
+static void smi_latency_add(struct smi_latency_stats *stats, u64 usecs)
+{
+	int bucket = 0;
+
+	while (bucket < SMI_HIST_BUCKETS - 1 && usecs >= (1ULL << bucket))
+		bucket++;
+
+	if (!stats->count || usecs < stats->min)
+		stats->min = usecs;
+	if (usecs > stats->max)
+		stats->max = usecs;
+	stats->total += usecs;
+	stats->count++;
+	stats->hist[bucket]++;
+}
+
+static void smi_latency_print(const struct smi_latency_stats *stats)
+{
+	u32 peak = 0;
+	int i, last = 0;
+
+	if (!stats->count)
+		return;
+
+	for (i = 0; i < SMI_HIST_BUCKETS; i++) {
+		if (stats->hist[i] > peak)
+			peak = stats->hist[i];
+		if (stats->hist[i])
+			last = i;
+	}
+
+	printf("\n%s: %u SMIs, min %llu us, avg %llu us, max %llu us\n", stats->name,
+	       stats->count, (unsigned long long)stats->min,
+	       (unsigned long long)(stats->total / stats->count),
+	       (unsigned long long)stats->max);
+
+	for (i = 0; i <= last; i++) {
+		if (i == 0)
+			printf("  %8s < %-8llu", "", 1ULL);
+		else if (i == SMI_HIST_BUCKETS - 1)
+			printf("  %8llu+ %-8s", 1ULL << (i - 1), "");
+		else
+			printf("  %8llu - %-8llu", 1ULL << (i - 1), 1ULL << i);
+		printf(" %8u ", stats->hist[i]);
+		for (u32 j = 0; j < (stats->hist[i] * 40 + peak - 1) / peak; j++)
+			putchar('#');
+		putchar('\n');
+	}
+}
+
+/* dump the SMI profile log */
+static void dump_smi_profile(void)
+{
+	const struct smi_profile_log *log_p;
+	struct smi_profile_log *log;
+	struct smi_latency_stats all = { .name = "All SMIs" };
+	struct smi_latency_stats per_source[ARRAY_SIZE(smi_sources)];
+	struct mapping smi_mapping;
+	uint64_t start;
+	size_t size, cbmem_size;
+	u32 count, first;
+
+	if (find_cbmem_entry(CBMEM_ID_SMI_PROFILE, &start, &cbmem_size)) {
+		fprintf(stderr, "No SMI profile found in coreboot table.\n");
+		return;
+	}
+
+	size = sizeof(*log_p);
+	log_p = map_memory(&smi_mapping, start, size);
+	if (!log_p)
+		die("Unable to map SMI profile header\n");
+
+	size += log_p->max_entries * sizeof(log_p->entries[0]);
+	if (size > cbmem_size)
+		die("SMI profile is larger than its CBMEM entry\n");
+
+	unmap_memory(&smi_mapping);
+
+	log_p = map_memory(&smi_mapping, start, size);
+	if (!log_p)
+		die("Unable to map full SMI profile\n");
+
+	log = malloc(size);
+	if (!log)
+		die("Failed to allocate memory");
+	aligned_memcpy(log, log_p, size);
+	unmap_memory(&smi_mapping);
+
+	timestamp_set_tick_freq(log->tick_freq_mhz);
+
+	if (log->num_entries > log->max_entries) {
+		count = log->max_entries;
+		first = count ? log->num_entries % count : 0;
+	} else {
+		count = log->num_entries;
+		first = 0;
+	}
+
+	printf("%u SMIs recorded, showing the last %u:\n\n", log->num_entries, count);
+	printf("%-10s %-4s %20s %12s  %s\n", "SMI", "CPU", "entry (us)", "latency (us)",
+	       "sources");
+
+	memset(per_source, 0, sizeof(per_source));
+	for (size_t i = 0; i < ARRAY_SIZE(smi_sources); i++)
+		per_source[i].name = smi_sources[i].name;
+
+	for (u32 i = 0; i < count; i++) {
+		const struct smi_profile_entry *e =
+			&log->entries[(first + i) % log->max_entries];
+		u64 latency = arch_convert_raw_ts_entry(e->exit_tsc - e->entry_tsc);
+
+		printf("%-10u %-4u ", log->num_entries - count + i, e->cpu);
+		printf("%20llu %12llu  ",
+		       (unsigned long long)arch_convert_raw_ts_entry(e->entry_tsc),
+		       (unsigned long long)latency);
+
+		smi_latency_add(&all, latency);
+		for (size_t j = 0; j < ARRAY_SIZE(smi_sources); j++) {
+			if (!(e->sources & smi_sources[j].source))
+				continue;
+			printf("%s ", smi_sources[j].name);
+			smi_latency_add(&per_source[j], latency);
+		}
+		if (e->sources & SMI_PROFILE_SRC_APMC)
+			printf("(apmc 0x%02x) ", e->apmc);
+		if (e->handlers)
+			printf("[handlers 0x%08x]", e->handlers);
+		printf("\n");
+	}
+
+	smi_latency_print(&all);
+	for (size_t i = 0; i < ARRAY_SIZE(smi_sources); i++)
+		smi_latency_print(&per_source[i]);
+
+	free(log);
+}
+
+/* Function symbols of ramstage.debug, sorted by address */
+struct profile_symbol {
+	u64 addr;
+	const char *name;
+};
+
+struct profile_symbols {
+	struct profile_symbol *syms;
+	size_t count;
+	u64 program;	/* Link address of _program */
+	u8 *image;
+};
+
+static int compare_profile_symbols(const void *a, const void *b)
+{
+	const struct profile_symbol *sa = a, *sb = b;
+
+	if (sa->addr < sb->addr)
+		return -1;
+	return sa->addr > sb->addr;
+}
+
+static const void *elf_at(const u8 *image, size_t size, u64 offset, u64 len)
+{
+	if (offset > size || len > size - offset)
+		die("ELF file is truncated\n");
+	return image + offset;
+}
+
+/* Load the function symbols of a 32 or 64 bit little endian ELF file. */
+static void load_profile_symbols(const char *path, struct profile_symbols *ps)
+{
+	const Elf64_Ehdr *eh64;
+	const Elf32_Ehdr *eh32;
+	u64 shoff, shentsize, shnum;
+	size_t size, i, j;
+	struct stat st;
+	FILE *f;
+	int is64;
+
+	f = fopen(path, "rb");
+	if (!f || fstat(fileno(f), &st))
+		die("Unable to open the ramstage ELF file\n");
+	size = st.st_size;
+	ps->image = malloc(size);
+	if (!ps->image)
+		die("Failed to allocate memory");
+	if (fread(ps->image, 1, size, f) != size)
+		die("Unable to read the ramstage ELF file\n");
+	fclose(f);
+
+	if (size < EI_NIDENT || memcmp(ps->image, ELFMAG, SELFMAG) ||
+	    ps->image[EI_DATA] != ELFDATA2LSB)
+		die("Not a little endian ELF file\n");
+	is64 = ps->image[EI_CLASS] == ELFCLASS64;
+
+	if (is64) {
+		eh64 = elf_at(ps->image, size, 0, sizeof(*eh64));
+		shoff = eh64->e_shoff;
+		shentsize = eh64->e_shentsize;
+		shnum = eh64->e_shnum;
+	} else {
+		eh32 = elf_at(ps->image, size, 0, sizeof(*eh32));
+		shoff = eh32->e_shoff;
+		shentsize = eh32->e_shentsize;
+		shnum = eh32->e_shnum;
+	}
+
+	for (i = 0; i < shnum; i++) {
+		u64 sym_off, sym_size, sym_ent, str_off, str_size;
+		const char *strtab;
+		u32 link;
+
+		if (is64) {
+			const Elf64_Shdr *sh = elf_at(ps->image, size, shoff + i * shentsize,
+						      sizeof(*sh));
+			if (sh->sh_type != SHT_SYMTAB)
+				continue;
+			sym_off = sh->sh_offset;
+			sym_size = sh->sh_size;
+			sym_ent = sizeof(Elf64_Sym);
+			link = sh->sh_link;
+		} else {
+			const Elf32_Shdr *sh = elf_at(ps->image, size, shoff + i * shentsize,
+						      sizeof(*sh));
+			if (sh->sh_type != SHT_SYMTAB)
+				continue;
+			sym_off = sh->sh_offset;
+			sym_size = sh->sh_size;
+			sym_ent = sizeof(Elf32_Sym);
+			link = sh->sh_link;
+		}
+
+		if (link >= shnum)
+			die("Invalid ELF string table\n");
+		if (is64) {
+			const Elf64_Shdr *sh = elf_at(ps->image, size, shoff + link * shentsize,
+						      sizeof(*sh));
+			str_off = sh->sh_offset;
+			str_size = sh->sh_size;
+		} else {
+			const Elf32_Shdr *sh = elf_at(ps->image, size, shoff + link * shentsize,
+						      sizeof(*sh));
+			str_off = sh->sh_offset;
+			str_size = sh->sh_size;
+		}
+		strtab = elf_at(ps->image, size, str_off, str_size);
+		elf_at(ps->image, size, sym_off, sym_size);
+
+		ps->syms = realloc(ps->syms, (ps->count + sym_size / sym_ent) *
+				   sizeof(ps->syms[0]));
+		if (!ps->syms)
+			die("Failed to allocate memory");
+
+		for (j = 0; j < sym_size / sym_ent; j++) {
+			const u8 *sym = ps->image + sym_off + j * sym_ent;
+			u32 name;
+			u16 shndx;
+			u8 type;
+			u64 value;
+
+			if (is64) {
+				const Elf64_Sym *s = (const Elf64_Sym *)sym;
+				name = s->st_name;
+				shndx = s->st_shndx;
+				type = ELF64_ST_TYPE(s->st_info);
+				value = s->st_value;
+			} else {
+				const Elf32_Sym *s = (const Elf32_Sym *)sym;
+				name = s->st_name;
+				shndx = s->st_shndx;
+				type = ELF32_ST_TYPE(s->st_info);
+				value = s->st_value;
+			}
+
+			if (name >= str_size || !memchr(strtab + name, '\0', str_size - name))
+				continue;
+			if (!strcmp(strtab + name, "_program"))
+				ps->program = value;
+
+			/* Assembly entry points often have no type */
+			if (shndx == SHN_UNDEF || shndx >= SHN_LORESERVE || !strtab[name] ||
+			    (type != STT_FUNC && type != STT_NOTYPE))
+				continue;
+			ps->syms[ps->count].addr = value;
+			ps->syms[ps->count].name = strtab + name;
+			ps->count++;
+		}
+	}
+
+	qsort(ps->syms, ps->count, sizeof(ps->syms[0]), compare_profile_symbols);
+}
+
+/* Return the index of the symbol containing addr, or -1. */
+static ssize_t find_profile_symbol(const struct profile_symbols *ps, u64 addr)
+{
+	size_t lo = 0, hi = ps->count;
+
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+
+		if (ps->syms[mid].addr <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return (ssize_t)lo - 1;
+}
+
+struct profile_frame {
+	u64 addr;	/* Sampled address if there is no symbol */
+	ssize_t sym;
+	u32 count;
+};
+
+static int compare_profile_frames(const void *a, const void *b)
+{
+	const struct profile_frame *fa = a, *fb = b;
+
+	if (fa->sym != fb->sym)
+		return fa->sym < fb->sym ? -1 : 1;
+	if (fa->addr != fb->addr)
+		return fa->addr < fb->addr ? -1 : 1;
+	return 0;
+}
+
+static int compare_profile_counts(const void *a, const void *b)
+{
+	const struct profile_frame *fa = a, *fb = b;
+
+	if (fa->count != fb->count)
+		return fa->count > fb->count ? -1 : 1;
+	return compare_profile_frames(a, b);
+}
+
+/* dump the ramstage profile as folded stacks, symbolized against elf_path if given */
+static void dump_profile(const char *elf_path)
+{
+	const struct ramstage_profile *profile_p;
+	struct ramstage_profile *profile;
+	struct profile_symbols ps = { 0 };
+	struct profile_frame *frames;
+	struct mapping profile_mapping;
+	uint64_t start;
+	size_t size, cbmem_size, i, n;
+	u64 bias = 0;
+	u32 count;
+
+	if (find_cbmem_entry(CBMEM_ID_PROFILE, &start, &cbmem_size)) {
+		fprintf(stderr, "No ramstage profile found in coreboot table.\n");
+		return;
+	}
+
+	size = sizeof(*profile_p);
+	profile_p = map_memory(&profile_mapping, start, size);
+	if (!profile_p)
+		die("Unable to map ramstage profile header\n");
+
+	size += (size_t)profile_p->max_samples * sizeof(profile_p->samples[0]);
+	if (size > cbmem_size)
+		die("Ramstage profile is larger than its CBMEM entry\n");
+
+	unmap_memory(&profile_mapping);
+
+	profile_p = map_memory(&profile_mapping, start, size);
+	if (!profile_p)
+		die("Unable to map full ramstage profile\n");
+
+	profile = malloc(size);
+	if (!profile)
+		die("Failed to allocate memory");
+	aligned_memcpy(profile, profile_p, size);
+	unmap_memory(&profile_mapping);
+
+	count = profile->num_samples;
+	if (count > profile->max_samples)
+		count = profile->max_samples;
+	fprintf(stderr, "%u samples at %u Hz, %u kept\n", profile->num_samples,
+		profile->frequency, count);
+
+	if (elf_path) {
+		load_profile_symbols(elf_path, &ps);
+		/* Ramstage may have been relocated since it was linked */
+		if (ps.program)
+			bias = profile->program_base - ps.program;
+	}
+
+	frames = calloc(count ? count : 1, sizeof(*frames));
+	if (!frames)
+		die("Failed to allocate memory");
+
+	for (i = 0; i < count; i++) {
+		u64 addr = profile->samples[i] - bias;
+
+		frames[i].sym = find_profile_symbol(&ps, addr);
+		frames[i].addr = frames[i].sym < 0 ? profile->samples[i] : 0;
+		frames[i].count = 1;
+	}
+
+	/* Merge the samples of each function, then sort by number of samples */
+	qsort(frames, count, sizeof(*frames), compare_profile_frames);
+	for (i = 0, n = 0; i < count; i++) {
+		if (n && !compare_profile_frames(&frames[n - 1], &frames[i]))
+			frames[n - 1].count++;
+		else
+			frames[n++] = frames[i];
+	}
+	qsort(frames, n, sizeof(*frames), compare_profile_counts);
+
+	for (i = 0; i < n; i++) {
+		if (frames[i].sym >= 0)
+			printf("ramstage;%s %u\n", ps.syms[frames[i].sym].name, frames[i].count);
+		else
+			printf("ramstage;0x%llx %u\n", (unsigned long long)frames[i].addr,
+			       frames[i].count);
+	}
+
+	free(frames);
+	free(ps.syms);
+	free(ps.image);
+	free(profile);
+}
+
 struct cbmem_console {
 	u32 size;
 	u32 cursor;
@@ -1083,7 +1534,7 @@ static void print_version(void)
 
 static void print_usage(const char *name, int exit_code)
 {
-	printf("usage: %s [-cCltTLxVvh?]\n", name);
+	printf("usage: %s [-cCltTLSpxVvh?]\n", name);
 	printf("\n"
 	     "   -c | --console:                   print cbmem console\n"
 	     "   -1 | --oneboot:                   print cbmem console for last boot only\n"
@@ -1094,6 +1545,9 @@ static void print_usage(const char *name, int exit_code)
 	     "   -t | --timestamps:                print timestamp information\n"
 	     "   -T | --parseable-timestamps:      print parseable timestamps\n"
 	     "   -L | --tcpa-log                   print TCPA log\n"
+	     "   -S | --smi-profile:               print SMI latencies and histograms\n"
+	     "   -p | --profile[=ELF]:             print ramstage profile as folded stacks,\n"
+	     "                                     symbolized against ramstage.debug ELF\n"
 	     "   -V | --verbose:                   verbose (debugging) output\n"
 	     "   -v | --version:                   print the version\n"
 	     "   -h | --help:                      print this help\n"
@@ -1226,6 +1680,9 @@ int main(int argc, char** argv)
 	int print_rawdump = 0;
 	int print_timestamps = 0;
 	int print_tcpa_log = 0;
+	int print_smi_profile = 0;
+	int print_profile = 0;
+	const char *profile_elf = NULL;
 	int machine_readable_timestamps = 0;
 	int one_boot_only = 0;
 	unsigned int rawdump_id = 0;
@@ -1237,6 +1694,8 @@ int main(int argc, char** argv)
 		{"coverage", 0, 0, 'C'},
 		{"list", 0, 0, 'l'},
 		{"tcpa-log", 0, 0, 'L'},
+		{"smi-profile", 0, 0, 'S'},
+		{"profile", optional_argument, 0, 'p'},
 		{"timestamps", 0, 0, 't'},
 		{"parseable-timestamps", 0, 0, 'T'},
 		{"hexdump", 0, 0, 'x'},
@@ -1246,7 +1705,7 @@ int main(int argc, char** argv)
 		{"help", 0, 0, 'h'},
 		{0, 0, 0, 0}
 	};
-	while ((opt = getopt_long(argc, argv, "c1CltTLxVvh?r:",
+	while ((opt = getopt_long(argc, argv, "c1CltTLSp::xVvh?r:",
 				  long_options, &option_index)) != EOF) {
 		switch (opt) {
 		case 'c':
@@ -1270,6 +1729,15 @@ int main(int argc, char** argv)
 			print_tcpa_log = 1;
 			print_defaults = 0;
 			break;
+		case 'S':
+			print_smi_profile = 1;
+			print_defaults = 0;
+			break;
+		case 'p':
+			print_profile = 1;
+			profile_elf = optarg;
+			print_defaults = 0;
+			break;
 		case 'x':
 			print_hexdump = 1;
 			print_defaults = 0;
@@ -1403,6 +1871,12 @@ int main(int argc, char** argv)
 	if (print_tcpa_log)
 		dump_tcpa_log();
 
+	if (print_smi_profile)
+		dump_smi_profile();
+
+	if (print_profile)
+		dump_profile(profile_elf);
+
 	unmap_memory(&lbtable_mapping);
 
 	close(mem_fd);
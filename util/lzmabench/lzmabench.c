@@ -0,0 +1,427 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+/*
+ * Host benchmark for the LZMA decoder used by coreboot stages
+ * (src/lib/lzmadecode.c). Streams are taken from files extracted from a
+ * coreboot image and decoded with the coreboot decoder, the LZMA SDK decoder
+ * used by cbfstool and, if built with BASELINE_REV, the coreboot decoder of
+ * that revision. The output of all decoders is compared.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <commonlib/bsd/cbfs_serialized.h>
+
+#include "common.h"
+#include "lzmadecode.h"
+
+#ifdef LZMABENCH_BASELINE
+int baseline_LzmaDecodeProperties(CLzmaProperties *propsRes,
+	const unsigned char *propsData, int size);
+int baseline_LzmaDecode(CLzmaDecoderState *vs,
+	const unsigned char *inStream, SizeT inSize, SizeT *inSizeProcessed,
+	unsigned char *outStream, SizeT outSize, SizeT *outSizeProcessed);
+#endif
+
+/* Used by the cbfstool LZMA wrapper. */
+int verbose;
+
+#define LZMA_HEADER_SIZE (LZMA_PROPERTIES_SIZE + 8)
+
+/* Same scratchpad size as ulzman() in coreboot. */
+#define SCRATCHPAD_SIZE 15980
+
+struct stream {
+	char name[128];
+	unsigned char *data;
+	size_t size;
+	size_t out_size;
+};
+
+struct decoder {
+	const char *name;
+	int (*decode)(const struct stream *s, unsigned char *out);
+	double seconds;
+	size_t bytes;
+};
+
+static struct stream *streams;
+static size_t num_streams;
+
+static CProb scratchpad[SCRATCHPAD_SIZE / sizeof(CProb)];
+
+static int decode_coreboot(const struct stream *s, unsigned char *out)
+{
+	CLzmaDecoderState state;
+	SizeT in_processed, out_processed;
+
+	if (LzmaDecodeProperties(&state.Properties, s->data, LZMA_PROPERTIES_SIZE) !=
+	    LZMA_RESULT_OK)
+		return -1;
+	if (LzmaGetNumProbs(&state.Properties) * sizeof(CProb) > SCRATCHPAD_SIZE)
+		return -1;
+	state.Probs = scratchpad;
+	if (LzmaDecode(&state, s->data + LZMA_HEADER_SIZE, s->size - LZMA_HEADER_SIZE,
+		       &in_processed, out, s->out_size, &out_processed) != LZMA_RESULT_OK)
+		return -1;
+	return out_processed == s->out_size ? 0 : -1;
+}
+
+#ifdef LZMABENCH_BASELINE
+static int decode_baseline(const struct stream *s, unsigned char *out)
+{
+	CLzmaDecoderState state;
+	SizeT in_processed, out_processed;
+
+	if (baseline_LzmaDecodeProperties(&state.Properties, s->data,
+					  LZMA_PROPERTIES_SIZE) != LZMA_RESULT_OK)
+		return -1;
+	if (LzmaGetNumProbs(&state.Properties) * sizeof(CProb) > SCRATCHPAD_SIZE)
+		return -1;
+	state.Probs = scratchpad;
+	if (baseline_LzmaDecode(&state, s->data + LZMA_HEADER_SIZE,
+				s->size - LZMA_HEADER_SIZE, &in_processed, out, s->out_size,
+				&out_processed) != LZMA_RESULT_OK)
+		return -1;
+	return out_processed == s->out_size ? 0 : -1;
+}
+#endif
+
+static int decode_sdk(const struct stream *s, unsigned char *out)
+{
+	size_t actual;
+
+	if (do_lzma_uncompress((char *)out, s->out_size, (char *)s->data, s->size, &actual))
+		return -1;
+	return actual == s->out_size ? 0 : -1;
+}
+
+static struct decoder decoders[] = {
+	{ .name = "coreboot", .decode = decode_coreboot },
+#ifdef LZMABENCH_BASELINE
+	{ .name = "baseline " LZMABENCH_BASELINE, .decode = decode_baseline },
+#endif
+	{ .name = "LZMA SDK", .decode = decode_sdk },
+};
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t read_be32(const void *p)
+{
+	const unsigned char *b = p;
+
+	return (uint32_t)b[0] << 24 | b[1] << 16 | b[2] << 8 | b[3];
+}
+
+static int add_stream(const char *name, const unsigned char *data, size_t size)
+{
+	struct stream *s;
+	uint64_t out_size = 0;
+	int i;
+
+	if (size <= LZMA_HEADER_SIZE || data[0] >= 9 * 5 * 5) {
+		fprintf(stderr, "%s: not an LZMA stream\n", name);
+		return -1;
+	}
+	for (i = 7; i >= 0; i--)
+		out_size = out_size << 8 | data[LZMA_PROPERTIES_SIZE + i];
+	if (out_size == 0 || out_size > 256 * MiB) {
+		fprintf(stderr, "%s: unexpected decompressed size\n", name);
+		return -1;
+	}
+
+	streams = realloc(streams, (num_streams + 1) * sizeof(*streams));
+	if (!streams)
+		return -1;
+	s = &streams[num_streams];
+	snprintf(s->name, sizeof(s->name), "%s", name);
+	s->data = malloc(size);
+	if (!s->data)
+		return -1;
+	memcpy(s->data, data, size);
+	s->size = size;
+	s->out_size = out_size;
+	num_streams++;
+	return 0;
+}
+
+static int is_segment_type(uint32_t type)
+{
+	switch (type) {
+	case PAYLOAD_SEGMENT_CODE:
+	case PAYLOAD_SEGMENT_DATA:
+	case PAYLOAD_SEGMENT_BSS:
+	case PAYLOAD_SEGMENT_PARAMS:
+	case PAYLOAD_SEGMENT_ENTRY:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static int is_payload(const unsigned char *data, size_t size)
+{
+	return size >= sizeof(struct cbfs_payload_segment) && is_segment_type(read_be32(data));
+}
+
+/* Add the LZMA compressed segments of an unprocessed SELF payload. */
+static int add_payload(const char *name, const unsigned char *data, size_t size)
+{
+	const size_t seg_size = sizeof(struct cbfs_payload_segment);
+	size_t pos;
+
+	for (pos = 0; pos + seg_size <= size; pos += seg_size) {
+		struct cbfs_payload_segment seg;
+		char seg_name[128];
+
+		memcpy(&seg, data + pos, seg_size);
+		if (!is_segment_type(read_be32(&seg.type))) {
+			fprintf(stderr, "%s: invalid payload segment\n", name);
+			return -1;
+		}
+		if (read_be32(&seg.type) == PAYLOAD_SEGMENT_ENTRY)
+			break;
+		if (read_be32(&seg.compression) != CBFS_COMPRESS_LZMA)
+			continue;
+
+		seg.offset = read_be32(&seg.offset);
+		seg.len = read_be32(&seg.len);
+		if (seg.offset > size || seg.len > size - seg.offset) {
+			fprintf(stderr, "%s: payload segment out of bounds\n", name);
+			return -1;
+		}
+
+		snprintf(seg_name, sizeof(seg_name), "%s[%zu]", name, pos / seg_size);
+		if (add_stream(seg_name, data + seg.offset, seg.len))
+			return -1;
+	}
+
+	return 0;
+}
+
+/* Compress a file with the cbfstool encoder, the same way `cbfstool add -c lzma` does. */
+static int add_compressed(const char *name, unsigned char *data, size_t size)
+{
+	unsigned char *out;
+	int out_len;
+	int ret;
+
+	/* The encoder fails if the output doesn't fit in the input size. */
+	out = malloc(size);
+	if (!out)
+		return -1;
+	if (do_lzma_compress((char *)data, size, (char *)out, &out_len)) {
+		fprintf(stderr, "%s: does not compress, skipped\n", name);
+		free(out);
+		return 0;
+	}
+	ret = add_stream(name, out, out_len);
+	free(out);
+	return ret;
+}
+
+static unsigned char *read_file(const char *name, size_t *size)
+{
+	unsigned char *data;
+	FILE *f;
+	long len;
+
+	f = fopen(name, "rb");
+	if (!f) {
+		fprintf(stderr, "%s: %s\n", name, strerror(errno));
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) || (len = ftell(f)) <= 0 || fseek(f, 0, SEEK_SET)) {
+		fprintf(stderr, "%s: cannot determine size\n", name);
+		fclose(f);
+		return NULL;
+	}
+	data = malloc(len);
+	if (!data || fread(data, 1, len, f) != (size_t)len) {
+		fprintf(stderr, "%s: read error\n", name);
+		free(data);
+		fclose(f);
+		return NULL;
+	}
+	fclose(f);
+	*size = len;
+	return data;
+}
+
+/* Decode a stream with all decoders once and check that their output is the same. */
+static int verify(const struct stream *s, unsigned char *out, unsigned char *ref, int *ok)
+{
+	size_t d;
+	int ret = 0;
+
+	for (d = 0; d < ARRAY_SIZE(decoders); d++) {
+		unsigned char *buf = d == 0 ? ref : out;
+
+		ok[d] = 0;
+		memset(buf, 0, s->out_size);
+		if (decoders[d].decode(s, buf)) {
+			fprintf(stderr, "%s: %s decoder failed\n", s->name, decoders[d].name);
+			ret = -1;
+		} else if (d != 0 && memcmp(ref, out, s->out_size)) {
+			fprintf(stderr, "%s: %s decoder output differs\n", s->name,
+				decoders[d].name);
+			ret = -1;
+		} else {
+			ok[d] = 1;
+		}
+	}
+
+	return ret;
+}
+
+static int run(unsigned int iterations)
+{
+	unsigned char *out, *ref;
+	double best[ARRAY_SIZE(decoders)];
+	int ok[ARRAY_SIZE(decoders)];
+	size_t max_out = 0;
+	size_t i, d;
+	unsigned int n;
+	int ret = 0;
+
+	for (i = 0; i < num_streams; i++)
+		max_out = MAX(max_out, streams[i].out_size);
+	out = malloc(max_out);
+	ref = malloc(max_out);
+	if (!out || !ref)
+		return -1;
+
+	printf("%-40s %10s %10s", "stream", "in", "out");
+	for (d = 0; d < ARRAY_SIZE(decoders); d++)
+		printf(" %16s", decoders[d].name);
+	printf("\n");
+
+	for (i = 0; i < num_streams; i++) {
+		const struct stream *s = &streams[i];
+
+		if (verify(s, out, ref, ok))
+			ret = -1;
+
+		/*
+		 * Interleave the decoders and report the fastest run of each, so that
+		 * load on the host affects all of them alike.
+		 */
+		for (n = 0; n < iterations; n++) {
+			for (d = 0; d < ARRAY_SIZE(decoders); d++) {
+				double start, seconds;
+
+				if (!ok[d])
+					continue;
+				start = now();
+				decoders[d].decode(s, out);
+				seconds = now() - start;
+				if (n == 0 || seconds < best[d])
+					best[d] = seconds;
+			}
+		}
+
+		printf("%-40s %10zu %10zu", s->name, s->size, s->out_size);
+		for (d = 0; d < ARRAY_SIZE(decoders); d++) {
+			if (!ok[d]) {
+				printf(" %16s", "FAILED");
+				continue;
+			}
+			decoders[d].seconds += best[d];
+			decoders[d].bytes += s->out_size;
+			printf(" %11.1f MB/s", s->out_size / best[d] / MiB);
+		}
+		printf("\n");
+	}
+
+	printf("%-62s", "total");
+	for (d = 0; d < ARRAY_SIZE(decoders); d++) {
+		if (decoders[d].seconds > 0)
+			printf(" %11.1f MB/s", decoders[d].bytes / decoders[d].seconds / MiB);
+		else
+			printf(" %16s", "-");
+	}
+	printf("\n");
+
+	free(out);
+	free(ref);
+	return ret;
+}
+
+static void usage(const char *name)
+{
+	printf("usage: %s [-c] [-i iterations] FILE...\n\n"
+	       "Benchmark the coreboot LZMA decoder. FILEs are LZMA compressed files or\n"
+	       "SELF payloads as extracted from a coreboot image with\n"
+	       "`cbfstool coreboot.rom extract -U -n NAME -f FILE`.\n\n"
+	       "  -c            compress FILEs with the cbfstool LZMA encoder first\n"
+	       "  -i iterations number of decode runs per stream (default: 20)\n"
+	       "  -h            show this help\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int iterations = 20;
+	int compress = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "ci:h")) != -1) {
+		switch (opt) {
+		case 'c':
+			compress = 1;
+			break;
+		case 'i':
+			iterations = strtoul(optarg, NULL, 0);
+			if (!iterations)
+				iterations = 1;
+			break;
+		case 'h':
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (optind == argc) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	for (; optind < argc; optind++) {
+		const char *name = argv[optind];
+		unsigned char *data;
+		size_t size;
+		int ret;
+
+		data = read_file(name, &size);
+		if (!data)
+			return 1;
+		if (compress)
+			ret = add_compressed(name, data, size);
+		else if (is_payload(data, size))
+			ret = add_payload(name, data, size);
+		else
+			ret = add_stream(name, data, size);
+		free(data);
+		if (ret)
+			return 1;
+	}
+
+	if (!num_streams) {
+		fprintf(stderr, "No LZMA streams found.\n");
+		return 1;
+	}
+
+	return run(iterations) ? 1 : 0;
+}
@@ -0,0 +1,3 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+/* The benchmark provides its own port I/O to the emulator, see x86emubench.c. */
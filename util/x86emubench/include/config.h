@@ -0,0 +1,3 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+/* Kconfig options are passed on the command line by the Makefile. */
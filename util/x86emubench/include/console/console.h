@@ -0,0 +1,15 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef X86EMUBENCH_CONSOLE_H
+#define X86EMUBENCH_CONSOLE_H
+
+#include <stdio.h>
+
+#define BIOS_ERR	3
+#define BIOS_INFO	6
+#define BIOS_DEBUG	7
+#define BIOS_SPEW	8
+
+#define printk(level, ...)	fprintf(stderr, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,21 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+#ifndef X86EMUBENCH_TYPES_H
+#define X86EMUBENCH_TYPES_H
+
+#include <stdint.h>
+
+/* coreboot's <stdint.h> provides these, the host one does not. */
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+/* Normally set by <rules.h>. Like non-x86 builds, the benchmark implements port I/O itself. */
+#define ENV_X86 0
+
+#endif
@@ -0,0 +1,372 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+
+/*
+ * Host benchmark for the x86emu interpreter used by YABEL
+ * (src/device/oprom/x86emu). It runs the initialization vector of a VGA
+ * Option ROM, e.g. SeaVGABIOS, in 1 MiB of flat emulated memory and reports
+ * how long that took. The Makefile builds it with and without the x86emu code
+ * cache; both builds print a checksum of the final machine state, which must
+ * match.
+ */
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <x86emu/x86emu.h>
+#include <x86emu/regs.h>
+
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#define MiB			(1024 * 1024)
+#define MEM_SIZE		(1 * MiB)
+
+#define ROM_ADDR		0xc0000
+#define ROM_MAX_SIZE		0x20000
+#define ROM_SEGMENT		(ROM_ADDR >> 4)
+
+/* BIOS stub every interrupt vector points to: IRET. */
+#define BIOS_SEGMENT		0xf000
+#define BIOS_IRET_OFFSET	0xff53
+
+#define STACK_SEGMENT		0x1000
+#define STACK_START		0xfffe
+
+/* Port 0x3da bit 3 is polled for the vertical retrace. */
+#define VGA_INPUT_STATUS_1	0x3da
+
+static uint8_t rom[ROM_MAX_SIZE];
+static size_t rom_size;
+
+/* Word and long accesses at the very end may run over by up to 3 bytes. */
+static uint8_t mem[MEM_SIZE + 3];
+static uint8_t ports[0x10000];
+static unsigned int retrace;
+
+/*
+ * Like YABEL's my_rdX()/my_wrX(), every access first looks for the address in
+ * the table of translated device ranges. The device's BARs are never hit here.
+ */
+static const struct {
+	uint32_t address;
+	uint32_t size;
+} translated[] = {
+	{ 0xe0000000, 0x10000000 },
+	{ 0xf0000000, 0x01000000 },
+	{ 0xf1000000, 0x00010000 },
+	{ 0xf1010000, 0x00001000 },
+	{ 0xf1020000, 0x00020000 },
+	{ 0xf1040000, 0x00004000 },
+};
+
+static uint8_t *mem_ptr(u32 addr)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(translated); i++) {
+		if (addr >= translated[i].address &&
+		    addr <= translated[i].address + translated[i].size)
+			abort();
+	}
+	return &mem[addr % MEM_SIZE];
+}
+
+static uint8_t X86API mem_rdb(u32 addr)
+{
+	return *mem_ptr(addr);
+}
+
+static uint16_t X86API mem_rdw(u32 addr)
+{
+	const uint8_t *p = mem_ptr(addr);
+
+	return p[0] | p[1] << 8;
+}
+
+static uint32_t X86API mem_rdl(u32 addr)
+{
+	const uint8_t *p = mem_ptr(addr);
+
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void X86API mem_wrb(u32 addr, u8 val)
+{
+	*mem_ptr(addr) = val;
+}
+
+static void X86API mem_wrw(u32 addr, u16 val)
+{
+	uint8_t *p = mem_ptr(addr);
+
+	p[0] = val;
+	p[1] = val >> 8;
+}
+
+static void X86API mem_wrl(u32 addr, u32 val)
+{
+	uint8_t *p = mem_ptr(addr);
+
+	p[0] = val;
+	p[1] = val >> 8;
+	p[2] = val >> 16;
+	p[3] = val >> 24;
+}
+
+static X86EMU_memFuncs mem_funcs = {
+	mem_rdb, mem_rdw, mem_rdl,
+	mem_wrb, mem_wrw, mem_wrl
+};
+
+/*
+ * There is no VGA behind the ports. Reads return what was last written, which
+ * is enough for the register read-back the ROMs do, and the retrace bit
+ * toggles so that waiting for it terminates.
+ */
+static uint8_t X86API port_inb(X86EMU_pioAddr port)
+{
+	if (port == VGA_INPUT_STATUS_1)
+		return (++retrace & 1) << 3;
+	return ports[port];
+}
+
+static uint16_t X86API port_inw(X86EMU_pioAddr port)
+{
+	return port_inb(port) | port_inb(port + 1) << 8;
+}
+
+static uint32_t X86API port_inl(X86EMU_pioAddr port)
+{
+	return port_inw(port) | (uint32_t)port_inw(port + 2) << 16;
+}
+
+static void X86API port_outb(X86EMU_pioAddr port, u8 val)
+{
+	ports[port] = val;
+}
+
+static void X86API port_outw(X86EMU_pioAddr port, u16 val)
+{
+	port_outb(port, val);
+	port_outb(port + 1, val >> 8);
+}
+
+static void X86API port_outl(X86EMU_pioAddr port, u32 val)
+{
+	port_outw(port, val);
+	port_outw(port + 2, val >> 16);
+}
+
+static X86EMU_pioFuncs pio_funcs = {
+	port_inb, port_inw, port_inl,
+	port_outb, port_outw, port_outl
+};
+
+/* The emulator is set up with its own port I/O, so these are never used. */
+void outb(u8 val, u16 port)
+{
+	abort();
+}
+
+void outw(u16 val, u16 port)
+{
+	abort();
+}
+
+void outl(u32 val, u16 port)
+{
+	abort();
+}
+
+u8 inb(u16 port)
+{
+	abort();
+}
+
+u16 inw(u16 port)
+{
+	abort();
+}
+
+u32 inl(u16 port)
+{
+	abort();
+}
+
+static void timeout(int sig)
+{
+	X86EMU_halt_sys();
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int read_rom(const char *name)
+{
+	FILE *f = fopen(name, "rb");
+
+	if (!f) {
+		perror(name);
+		return -1;
+	}
+	rom_size = fread(rom, 1, sizeof(rom), f);
+	fclose(f);
+
+	if (rom_size < 3 || rom[0] != 0x55 || rom[1] != 0xaa) {
+		fprintf(stderr, "%s: Not an Option ROM.\n", name);
+		return -1;
+	}
+	return 0;
+}
+
+/* Set up the machine the way YABEL does and far call the ROM at C000:0003. */
+static void setup(void)
+{
+	int i;
+
+	memset(mem, 0, sizeof(mem));
+	memset(ports, 0, sizeof(ports));
+	retrace = 0;
+
+	for (i = 0; i < 256; i++) {
+		mem_wrw(i * 4, BIOS_IRET_OFFSET);
+		mem_wrw(i * 4 + 2, BIOS_SEGMENT);
+	}
+	mem_wrb(BIOS_SEGMENT * 16 + BIOS_IRET_OFFSET, 0xcf);
+	memcpy(mem + ROM_ADDR, rom, rom_size);
+
+	memset(&M, 0, sizeof(M));
+	X86EMU_setMemBase(mem, MEM_SIZE);
+	X86EMU_setupMemFuncs(&mem_funcs);
+	X86EMU_setupPioFuncs(&pio_funcs);
+
+	/* The ROM returns to a HLT on the stack. */
+	M.x86.R_SS = STACK_SEGMENT;
+	M.x86.R_SP = STACK_START;
+	mem_wrw(STACK_SEGMENT * 16 + STACK_START, 0xf4f4);
+	M.x86.R_SP -= 4;
+	mem_wrw(STACK_SEGMENT * 16 + M.x86.R_SP + 2, STACK_SEGMENT);
+	mem_wrw(STACK_SEGMENT * 16 + M.x86.R_SP, STACK_START);
+
+	M.x86.R_DS = 0x40;
+	M.x86.R_ES = 0;
+	M.x86.R_AX = 0;		/* bus 0, devfn 0 */
+	M.x86.R_DX = 0x80;
+	M.x86.R_CS = ROM_SEGMENT;
+	M.x86.R_EIP = 3;
+}
+
+/* FNV-1a over memory, ports and registers. */
+static uint32_t checksum(void)
+{
+	uint32_t regs[] = {
+		M.x86.R_EAX, M.x86.R_EBX, M.x86.R_ECX, M.x86.R_EDX,
+		M.x86.R_ESI, M.x86.R_EDI, M.x86.R_EBP, M.x86.R_ESP,
+		M.x86.R_CS, M.x86.R_DS, M.x86.R_ES, M.x86.R_SS, M.x86.R_EIP,
+	};
+	uint32_t h = 2166136261u;
+	size_t i;
+
+	for (i = 0; i < sizeof(mem); i++)
+		h = (h ^ mem[i]) * 16777619u;
+	for (i = 0; i < sizeof(ports); i++)
+		h = (h ^ ports[i]) * 16777619u;
+	for (i = 0; i < sizeof(regs); i++)
+		h = (h ^ ((uint8_t *)regs)[i]) * 16777619u;
+	return h;
+}
+
+static void usage(const char *name)
+{
+	printf("usage: %s [-i iterations] [-t seconds] ROM\n\n"
+	       "Benchmark x86emu with the initialization vector of a VGA Option ROM, e.g.\n"
+	       "SeaVGABIOS' out/vgabios.bin.\n\n"
+	       "  -i iterations number of runs (default: 5)\n"
+	       "  -t seconds    stop each run after this long (default: 30)\n"
+	       "  -h            show this help\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int iterations = 5, seconds = 30, i;
+	double best = 0;
+	X86EMU_stats stats;
+	uint32_t sum = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "i:t:h")) != -1) {
+		switch (opt) {
+		case 'i':
+			iterations = strtoul(optarg, NULL, 0);
+			if (!iterations)
+				iterations = 1;
+			break;
+		case 't':
+			seconds = strtoul(optarg, NULL, 0);
+			break;
+		case 'h':
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (optind + 1 != argc) {
+		usage(argv[0]);
+		return 1;
+	}
+	if (read_rom(argv[optind]))
+		return 1;
+
+	signal(SIGALRM, timeout);
+
+	for (i = 0; i < iterations; i++) {
+		double start, t;
+		uint32_t s;
+
+		setup();
+		X86EMU_resetStats();
+		alarm(seconds);
+		start = now();
+		X86EMU_exec();
+		t = now() - start;
+		alarm(0);
+		X86EMU_getStats(&stats);
+
+		if (M.x86.R_CS != STACK_SEGMENT) {
+			fprintf(stderr, "ROM did not return, stopped at %04x:%04x.\n",
+				M.x86.R_CS, M.x86.R_IP);
+			return 1;
+		}
+
+		s = checksum();
+		if (i && s != sum) {
+			fprintf(stderr, "Run %u ended in a different state.\n", i);
+			return 1;
+		}
+		sum = s;
+		if (!i || t < best)
+			best = t;
+	}
+
+	printf("code cache:          %s\n",
+	       CONFIG(X86EMU_CODE_CACHE) ? "enabled" : "disabled");
+	printf("instructions:        %llu\n", stats.instructions);
+	printf("best time:           %.3f ms\n", best * 1e3);
+	printf("MIPS:                %.1f\n", stats.instructions / best / 1e6);
+	printf("cache misses:        %lu\n", stats.code_cache_misses);
+	printf("cache invalidations: %lu\n", stats.code_cache_invalidations);
+	printf("uncached fetches:    %lu\n", stats.code_cache_bypassed);
+	printf("checksum:            %08x\n", sum);
+
+	return 0;
+}